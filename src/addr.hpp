@@ -273,6 +273,53 @@ namespace mage {
      */
     using StoragePageNumber = std::uint64_t;
 
+    /**
+     * @brief Number of high-order bits of a storage page number that identify
+     * the storage tier (e.g., a fast NVMe drive or a larger, slower disk)
+     * holding the page. The remaining bits identify a page frame within that
+     * tier's swap file or device.
+     */
+    const constexpr int storage_tier_bits = 2;
+
+    /** @brief Maximum number of storage tiers. */
+    const constexpr std::uint8_t max_storage_tiers = 1 << storage_tier_bits;
+
+    /** @brief Bit position of the storage tier in a storage page number. */
+    const constexpr int storage_tier_shift = storage_address_bits - storage_tier_bits;
+
+    /**
+     * @brief Computes the storage tier holding the specified storage page.
+     *
+     * @param spn The storage page number.
+     * @return The storage tier identified by the storage page number.
+     */
+    inline std::uint8_t storage_tier(StoragePageNumber spn) {
+        return static_cast<std::uint8_t>(spn >> storage_tier_shift);
+    }
+
+    /**
+     * @brief Computes the page frame, within its storage tier, of the
+     * specified storage page.
+     *
+     * @param spn The storage page number.
+     * @return The page frame number within the storage tier.
+     */
+    inline StoragePageNumber storage_tier_frame(StoragePageNumber spn) {
+        return spn & ((UINT64_C(1) << storage_tier_shift) - 1);
+    }
+
+    /**
+     * @brief Computes the storage page number for the specified page frame in
+     * the specified storage tier.
+     *
+     * @param tier The storage tier.
+     * @param frame The page frame number within the storage tier.
+     * @return The storage page number.
+     */
+    inline StoragePageNumber storage_page_number(std::uint8_t tier, StoragePageNumber frame) {
+        return (static_cast<StoragePageNumber>(tier) << storage_tier_shift) | frame;
+    }
+
     /* CLUSTER */
 
     /**
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "crypto/ot/random.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "crypto/block.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/ot/extension.hpp"
+#include "util/filebuffer.hpp"
+
+namespace mage::crypto::ot {
+    static inline void clear_bits(block* bits, std::size_t num_bits) {
+        std::size_t num_row_blocks = (num_bits + block_num_bits - 1) / block_num_bits;
+        for (std::size_t i = 0; i != num_row_blocks; i++) {
+            bits[i] = zero_block();
+        }
+    }
+
+    static inline void set_bit(block* bits, std::uint32_t index, bool value) {
+        std::uint64_t* halves = reinterpret_cast<std::uint64_t*>(&bits[index / block_num_bits]);
+        std::uint32_t offset = index % block_num_bits;
+        halves[offset >> 6] |= (static_cast<std::uint64_t>(value) << (offset & 0x3f));
+    }
+
+    void RandomExtensionSender::finish_send_bits(block* first_bits, block* second_bits, std::size_t num_choices, const block* qT) {
+        assert(this->initialized);
+
+        clear_bits(first_bits, num_choices);
+        clear_bits(second_bits, num_choices);
+        for (std::uint32_t j = 0; j != num_choices; j++) { // iterating over rows (columns of transpose)
+            const block* qj = &qT[j];
+            {
+                Hasher h(&j, sizeof(j)); // TODO: marshal this
+                h.update(qj, sizeof(block));
+                set_bit(first_bits, j, getLSB(h.output_block()));
+            }
+            {
+                Hasher h(&j, sizeof(j)); // TODO: marshal this
+                block temp = xorBlocks(block_load_unaligned(qj), this->s);
+                h.update(&temp, sizeof(block));
+                set_bit(second_bits, j, getLSB(h.output_block()));
+            }
+        }
+    }
+
+    void RandomExtensionSender::send_bits(util::BufferedFileReader<false>& network_in, block* first_bits, block* second_bits, std::size_t num_choices) {
+        assert(num_choices != 0); // sse_trans does not work for zero-size matrices
+
+        std::size_t num_row_blocks = (num_choices + block_num_bits - 1) / block_num_bits;
+        std::size_t num_blocks = num_row_blocks * extension_kappa;
+
+        block q[num_blocks];
+        block qT[num_blocks];
+
+        void* from = network_in.start_read(sizeof(block) * num_blocks);
+        block* u = reinterpret_cast<block*>(from);
+        this->prepare_send(num_choices, u, q);
+        network_in.finish_read(sizeof(block) * num_blocks);
+
+        sse_trans(reinterpret_cast<std::uint8_t*>(qT), reinterpret_cast<std::uint8_t*>(q), extension_kappa, num_row_blocks * block_num_bits);
+
+        this->finish_send_bits(first_bits, second_bits, num_choices, qT);
+    }
+
+    void RandomExtensionChooser::finish_choose_bits(block* result_bits, std::size_t num_choices, const block* tT) {
+        assert(this->initialized);
+
+        clear_bits(result_bits, num_choices);
+        for (std::uint32_t j = 0; j != num_choices; j++) {
+            Hasher h(&j, sizeof(j)); // TODO: marshal this
+            h.update(&tT[j], sizeof(block));
+            set_bit(result_bits, j, getLSB(h.output_block()));
+        }
+    }
+
+    void RandomExtensionChooser::choose_bits(util::BufferedFileWriter<false>& network_out, const block* choices, block* result_bits, std::size_t num_choices) {
+        assert(num_choices != 0); // sse_trans does not work for zero-size matrices
+
+        std::size_t num_row_blocks = (num_choices + block_num_bits - 1) / block_num_bits;
+        std::size_t num_blocks = num_row_blocks * extension_kappa;
+
+        block t[num_blocks];
+        block tT[num_blocks];
+
+        network_out.flush(); // This guarantees that u will be aligned
+        void* into = network_out.start_write(sizeof(block) * num_blocks);
+        block* u = static_cast<block*>(into);
+        this->prepare_choose(choices, num_choices, u, t);
+        network_out.finish_write(sizeof(block) * num_blocks);
+        network_out.flush();
+
+        sse_trans(reinterpret_cast<std::uint8_t*>(tT), reinterpret_cast<std::uint8_t*>(t), extension_kappa, num_row_blocks * block_num_bits);
+
+        this->finish_choose_bits(result_bits, num_choices, tT);
+    }
+}
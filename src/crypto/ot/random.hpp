@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAGE_CRYPTO_OT_RANDOM_HPP_
+#define MAGE_CRYPTO_OT_RANDOM_HPP_
+
+#include <cstddef>
+#include "crypto/block.hpp"
+#include "crypto/ot/extension.hpp"
+#include "util/filebuffer.hpp"
+
+namespace mage::crypto::ot {
+    /*
+     * Random OT on bits, built on the same OT extension. Neither party
+     * chooses the messages; instead, the sender obtains two random bits per
+     * OT and the chooser obtains the one selected by its choice bit. Unlike
+     * chosen-message or correlated OT, the sender sends nothing after
+     * receiving u, so the only communication is the chooser's u matrix.
+     *
+     * All bit arrays are packed, 128 bits per block, with bit j of the
+     * arrays corresponding to the jth OT.
+     */
+    class RandomExtensionSender : public ExtensionSender {
+    public:
+        void send_bits(util::BufferedFileReader<false>& network_in, block* first_bits, block* second_bits, std::size_t num_choices);
+
+    protected:
+        void finish_send_bits(block* first_bits, block* second_bits, std::size_t num_choices, const block* qT);
+    };
+
+    class RandomExtensionChooser : public ExtensionChooser {
+    public:
+        void choose_bits(util::BufferedFileWriter<false>& network_out, const block* choices, block* result_bits, std::size_t num_choices);
+
+    protected:
+        void finish_choose_bits(block* result_bits, std::size_t num_choices, const block* tT);
+    };
+}
+
+#endif
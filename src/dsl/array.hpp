@@ -324,6 +324,7 @@ namespace mage::dsl {
                 auto [my_target_base, my_target_stride] = this->get_global_base_and_stride(this->self_id, to);
                 std::size_t my_length = this->get_local_size(this->self_id);
                 if (my_length == 0) {
+                    this->layout = to;
                     return;
                 }
                 std::vector<T> array(my_length);
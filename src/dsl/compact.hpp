@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dsl/compact.hpp
+ * @brief Utilities for oblivious compaction using MAGE's DSLs.
+ */
+
+#ifndef MAGE_DSL_COMPACT_HPP_
+#define MAGE_DSL_COMPACT_HPP_
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "dsl/array.hpp"
+#include "util/misc.hpp"
+
+namespace mage::dsl {
+    /**
+     * @brief Obliviously moves the valid elements of an array stored locally
+     * by the calling worker to the front of the array, preserving their
+     * relative order.
+     *
+     * This is the order-preserving compaction network described by
+     * M. T. Goodrich in "Data-Oblivious External-Memory Algorithms for the
+     * Compaction, Selection, and Sorting of Outsourced Data" (SPAA 2011).
+     * Each valid element first computes the number of invalid elements that
+     * precede it, which is the distance it has to move towards the front of
+     * the array. Then, for each bit of that distance, starting with the least
+     * significant, every element whose distance has that bit set moves
+     * towards the front by the corresponding power of two. Two valid elements
+     * never contend for the same position, so each move is a conditional swap
+     * with an invalid element. This uses O(length * log(length)) conditional
+     * swaps, compared to O(length * log^2(length)) comparators to sort the
+     * array by its valid bits.
+     *
+     * The invalid elements end up after all of the valid elements, in an
+     * unspecified order. Because the number of valid elements is not
+     * revealed, the caller can only discard a suffix of the array whose
+     * length is known to be safe (e.g., keep a padded prefix whose length is
+     * a public upper bound on the number of valid elements).
+     *
+     * @tparam Counter The (unsliced) Integer type used to compute each
+     * element's distance. It must be wide enough to hold @p length - 1.
+     * @tparam T The type of elements in the array. It must support a static
+     * swap_if function similar to the one in the Integer<...> class, which
+     * must accept a sliced Bit as its predicate.
+     * @tparam GetValid The type of @p get_valid.
+     * @param array A pointer to the array of elements to compact.
+     * @param length The length of the array to compact.
+     * @param get_valid A function that, given a reference to an element of
+     * the array, returns a reference to a Bit indicating whether the element
+     * is valid. It is called once for each element, before any elements are
+     * moved.
+     */
+    template <typename Counter, typename T, typename GetValid>
+    void compact(T* array, std::uint64_t length, GetValid get_valid) {
+        if (length == 0 || length == 1) {
+            return;
+        }
+
+        std::uint8_t num_stages = util::log_base_2(length);
+        assert(num_stages <= Counter::width());
+
+        /* Compute the distance that each element must move. */
+        std::vector<Counter> distance(length);
+        {
+            Counter zero(0);
+            Counter num_invalid(0);
+            for (std::uint64_t i = 0; i != length; i++) {
+                const auto& valid = get_valid(array[i]);
+                distance[i] = Counter::select(valid, num_invalid, zero);
+                if (i + 1 != length) {
+                    Counter incremented = num_invalid.increment();
+                    num_invalid = Counter::select(valid, num_invalid, incremented);
+                }
+            }
+        }
+
+        for (std::uint8_t k = 0; k != num_stages; k++) {
+            std::uint64_t shift = UINT64_C(1) << k;
+            bool last_stage = (k + 1 == num_stages);
+
+            /*
+             * An element's distance is at most its index, so elements before
+             * index "shift" never move in this stage. Processing indices in
+             * increasing order ensures that the position at j - shift has
+             * already been vacated if the element there is moving too.
+             */
+            for (std::uint64_t j = shift; j != length; j++) {
+                /*
+                 * Swap the elements before the distances, since swapping the
+                 * distances invalidates the slice used as the predicate.
+                 */
+                auto move = distance[j][k];
+                T::swap_if(move, array[j - shift], array[j]);
+                if (!last_stage) {
+                    Counter::swap_if(move, distance[j - shift], distance[j]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Obliviously moves the valid elements of a vector stored locally
+     * by the calling worker to the front of the vector, preserving their
+     * relative order.
+     *
+     * @tparam Counter The (unsliced) Integer type used to compute each
+     * element's distance. It must be wide enough to hold the vector's size
+     * minus one.
+     * @tparam T The type of elements in the vector.
+     * @tparam GetValid The type of @p get_valid.
+     * @param elements The vector to compact.
+     * @param get_valid A function that, given a reference to an element,
+     * returns a reference to a Bit indicating whether it is valid.
+     * @sa compact(T*, std::uint64_t, GetValid)
+     */
+    template <typename Counter, typename T, typename GetValid>
+    void compact(std::vector<T>& elements, GetValid get_valid) {
+        compact<Counter>(elements.data(), elements.size(), get_valid);
+    }
+
+    /**
+     * @brief Obliviously moves the valid elements of each worker's partition
+     * of a ShardedArray to the front of that partition, preserving their
+     * relative order.
+     *
+     * Each worker compacts its own partition, without communicating with
+     * other workers. With the Layout::Blocked layout, each worker's valid
+     * elements are therefore contiguous in the logical array, starting at
+     * the beginning of the worker's block; a padded prefix of each block can
+     * then be processed further or output.
+     *
+     * All workers should call this function.
+     *
+     * @tparam Counter The (unsliced) Integer type used to compute each
+     * element's distance. It must be wide enough to hold the size of the
+     * largest partition minus one.
+     * @tparam T The type of elements in the ShardedArray.
+     * @tparam GetValid The type of @p get_valid.
+     * @param array The ShardedArray whose partitions to compact.
+     * @param get_valid A function that, given a reference to an element,
+     * returns a reference to a Bit indicating whether it is valid.
+     * @sa compact(T*, std::uint64_t, GetValid)
+     */
+    template <typename Counter, typename T, typename GetValid>
+    void compact_shards(ShardedArray<T>& array, GetValid get_valid) {
+        compact<Counter>(array.get_locals(), get_valid);
+    }
+}
+
+#endif
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dsl/fixed.hpp
+ * @brief Fixed-point DSL for writing programs for MAGE.
+ */
+
+#ifndef MAGE_DSL_FIXED_HPP_
+#define MAGE_DSL_FIXED_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include "dsl/integer.hpp"
+#include "instruction.hpp"
+#include "memprog/program.hpp"
+#include "opcode.hpp"
+
+namespace mage::dsl {
+    /**
+     * @brief A signed fixed-point number, stored in two's complement with
+     * @p frac_bits bits after the binary point.
+     *
+     * A Fixed is represented by an Integer of width int_bits + frac_bits,
+     * whose value is the fixed-point number times 2 ^ frac_bits. Addition,
+     * subtraction, and equality are therefore the same as for Integer.
+     * Multiplication uses a dedicated instruction that computes only the bits
+     * of the product that survive truncation back to int_bits + frac_bits
+     * bits (rounding toward negative infinity), which takes fewer than half
+     * the AND gates of multiplying the sign-extended Integers and slicing the
+     * result. Comparisons are signed.
+     *
+     * Like Integer, a Fixed owns its underlying memory in the MAGE-virtual
+     * address space, is not copyable, and reuses the memory of temporaries
+     * in chains of additions and subtractions.
+     *
+     * @tparam int_bits The number of bits before the binary point, including
+     * the sign bit.
+     * @tparam frac_bits The number of bits after the binary point.
+     * @tparam Placer Type of the placement algorithm used to allocate and
+     * deallocate memory in the MAGE-virtual address space.
+     * @tparam p Double pointer to the program object with access to MAGE's
+     * placement module and to the intermediate bytecode being written.
+     */
+    template <BitWidth int_bits, BitWidth frac_bits, typename Placer, Program<Placer>** p>
+    class Fixed {
+        static constexpr BitWidth bits = int_bits + frac_bits;
+        static_assert(bits > 0 && bits < 256);
+
+    public:
+        /**
+         * @brief The Integer type holding the representation of a Fixed.
+         */
+        using Raw = Integer<bits, false, Placer, p>;
+
+        /**
+         * @brief Creates an invalid Fixed, with no underlying memory.
+         */
+        Fixed() {
+        }
+
+        /**
+         * @brief Creates a Fixed, allocates fresh memory for it, and
+         * initializes it to the provided constant, rounded to the nearest
+         * representable value.
+         *
+         * @param public_constant The value to which to initialize the Fixed.
+         */
+        Fixed(double public_constant) {
+            static_assert(bits <= 64);
+
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = OpCode::PublicConstant;
+            instr.header.width = bits;
+            instr.header.flags = 0;
+            instr.constant.constant = Fixed<int_bits, frac_bits, Placer, p>::encode(public_constant);
+            this->value.v = (*p)->commit_instruction(bits);
+        }
+
+        /**
+         * @brief Creates a Fixed whose representation is the provided Integer,
+         * taking ownership of its memory.
+         *
+         * @param raw The Integer whose value is the fixed-point number times
+         * 2 ^ frac_bits.
+         */
+        explicit Fixed(Raw&& raw) : value(std::move(raw)) {
+        }
+
+        /**
+         * @brief Move-constructs a Fixed, transferring ownership of the
+         * specified Fixed's memory to this one (see Integer's move
+         * constructor).
+         *
+         * @param other The Fixed to whose value this Fixed should be set.
+         */
+        Fixed(Fixed<int_bits, frac_bits, Placer, p>&& other) = default;
+
+        /**
+         * @brief Move-assigns a Fixed, transferring ownership of the
+         * specified Fixed's memory to this one.
+         *
+         * @param other The Fixed to whose value this Fixed should be set.
+         */
+        Fixed<int_bits, frac_bits, Placer, p>& operator =(Fixed<int_bits, frac_bits, Placer, p>&& other) = default;
+
+        /**
+         * @brief Overwrites the value of this Fixed with its representation,
+         * read from the program's input.
+         *
+         * @param party The party whose input to read.
+         */
+        void mark_input(enum Party party) {
+            this->value.mark_input(party);
+        }
+
+        /**
+         * @brief Writes the representation of this Fixed to the program's
+         * output.
+         */
+        void mark_output() {
+            this->value.mark_output();
+        }
+
+        /**
+         * @brief Copies the value of the specified Fixed into this Fixed,
+         * allocating fresh memory for this Fixed, if necessary.
+         *
+         * @param other The Fixed object whose value to copy into this one.
+         */
+        void mutate(const Fixed<int_bits, frac_bits, Placer, p>& other) {
+            this->value.mutate(other.value);
+        }
+
+        /**
+         * @brief Provides the Integer holding the representation of this
+         * Fixed (its value times 2 ^ frac_bits).
+         *
+         * @return A reference to the underlying Integer.
+         */
+        const Raw& raw() const {
+            return this->value;
+        }
+
+        /**
+         * @brief Provides the Integer holding the representation of this
+         * Fixed (its value times 2 ^ frac_bits).
+         *
+         * @return A reference to the underlying Integer.
+         */
+        Raw& raw() {
+            return this->value;
+        }
+
+        /**
+         * @brief Computes the sum of this Fixed and the specified Fixed, with
+         * possible overflow.
+         *
+         * @param other The Fixed to add with this one.
+         * @return A Fixed whose value is the sum.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator +(const Fixed<int_bits, frac_bits, Placer, p>& other) const & {
+            return Fixed<int_bits, frac_bits, Placer, p>(this->value + other.value);
+        }
+
+        /**
+         * @brief Computes the sum of this temporary Fixed and the specified
+         * Fixed, storing the result in this Fixed's memory.
+         *
+         * @param other The Fixed to add with this one.
+         * @return A Fixed, owning this Fixed's memory, whose value is the sum.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator +(const Fixed<int_bits, frac_bits, Placer, p>& other) && {
+            return Fixed<int_bits, frac_bits, Placer, p>(std::move(this->value) + other.value);
+        }
+
+        /**
+         * @brief Adds the specified Fixed to this Fixed, in place.
+         *
+         * @param other The Fixed to add to this one.
+         * @return A reference to this Fixed.
+         */
+        Fixed<int_bits, frac_bits, Placer, p>& operator +=(const Fixed<int_bits, frac_bits, Placer, p>& other) {
+            this->value += other.value;
+            return *this;
+        }
+
+        /**
+         * @brief Computes the difference of this Fixed and the specified
+         * Fixed, with possible overflow.
+         *
+         * @param other The Fixed to subtract from this one.
+         * @return A Fixed whose value is the difference.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator -(const Fixed<int_bits, frac_bits, Placer, p>& other) const & {
+            return Fixed<int_bits, frac_bits, Placer, p>(this->value - other.value);
+        }
+
+        /**
+         * @brief Computes the difference of this temporary Fixed and the
+         * specified Fixed, storing the result in this Fixed's memory.
+         *
+         * @param other The Fixed to subtract from this one.
+         * @return A Fixed, owning this Fixed's memory, whose value is the
+         * difference.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator -(const Fixed<int_bits, frac_bits, Placer, p>& other) && {
+            return Fixed<int_bits, frac_bits, Placer, p>(std::move(this->value) - other.value);
+        }
+
+        /**
+         * @brief Subtracts the specified Fixed from this Fixed, in place.
+         *
+         * @param other The Fixed to subtract from this one.
+         * @return A reference to this Fixed.
+         */
+        Fixed<int_bits, frac_bits, Placer, p>& operator -=(const Fixed<int_bits, frac_bits, Placer, p>& other) {
+            this->value -= other.value;
+            return *this;
+        }
+
+        /**
+         * @brief Computes the negation of this Fixed, with possible overflow.
+         *
+         * @return A Fixed whose value is the negation of this one.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator -() const {
+            return Fixed<int_bits, frac_bits, Placer, p>((~this->value).increment());
+        }
+
+        /**
+         * @brief Computes the product of this Fixed and the specified Fixed,
+         * truncated to frac_bits bits after the binary point, with possible
+         * overflow.
+         *
+         * @param other The Fixed to multiply with this one.
+         * @return A Fixed whose value is the product.
+         */
+        Fixed<int_bits, frac_bits, Placer, p> operator *(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return Fixed<int_bits, frac_bits, Placer, p>(Raw(OpCode::FixedMultiply, pack_widths(bits, frac_bits), this->value, other.value));
+        }
+
+        /**
+         * @brief Multiplies this Fixed by the specified Fixed.
+         *
+         * @param other The Fixed by which to multiply this one.
+         * @return A reference to this Fixed.
+         */
+        Fixed<int_bits, frac_bits, Placer, p>& operator *=(const Fixed<int_bits, frac_bits, Placer, p>& other) {
+            *this = *this * other;
+            return *this;
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Fixed is less than the
+         * specified Fixed.
+         *
+         * @param other The Fixed to compare to this one.
+         * @return A bit that is 1 if this Fixed is less than @p other, and 0
+         * otherwise.
+         */
+        Bit<false, Placer, p> operator <(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return Bit<false, Placer, p>(OpCode::IntLessSigned, this->value, other.value);
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Fixed is greater than the
+         * specified Fixed.
+         *
+         * @param other The Fixed to compare to this one.
+         * @return A bit that is 1 if this Fixed is greater than @p other, and
+         * 0 otherwise.
+         */
+        Bit<false, Placer, p> operator >(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return other < *this;
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Fixed is less than or equal
+         * to the specified Fixed.
+         *
+         * @param other The Fixed to compare to this one.
+         * @return A bit that is 1 if this Fixed is less than or equal to
+         * @p other, and 0 otherwise.
+         */
+        Bit<false, Placer, p> operator <=(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return ~(other < *this);
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Fixed is greater than or
+         * equal to the specified Fixed.
+         *
+         * @param other The Fixed to compare to this one.
+         * @return A bit that is 1 if this Fixed is greater than or equal to
+         * @p other, and 0 otherwise.
+         */
+        Bit<false, Placer, p> operator >=(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return ~(*this < other);
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Fixed is equal to the
+         * specified Fixed.
+         *
+         * @param other The Fixed to compare to this one.
+         * @return A bit that is 1 if this Fixed is equal to @p other, and 0
+         * otherwise.
+         */
+        Bit<false, Placer, p> operator ==(const Fixed<int_bits, frac_bits, Placer, p>& other) const {
+            return this->value == other.value;
+        }
+
+        /**
+         * @brief Multiplexor operation. It provides either one argument or the
+         * other, depending on the value of the provided selector bit.
+         *
+         * @param selector Determines which of the two other arguments this
+         * function returns.
+         * @param arg0 The Fixed whose value to return if selector is 1.
+         * @param arg1 The Fixed whose value to return if selector is 0.
+         * @return A new Fixed with the value of either @p arg0 or @p arg1.
+         */
+        template <bool selector_sliced>
+        static Fixed<int_bits, frac_bits, Placer, p> select(const Bit<selector_sliced, Placer, p>& selector, const Fixed<int_bits, frac_bits, Placer, p>& arg0, const Fixed<int_bits, frac_bits, Placer, p>& arg1) {
+            return Fixed<int_bits, frac_bits, Placer, p>(Raw::select(selector, arg0.value, arg1.value));
+        }
+
+        /**
+         * @brief Computes the representation of a fixed-point number, rounded
+         * to the nearest representable value, as an unsigned integer of
+         * int_bits + frac_bits bits.
+         *
+         * This is useful for preparing input files and checking output files.
+         *
+         * @param number The number to represent.
+         * @return The representation of @p number.
+         */
+        static std::uint64_t encode(double number) {
+            static_assert(bits <= 64);
+            std::int64_t scaled = std::llround(std::ldexp(number, frac_bits));
+            std::uint64_t mask = (bits == 64) ? UINT64_MAX : ((UINT64_C(1) << bits) - 1);
+            return static_cast<std::uint64_t>(scaled) & mask;
+        }
+
+        /**
+         * @brief Computes the fixed-point number with the provided
+         * representation.
+         *
+         * @param raw The representation, as an unsigned integer of
+         * int_bits + frac_bits bits.
+         * @return The fixed-point number represented by @p raw.
+         */
+        static double decode(std::uint64_t raw) {
+            static_assert(bits <= 64);
+            std::int64_t scaled = static_cast<std::int64_t>(raw << (64 - bits)) >> (64 - bits);
+            return std::ldexp(static_cast<double>(scaled), -static_cast<int>(frac_bits));
+        }
+
+        /**
+         * @brief Checks if this Fixed is valid (i.e., it has backing memory
+         * allocated).
+         *
+         * @return True if this Fixed's underlying memory is allocated,
+         * otherwise false.
+         */
+        bool valid() const {
+            return this->value.valid();
+        }
+
+        /**
+         * @brief Returns this Fixed to the invalid state, deallocating its
+         * memory if it is valid.
+         */
+        void recycle() {
+            this->value.recycle();
+        }
+
+    private:
+        Raw value;
+    };
+}
+
+#endif
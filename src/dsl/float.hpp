@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dsl/float.hpp
+ * @brief Floating-point DSL for writing programs for MAGE.
+ */
+
+#ifndef MAGE_DSL_FLOAT_HPP_
+#define MAGE_DSL_FLOAT_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include "dsl/integer.hpp"
+#include "instruction.hpp"
+#include "memprog/program.hpp"
+#include "opcode.hpp"
+
+namespace mage::dsl {
+    /**
+     * @brief A floating-point number with a layout like that of IEEE 754: a
+     * sign bit, followed by a biased exponent, followed by a mantissa with an
+     * implicit leading 1.
+     *
+     * The arithmetic is simplified relative to IEEE 754 to keep the circuits
+     * small. A number whose exponent field is zero is zero (the mantissa must
+     * also be zero; there are no subnormal numbers), and results that would
+     * be subnormal are flushed to zero. There are no infinities or NaNs; the
+     * largest exponent is an ordinary exponent, and results whose magnitude
+     * is too large to represent are undefined. Results are truncated toward
+     * zero rather than rounded, so they may differ from IEEE 754 results in
+     * the last place.
+     *
+     * Addition, subtraction, multiplication, and comparison each execute as
+     * a single instruction, which the engine implements with a dedicated
+     * circuit. Like Integer, a Float owns its underlying memory in the
+     * MAGE-virtual address space and is not copyable.
+     *
+     * @tparam exponent_bits The width of the exponent field.
+     * @tparam mantissa_bits The width of the mantissa field, excluding the
+     * implicit leading 1.
+     * @tparam Placer Type of the placement algorithm used to allocate and
+     * deallocate memory in the MAGE-virtual address space.
+     * @tparam p Double pointer to the program object with access to MAGE's
+     * placement module and to the intermediate bytecode being written.
+     */
+    template <BitWidth exponent_bits, BitWidth mantissa_bits, typename Placer, Program<Placer>** p>
+    class Float {
+        static constexpr BitWidth bits = 1 + exponent_bits + mantissa_bits;
+        static_assert(exponent_bits >= 2 && exponent_bits < 16);
+        static_assert(mantissa_bits >= 1 && mantissa_bits < 256);
+        static constexpr BitWidth width_param = pack_widths(mantissa_bits, exponent_bits);
+
+    public:
+        /**
+         * @brief The Integer type holding the representation of a Float.
+         */
+        using Raw = Integer<bits, false, Placer, p>;
+
+        /**
+         * @brief Creates an invalid Float, with no underlying memory.
+         */
+        Float() {
+        }
+
+        /**
+         * @brief Creates a Float, allocates fresh memory for it, and
+         * initializes it to the provided constant (see encode()).
+         *
+         * @param public_constant The value to which to initialize the Float.
+         */
+        Float(double public_constant) {
+            static_assert(bits <= 64);
+
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = OpCode::PublicConstant;
+            instr.header.width = bits;
+            instr.header.flags = 0;
+            instr.constant.constant = Float<exponent_bits, mantissa_bits, Placer, p>::encode(public_constant);
+            this->value.v = (*p)->commit_instruction(bits);
+        }
+
+        /**
+         * @brief Creates a Float whose representation is the provided Integer,
+         * taking ownership of its memory.
+         *
+         * @param raw The Integer holding the sign, exponent, and mantissa.
+         */
+        explicit Float(Raw&& raw) : value(std::move(raw)) {
+        }
+
+        /**
+         * @brief Move-constructs a Float, transferring ownership of the
+         * specified Float's memory to this one (see Integer's move
+         * constructor).
+         *
+         * @param other The Float to whose value this Float should be set.
+         */
+        Float(Float<exponent_bits, mantissa_bits, Placer, p>&& other) = default;
+
+        /**
+         * @brief Move-assigns a Float, transferring ownership of the
+         * specified Float's memory to this one.
+         *
+         * @param other The Float to whose value this Float should be set.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p>& operator =(Float<exponent_bits, mantissa_bits, Placer, p>&& other) = default;
+
+        /**
+         * @brief Overwrites the value of this Float with its representation,
+         * read from the program's input.
+         *
+         * @param party The party whose input to read.
+         */
+        void mark_input(enum Party party) {
+            this->value.mark_input(party);
+        }
+
+        /**
+         * @brief Writes the representation of this Float to the program's
+         * output.
+         */
+        void mark_output() {
+            this->value.mark_output();
+        }
+
+        /**
+         * @brief Copies the value of the specified Float into this Float,
+         * allocating fresh memory for this Float, if necessary.
+         *
+         * @param other The Float object whose value to copy into this one.
+         */
+        void mutate(const Float<exponent_bits, mantissa_bits, Placer, p>& other) {
+            this->value.mutate(other.value);
+        }
+
+        /**
+         * @brief Provides the Integer holding the representation of this
+         * Float.
+         *
+         * @return A reference to the underlying Integer.
+         */
+        const Raw& raw() const {
+            return this->value;
+        }
+
+        /**
+         * @brief Provides the Integer holding the representation of this
+         * Float.
+         *
+         * @return A reference to the underlying Integer.
+         */
+        Raw& raw() {
+            return this->value;
+        }
+
+        /**
+         * @brief Computes the sum of this Float and the specified Float.
+         *
+         * @param other The Float to add with this one.
+         * @return A Float whose value is the sum.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p> operator +(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return Float<exponent_bits, mantissa_bits, Placer, p>(Raw(OpCode::FloatAdd, width_param, this->value, other.value));
+        }
+
+        /**
+         * @brief Adds the specified Float to this Float.
+         *
+         * @param other The Float to add to this one.
+         * @return A reference to this Float.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p>& operator +=(const Float<exponent_bits, mantissa_bits, Placer, p>& other) {
+            *this = *this + other;
+            return *this;
+        }
+
+        /**
+         * @brief Computes the difference of this Float and the specified
+         * Float.
+         *
+         * @param other The Float to subtract from this one.
+         * @return A Float whose value is the difference.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p> operator -(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return Float<exponent_bits, mantissa_bits, Placer, p>(Raw(OpCode::FloatSub, width_param, this->value, other.value));
+        }
+
+        /**
+         * @brief Subtracts the specified Float from this Float.
+         *
+         * @param other The Float to subtract from this one.
+         * @return A reference to this Float.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p>& operator -=(const Float<exponent_bits, mantissa_bits, Placer, p>& other) {
+            *this = *this - other;
+            return *this;
+        }
+
+        /**
+         * @brief Computes the negation of this Float, which flips its sign
+         * bit without any AND gates.
+         *
+         * @return A Float whose value is the negation of this one.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p> operator -() const {
+            Raw result;
+            result.mutate(this->value);
+            Bit<true, Placer, p> sign = result.template slice<1>(bits - 1);
+            sign.overwrite(OpCode::BitNOT, sign);
+            return Float<exponent_bits, mantissa_bits, Placer, p>(std::move(result));
+        }
+
+        /**
+         * @brief Computes the product of this Float and the specified Float.
+         *
+         * @param other The Float to multiply with this one.
+         * @return A Float whose value is the product.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p> operator *(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return Float<exponent_bits, mantissa_bits, Placer, p>(Raw(OpCode::FloatMultiply, width_param, this->value, other.value));
+        }
+
+        /**
+         * @brief Multiplies this Float by the specified Float.
+         *
+         * @param other The Float by which to multiply this one.
+         * @return A reference to this Float.
+         */
+        Float<exponent_bits, mantissa_bits, Placer, p>& operator *=(const Float<exponent_bits, mantissa_bits, Placer, p>& other) {
+            *this = *this * other;
+            return *this;
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Float is less than the
+         * specified Float. Positive and negative zero compare equal.
+         *
+         * @param other The Float to compare to this one.
+         * @return A bit that is 1 if this Float is less than @p other, and 0
+         * otherwise.
+         */
+        Bit<false, Placer, p> operator <(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return Bit<false, Placer, p>(OpCode::FloatLess, width_param, this->value, other.value);
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Float is greater than the
+         * specified Float.
+         *
+         * @param other The Float to compare to this one.
+         * @return A bit that is 1 if this Float is greater than @p other, and
+         * 0 otherwise.
+         */
+        Bit<false, Placer, p> operator >(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return other < *this;
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Float is less than or equal
+         * to the specified Float.
+         *
+         * @param other The Float to compare to this one.
+         * @return A bit that is 1 if this Float is less than or equal to
+         * @p other, and 0 otherwise.
+         */
+        Bit<false, Placer, p> operator <=(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return ~(other < *this);
+        }
+
+        /**
+         * @brief Computes a bit indicating if this Float is greater than or
+         * equal to the specified Float.
+         *
+         * @param other The Float to compare to this one.
+         * @return A bit that is 1 if this Float is greater than or equal to
+         * @p other, and 0 otherwise.
+         */
+        Bit<false, Placer, p> operator >=(const Float<exponent_bits, mantissa_bits, Placer, p>& other) const {
+            return ~(*this < other);
+        }
+
+        /**
+         * @brief Multiplexor operation. It provides either one argument or the
+         * other, depending on the value of the provided selector bit.
+         *
+         * @param selector Determines which of the two other arguments this
+         * function returns.
+         * @param arg0 The Float whose value to return if selector is 1.
+         * @param arg1 The Float whose value to return if selector is 0.
+         * @return A new Float with the value of either @p arg0 or @p arg1.
+         */
+        template <bool selector_sliced>
+        static Float<exponent_bits, mantissa_bits, Placer, p> select(const Bit<selector_sliced, Placer, p>& selector, const Float<exponent_bits, mantissa_bits, Placer, p>& arg0, const Float<exponent_bits, mantissa_bits, Placer, p>& arg1) {
+            return Float<exponent_bits, mantissa_bits, Placer, p>(Raw::select(selector, arg0.value, arg1.value));
+        }
+
+        /**
+         * @brief Computes the representation of a number as a Float,
+         * truncating the mantissa, flushing numbers too small to represent to
+         * zero, and saturating numbers too large to represent.
+         *
+         * This is useful for preparing input files and checking output files.
+         *
+         * @param number The number to represent.
+         * @return The representation of @p number.
+         */
+        static std::uint64_t encode(double number) {
+            static_assert(bits <= 64);
+            constexpr std::int64_t bias = (INT64_C(1) << (exponent_bits - 1)) - 1;
+            constexpr std::int64_t max_exponent = (INT64_C(1) << exponent_bits) - 1;
+            constexpr std::uint64_t mantissa_mask = (UINT64_C(1) << mantissa_bits) - 1;
+            if (number == 0.0 || std::isnan(number)) {
+                return 0;
+            }
+
+            std::uint64_t sign = std::signbit(number) ? 1 : 0;
+            int exp;
+            double fraction = std::frexp(std::fabs(number), &exp);
+            std::int64_t exponent = exp - 1 + bias;
+            std::uint64_t mantissa = static_cast<std::uint64_t>(std::ldexp(2.0 * fraction - 1.0, mantissa_bits));
+            if (exponent <= 0) {
+                return 0;
+            } else if (exponent > max_exponent) {
+                exponent = max_exponent;
+                mantissa = mantissa_mask;
+            }
+            return (sign << (bits - 1)) | (static_cast<std::uint64_t>(exponent) << mantissa_bits) | (mantissa & mantissa_mask);
+        }
+
+        /**
+         * @brief Computes the number with the provided representation as a
+         * Float.
+         *
+         * @param raw The representation, holding the sign, exponent, and
+         * mantissa.
+         * @return The number represented by @p raw.
+         */
+        static double decode(std::uint64_t raw) {
+            static_assert(bits <= 64);
+            constexpr std::int64_t bias = (INT64_C(1) << (exponent_bits - 1)) - 1;
+            constexpr std::uint64_t mantissa_mask = (UINT64_C(1) << mantissa_bits) - 1;
+            std::int64_t exponent = static_cast<std::int64_t>((raw >> mantissa_bits) & ((UINT64_C(1) << exponent_bits) - 1));
+            if (exponent == 0) {
+                return 0.0;
+            }
+            double significand = 1.0 + std::ldexp(static_cast<double>(raw & mantissa_mask), -static_cast<int>(mantissa_bits));
+            double magnitude = std::ldexp(significand, static_cast<int>(exponent - bias));
+            return ((raw >> (bits - 1)) & 0x1) != 0 ? -magnitude : magnitude;
+        }
+
+        /**
+         * @brief Checks if this Float is valid (i.e., it has backing memory
+         * allocated).
+         *
+         * @return True if this Float's underlying memory is allocated,
+         * otherwise false.
+         */
+        bool valid() const {
+            return this->value.valid();
+        }
+
+        /**
+         * @brief Returns this Float to the invalid state, deallocating its
+         * memory if it is valid.
+         */
+        void recycle() {
+            this->value.recycle();
+        }
+
+    private:
+        Raw value;
+    };
+}
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dsl/groupby.hpp
+ * @brief Utilities for oblivious group-by aggregation using MAGE's DSLs.
+ */
+
+#ifndef MAGE_DSL_GROUPBY_HPP_
+#define MAGE_DSL_GROUPBY_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "addr.hpp"
+#include "dsl/array.hpp"
+#include "dsl/integer.hpp"
+#include "dsl/sort.hpp"
+
+namespace mage::dsl {
+    /**
+     * @brief Describes the function used to aggregate the values in each
+     * group.
+     */
+    enum class Aggregate : std::uint8_t {
+        Sum,
+        Count,
+        Min,
+        Max
+    };
+
+    /**
+     * @brief An element of an array to be aggregated by group_by_aggregate()
+     * or parallel_group_by_aggregate().
+     *
+     * Before aggregation, @p key and @p value hold the input; @p last is
+     * unused. After aggregation, the array is sorted by key, @p last is 1 for
+     * the last element of each group and 0 otherwise, and @p value holds the
+     * aggregate of the values of the elements of the group up to and
+     * including this one. In particular, the elements whose @p last bit is 1
+     * hold the aggregate of each group.
+     *
+     * The comparator, buffer_send() and post_receive() functions, used when
+     * sorting, only involve @p key and @p value; swap_if() also involves
+     * @p last, so that the aggregates can be compacted (see dsl/compact.hpp).
+     *
+     * @tparam key_bits The width of the key by which elements are grouped.
+     * @tparam value_bits The width of the values and aggregates.
+     * @tparam Placer Type of the placement algorithm used to allocate and
+     * deallocate memory in the MAGE-virtual address space.
+     * @tparam p Double pointer to the program object.
+     */
+    template <BitWidth key_bits, BitWidth value_bits, typename Placer, Program<Placer>** p>
+    struct GroupByEntry {
+        using Key = Integer<key_bits, false, Placer, p>;
+        using Value = Integer<value_bits, false, Placer, p>;
+
+        Key key;
+        Value value;
+        Bit<false, Placer, p> last;
+
+        static void comparator(GroupByEntry<key_bits, value_bits, Placer, p>& arg0, GroupByEntry<key_bits, value_bits, Placer, p>& arg1) {
+            Bit<false, Placer, p> predicate = arg0.key > arg1.key;
+            Key::swap_if(predicate, arg0.key, arg1.key);
+            Value::swap_if(predicate, arg0.value, arg1.value);
+        }
+
+        template <bool predicate_sliced>
+        static void swap_if(const Bit<predicate_sliced, Placer, p>& predicate, GroupByEntry<key_bits, value_bits, Placer, p>& arg0, GroupByEntry<key_bits, value_bits, Placer, p>& arg1) {
+            Key::swap_if(predicate, arg0.key, arg1.key);
+            Value::swap_if(predicate, arg0.value, arg1.value);
+            Bit<false, Placer, p>::swap_if(predicate, arg0.last, arg1.last);
+        }
+
+        void buffer_send(WorkerID to) {
+            this->key.buffer_send(to);
+            this->value.buffer_send(to);
+        }
+
+        static void finish_send(WorkerID to) {
+            Key::finish_send(to);
+        }
+
+        void post_receive(WorkerID from) {
+            this->key.post_receive(from);
+            this->value.post_receive(from);
+        }
+
+        static void finish_receive(WorkerID from) {
+            Key::finish_receive(from);
+        }
+    };
+
+    /**
+     * @brief Combines two partial aggregates.
+     *
+     * @param op The aggregation function.
+     * @param before The aggregate of the earlier elements.
+     * @param after The aggregate of the later elements.
+     * @return The aggregate of both sets of elements.
+     */
+    template <BitWidth value_bits, typename Placer, Program<Placer>** p>
+    Integer<value_bits, false, Placer, p> combine_aggregates(Aggregate op, const Integer<value_bits, false, Placer, p>& before, const Integer<value_bits, false, Placer, p>& after) {
+        using Value = Integer<value_bits, false, Placer, p>;
+        switch (op) {
+        case Aggregate::Sum:
+        case Aggregate::Count:
+            return before + after;
+        case Aggregate::Min:
+        {
+            Bit<false, Placer, p> smaller = after < before;
+            return Value::select(smaller, after, before);
+        }
+        case Aggregate::Max:
+        {
+            Bit<false, Placer, p> larger = before < after;
+            return Value::select(larger, after, before);
+        }
+        default:
+            std::cerr << "Unknown aggregate " << static_cast<int>(op) << std::endl;
+            std::abort();
+        }
+    }
+
+    /**
+     * @brief Computes a segmented inclusive prefix scan of the values of the
+     * provided elements, using a log-depth (Hillis-Steele) network.
+     *
+     * Each step doubles the distance over which partial aggregates have been
+     * combined, so the scan has ceil(log2(length)) steps, each of which
+     * combines every element with one earlier element independently. The
+     * resulting circuit has logarithmic depth, at the cost of
+     * O(length * log(length)) operations instead of the O(length) operations
+     * of a sequential scan.
+     *
+     * @param elements A pointer to the array of elements.
+     * @param starts An array of bits, one per element, which are 1 for the
+     * elements that start a new segment. On return, each bit is the OR of
+     * the bits up to and including that position.
+     * @param length The number of elements.
+     * @param op The aggregation function.
+     */
+    template <BitWidth key_bits, BitWidth value_bits, typename Placer, Program<Placer>** p>
+    void segmented_scan(GroupByEntry<key_bits, value_bits, Placer, p>* elements, Bit<false, Placer, p>* starts, std::uint64_t length, Aggregate op) {
+        using Value = Integer<value_bits, false, Placer, p>;
+        for (std::uint64_t distance = 1; distance < length; distance <<= 1) {
+            /* Go backwards, so that elements[i - distance] is not yet updated. */
+            for (std::uint64_t i = length - 1; i >= distance; i--) {
+                Value combined = combine_aggregates(op, elements[i - distance].value, elements[i].value);
+                elements[i].value = Value::select(starts[i], elements[i].value, combined);
+                starts[i] = starts[i] | starts[i - distance];
+            }
+        }
+    }
+
+    /**
+     * @brief Computes the segment-start bits and the @p last bits of a sorted
+     * array of elements, given the keys adjacent to the array.
+     *
+     * @param elements A pointer to the sorted array of elements.
+     * @param length The number of elements (must be nonzero).
+     * @param prev_key The key of the element preceding the array, or nullptr
+     * if there is none.
+     * @param next_key The key of the element following the array, or nullptr
+     * if there is none.
+     * @return A vector of bits, one per element, which are 1 for the elements
+     * whose key differs from that of the preceding element.
+     */
+    template <BitWidth key_bits, BitWidth value_bits, typename Placer, Program<Placer>** p>
+    std::vector<Bit<false, Placer, p>> find_group_boundaries(GroupByEntry<key_bits, value_bits, Placer, p>* elements, std::uint64_t length, const Integer<key_bits, false, Placer, p>* prev_key, const Integer<key_bits, false, Placer, p>* next_key) {
+        using Flag = Bit<false, Placer, p>;
+        std::vector<Flag> starts(length);
+        if (prev_key == nullptr) {
+            starts[0] = Flag(1);
+        } else {
+            Flag same = *prev_key == elements[0].key;
+            starts[0] = ~same;
+        }
+        for (std::uint64_t i = 0; i + 1 != length; i++) {
+            Flag same = elements[i].key == elements[i + 1].key;
+            elements[i].last = ~same;
+            starts[i + 1].mutate(elements[i].last);
+        }
+        if (next_key == nullptr) {
+            elements[length - 1].last = Flag(1);
+        } else {
+            Flag same = elements[length - 1].key == *next_key;
+            elements[length - 1].last = ~same;
+        }
+        return starts;
+    }
+
+    /**
+     * @brief Obliviously groups an array stored locally by the calling worker
+     * by key, and aggregates the values in each group.
+     *
+     * The array is first sorted by key with the sorter() network, and then
+     * the values of each group are aggregated with a log-depth segmented
+     * prefix scan (see segmented_scan()). The number of groups is not
+     * revealed; the aggregates are held by the elements whose @p last bit is
+     * 1 (see GroupByEntry).
+     *
+     * @param elements A pointer to the array of elements.
+     * @param length The number of elements.
+     * @param op The aggregation function. If it is Aggregate::Count, the
+     * input values are ignored, and replaced with the size of each group.
+     */
+    template <BitWidth key_bits, BitWidth value_bits, typename Placer, Program<Placer>** p>
+    void group_by_aggregate(GroupByEntry<key_bits, value_bits, Placer, p>* elements, std::uint64_t length, Aggregate op) {
+        using Key = Integer<key_bits, false, Placer, p>;
+        using Value = Integer<value_bits, false, Placer, p>;
+        if (length == 0) {
+            return;
+        }
+        if (op == Aggregate::Count) {
+            for (std::uint64_t i = 0; i != length; i++) {
+                elements[i].value = Value(1);
+            }
+        }
+
+        sorter(elements, length);
+
+        const Key* no_key = nullptr;
+        auto starts = find_group_boundaries(elements, length, no_key, no_key);
+        segmented_scan(elements, starts.data(), length, op);
+    }
+
+    /**
+     * @brief Obliviously groups a ShardedArray by key, and aggregates the
+     * values in each group.
+     *
+     * The array is first sorted with parallel_sorter(), leaving it in the
+     * Blocked layout. Each worker then exchanges its boundary keys with its
+     * neighbors, to find the group boundaries that coincide with block
+     * boundaries, and scans its block locally (see segmented_scan()).
+     * Finally, the aggregate of the group that spans the end of each block is
+     * passed to the next worker, which combines it into the elements of its
+     * block that precede its first group boundary. This carry is passed along
+     * the workers in order, but each worker forwards its own carry before
+     * updating the rest of its block.
+     *
+     * It is expected that all workers call this function concurrently.
+     *
+     * @param array The ShardedArray to aggregate.
+     * @param op The aggregation function. If it is Aggregate::Count, the
+     * input values are ignored, and replaced with the size of each group.
+     */
+    template <BitWidth key_bits, BitWidth value_bits, typename Placer, Program<Placer>** p>
+    void parallel_group_by_aggregate(ShardedArray<GroupByEntry<key_bits, value_bits, Placer, p>>& array, Aggregate op) {
+        using Key = Integer<key_bits, false, Placer, p>;
+        using Value = Integer<value_bits, false, Placer, p>;
+        if (op == Aggregate::Count) {
+            array.for_each([](std::size_t i, auto& elem) {
+                elem.value = Value(1);
+            });
+        }
+
+        parallel_sorter(array);
+
+        /* Workers beyond the length of the array have no elements. */
+        WorkerID self = array.get_self_id();
+        WorkerID num_active = static_cast<WorkerID>(std::min<std::uint64_t>(array.get_num_proc(), array.get_total_size()));
+        if (self >= num_active) {
+            return;
+        }
+        bool has_prev = (self != 0);
+        bool has_next = (self + 1 != num_active);
+
+        auto& locals = array.get_locals();
+        std::uint64_t length = locals.size();
+
+        /* Exchange boundary keys with neighbors. */
+        Key prev_key;
+        Key next_key;
+        if (has_prev) {
+            prev_key.post_receive(self - 1);
+            locals[0].key.buffer_send(self - 1);
+            Key::finish_send(self - 1);
+        }
+        if (has_next) {
+            next_key.post_receive(self + 1);
+            locals[length - 1].key.buffer_send(self + 1);
+            Key::finish_send(self + 1);
+        }
+        if (has_prev) {
+            Key::finish_receive(self - 1);
+        }
+        if (has_next) {
+            Key::finish_receive(self + 1);
+        }
+
+        auto starts = find_group_boundaries(locals.data(), length, has_prev ? &prev_key : nullptr, has_next ? &next_key : nullptr);
+        segmented_scan(locals.data(), starts.data(), length, op);
+
+        /* Combine the carry from the previous worker, last element first. */
+        Value carry;
+        if (has_prev) {
+            carry.post_receive(self - 1);
+            Value::finish_receive(self - 1);
+            Value combined = combine_aggregates(op, carry, locals[length - 1].value);
+            locals[length - 1].value = Value::select(starts[length - 1], locals[length - 1].value, combined);
+        }
+        if (has_next) {
+            locals[length - 1].value.buffer_send(self + 1);
+            Value::finish_send(self + 1);
+        }
+        if (has_prev) {
+            for (std::uint64_t i = 0; i + 1 < length; i++) {
+                Value combined = combine_aggregates(op, carry, locals[i].value);
+                locals[i].value = Value::select(starts[i], locals[i].value, combined);
+            }
+        }
+    }
+}
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <utility>
 #include "instruction.hpp"
 #include "memprog/program.hpp"
 #include "addr.hpp"
@@ -57,8 +58,6 @@ namespace mage::dsl {
         Evaluator = 1,
     };
 
-    /* TODO: reduce placement allocations by overloading on ref-qualifiers? */
-
     /**
      * @brief A fixed-width sequence of bits, interpreted as an integer by the
      * operations supported by this class.
@@ -95,6 +94,15 @@ namespace mage::dsl {
      * arguments and storing the result in the newly allocated space in the
      * MAGE-virtual address space.
      *
+     * Operators are overloaded on the value category of their operands. If
+     * an operand is a temporary, non-sliced Integer of the same width as the
+     * result (e.g., the result of a + b in the expression a + b + c), its
+     * memory is reused for the result instead of allocating fresh memory, so
+     * chains of operations do not repeatedly allocate and deallocate memory
+     * in the MAGE-virtual address space. Compound assignment operators (e.g.,
+     * a += b) likewise write the result into the left operand's existing
+     * memory, preserving aliasing relationships as mutate() does.
+     *
      * The documentation below generally describes the effect that the
      * functions have in the program. In reality, when the functions below are
      * executed, they emit instructions that perform the described actions.
@@ -118,6 +126,12 @@ namespace mage::dsl {
         template <BitWidth other_bits, bool other_sliced, typename OtherPlacer, Program<OtherPlacer>** other_p>
         friend class Integer;
 
+        template <BitWidth int_bits, BitWidth frac_bits, typename FixedPlacer, Program<FixedPlacer>** fixed_p>
+        friend class Fixed;
+
+        template <BitWidth exponent_bits, BitWidth mantissa_bits, typename FloatPlacer, Program<FloatPlacer>** float_p>
+        friend class Float;
+
         static_assert(bits > 0);
 
     public:
@@ -410,10 +424,60 @@ namespace mage::dsl {
          * specified Integer.
          */
         template <bool other_sliced>
-        Integer<bits, false, Placer, p> operator +(const Integer<bits, other_sliced, Placer, p>& other) const {
+        Integer<bits, false, Placer, p> operator +(const Integer<bits, other_sliced, Placer, p>& other) const & {
             return Integer<bits, false, Placer, p>(OpCode::IntAdd, *this, other);
         }
 
+        /**
+         * @brief Computes the sum of this temporary Integer and the
+         * specified Integer, storing the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        template <bool other_sliced>
+        Integer<bits, false, Placer, p> operator +(const Integer<bits, other_sliced, Placer, p>& other) && {
+            return std::move(*this).reuse(OpCode::IntAdd, *this, other);
+        }
+
+        /**
+         * @brief Computes the sum of this Integer and the specified
+         * temporary Integer, storing the result in the temporary's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning the memory of @p other, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator +(Integer<bits, false, Placer, p>&& other) const & {
+            return std::move(other).reuse(OpCode::IntAdd, *this, other);
+        }
+
+        /**
+         * @brief Computes the sum of two temporary Integers, storing
+         * the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator +(Integer<bits, false, Placer, p>&& other) && {
+            return std::move(*this).reuse(OpCode::IntAdd, *this, other);
+        }
+
+        /**
+         * @brief Sets this Integer to the sum of itself and the
+         * specified Integer, writing to its existing memory.
+         *
+         * @param other The second operand.
+         * @return A reference to this Integer.
+         */
+        template <bool other_sliced>
+        Integer<bits, sliced, Placer, p>& operator +=(const Integer<bits, other_sliced, Placer, p>& other) {
+            this->overwrite(OpCode::IntAdd, *this, other);
+            return *this;
+        }
+
         /**
          * @brief Computes the sum of this Integer and the specified Integer,
          * without overflow; the output carry bit is preserved in the result's
@@ -449,28 +513,48 @@ namespace mage::dsl {
          * @return An Integer whose value is one more than this Integer,
          * with possible overflow.
          */
-        Integer<bits, false, Placer, p> increment() {
+        Integer<bits, false, Placer, p> increment() const & {
             return Integer<bits, false, Placer, p>(OpCode::IntIncrement, *this);
         }
 
-        /*
-        These operations do not appear to be correctly implemented. They don't
-        increment in place; they create a new integer that is incremented and
-        reassign the address. I suppose that's fine, but what if the integer
-        is sliced (meaning someone else can observer the underlying virtual
-        address)? It's not clear what the semantics should be.
+        /**
+         * @brief Computes the result of (*this) + Integer<...>(1) for this
+         * temporary Integer, storing the result in its memory.
+         *
+         * @return An Integer, owning this Integer's memory, whose value is
+         * one more than this Integer, with possible overflow.
+         */
+        Integer<bits, false, Placer, p> increment() && {
+            return std::move(*this).reuse(OpCode::IntIncrement, *this);
+        }
 
-        Integer<bits, Placer, p>& operator ++() {
-            *this = this->increment();
-            return this;
+        /**
+         * @brief Increments this Integer in place, with possible overflow.
+         *
+         * The result is written to this Integer's existing memory, so any
+         * slices of this Integer (or the Integer of which it is a slice)
+         * observe the new value, as with mutate().
+         *
+         * @return A reference to this Integer.
+         */
+        Integer<bits, sliced, Placer, p>& operator ++() {
+            this->overwrite(OpCode::IntIncrement, *this);
+            return *this;
         }
 
-        Integer<bits, Placer, p> operator ++(int) {
-            Integer<bits, Placer, p> old = *this;
-            *this = this->increment();
+        /**
+         * @brief Increments this Integer in place, with possible overflow,
+         * and returns a copy of its previous value.
+         *
+         * @return A new Integer whose value is that of this Integer before
+         * it was incremented.
+         */
+        Integer<bits, false, Placer, p> operator ++(int) {
+            Integer<bits, false, Placer, p> old;
+            old.mutate(*this);
+            ++(*this);
             return old;
         }
-        */
 
         /**
          * @brief Computes the difference of this Integer and the specified
@@ -488,10 +572,60 @@ namespace mage::dsl {
          * and the specified Integer.
          */
         template <bool other_sliced>
-        Integer<bits, false, Placer, p> operator -(const Integer<bits, other_sliced, Placer, p>& other) const {
+        Integer<bits, false, Placer, p> operator -(const Integer<bits, other_sliced, Placer, p>& other) const & {
             return Integer<bits, false, Placer, p>(OpCode::IntSub, *this, other);
         }
 
+        /**
+         * @brief Computes the difference of this temporary Integer and the
+         * specified Integer, storing the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        template <bool other_sliced>
+        Integer<bits, false, Placer, p> operator -(const Integer<bits, other_sliced, Placer, p>& other) && {
+            return std::move(*this).reuse(OpCode::IntSub, *this, other);
+        }
+
+        /**
+         * @brief Computes the difference of this Integer and the specified
+         * temporary Integer, storing the result in the temporary's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning the memory of @p other, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator -(Integer<bits, false, Placer, p>&& other) const & {
+            return std::move(other).reuse(OpCode::IntSub, *this, other);
+        }
+
+        /**
+         * @brief Computes the difference of two temporary Integers, storing
+         * the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator -(Integer<bits, false, Placer, p>&& other) && {
+            return std::move(*this).reuse(OpCode::IntSub, *this, other);
+        }
+
+        /**
+         * @brief Sets this Integer to the difference of itself and the
+         * specified Integer, writing to its existing memory.
+         *
+         * @param other The second operand.
+         * @return A reference to this Integer.
+         */
+        template <bool other_sliced>
+        Integer<bits, sliced, Placer, p>& operator -=(const Integer<bits, other_sliced, Placer, p>& other) {
+            this->overwrite(OpCode::IntSub, *this, other);
+            return *this;
+        }
+
         /**
          * @brief Computes the result of (*this) - Integer<...>(1).
          *
@@ -506,24 +640,46 @@ namespace mage::dsl {
          * @return An Integer whose value is one less than this Integer,
          * with possible overflow.
          */
-        Integer<bits, false, Placer, p> decrement() {
+        Integer<bits, false, Placer, p> decrement() const & {
             return Integer<bits, false, Placer, p>(OpCode::IntDecrement, *this);
         }
 
-        /*
-        Same problem as prefix/postfix increment
+        /**
+         * @brief Computes the result of (*this) - Integer<...>(1) for this
+         * temporary Integer, storing the result in its memory.
+         *
+         * @return An Integer, owning this Integer's memory, whose value is
+         * one less than this Integer, with possible overflow.
+         */
+        Integer<bits, false, Placer, p> decrement() && {
+            return std::move(*this).reuse(OpCode::IntDecrement, *this);
+        }
 
-        Integer<bits, Placer, p>& operator --() {
-            *this = this->decrement();
-            return this;
+        /**
+         * @brief Decrements this Integer in place, with possible overflow.
+         *
+         * @sa operator++()
+         *
+         * @return A reference to this Integer.
+         */
+        Integer<bits, sliced, Placer, p>& operator --() {
+            this->overwrite(OpCode::IntDecrement, *this);
+            return *this;
         }
 
-        Integer<bits, Placer, p> operator --(int) {
-            Integer<bits, Placer, p> old = *this;
-            *this = this->decrement();
+        /**
+         * @brief Decrements this Integer in place, with possible overflow,
+         * and returns a copy of its previous value.
+         *
+         * @return A new Integer whose value is that of this Integer before
+         * it was decremented.
+         */
+        Integer<bits, false, Placer, p> operator --(int) {
+            Integer<bits, false, Placer, p> old;
+            old.mutate(*this);
+            --(*this);
             return old;
         }
-        */
 
         /**
          * @brief Computes the product of this Integer and the specified
@@ -638,10 +794,21 @@ namespace mage::dsl {
          * @return A new Integer whose value is the bitwise negation of this
          * one.
          */
-        Integer<bits, false, Placer, p> operator ~() const {
+        Integer<bits, false, Placer, p> operator ~() const & {
             return Integer<bits, false, Placer, p>(OpCode::BitNOT, *this);
         }
 
+        /**
+         * @brief Computes the bitwise negation of this temporary Integer,
+         * storing the result in its memory.
+         *
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the bitwise negation of this one.
+         */
+        Integer<bits, false, Placer, p> operator ~() && {
+            return std::move(*this).reuse(OpCode::BitNOT, *this);
+        }
+
         /**
          * @brief Computes the bitwise AND of this Integer and the specified
          * Integer.
@@ -651,10 +818,60 @@ namespace mage::dsl {
          * Integer and the specified Integer.
          */
         template <bool other_sliced>
-        Integer<bits, false, Placer, p> operator &(const Integer<bits, other_sliced, Placer, p>& other) const {
+        Integer<bits, false, Placer, p> operator &(const Integer<bits, other_sliced, Placer, p>& other) const & {
             return Integer<bits, false, Placer, p>(OpCode::BitAND, *this, other);
         }
 
+        /**
+         * @brief Computes the bitwise AND of this temporary Integer and the
+         * specified Integer, storing the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        template <bool other_sliced>
+        Integer<bits, false, Placer, p> operator &(const Integer<bits, other_sliced, Placer, p>& other) && {
+            return std::move(*this).reuse(OpCode::BitAND, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise AND of this Integer and the specified
+         * temporary Integer, storing the result in the temporary's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning the memory of @p other, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator &(Integer<bits, false, Placer, p>&& other) const & {
+            return std::move(other).reuse(OpCode::BitAND, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise AND of two temporary Integers, storing
+         * the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator &(Integer<bits, false, Placer, p>&& other) && {
+            return std::move(*this).reuse(OpCode::BitAND, *this, other);
+        }
+
+        /**
+         * @brief Sets this Integer to the bitwise AND of itself and the
+         * specified Integer, writing to its existing memory.
+         *
+         * @param other The second operand.
+         * @return A reference to this Integer.
+         */
+        template <bool other_sliced>
+        Integer<bits, sliced, Placer, p>& operator &=(const Integer<bits, other_sliced, Placer, p>& other) {
+            this->overwrite(OpCode::BitAND, *this, other);
+            return *this;
+        }
+
         /**
          * @brief Computes the bitwise OR of this Integer and the specified
          * Integer.
@@ -664,10 +881,60 @@ namespace mage::dsl {
          * Integer and the specified Integer.
          */
         template <bool other_sliced>
-        Integer<bits, false, Placer, p> operator |(const Integer<bits, other_sliced, Placer, p>& other) const {
+        Integer<bits, false, Placer, p> operator |(const Integer<bits, other_sliced, Placer, p>& other) const & {
             return Integer<bits, false, Placer, p>(OpCode::BitOR, *this, other);
         }
 
+        /**
+         * @brief Computes the bitwise OR of this temporary Integer and the
+         * specified Integer, storing the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        template <bool other_sliced>
+        Integer<bits, false, Placer, p> operator |(const Integer<bits, other_sliced, Placer, p>& other) && {
+            return std::move(*this).reuse(OpCode::BitOR, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise OR of this Integer and the specified
+         * temporary Integer, storing the result in the temporary's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning the memory of @p other, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator |(Integer<bits, false, Placer, p>&& other) const & {
+            return std::move(other).reuse(OpCode::BitOR, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise OR of two temporary Integers, storing
+         * the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator |(Integer<bits, false, Placer, p>&& other) && {
+            return std::move(*this).reuse(OpCode::BitOR, *this, other);
+        }
+
+        /**
+         * @brief Sets this Integer to the bitwise OR of itself and the
+         * specified Integer, writing to its existing memory.
+         *
+         * @param other The second operand.
+         * @return A reference to this Integer.
+         */
+        template <bool other_sliced>
+        Integer<bits, sliced, Placer, p>& operator |=(const Integer<bits, other_sliced, Placer, p>& other) {
+            this->overwrite(OpCode::BitOR, *this, other);
+            return *this;
+        }
+
         /**
          * @brief Computes the bitwise XOR of this Integer and the specified
          * Integer.
@@ -677,10 +944,60 @@ namespace mage::dsl {
          * Integer and the specified Integer.
          */
         template <bool other_sliced>
-        Integer<bits, false, Placer, p> operator ^(const Integer<bits, other_sliced, Placer, p>& other) const {
+        Integer<bits, false, Placer, p> operator ^(const Integer<bits, other_sliced, Placer, p>& other) const & {
             return Integer<bits, false, Placer, p>(OpCode::BitXOR, *this, other);
         }
 
+        /**
+         * @brief Computes the bitwise XOR of this temporary Integer and the
+         * specified Integer, storing the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        template <bool other_sliced>
+        Integer<bits, false, Placer, p> operator ^(const Integer<bits, other_sliced, Placer, p>& other) && {
+            return std::move(*this).reuse(OpCode::BitXOR, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise XOR of this Integer and the specified
+         * temporary Integer, storing the result in the temporary's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning the memory of @p other, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator ^(Integer<bits, false, Placer, p>&& other) const & {
+            return std::move(other).reuse(OpCode::BitXOR, *this, other);
+        }
+
+        /**
+         * @brief Computes the bitwise XOR of two temporary Integers, storing
+         * the result in this Integer's memory.
+         *
+         * @param other The second operand.
+         * @return An Integer, owning this Integer's memory, whose value is
+         * the result.
+         */
+        Integer<bits, false, Placer, p> operator ^(Integer<bits, false, Placer, p>&& other) && {
+            return std::move(*this).reuse(OpCode::BitXOR, *this, other);
+        }
+
+        /**
+         * @brief Sets this Integer to the bitwise XOR of itself and the
+         * specified Integer, writing to its existing memory.
+         *
+         * @param other The second operand.
+         * @return A reference to this Integer.
+         */
+        template <bool other_sliced>
+        Integer<bits, sliced, Placer, p>& operator ^=(const Integer<bits, other_sliced, Placer, p>& other) {
+            this->overwrite(OpCode::BitXOR, *this, other);
+            return *this;
+        }
+
         /**
          * @brief Provides a slice of this Integer, which refers to the
          * same underlying memory as this Integer.
@@ -743,9 +1060,9 @@ namespace mage::dsl {
         /**
          * @brief Swaps the values of @p arg0 and @p arg1 if @p predicate is 1.
          *
-         * This is implemented by composing existing operator and assigning to
-         * the provided Integers. So the allocated memory for @p arg0 and
-         * @p arg1 may change, invalidated any prior slices of those Integers.
+         * This is implemented by composing existing operators and updating
+         * the provided Integers in place, so prior slices of @p arg0 and
+         * @p arg1 remain valid and observe the swapped values.
          *
          * @param predicate Determines whether the values of the two other
          * arguments are swapped.
@@ -758,8 +1075,8 @@ namespace mage::dsl {
         static void swap_if(const Bit<predicate_sliced, Placer, p>& predicate, Integer<bits, false, Placer, p>& arg0, Integer<bits, false, Placer, p>& arg1) {
             assert(arg0.valid() && arg1.valid());
             Integer<bits, false, Placer, p> mask = Integer<bits, false, Placer, p>::select(predicate, arg0, arg1) ^ arg1;
-            arg0 = arg0 ^ mask;
-            arg1 = arg1 ^ mask;
+            arg0 ^= mask;
+            arg1 ^= mask;
         }
 
         /**
@@ -767,9 +1084,8 @@ namespace mage::dsl {
          * that arg0's value is less than or equal to arg1's value after the
          * operation.
          *
-         * This is implemented using swap_if(), so the allocated memory for
-         * @p arg0 and @p arg1 may change, invalidated any prior slices of
-         * those Integers.
+         * This is implemented using swap_if(), so @p arg0 and @p arg1 are
+         * updated in place.
          *
          * @param arg0 A reference to the first Integer whose value to compare
          * and potentially swap.
@@ -824,11 +1140,20 @@ namespace mage::dsl {
         }
 
         template <BitWidth arg_bits, bool arg0_sliced, bool arg1_sliced>
-        Integer(OpCode operation, const Integer<arg_bits, arg0_sliced, Placer, p>& arg0, const Integer<arg_bits, arg1_sliced, Placer, p>& arg1) {
+        Integer(OpCode operation, const Integer<arg_bits, arg0_sliced, Placer, p>& arg0, const Integer<arg_bits, arg1_sliced, Placer, p>& arg1)
+            : Integer(operation, arg_bits, arg0, arg1) {
+        }
+
+        /*
+         * Used for operations whose instruction width field describes more
+         * than the width of the operands (see mage::pack_widths()).
+         */
+        template <BitWidth arg_bits, bool arg0_sliced, bool arg1_sliced>
+        Integer(OpCode operation, BitWidth width, const Integer<arg_bits, arg0_sliced, Placer, p>& arg0, const Integer<arg_bits, arg1_sliced, Placer, p>& arg1) {
             static_assert(!sliced);
             Instruction& instr = (*p)->instruction();
             instr.header.operation = operation;
-            instr.header.width = arg_bits;
+            instr.header.width = width;
             instr.header.flags = 0;
             instr.two_args.input1 = arg0.v;
             instr.two_args.input2 = arg1.v;
@@ -852,6 +1177,51 @@ namespace mage::dsl {
             static_assert(sliced);
         }
 
+        /*
+         * Emits an instruction that writes its output to this Integer's
+         * existing memory. The engines compute each operation supported here
+         * so that the output may alias the inputs.
+         */
+        template <BitWidth arg0_bits, bool arg0_sliced>
+        void overwrite(OpCode operation, const Integer<arg0_bits, arg0_sliced, Placer, p>& arg0) {
+            assert(this->valid());
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = operation;
+            instr.header.width = arg0_bits;
+            instr.header.flags = 0;
+            instr.header.output = this->v;
+            instr.one_arg.input1 = arg0.v;
+            (*p)->commit_instruction(0);
+        }
+
+        template <BitWidth arg_bits, bool arg0_sliced, bool arg1_sliced>
+        void overwrite(OpCode operation, const Integer<arg_bits, arg0_sliced, Placer, p>& arg0, const Integer<arg_bits, arg1_sliced, Placer, p>& arg1) {
+            assert(this->valid());
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = operation;
+            instr.header.width = arg_bits;
+            instr.header.flags = 0;
+            instr.header.output = this->v;
+            instr.two_args.input1 = arg0.v;
+            instr.two_args.input2 = arg1.v;
+            (*p)->commit_instruction(0);
+        }
+
+        /*
+         * Computes the result of an operation into this temporary Integer's
+         * memory and transfers that memory to the result. A slice does not
+         * own its memory, so a fresh Integer is allocated for it instead.
+         */
+        template <typename... Args>
+        Integer<bits, false, Placer, p> reuse(OpCode operation, const Args&... args) && {
+            if constexpr (sliced) {
+                return Integer<bits, false, Placer, p>(operation, args...);
+            } else {
+                this->overwrite(operation, args...);
+                return std::move(*this);
+            }
+        }
+
         /**
          * @brief Pointer to the underlying data in the MAGE-virtual address
          * space.
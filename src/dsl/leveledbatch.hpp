@@ -135,6 +135,25 @@ namespace mage::dsl {
             return *this;
         }
 
+        /**
+         * @brief Allocates fresh memory for this LeveledPlaintextBatch and
+         * reads its value, already encoded at this batch's level, from the
+         * program's plaintext input.
+         *
+         * This moves the cost of encoding public data (e.g., a database)
+         * offline, so that it can be reused across executions. The
+         * plaintext input file can be produced with ckks_utils encode_file.
+         */
+        void mark_input() {
+            this->recycle();
+
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = OpCode::Input;
+            instr.header.width = level;
+            instr.header.flags = FlagPlaintextInput;
+            this->v = (*p)->commit_instruction(this->get_size());
+        }
+
     private:
         void recycle() {
             if (this->v != invalid_vaddr) {
@@ -538,6 +557,55 @@ namespace mage::dsl {
             return LeveledBatch<level, false, Placer, p>(OpCode::MultiplyPlaintextRaw, *this, plaintext);
         }
 
+        /**
+         * @brief Computes the sum of the element-wise products of two arrays
+         * of LeveledBatches, without normalizing the result.
+         *
+         * The result is the same as computing each product using
+         * multiply_without_normalizing() and adding the products, but the
+         * products are accumulated by the engine in a single register outside
+         * of MAGE-virtual memory. Only the final sum is written to memory, so
+         * no temporary storage is allocated for the intermediate products and
+         * partial sums.
+         *
+         * @param vector_a A pointer to the array of first factors.
+         * @param vector_b A pointer to the array of second factors.
+         * @param length The number of products to sum (must be nonzero).
+         * @return A new LeveledBatch containing the sum of the element-wise
+         * products.
+         */
+        static LeveledBatch<level, false, Placer, p> dot_product_without_normalizing(const LeveledBatch<level, true, Placer, p>* vector_a, const LeveledBatch<level, true, Placer, p>* vector_b, std::size_t length) {
+            static_assert(level > 0);
+            static_assert(normalized);
+            for (std::size_t i = 0; i != length; i++) {
+                LeveledBatch<level, normalized, Placer, p>::accumulate_product(OpCode::MultiplyAccumulateRaw, vector_a[i], vector_b[i]);
+            }
+            return LeveledBatch<level, false, Placer, p>::store_accumulator(length);
+        }
+
+        /**
+         * @brief Computes the sum of the element-wise products of an array of
+         * LeveledBatches and an array of batches of plaintexts, without
+         * normalizing the result.
+         *
+         * As above, the products are accumulated outside of MAGE-virtual
+         * memory and only the final sum is written to memory.
+         *
+         * @param vector_a A pointer to the array of ciphertext factors.
+         * @param vector_b A pointer to the array of plaintext factors.
+         * @param length The number of products to sum (must be nonzero).
+         * @return A new LeveledBatch containing the sum of the element-wise
+         * products.
+         */
+        static LeveledBatch<level, false, Placer, p> dot_product_without_normalizing(const LeveledBatch<level, true, Placer, p>* vector_a, const LeveledPlaintextBatch<level, Placer, p>* vector_b, std::size_t length) {
+            static_assert(level > 0);
+            static_assert(normalized);
+            for (std::size_t i = 0; i != length; i++) {
+                LeveledBatch<level, normalized, Placer, p>::accumulate_product(OpCode::MultiplyPlaintextAccumulateRaw, vector_a[i], vector_b[i]);
+            }
+            return LeveledBatch<level, false, Placer, p>::store_accumulator(length);
+        }
+
         /**
          * @brief Converts a non-normalized LeveledBatch into a normalized one,
          * decreasing its level by 1.
@@ -632,6 +700,30 @@ namespace mage::dsl {
             this->v = (*p)->commit_instruction(this->get_size());
         }
 
+        template <typename Arg1>
+        static void accumulate_product(OpCode operation, const LeveledBatch<level, true, Placer, p>& arg0, const Arg1& arg1) {
+            /* The output field names the first factor; nothing is written. */
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = operation;
+            instr.header.width = level;
+            instr.header.flags = 0;
+            instr.header.output = arg0.v;
+            instr.one_arg.input1 = arg1.v;
+            (*p)->commit_instruction(0);
+        }
+
+        static LeveledBatch<level, normalized, Placer, p> store_accumulator(std::size_t num_products) {
+            static_assert(!normalized);
+            assert(num_products != 0);
+            LeveledBatch<level, normalized, Placer, p> result;
+            Instruction& instr = (*p)->instruction();
+            instr.header.operation = OpCode::StoreAccumulator;
+            instr.header.width = level;
+            instr.header.flags = FlagNotNormalized;
+            result.v = (*p)->commit_instruction(result.get_size());
+            return result;
+        }
+
         /**
          * @brief Pointer to the underlying data in the MAGE-virtual address
          * space.
@@ -99,6 +99,13 @@ namespace mage::dsl {
          * arrays that are each partitioned over multiple workers into a union
          * of local cross products, one at each worker.
          *
+         * The workers are arranged in a grid whose dimensions are the two
+         * factors of the number of workers closest to its square root, so
+         * every worker is used even if the number of workers is not a power
+         * of two (in the worst case, a prime number of workers, each worker
+         * gets all of B). The arrays need not divide evenly among the
+         * workers.
+         *
          * It is expected that all workers will call this function
          * concurrently.
          *
@@ -118,10 +125,8 @@ namespace mage::dsl {
              * each worker has one partition.
              */
             std::uint32_t num_partitions = this->num_proc;
-            std::uint32_t partition_size_a = a.get_total_size() / num_partitions;
-            assert(a.get_total_size() % num_partitions == 0); // for now. This shouldn't be too hard to fix.
-            std::uint32_t partition_size_b = b.get_total_size() / num_partitions;
-            assert(b.get_total_size() % num_partitions == 0); // for now. This shouldn't be too hard to fix.
+            std::uint32_t max_partition_size_a = a.get_local_size(0);
+            std::uint32_t max_partition_size_b = b.get_local_size(0);
 
             /*
              * After the shuffle, each worker has one portion of each array,
@@ -129,21 +134,15 @@ namespace mage::dsl {
              * is assigned to multiple workers.
              */
 
-            assert(util::is_power_of_two(this->num_proc));
-            std::uint8_t log_num_workers = util::log_base_2(this->num_proc);
-            std::uint32_t num_portions_a = UINT32_C(1) << ((log_num_workers / 2) + (log_num_workers % 2));
-            std::uint32_t num_portions_b = UINT32_C(1) << (log_num_workers / 2);
+            std::uint32_t num_portions_b = 1;
+            for (std::uint32_t d = 1; d * d <= num_partitions; d++) {
+                if (num_partitions % d == 0) {
+                    num_portions_b = d;
+                }
+            }
+            std::uint32_t num_portions_a = num_partitions / num_portions_b;
             std::uint32_t partitions_per_portion_a = num_partitions / num_portions_a;
             std::uint32_t partitions_per_portion_b = num_partitions / num_portions_b;
-            std::uint32_t portion_size_a = a.get_total_size() / num_portions_a;
-            std::uint32_t portion_size_b = a.get_total_size() / num_portions_b;
-
-            /*
-             * These variables store the portion of each array assigned to this
-             * worker.
-             */
-            std::vector<T> my_a(portion_size_a);
-            std::vector<T> my_b(portion_size_b);
 
             /* Figure out who has the partitions I need. */
             std::uint32_t my_target_portion_a = this->self_id / num_portions_b;
@@ -157,24 +156,44 @@ namespace mage::dsl {
             WorkerID first_needing_my_partition_a = my_current_portion_a * num_portions_b; // contiguous
             WorkerID first_needing_my_partition_b = my_current_portion_b; // strided by num_portions_b
 
+            /*
+             * These variables store the portion of each array assigned to this
+             * worker. The partitions in each portion are stored in order.
+             */
+            std::vector<std::uint32_t> partition_start_a(partitions_per_portion_a + 1, 0);
+            for (WorkerID from_delta = 0; from_delta != partitions_per_portion_a; from_delta++) {
+                partition_start_a[from_delta + 1] = partition_start_a[from_delta] + a.get_local_size(first_needed_partition_owner_a + from_delta);
+            }
+            std::vector<std::uint32_t> partition_start_b(partitions_per_portion_b + 1, 0);
+            for (WorkerID from_delta = 0; from_delta != partitions_per_portion_b; from_delta++) {
+                partition_start_b[from_delta + 1] = partition_start_b[from_delta] + b.get_local_size(first_needed_partition_owner_b + from_delta);
+            }
+            std::vector<T> my_a(partition_start_a[partitions_per_portion_a]);
+            std::vector<T> my_b(partition_start_b[partitions_per_portion_b]);
+
             /* Shuffle array A. */
             std::vector<T>& a_locals = a.get_locals();
-            for (std::uint32_t i = 0; i != partition_size_a; i++) {
-                for (WorkerID to_delta = 0; to_delta != num_portions_b; to_delta++) {
-                    WorkerID to = first_needing_my_partition_a + to_delta;
-                    // std::cout << "A: " << i << " -> " << to << std::endl;
-                    if (to != this->self_id) {
-                        a_locals[i].buffer_send(to);
+            for (std::uint32_t i = 0; i != max_partition_size_a; i++) {
+                if (i < a_locals.size()) {
+                    for (WorkerID to_delta = 0; to_delta != num_portions_b; to_delta++) {
+                        WorkerID to = first_needing_my_partition_a + to_delta;
+                        // std::cout << "A: " << i << " -> " << to << std::endl;
+                        if (to != this->self_id) {
+                            a_locals[i].buffer_send(to);
+                        }
+                        /*
+                         * If to == this->self_id, we handle it in the next loop.
+                         * We don't std::move it now, since we still need
+                         * a_locals[i] to send to the other workers.
+                         */
                     }
-                    /*
-                     * If to == this->self_id, we handle it in the next loop.
-                     * We don't std::move it now, since we still need
-                     * b_locals[i] to send to the other workers.
-                     */
                 }
                 for (WorkerID from_delta = 0; from_delta != partitions_per_portion_a; from_delta++) {
                     WorkerID from = first_needed_partition_owner_a + from_delta;
-                    std::uint32_t into = from_delta * partition_size_a + i;
+                    std::uint32_t into = partition_start_a[from_delta] + i;
+                    if (into >= partition_start_a[from_delta + 1]) {
+                        continue;
+                    }
                     // std::cout << "A: " << into << " <- " << from << std::endl;
                     if (from == this->self_id) {
                         my_a[into] = std::move(a_locals[i]);
@@ -186,21 +205,26 @@ namespace mage::dsl {
 
             /* Shuffle array B. */
             std::vector<T>& b_locals = b.get_locals();
-            for (std::uint32_t i = 0; i != partition_size_b; i++) {
-                for (WorkerID to = first_needing_my_partition_b; to < this->num_proc; to += num_portions_b) {
-                    // std::cout << "B: " << i << " -> " << to << std::endl;
-                    if (to != this->self_id) {
-                        b_locals[i].buffer_send(to);
+            for (std::uint32_t i = 0; i != max_partition_size_b; i++) {
+                if (i < b_locals.size()) {
+                    for (WorkerID to = first_needing_my_partition_b; to < this->num_proc; to += num_portions_b) {
+                        // std::cout << "B: " << i << " -> " << to << std::endl;
+                        if (to != this->self_id) {
+                            b_locals[i].buffer_send(to);
+                        }
+                        /*
+                         * If to == this->self_id, we handle it in the next loop.
+                         * We don't std::move it now, since we still need
+                         * b_locals[i] to send to the other workers.
+                         */
                     }
-                    /*
-                     * If to == this->self_id, we handle it in the next loop.
-                     * We don't std::move it now, since we still need
-                     * b_locals[i] to send to the other workers.
-                     */
                 }
                 for (WorkerID from_delta = 0; from_delta != partitions_per_portion_b; from_delta++) {
                     WorkerID from = first_needed_partition_owner_b + from_delta;
-                    std::uint32_t into = from_delta * partition_size_b + i;
+                    std::uint32_t into = partition_start_b[from_delta] + i;
+                    if (into >= partition_start_b[from_delta + 1]) {
+                        continue;
+                    }
                     // std::cout << "B: " << into << " <- " << from << std::endl;
                     if (from == this->self_id) {
                         my_b[into] = std::move(b_locals[i]);
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dsl/shuffle.hpp
+ * @brief Utilities for obliviously permuting arrays using MAGE's DSLs.
+ *
+ * An oblivious shuffle is a building block for "shuffle-then-sort" and other
+ * shuffle-then-reveal algorithms: once an array has been permuted by a
+ * permutation unknown to one party, the results of comparisons between its
+ * elements leak only the sorted order, not the original positions. Note,
+ * however, that MAGE plans the full sequence of instructions before the
+ * computation starts, so a sort whose control flow depends on revealed
+ * comparison results cannot be expressed in MAGE's DSLs; for sorting, use
+ * the networks in dsl/sort.hpp.
+ */
+
+#ifndef MAGE_DSL_SHUFFLE_HPP_
+#define MAGE_DSL_SHUFFLE_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "dsl/array.hpp"
+
+namespace mage::dsl {
+    /**
+     * @brief Enumerates the switches of a Waksman permutation network on the
+     * elements at indices [first, first + length).
+     *
+     * The network is defined recursively, like a Benes network: a column of
+     * switches exchanges each element in the lower half with the
+     * corresponding element in the upper half, each half is permuted by a
+     * smaller network, and a final column of switches again pairs up the two
+     * halves. If the length is odd, the last element has no partner and goes
+     * directly to the upper (larger) half. Following Waksman, one switch of
+     * the final column is omitted if the length is even. For any permutation,
+     * there is a setting of the switches that realizes it; the network has
+     * roughly length * (log2(length) - 1) switches.
+     *
+     * This function does not emit any instructions; it can also be used
+     * outside of a DSL program, for example to compute the permutation that
+     * a particular assignment of switch bits realizes.
+     *
+     * @tparam F The type of @p f.
+     * @param first The index of the first element of the network.
+     * @param length The number of elements permuted by the network.
+     * @param f A function called with the two indices (lower first) of each
+     * switch, in the order in which switches must be applied.
+     */
+    template <typename F>
+    void waksman_network(std::uint64_t first, std::uint64_t length, F& f) {
+        if (length == 0 || length == 1) {
+            return;
+        }
+
+        std::uint64_t half = length >> 1;
+        for (std::uint64_t i = 0; i != half; i++) {
+            f(first + i, first + i + half);
+        }
+        waksman_network(first, half, f);
+        waksman_network(first + half, length - half, f);
+        if (length != 2) {
+            std::uint64_t num_output_switches = ((length & 0x1) == 0) ? half - 1 : half;
+            for (std::uint64_t i = 0; i != num_output_switches; i++) {
+                f(first + i, first + i + half);
+            }
+        }
+    }
+
+    /**
+     * @brief Obliviously permutes an array stored locally by the calling
+     * worker, using a Waksman permutation network whose switch bits are
+     * secret.
+     *
+     * Typically, the switch bits are the input of one party, who chooses
+     * them by routing a random permutation through the network. The
+     * permutation is then hidden from any party that does not learn the
+     * switch bits.
+     *
+     * @tparam T The type of elements in the array. It must support a static
+     * swap_if function similar to the one in the Integer<...> class.
+     * @tparam GetSwitch The type of @p get_switch.
+     * @param array A pointer to the array of elements to permute.
+     * @param length The length of the array to permute.
+     * @param get_switch A function that returns the Bit controlling the next
+     * switch of the network; it is called once for each switch, in order.
+     */
+    template <typename T, typename GetSwitch>
+    void waksman_shuffle(T* array, std::uint64_t length, GetSwitch& get_switch) {
+        auto apply_switch = [&](std::uint64_t i, std::uint64_t j) {
+            auto control = get_switch();
+            T::swap_if(control, array[i], array[j]);
+        };
+        waksman_network(0, length, apply_switch);
+    }
+
+    /**
+     * @brief Obliviously permutes a ShardedArray using a three-stage Clos
+     * network built from Waksman networks.
+     *
+     * Each of the W workers first permutes its m elements in the Blocked
+     * layout. The array is then switched to the Cyclic layout, where each
+     * worker holds m / W elements from each worker's block; every group of W
+     * elements, one from each block, is permuted by a Waksman network.
+     * Finally, the array is switched back to the Blocked layout and each
+     * worker permutes its m elements again. Since there are m groups in the
+     * middle stage, this network can realize any permutation (it is a
+     * rearrangeable Clos network), and all communication is done by the two
+     * layout switches.
+     *
+     * All workers must call this function concurrently. Each worker calls
+     * @p get_switch for the switches that it applies, in the order in which
+     * they are applied: the first stage's network, then each of the m / W
+     * middle groups (in order of local index), then the last stage's
+     * network.
+     *
+     * @pre Each worker holds the same number of elements, and that number is
+     * a multiple of the number of workers.
+     * @post The array is permuted, and is in the Blocked layout.
+     *
+     * @tparam T The type of elements in the array. It must support a static
+     * swap_if function similar to the one in the Integer<...> class.
+     * @tparam GetSwitch The type of @p get_switch.
+     * @param array The ShardedArray to permute.
+     * @param get_switch A function that returns the Bit controlling the next
+     * switch applied by this worker.
+     */
+    template <typename T, typename GetSwitch>
+    void parallel_waksman_shuffle(ShardedArray<T>& array, GetSwitch& get_switch) {
+        WorkerID num_proc = array.get_num_proc();
+        std::uint64_t local_length = array.get_total_size() / num_proc;
+        if (array.get_total_size() != local_length * num_proc || local_length % num_proc != 0) {
+            std::cerr << "Oblivious shuffle requires each worker to have the same number of elements, a multiple of the number of workers" << std::endl;
+            std::abort();
+        }
+
+        array.switch_layout(Layout::Blocked);
+        waksman_shuffle(array.get_locals().data(), local_length, get_switch);
+        if (num_proc == 1) {
+            return;
+        }
+
+        array.switch_layout(Layout::Cyclic);
+        {
+            std::vector<T>& locals = array.get_locals();
+            std::uint64_t num_groups = local_length / num_proc;
+            std::vector<T> group(num_proc);
+            for (std::uint64_t t = 0; t != num_groups; t++) {
+                for (WorkerID w = 0; w != num_proc; w++) {
+                    group[w] = std::move(locals[w * num_groups + t]);
+                }
+                waksman_shuffle(group.data(), num_proc, get_switch);
+                for (WorkerID w = 0; w != num_proc; w++) {
+                    locals[w * num_groups + t] = std::move(group[w]);
+                }
+            }
+        }
+
+        array.switch_layout(Layout::Blocked);
+        waksman_shuffle(array.get_locals().data(), local_length, get_switch);
+    }
+}
+
+#endif
@@ -27,8 +27,11 @@
 #ifndef MAGE_DSL_SORT_HPP_
 #define MAGE_DSL_SORT_HPP_
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <vector>
+#include "addr.hpp"
 #include "dsl/array.hpp"
 #include "util/misc.hpp"
 
@@ -38,9 +41,18 @@ namespace mage::dsl {
     * bitonic sequence of elements.
      *
      * This function is based on the BITONIC-SORTER[length] network from
-     * Algorithms by CLR, Section 28.3).
+     * Algorithms by CLR, Section 28.3). To support lengths that are not a
+     * power of two, each half-cleaner compares elements that are separated by
+     * the largest power of two less than the length, as in the arbitrary-size
+     * bitonic merge described by H. W. Lang. This is equivalent to padding the
+     * array to a power of two with elements that always compare larger (or
+     * smaller, if sorting in decreasing order) and then removing all of the
+     * comparators that involve the padding, so it uses no more comparators
+     * than the power-of-two network.
      *
-     * @pre The array stores a bitonic sequence.
+     * @pre The array stores a bitonic sequence. If @p length is not a power
+     * of two, the sequence must be ascending and then descending (either part
+     * may be empty).
      * @post The array is sorted.
      *
      * @tparam T The type of elements in the array. It must support a static
@@ -54,26 +66,35 @@ namespace mage::dsl {
      */
     template <typename T>
     void bitonic_sorter(T* array, std::uint64_t length, bool increasing = true, std::uint64_t max_depth = UINT64_MAX) {
-        assert(util::is_power_of_two(length));
-
         /* Base case */
         if (length == 1 || length == 0 || max_depth == 0) {
             return;
         }
 
-        std::uint64_t half_length = length >> 1;
+        std::uint64_t distance = util::largest_power_of_two_below(length);
+        std::uint64_t remainder = length - distance;
 
         /* HALF-CLEANER[length] network (see CLR, Section 28.3). */
-        for (std::uint64_t i = 0; i < half_length; i++) {
+        for (std::uint64_t i = 0; i < remainder; i++) {
             if (increasing) {
-                T::comparator(array[i], array[i + half_length]);
+                T::comparator(array[i], array[i + distance]);
             } else {
-                T::comparator(array[i + half_length], array[i]);
+                T::comparator(array[i + distance], array[i]);
             }
         }
 
-        bitonic_sorter<T>(array, half_length, increasing, max_depth - 1);
-        bitonic_sorter<T>(array + half_length, half_length, increasing, max_depth - 1);
+        /*
+         * The padding sits after the descending part of the sequence, so it
+         * ends up in the upper half of the half-cleaner's output if sorting
+         * in increasing order, and in the lower half otherwise.
+         */
+        if (increasing) {
+            bitonic_sorter<T>(array, remainder, increasing, max_depth - 1);
+            bitonic_sorter<T>(array + remainder, distance, increasing, max_depth - 1);
+        } else {
+            bitonic_sorter<T>(array, distance, increasing, max_depth - 1);
+            bitonic_sorter<T>(array + distance, remainder, increasing, max_depth - 1);
+        }
     }
 
     /**
@@ -92,6 +113,9 @@ namespace mage::dsl {
      * parallel_sorter(), because we use the communication schedule suggested
      * in that paper.
      *
+     * The length need not be a power of two; if it isn't, the two halves
+     * differ in length by one (see bitonic_sorter()).
+     *
      * @pre The array stores any sequence.
      * @post The array is sorted.
      *
@@ -104,18 +128,202 @@ namespace mage::dsl {
      */
     template <typename T>
     void sorter(T* array, std::uint64_t length, bool increasing = true) {
-        assert(util::is_power_of_two(length));
-
         if (length == 1 || length == 0) {
             return;
         }
 
         std::uint64_t half_length = length >> 1;
         sorter(array, half_length, true);
-        sorter(array + half_length, half_length, false);
+        sorter(array + half_length, length - half_length, false);
         bitonic_sorter(array, length, increasing);
     }
 
+    /**
+     * @brief Applies one half-cleaner level of the BITONIC-SORTER network to
+     * a ShardedArray in the Blocked layout, comparing the element at each
+     * index i in [first, first + count) with the element at index
+     * i + distance.
+     *
+     * It is expected that all workers whose elements are involved call this
+     * function concurrently. Comparisons whose elements are held by two
+     * different workers are split evenly between those workers: the worker
+     * doing a comparison receives the other worker's element and sends back
+     * the element that belongs to the other worker afterward.
+     *
+     * @tparam T The type of elements in the array.
+     * @param array The ShardedArray, in the Blocked layout.
+     * @param first The global index of the first element to compare.
+     * @param count The number of comparisons in the half-cleaner.
+     * @param distance The difference in global index between the elements
+     * in each comparison.
+     * @param increasing If true, the smaller element of each comparison is
+     * moved to the lower index; otherwise, it is moved to the higher index.
+     */
+    template <typename T>
+    void parallel_half_cleaner(ShardedArray<T>& array, std::uint64_t first, std::uint64_t count, std::uint64_t distance, bool increasing) {
+        assert(array.get_layout() == Layout::Blocked);
+        std::vector<T>& locals = array.get_locals();
+        std::uint64_t base = array.get_global_base_and_stride().first;
+        std::uint64_t end = base + locals.size();
+        std::uint64_t last = first + count;
+
+        /*
+         * Comparisons involving another worker. Those with a given worker are
+         * listed in order of global index, on both workers, so that the
+         * elements are sent and received in the same order.
+         */
+        struct RemoteComparison {
+            std::uint64_t local_index;
+            WorkerID other;
+            bool local_is_lower;
+            bool done_locally;
+        };
+        std::vector<RemoteComparison> remote;
+        std::vector<WorkerID> others;
+        auto add_remote = [&](std::uint64_t i, WorkerID other, bool local_is_lower) {
+            std::uint64_t local_index = (local_is_lower ? i : i + distance) - base;
+            remote.push_back(RemoteComparison { local_index, other, local_is_lower, ((i - first) & 0x1) == (local_is_lower ? 0 : 1) });
+            if (others.empty() || others.back() != other) {
+                others.push_back(other);
+            }
+        };
+        /* Comparisons whose upper element is here, but not the lower. */
+        std::uint64_t upper_here_end = std::min(std::min(last, base), end < distance ? 0 : end - distance);
+        for (std::uint64_t i = std::max(first, base < distance ? 0 : base - distance); i < upper_here_end; i++) {
+            add_remote(i, array.who(i), false);
+        }
+        /* Comparisons whose lower element is here, but not the upper. */
+        for (std::uint64_t i = std::max(std::max(first, base), end < distance ? 0 : end - distance); i < std::min(last, end); i++) {
+            add_remote(i, array.who(i + distance), true);
+        }
+
+        /* Exchange the elements needed for remote comparisons. */
+        std::vector<T> received(remote.size());
+        for (std::size_t k = 0; k != remote.size(); k++) {
+            RemoteComparison& c = remote[k];
+            if (c.done_locally) {
+                received[k].post_receive(c.other);
+            } else {
+                locals[c.local_index].buffer_send(c.other);
+            }
+        }
+        for (WorkerID other : others) {
+            T::finish_send(other);
+        }
+
+        /* Do the comparisons with both elements here while waiting. */
+        for (std::uint64_t i = std::max(first, base); i < last && i + distance < end; i++) {
+            if (increasing) {
+                T::comparator(locals[i - base], locals[i + distance - base]);
+            } else {
+                T::comparator(locals[i + distance - base], locals[i - base]);
+            }
+        }
+
+        for (WorkerID other : others) {
+            T::finish_receive(other);
+        }
+
+        /* Do the remote comparisons and return the other workers' elements. */
+        for (std::size_t k = 0; k != remote.size(); k++) {
+            RemoteComparison& c = remote[k];
+            if (c.done_locally) {
+                T& lower = c.local_is_lower ? locals[c.local_index] : received[k];
+                T& upper = c.local_is_lower ? received[k] : locals[c.local_index];
+                if (increasing) {
+                    T::comparator(lower, upper);
+                } else {
+                    T::comparator(upper, lower);
+                }
+                received[k].buffer_send(c.other);
+            } else {
+                locals[c.local_index].post_receive(c.other);
+            }
+        }
+        for (WorkerID other : others) {
+            T::finish_send(other);
+        }
+        for (WorkerID other : others) {
+            T::finish_receive(other);
+        }
+    }
+
+    /**
+     * @brief Applies the BITONIC-SORTER network (see bitonic_sorter()) to the
+     * elements at global indices [first, first + length) of a ShardedArray in
+     * the Blocked layout.
+     *
+     * It is expected that all workers call this function concurrently. Parts
+     * of the network that involve only one worker's elements are done by
+     * that worker without communication, using bitonic_sorter().
+     *
+     * @tparam T The type of elements in the array.
+     * @param array The ShardedArray, in the Blocked layout.
+     * @param first The global index of the first element of the sequence.
+     * @param length The length of the sequence.
+     * @param increasing If true, the sequence is sorted in order from lowest
+     * to highest. If false, it is sorted in order from highest to lowest.
+     */
+    template <typename T>
+    void parallel_bitonic_sorter_range(ShardedArray<T>& array, std::uint64_t first, std::uint64_t length, bool increasing) {
+        std::vector<T>& locals = array.get_locals();
+        std::uint64_t base = array.get_global_base_and_stride().first;
+        std::uint64_t end = base + locals.size();
+        if (length <= 1 || first >= end || first + length <= base) {
+            return;
+        }
+        if (first >= base && first + length <= end) {
+            bitonic_sorter<T>(locals.data() + (first - base), length, increasing);
+            return;
+        }
+
+        std::uint64_t distance = util::largest_power_of_two_below(length);
+        std::uint64_t remainder = length - distance;
+        parallel_half_cleaner(array, first, remainder, distance, increasing);
+        if (increasing) {
+            parallel_bitonic_sorter_range(array, first, remainder, increasing);
+            parallel_bitonic_sorter_range(array, first + remainder, distance, increasing);
+        } else {
+            parallel_bitonic_sorter_range(array, first, distance, increasing);
+            parallel_bitonic_sorter_range(array, first + distance, remainder, increasing);
+        }
+    }
+
+    /**
+     * @brief Applies the modified SORTER network (see sorter()) to the
+     * elements at global indices [first, first + length) of a ShardedArray in
+     * the Blocked layout.
+     *
+     * It is expected that all workers call this function concurrently. Parts
+     * of the network that involve only one worker's elements are done by
+     * that worker without communication, using sorter().
+     *
+     * @tparam T The type of elements in the array.
+     * @param array The ShardedArray, in the Blocked layout.
+     * @param first The global index of the first element to sort.
+     * @param length The number of elements to sort.
+     * @param increasing If true, the elements are sorted in order from lowest
+     * to highest. If false, they are sorted in order from highest to lowest.
+     */
+    template <typename T>
+    void parallel_sorter_range(ShardedArray<T>& array, std::uint64_t first, std::uint64_t length, bool increasing) {
+        std::vector<T>& locals = array.get_locals();
+        std::uint64_t base = array.get_global_base_and_stride().first;
+        std::uint64_t end = base + locals.size();
+        if (length <= 1 || first >= end || first + length <= base) {
+            return;
+        }
+        if (first >= base && first + length <= end) {
+            sorter<T>(locals.data() + (first - base), length, increasing);
+            return;
+        }
+
+        std::uint64_t half_length = length >> 1;
+        parallel_sorter_range(array, first, half_length, true);
+        parallel_sorter_range(array, first + half_length, length - half_length, false);
+        parallel_bitonic_sorter_range(array, first, length, increasing);
+    }
+
     /**
      * @brief Sorts a ShardedArray containing a bitonic sequence.
      *
@@ -123,10 +331,16 @@ namespace mage::dsl {
      * function concurrently on their share of the partitioned logical array.
      *
      * This function is based on the BITONIC-SORTER[length] network from
-     * Algorithms by CLR, Section 28.3).
+     * Algorithms by CLR, Section 28.3). If the number of workers and the
+     * number of elements at each worker are powers of two, it uses the
+     * communication schedule from the "Fast Parallel Sorting under LogP"
+     * paper, provided that each worker has at least as many elements as there
+     * are workers. Otherwise, it applies the network directly to the array in
+     * the Blocked layout (see parallel_bitonic_sorter_range()).
      *
-     * @pre The array stores a bitonic sequence.
-     * @post The array is sorted.
+     * @pre The array stores a bitonic sequence. If the array's length is not
+     * a power of two, the sequence must be ascending and then descending.
+     * @post The array is sorted, and is in the Blocked layout.
      *
      * @tparam T The type of elements in the array. It must support a static
      * comparator function similar to the one in the Integer<...> class.
@@ -139,9 +353,11 @@ namespace mage::dsl {
         std::vector<T>& locals = array.get_locals();
         std::uint64_t length = locals.size();
 
-        assert(util::is_power_of_two(length));
-        assert(util::is_power_of_two(array.get_num_proc()));
-        assert(array.get_layout() == Layout::Cyclic);
+        if (array.get_total_size() != length * array.get_num_proc() || !util::is_power_of_two(length) || !util::is_power_of_two(array.get_num_proc()) || length < array.get_num_proc() || array.get_layout() != Layout::Cyclic) {
+            array.switch_layout(Layout::Blocked);
+            parallel_bitonic_sorter_range(array, 0, array.get_total_size(), increasing);
+            return;
+        }
 
         std::uint64_t total_phases = util::log_base_2(length * array.get_num_proc());
         std::uint64_t first_pass_phases = total_phases - util::log_base_2(length);
@@ -161,8 +377,14 @@ namespace mage::dsl {
      * recursive parallel_sorter circuits; simply making a recursive call would
      * result in each recursive call having its own all-to-all phase.
      *
+     * That communication schedule requires the number of workers and the
+     * number of elements at each worker to be powers of two. Otherwise, the
+     * SORTER network is applied directly to the array in the Blocked layout
+     * (see parallel_sorter_range()), exchanging elements between pairs of
+     * workers for each half-cleaner that spans workers.
+     *
      * @pre The array stores any sequence.
-     * @post The array is sorted.
+     * @post The array is sorted, and is in the Blocked layout.
      *
      * @tparam T The type of elements in the array. It must support a static
      * comparator function similar to the one in the Integer<...> class.
@@ -175,9 +397,11 @@ namespace mage::dsl {
         std::vector<T>& locals = array.get_locals();
         std::uint64_t local_length = locals.size();
 
-        assert(util::is_power_of_two(local_length));
-        assert(util::is_power_of_two(array.get_num_proc()));
-        assert(local_length >= array.get_num_proc());
+        if (array.get_total_size() != local_length * array.get_num_proc() || !util::is_power_of_two(local_length) || !util::is_power_of_two(array.get_num_proc()) || local_length < array.get_num_proc()) {
+            array.switch_layout(Layout::Blocked);
+            parallel_sorter_range(array, 0, array.get_total_size(), increasing);
+            return;
+        }
 
         WorkerID k = array.get_self_id();
 
@@ -74,14 +74,10 @@ namespace mage::engine {
         AddMultiplyEngine(const std::shared_ptr<ClusterNetwork>& network, const util::ConfigValue& worker, ProtEngine& prot, std::string program)
             : Engine(network), protocol(prot), input(program.c_str()) {
             const ProgramFileHeader& header = this->input.get_header();
-            if (worker.get("storage_path") == nullptr) {
-                std::cerr << "No storage path is specified for this worker" << std::endl;
-                std::abort();
-            }
             PageShift wire_page_shift = header.page_shift;
             PageSize wire_page_size = pg_size(header.page_shift);
             PageSize byte_page_size = wire_page_size * sizeof(typename ProtEngine::Wire);
-            this->init(worker["storage_path"].as_string(), byte_page_size, header.num_pages, header.num_swap_pages, header.max_concurrent_swaps);
+            this->init(worker, byte_page_size, header.num_pages, header.num_swap_pages, header.max_concurrent_swaps, (header.flags & ProgramFlagMemoryBudget) == 0);
             this->input.enable_stats("READ-INSTR (ns)");
             this->memory = this->get_memory();
         }
@@ -93,10 +89,12 @@ namespace mage::engine {
             InstructionNumber num_instructions = this->input.get_header().num_instructions;
             this->progress_bar.set_label("Execution");
             this->input.set_progress_bar(&this->progress_bar);
+            this->start_status(num_instructions);
             for (InstructionNumber i = 0; i != num_instructions; i++) {
                 PackedPhysInstruction& phys = this->input.start_instruction();
                 std::size_t size = this->execute_instruction(phys);
                 this->input.finish_instruction(size);
+                this->update_status(i + 1);
             }
             this->progress_bar.finish();
         }
@@ -136,6 +134,9 @@ namespace mage::engine {
             case OpCode::CopySwap:
                 this->copy_page(phys.swap.storage, phys.swap.memory);
                 return PackedPhysInstruction::size(OpCode::CopySwap);
+            case OpCode::DiscardPage:
+                this->discard_page(phys.swap_finish.memory);
+                return PackedPhysInstruction::size(OpCode::DiscardPage);
             case OpCode::NetworkPostReceive:
                 this->network_post_receive(phys.constant.constant, &this->memory[phys.constant.output], ProtEngine::ciphertext_size(phys.constant.width, normalized(phys)));
                 return PackedPhysInstruction::size(OpCode::NetworkPostReceive);
@@ -149,7 +150,11 @@ namespace mage::engine {
                 this->network_finish_send(phys.control.data);
                 return PackedPhysInstruction::size(OpCode::NetworkFinishSend);
             case OpCode::Input:
-                this->protocol.input(&this->memory[phys.no_args.output], phys.no_args.width, normalized(phys));
+                if ((phys.header.flags & FlagPlaintextInput) != 0) {
+                    this->protocol.input_plaintext(&this->memory[phys.no_args.output], phys.no_args.width);
+                } else {
+                    this->protocol.input(&this->memory[phys.no_args.output], phys.no_args.width, normalized(phys));
+                }
                 return PackedPhysInstruction::size(OpCode::Input);
             case OpCode::Output:
                 this->protocol.output(&this->memory[phys.no_args.output], phys.no_args.width, normalized(phys));
@@ -175,6 +180,15 @@ namespace mage::engine {
             case OpCode::MultiplyPlaintextRaw:
                 this->protocol.op_multiply_plaintext_raw(&this->memory[phys.two_args.output], &this->memory[phys.two_args.input1], &this->memory[phys.two_args.input2], phys.two_args.width);
                 return PackedPhysInstruction::size(OpCode::MultiplyPlaintextRaw);
+            case OpCode::MultiplyAccumulateRaw:
+                this->protocol.op_multiply_accumulate_raw(&this->memory[phys.one_arg.output], &this->memory[phys.one_arg.input1], phys.one_arg.width);
+                return PackedPhysInstruction::size(OpCode::MultiplyAccumulateRaw);
+            case OpCode::MultiplyPlaintextAccumulateRaw:
+                this->protocol.op_multiply_plaintext_accumulate_raw(&this->memory[phys.one_arg.output], &this->memory[phys.one_arg.input1], phys.one_arg.width);
+                return PackedPhysInstruction::size(OpCode::MultiplyPlaintextAccumulateRaw);
+            case OpCode::StoreAccumulator:
+                this->protocol.op_store_accumulator(&this->memory[phys.no_args.output], phys.no_args.width);
+                return PackedPhysInstruction::size(OpCode::StoreAccumulator);
             case OpCode::Renormalize:
                 this->protocol.op_normalize(&this->memory[phys.one_arg.output], &this->memory[phys.one_arg.input1], phys.one_arg.width);
                 return PackedPhysInstruction::size(OpCode::Renormalize);
@@ -29,9 +29,12 @@
 #ifndef MAGE_ENGINE_ANDXOR_HPP_
 #define MAGE_ENGINE_ANDXOR_HPP_
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "addr.hpp"
 #include "opcode.hpp"
 #include "engine/engine.hpp"
@@ -48,6 +51,24 @@ namespace mage::engine {
      * example of such a protocol is Garbled Circuits, with the HalfGates and
      * Free XOR optimizations.
      *
+     * By default, arithmetic and comparisons use ripple circuits, which have
+     * the fewest AND gates but whose depth is linear in the width. Protocols
+     * in which AND gates at the same depth can be evaluated in parallel or in
+     * the same round (e.g., TFHE) can instead use circuits of logarithmic
+     * depth: a Sklansky parallel-prefix adder and subtractor, and tree
+     * reductions for comparison, equality, and zero testing. The protocol
+     * driver chooses via its prefers_low_depth_circuits constant, which the
+     * low_depth_circuits key in the worker's configuration overrides.
+     *
+     * Protocols whose AND gates require interaction (e.g., GMW) set
+     * batches_and_gates and provide op_and_batch; the engine then hands them
+     * each layer of independent AND gates within an instruction at once, so
+     * that the layer costs a single round of communication.
+     *
+     * Protocols that communicate with the other party set
+     * exchanges_network_traffic and provide get_bytes_sent and
+     * get_bytes_received, which the engine reports in its status file.
+     *
      * @tparam ProtEngine The type of the underlying protocol driver.
      */
     template <typename ProtEngine>
@@ -64,16 +85,15 @@ namespace mage::engine {
          * @param program The file path of the memory program to execute.
          */
         ANDXOREngine(const std::shared_ptr<ClusterNetwork>& network, const util::ConfigValue& worker, ProtEngine& prot, std::string program)
-            : Engine(network), protocol(prot), input(program.c_str()) {
+            : Engine(network), protocol(prot), input(program.c_str()), low_depth_circuits(ProtEngine::prefers_low_depth_circuits) {
             const ProgramFileHeader& header = this->input.get_header();
-            if (worker.get("storage_path") == nullptr) {
-                std::cerr << "No storage path is specified for this worker" << std::endl;
-                std::abort();
+            if (worker.get("low_depth_circuits") != nullptr) {
+                this->low_depth_circuits = (worker["low_depth_circuits"].as_int() != 0);
             }
             PageShift wire_page_shift = header.page_shift;
             PageSize wire_page_size = pg_size(header.page_shift);
             PageSize byte_page_size = wire_page_size * sizeof(typename ProtEngine::Wire);
-            this->init(worker["storage_path"].as_string(), byte_page_size, header.num_pages, header.num_swap_pages, header.max_concurrent_swaps);
+            this->init(worker, byte_page_size, header.num_pages, header.num_swap_pages, header.max_concurrent_swaps, (header.flags & ProgramFlagMemoryBudget) == 0);
             this->input.enable_stats("READ-INSTR (ns)");
             this->wires = reinterpret_cast<typename ProtEngine::Wire*>(this->get_memory());
         }
@@ -85,14 +105,25 @@ namespace mage::engine {
             InstructionNumber num_instructions = this->input.get_header().num_instructions;
             this->progress_bar.set_label("Execution");
             this->input.set_progress_bar(&this->progress_bar);
+            this->start_status(num_instructions);
             for (InstructionNumber i = 0; i != num_instructions; i++) {
                 PackedPhysInstruction& phys = this->input.start_instruction();
                 std::size_t size = this->execute_instruction(phys);
                 this->input.finish_instruction(size);
+                this->update_status(i + 1);
             }
             this->progress_bar.finish();
         }
 
+    protected:
+        std::pair<std::uint64_t, std::uint64_t> get_protocol_traffic() const override {
+            if constexpr (ProtEngine::exchanges_network_traffic) {
+                return std::make_pair(this->protocol.get_bytes_sent(), this->protocol.get_bytes_received());
+            } else {
+                return this->Engine::get_protocol_traffic();
+            }
+        }
+
     private:
         void execute_public_constant(const PackedPhysInstruction& phys) {
             typename ProtEngine::Wire* output = &this->wires[phys.constant.output];
@@ -153,15 +184,18 @@ namespace mage::engine {
             typename ProtEngine::Wire* input = &this->wires[phys.one_arg.input1];
             BitWidth width = phys.one_arg.width;
 
+            /* Read each input bit before writing the output, which may alias it. */
             typename ProtEngine::Wire carry;
-            this->protocol.op_not(output[0], input[0]);
             this->protocol.op_copy(carry, input[0]);
+            this->protocol.op_not(output[0], carry);
             if (width == 1) {
                 return;
             }
+            typename ProtEngine::Wire next_carry;
             for (BitWidth i = 1; i != width - 1; i++) {
+                this->protocol.op_and(next_carry, carry, input[i]);
                 this->protocol.op_xor(output[i], input[i], carry);
-                this->protocol.op_and(carry, carry, input[i]);
+                this->protocol.op_copy(carry, next_carry);
             }
             this->protocol.op_xor(output[width - 1], input[width - 1], carry);
             // skip computing the final output carry
@@ -179,9 +213,9 @@ namespace mage::engine {
 
             typename ProtEngine::Wire borrow;
             this->protocol.zero(borrow);
-            this->protocol.op_copy(temp1, input1[0]);
+            this->protocol.op_xor(temp1, input1[0], input2[0]);
             this->protocol.op_copy(temp2, input2[0]);
-            this->protocol.op_xor(output[0], temp1, temp2);
+            this->protocol.op_copy(output[0], temp1);
             for (BitWidth i = 1; i != width; i++) {
                 /* Calculate carry from previous adder. */
                 this->protocol.op_and(temp3, temp1, temp2);
@@ -198,6 +232,10 @@ namespace mage::engine {
             typename ProtEngine::Wire* input = &this->wires[phys.one_arg.input1];
             BitWidth width = phys.one_arg.width;
 
+            /*
+             * The output may alias the input (e.g., for Integer::operator--),
+             * so the borrow is computed from output[i] once it is written.
+             */
             typename ProtEngine::Wire borrow;
             this->protocol.op_not(borrow, input[0]);
             this->protocol.op_copy(output[0], borrow);
@@ -252,12 +290,7 @@ namespace mage::engine {
         }
 
         /* Based on https://github.com/samee/obliv-c/blob/obliv-c/src/ext/oblivc/obliv_bits.c */
-        void execute_int_less(const PackedPhysInstruction& phys) {
-            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
-            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
-            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
-            BitWidth width = phys.two_args.width;
-
+        void int_less(typename ProtEngine::Wire& output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
             typename ProtEngine::Wire result;
 
             typename ProtEngine::Wire temp1;
@@ -273,7 +306,16 @@ namespace mage::engine {
                 this->protocol.op_xor(result, result, temp3);
             }
 
-            this->protocol.op_copy(*output, result);
+            this->protocol.op_copy(output, result);
+        }
+
+        void execute_int_less(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            this->int_less(*output, input1, input2, width);
         }
 
         void execute_equal(const PackedPhysInstruction& phys) {
@@ -299,10 +341,10 @@ namespace mage::engine {
             BitWidth width = phys.one_arg.width;
 
             typename ProtEngine::Wire result;
-            this->protocol.op_copy(result, input[0]);
+            this->protocol.op_not(result, input[0]);
 
             typename ProtEngine::Wire temp;
-            for (BitWidth i = 0; i != width; i++) {
+            for (BitWidth i = 1; i != width; i++) {
                 this->protocol.op_not(temp, input[i]);
                 this->protocol.op_and(result, result, temp);
             }
@@ -315,16 +357,348 @@ namespace mage::engine {
             BitWidth width = phys.one_arg.width;
 
             typename ProtEngine::Wire result;
-            this->protocol.op_copy(result, input[0]);
+            this->protocol.op_not(result, input[0]);
 
             typename ProtEngine::Wire temp;
-            for (BitWidth i = 0; i != width; i++) {
+            for (BitWidth i = 1; i != width; i++) {
                 this->protocol.op_not(temp, input[i]);
                 this->protocol.op_and(result, result, temp);
             }
             this->protocol.op_not(*output, result);
         }
 
+        /**
+         * @brief Temporary wires for a circuit, borrowed from the engine for
+         * the lifetime of this object.
+         *
+         * A wire can be several kilobytes (e.g., for TFHE), so circuits keep
+         * their temporary arrays on the heap rather than the stack. The
+         * engine keeps one buffer per nesting level and reuses it across
+         * instructions; a helper may borrow wires while its caller still
+         * holds its own, as long as they are released in reverse order.
+         */
+        class ScratchWires {
+        public:
+            ScratchWires(ANDXOREngine<ProtEngine>& engine, std::size_t count) : depth(engine.scratch_depth) {
+                if (this->depth == engine.scratch.size()) {
+                    engine.scratch.emplace_back();
+                }
+                ScratchLevel& level = engine.scratch[this->depth++];
+                if (level.capacity < count) {
+                    level.wires = std::make_unique<typename ProtEngine::Wire[]>(count);
+                    level.capacity = count;
+                }
+                this->wires = level.wires.get();
+            }
+
+            ~ScratchWires() {
+                this->depth--;
+            }
+
+            ScratchWires(const ScratchWires& other) = delete;
+            ScratchWires& operator =(const ScratchWires& other) = delete;
+
+            typename ProtEngine::Wire& operator [](std::size_t i) const {
+                return this->wires[i];
+            }
+
+            operator typename ProtEngine::Wire*() const {
+                return this->wires;
+            }
+
+        private:
+            std::size_t& depth;
+            typename ProtEngine::Wire* wires;
+        };
+
+        /**
+         * @brief Evaluates a layer of independent AND gates, computing
+         * output[i] = input1[i] AND input2[i] for each i.
+         *
+         * Protocols that evaluate AND gates interactively (batches_and_gates)
+         * evaluate the whole layer in a single round of communication, so
+         * circuits should present all AND gates at the same depth together.
+         * The output may alias the inputs.
+         *
+         * @param output The array into which to write the results.
+         * @param input1 The array of first operands.
+         * @param input2 The array of second operands.
+         * @param count The number of AND gates in the layer.
+         */
+        void and_layer(typename ProtEngine::Wire* output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, std::size_t count) {
+            if constexpr (ProtEngine::batches_and_gates) {
+                this->protocol.op_and_batch(output, input1, input2, count);
+            } else {
+                for (std::size_t i = 0; i != count; i++) {
+                    this->protocol.op_and(output[i], input1[i], input2[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief Computes the carries of an addition using a Sklansky
+         * parallel-prefix network, which has depth logarithmic in the width.
+         *
+         * On input, generate[i] and propagate[i] indicate whether bit i
+         * generates a carry and propagates an incoming carry, respectively.
+         * On output, generate[i] is the carry out of bit i, assuming no carry
+         * into bit 0 (a carry into bit 0 can be included in generate[0]).
+         * Since a bit never both generates and propagates a carry, the OR in
+         * the carry operator is computed as an XOR.
+         *
+         * @param generate The generate signal of each bit.
+         * @param propagate The propagate signal of each bit, which is
+         * overwritten.
+         * @param length The number of bits.
+         */
+        void prefix_carries(typename ProtEngine::Wire* generate, typename ProtEngine::Wire* propagate, BitWidth length) {
+            if (length < 2) {
+                return;
+            }
+            ScratchWires left(*this, length << 1);
+            ScratchWires right(*this, length << 1);
+            for (BitWidth distance = 1; distance < length; distance <<= 1) {
+                bool propagate_needed = (distance << 1) < length;
+                std::size_t count = 0;
+                for (BitWidth i = distance; i < length; i++) {
+                    if ((i & distance) == 0) {
+                        i += distance - 1;
+                        continue;
+                    }
+                    /* Combine with the prefix ending just before i's block. */
+                    BitWidth from = (i & ~(distance - 1)) - 1;
+                    this->protocol.op_copy(left[count], propagate[i]);
+                    this->protocol.op_copy(right[count++], generate[from]);
+                    if (propagate_needed) {
+                        this->protocol.op_copy(left[count], propagate[i]);
+                        this->protocol.op_copy(right[count++], propagate[from]);
+                    }
+                }
+                this->and_layer(left, left, right, count);
+                count = 0;
+                for (BitWidth i = distance; i < length; i++) {
+                    if ((i & distance) == 0) {
+                        i += distance - 1;
+                        continue;
+                    }
+                    this->protocol.op_xor(generate[i], generate[i], left[count++]);
+                    if (propagate_needed) {
+                        this->protocol.op_copy(propagate[i], left[count++]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Reduces the bits of the provided array using AND, with a
+         * balanced tree of depth logarithmic in the number of bits.
+         *
+         * @param bits The bits to reduce, which are overwritten. The result
+         * is stored in bits[0].
+         * @param length The number of bits, which must be at least 1.
+         */
+        void reduce_and(typename ProtEngine::Wire* bits, BitWidth length) {
+            ScratchWires left(*this, length);
+            ScratchWires right(*this, length);
+            for (BitWidth distance = 1; distance < length; distance <<= 1) {
+                std::size_t count = 0;
+                for (BitWidth i = 0; i + distance < length; i += (distance << 1)) {
+                    this->protocol.op_copy(left[count], bits[i]);
+                    this->protocol.op_copy(right[count++], bits[i + distance]);
+                }
+                this->and_layer(left, left, right, count);
+                count = 0;
+                for (BitWidth i = 0; i + distance < length; i += (distance << 1)) {
+                    this->protocol.op_copy(bits[i], left[count++]);
+                }
+            }
+        }
+
+        /**
+         * @brief Adds two integers using a Sklansky parallel-prefix adder.
+         *
+         * @tparam final_carry If true, the carry out of the most significant
+         * bit is written to output[width].
+         * @param output The sum, which may alias either input.
+         * @param input1 The first operand.
+         * @param input2 The second operand.
+         * @param width The width of each operand.
+         */
+        template <bool final_carry>
+        void int_add_low_depth(typename ProtEngine::Wire* output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
+            /* Only the carries into bits 1 to width - 1 (and out) are needed. */
+            BitWidth num_carries = final_carry ? width : width - 1;
+            ScratchWires generate(*this, width);
+            ScratchWires propagate(*this, width);
+            this->and_layer(generate, input1, input2, num_carries);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_xor(propagate[i], input1[i], input2[i]);
+            }
+            /* The output may alias the inputs, so write it only now. */
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_copy(output[i], propagate[i]);
+            }
+
+            this->prefix_carries(generate, propagate, num_carries);
+            for (BitWidth i = 1; i != width; i++) {
+                this->protocol.op_xor(output[i], output[i], generate[i - 1]);
+            }
+            if constexpr (final_carry) {
+                this->protocol.op_copy(output[width], generate[width - 1]);
+            }
+        }
+
+        template <bool final_carry>
+        void execute_int_add_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            this->int_add_low_depth<final_carry>(output, input1, input2, width);
+        }
+
+        /**
+         * @brief Computes the generate and propagate signals for computing
+         * input1 - input2 as input1 + ~input2 + 1, with the carry into bit 0
+         * folded into generate[0].
+         */
+        void subtraction_signals(typename ProtEngine::Wire* generate, typename ProtEngine::Wire* propagate, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
+            ScratchWires inverted(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_not(inverted[i], input2[i]);
+                this->protocol.op_xnor(propagate[i], input1[i], input2[i]);
+            }
+            this->and_layer(generate, input1, inverted, width);
+            this->protocol.op_xor(generate[0], generate[0], propagate[0]);
+        }
+
+        void execute_int_sub_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            ScratchWires generate(*this, width);
+            ScratchWires propagate(*this, width);
+            this->subtraction_signals(generate, propagate, input1, input2, width);
+            this->protocol.op_not(output[0], propagate[0]);
+            for (BitWidth i = 1; i != width; i++) {
+                this->protocol.op_copy(output[i], propagate[i]);
+            }
+
+            this->prefix_carries(generate, propagate, width - 1);
+            for (BitWidth i = 1; i != width; i++) {
+                this->protocol.op_xor(output[i], output[i], generate[i - 1]);
+            }
+        }
+
+        void execute_int_multiply_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth operand_width = phys.two_args.width;
+
+            if (operand_width == 0) {
+                return;
+            }
+
+            /* All partial products are independent, so compute them at once. */
+            std::size_t num_products = static_cast<std::size_t>(operand_width) * operand_width;
+            ScratchWires left(*this, num_products);
+            ScratchWires right(*this, num_products);
+            for (BitWidth i = 0; i != operand_width; i++) {
+                for (BitWidth j = 0; j != operand_width; j++) {
+                    this->protocol.op_copy(left[i * operand_width + j], input1[j]);
+                    this->protocol.op_copy(right[i * operand_width + j], input2[i]);
+                }
+            }
+            this->and_layer(left, left, right, num_products);
+
+            for (BitWidth j = 0; j != operand_width; j++) {
+                this->protocol.op_copy(output[j], left[j]);
+            }
+            this->protocol.zero(output[operand_width]);
+            for (BitWidth i = 1; i != operand_width; i++) {
+                /* Add partial product i to output starting at bit i. */
+                this->int_add_low_depth<true>(&output[i], &output[i], &left[i * operand_width], operand_width);
+            }
+        }
+
+        void int_less_low_depth(typename ProtEngine::Wire& output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
+            /* input1 < input2 iff computing input1 - input2 borrows. */
+            ScratchWires generate(*this, width);
+            ScratchWires propagate(*this, width);
+            this->subtraction_signals(generate, propagate, input1, input2, width);
+
+            /* Only the final carry is needed, so reduce with a tree. */
+            ScratchWires left(*this, width);
+            ScratchWires right(*this, width);
+            for (BitWidth distance = 1; distance < width; distance <<= 1) {
+                bool propagate_needed = (distance << 1) < width;
+                std::size_t count = 0;
+                for (BitWidth i = 0; i + distance < width; i += (distance << 1)) {
+                    BitWidth upper = i + distance;
+                    this->protocol.op_copy(left[count], propagate[upper]);
+                    this->protocol.op_copy(right[count++], generate[i]);
+                    if (propagate_needed) {
+                        this->protocol.op_copy(left[count], propagate[upper]);
+                        this->protocol.op_copy(right[count++], propagate[i]);
+                    }
+                }
+                this->and_layer(left, left, right, count);
+                count = 0;
+                for (BitWidth i = 0; i + distance < width; i += (distance << 1)) {
+                    this->protocol.op_xor(generate[i], generate[i + distance], left[count++]);
+                    if (propagate_needed) {
+                        this->protocol.op_copy(propagate[i], left[count++]);
+                    }
+                }
+            }
+            this->protocol.op_not(output, generate[0]);
+        }
+
+        void execute_int_less_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            this->int_less_low_depth(*output, input1, input2, width);
+        }
+
+        void execute_equal_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            ScratchWires same(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_xnor(same[i], input1[i], input2[i]);
+            }
+            this->reduce_and(same, width);
+            this->protocol.op_copy(*output, same[0]);
+        }
+
+        template <bool negate>
+        void execute_is_zero_low_depth(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.one_arg.output];
+            typename ProtEngine::Wire* input = &this->wires[phys.one_arg.input1];
+            BitWidth width = phys.one_arg.width;
+
+            ScratchWires zero(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_not(zero[i], input[i]);
+            }
+            this->reduce_and(zero, width);
+            if constexpr (negate) {
+                this->protocol.op_not(*output, zero[0]);
+            } else {
+                this->protocol.op_copy(*output, zero[0]);
+            }
+        }
+
         void execute_bit_not(const PackedPhysInstruction& phys) {
             typename ProtEngine::Wire* output = &this->wires[phys.one_arg.output];
             typename ProtEngine::Wire* input = &this->wires[phys.one_arg.input1];
@@ -341,9 +715,7 @@ namespace mage::engine {
             typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
             BitWidth width = phys.two_args.width;
 
-            for (BitWidth i = 0; i != width; i++) {
-                this->protocol.op_and(output[i], input1[i], input2[i]);
-            }
+            this->and_layer(output, input1, input2, width);
         }
 
         void execute_bit_or(const PackedPhysInstruction& phys) {
@@ -352,12 +724,13 @@ namespace mage::engine {
             typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
             BitWidth width = phys.two_args.width;
 
-            typename ProtEngine::Wire temp1;
-            typename ProtEngine::Wire temp2;
+            ScratchWires both(*this, width);
+            this->and_layer(both, input1, input2, width);
+
+            typename ProtEngine::Wire temp;
             for (BitWidth i = 0; i != width; i++) {
-                this->protocol.op_xor(temp1, input1[i], input2[i]);
-                this->protocol.op_and(temp2, input1[i], input2[i]);
-                this->protocol.op_xor(output[i], temp1, temp2);
+                this->protocol.op_xor(temp, input1[i], input2[i]);
+                this->protocol.op_xor(output[i], temp, both[i]);
             }
         }
 
@@ -379,16 +752,576 @@ namespace mage::engine {
             typename ProtEngine::Wire* input3 = &this->wires[phys.three_args.input3];
             BitWidth width = phys.three_args.width;
 
-            typename ProtEngine::Wire selector;
-            this->protocol.op_copy(selector, *input3);
+            this->select(output, *input3, input1, input2, width);
+        }
 
-            typename ProtEngine::Wire different;
-            typename ProtEngine::Wire temp;
+        /*
+         * The circuits below implement the fixed-point and floating-point
+         * operations. They are built from the following primitives on arrays
+         * of wires. Where the engine is configured for low-depth circuits,
+         * comparisons use the low-depth variants; additions use ripple-carry
+         * adders, which have the fewest AND gates.
+         */
+
+        /**
+         * @brief Selects between two arrays of wires, computing
+         * output[i] = selector ? if_one[i] : if_zero[i] for each i.
+         *
+         * @param output The array into which to write the result, which may
+         * alias either input.
+         * @param selector The bit that chooses between the two inputs.
+         * @param if_one The array to select if @p selector is 1.
+         * @param if_zero The array to select if @p selector is 0.
+         * @param width The number of wires in each array.
+         */
+        void select(typename ProtEngine::Wire* output, const typename ProtEngine::Wire& selector, const typename ProtEngine::Wire* if_one, const typename ProtEngine::Wire* if_zero, BitWidth width) {
+            if (width == 0) {
+                return;
+            }
+            ScratchWires selectors(*this, width);
+            ScratchWires different(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_copy(selectors[i], selector);
+                this->protocol.op_xor(different[i], if_one[i], if_zero[i]);
+            }
+            this->and_layer(different, different, selectors, width);
+
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_xor(output[i], different[i], if_zero[i]);
+            }
+        }
+
+        /**
+         * @brief Checks if any bit of the provided array is set, using a
+         * tree of depth logarithmic in the number of bits.
+         *
+         * @param output The wire into which to write the result.
+         * @param input The bits to check.
+         * @param width The number of bits, which may be 0.
+         */
+        void any_set(typename ProtEngine::Wire& output, const typename ProtEngine::Wire* input, BitWidth width) {
+            if (width == 0) {
+                this->protocol.zero(output);
+                return;
+            }
+            ScratchWires zero(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_not(zero[i], input[i]);
+            }
+            this->reduce_and(zero, width);
+            this->protocol.op_not(output, zero[0]);
+        }
+
+        /**
+         * @brief Compares two unsigned integers, using the circuit style
+         * chosen for this engine.
+         *
+         * @param output The wire into which to write input1 < input2.
+         * @param input1 The first operand.
+         * @param input2 The second operand.
+         * @param width The width of each operand.
+         */
+        void less_than(typename ProtEngine::Wire& output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
+            if (this->low_depth_circuits) {
+                this->int_less_low_depth(output, input1, input2, width);
+            } else {
+                this->int_less(output, input1, input2, width);
+            }
+        }
+
+        /**
+         * @brief Adds two integers using a ripple-carry adder, with an
+         * optional carry in and carry out.
+         *
+         * @param output The sum, which may alias either input.
+         * @param input1 The first operand.
+         * @param input2 The second operand.
+         * @param width The width of each operand, which must be at least 1.
+         * @param carry_in The carry into the least significant bit, or
+         * nullptr if there is none.
+         * @param carry_out The wire into which to write the carry out of the
+         * most significant bit, or nullptr if it is not needed.
+         */
+        void ripple_add(typename ProtEngine::Wire* output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width, const typename ProtEngine::Wire* carry_in, typename ProtEngine::Wire* carry_out) {
+            typename ProtEngine::Wire carry;
+            typename ProtEngine::Wire temp1;
+            typename ProtEngine::Wire temp2;
+            typename ProtEngine::Wire temp3;
+
+            BitWidth i = 0;
+            if (carry_in == nullptr) {
+                /* Without a carry in, bit 0 is a half adder. */
+                this->protocol.op_and(carry, input1[0], input2[0]);
+                this->protocol.op_xor(output[0], input1[0], input2[0]);
+                i = 1;
+            } else {
+                this->protocol.op_copy(carry, *carry_in);
+            }
+            for (; i != width; i++) {
+                this->protocol.op_xor(temp1, input1[i], carry);
+                this->protocol.op_xor(temp2, input2[i], carry);
+                this->protocol.op_xor(output[i], temp1, input2[i]);
+                if (i != width - 1 || carry_out != nullptr) {
+                    this->protocol.op_and(temp3, temp1, temp2);
+                    this->protocol.op_xor(carry, carry, temp3);
+                }
+            }
+            if (carry_out != nullptr) {
+                this->protocol.op_copy(*carry_out, carry);
+            }
+        }
+
+        /**
+         * @brief Subtracts two integers using a ripple-carry subtractor.
+         *
+         * @param output The difference, input1 - input2, which may alias
+         * either input.
+         * @param input1 The first operand.
+         * @param input2 The second operand.
+         * @param width The width of each operand, which must be at least 1.
+         */
+        void ripple_sub(typename ProtEngine::Wire* output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth width) {
+            ScratchWires inverted(*this, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_not(inverted[i], input2[i]);
+            }
+            typename ProtEngine::Wire one;
+            this->protocol.one(one);
+            this->ripple_add(output, input1, inverted, width, &one, nullptr);
+        }
+
+        /**
+         * @brief Computes the low bits of the product of two unsigned
+         * integers.
+         *
+         * Partial products that only affect bits at or above
+         * @p product_width are skipped, so a truncated product needs fewer
+         * AND gates than a full multiplication.
+         *
+         * @param product The array of @p product_width wires into which to
+         * write the product. It must not alias either input.
+         * @param input1 The first operand.
+         * @param input2 The second operand.
+         * @param operand_width The width of each operand, which must be at
+         * least 1.
+         * @param product_width The number of low bits of the product to
+         * compute, which must be at least 1.
+         */
+        void multiply_truncated(typename ProtEngine::Wire* product, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth operand_width, BitWidth product_width) {
+            /* Row i of partial products is added to the product at bit i. */
+            BitWidth num_rows = std::min(operand_width, product_width);
+            std::size_t num_products = 0;
+            for (BitWidth i = 0; i != num_rows; i++) {
+                num_products += std::min<BitWidth>(operand_width, product_width - i);
+            }
+
+            /* All partial products are independent, so compute them at once. */
+            ScratchWires left(*this, num_products);
+            ScratchWires right(*this, num_products);
+            std::size_t count = 0;
+            for (BitWidth i = 0; i != num_rows; i++) {
+                BitWidth row_width = std::min<BitWidth>(operand_width, product_width - i);
+                for (BitWidth j = 0; j != row_width; j++) {
+                    this->protocol.op_copy(left[count], input1[j]);
+                    this->protocol.op_copy(right[count++], input2[i]);
+                }
+            }
+            this->and_layer(left, left, right, num_products);
+
+            for (BitWidth j = 0; j != product_width; j++) {
+                if (j < operand_width) {
+                    this->protocol.op_copy(product[j], left[j]);
+                } else {
+                    this->protocol.zero(product[j]);
+                }
+            }
+            count = std::min(operand_width, product_width);
+            for (BitWidth i = 1; i != num_rows; i++) {
+                BitWidth row_width = std::min<BitWidth>(operand_width, product_width - i);
+                /* Bit i + row_width is still zero, so the carry can go there. */
+                BitWidth top = i + row_width;
+                this->ripple_add(&product[i], &product[i], &left[count], row_width, nullptr, top < product_width ? &product[top] : nullptr);
+                count += row_width;
+            }
+        }
+
+        /**
+         * @brief Shifts an integer right, in place, by a secret distance,
+         * shifting in zeros.
+         *
+         * Each bit of the distance conditionally shifts the integer by the
+         * corresponding power of two (a logarithmic barrel shifter). A
+         * distance of at least the width produces zero.
+         *
+         * @param value The integer to shift.
+         * @param width The width of the integer.
+         * @param distance The distance by which to shift.
+         * @param distance_width The width of the distance.
+         */
+        void shift_right(typename ProtEngine::Wire* value, BitWidth width, const typename ProtEngine::Wire* distance, BitWidth distance_width) {
+            ScratchWires shifted(*this, width);
+            BitWidth k = 0;
+            for (; k != distance_width && (UINT64_C(1) << k) < width; k++) {
+                BitWidth step = 1 << k;
+                for (BitWidth i = 0; i != width; i++) {
+                    if (i + step < width) {
+                        this->protocol.op_copy(shifted[i], value[i + step]);
+                    } else {
+                        this->protocol.zero(shifted[i]);
+                    }
+                }
+                this->select(value, distance[k], shifted, value, width);
+            }
+            if (k != distance_width) {
+                /* Any remaining bit of the distance shifts out everything. */
+                typename ProtEngine::Wire out_of_range;
+                this->any_set(out_of_range, &distance[k], distance_width - k);
+                for (BitWidth i = 0; i != width; i++) {
+                    this->protocol.zero(shifted[i]);
+                }
+                this->select(value, out_of_range, shifted, value, width);
+            }
+        }
+
+        /**
+         * @brief Shifts an integer left, in place, until its most significant
+         * bit is set, and computes the distance shifted.
+         *
+         * The distance is found by binary search: from the largest power of
+         * two down, the integer is shifted by that power of two if its top
+         * bits of that length are all zero. An integer that is zero remains
+         * zero.
+         *
+         * @param value The integer to shift.
+         * @param width The width of the integer.
+         * @param distance The array into which to write the distance shifted.
+         * @param distance_width The width of the distance, which must be
+         * large enough that 2 ^ distance_width is at least @p width.
+         */
+        void normalize_left(typename ProtEngine::Wire* value, BitWidth width, typename ProtEngine::Wire* distance, BitWidth distance_width) {
+            ScratchWires shifted(*this, width);
+            for (BitWidth k = distance_width; k-- != 0;) {
+                if ((UINT64_C(1) << k) >= width) {
+                    this->protocol.zero(distance[k]);
+                    continue;
+                }
+                BitWidth step = 1 << k;
+                typename ProtEngine::Wire top_set;
+                this->any_set(top_set, &value[width - step], step);
+                this->protocol.op_not(distance[k], top_set);
+                for (BitWidth i = 0; i != width; i++) {
+                    if (i >= step) {
+                        this->protocol.op_copy(shifted[i], value[i - step]);
+                    } else {
+                        this->protocol.zero(shifted[i]);
+                    }
+                }
+                this->select(value, distance[k], shifted, value, width);
+            }
+        }
+
+        /*
+         * The signed comparison is the unsigned comparison with the sign bits
+         * of the operands exchanged.
+         */
+        void execute_int_less_signed(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = phys.two_args.width;
+
+            ScratchWires left(*this, width);
+            ScratchWires right(*this, width);
+            std::copy(input1, input1 + width, &left[0]);
+            std::copy(input2, input2 + width, &right[0]);
+            this->protocol.op_copy(left[width - 1], input2[width - 1]);
+            this->protocol.op_copy(right[width - 1], input1[width - 1]);
+            this->less_than(*output, left, right, width);
+        }
+
+        /*
+         * Computes (input1 * input2) >> fraction_width for signed fixed-point
+         * inputs. Only the low width + fraction_width bits of the signed
+         * product are needed. Modulo 2 ^ (width + fraction_width), the signed
+         * product is the unsigned product minus 2 ^ width times
+         * (sign1 * input2 + sign2 * input1), of which only the low
+         * fraction_width bits matter.
+         */
+        void execute_fixed_multiply(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth width = packed_width_low(phys.two_args.width);
+            BitWidth fraction_width = packed_width_high(phys.two_args.width);
+            BitWidth product_width = width + fraction_width;
+
+            ScratchWires product(*this, product_width);
+            this->multiply_truncated(product, input1, input2, width, product_width);
+
+            if (fraction_width != 0) {
+                ScratchWires correction(*this, fraction_width << 1);
+                ScratchWires signs(*this, fraction_width << 1);
+                for (BitWidth j = 0; j != fraction_width; j++) {
+                    if (j < width) {
+                        this->protocol.op_copy(correction[j], input2[j]);
+                        this->protocol.op_copy(correction[fraction_width + j], input1[j]);
+                    } else {
+                        this->protocol.zero(correction[j]);
+                        this->protocol.zero(correction[fraction_width + j]);
+                    }
+                    this->protocol.op_copy(signs[j], input1[width - 1]);
+                    this->protocol.op_copy(signs[fraction_width + j], input2[width - 1]);
+                }
+                this->and_layer(correction, correction, signs, fraction_width << 1);
+                this->ripple_add(correction, correction, &correction[fraction_width], fraction_width, nullptr, nullptr);
+                this->ripple_sub(&product[width], &product[width], correction, fraction_width);
+            }
+
+            std::copy(&product[fraction_width], &product[product_width], output);
+        }
+
+        /**
+         * @brief Writes the sign, exponent, and mantissa of a floating-point
+         * result, or zero if @p nonzero is 0.
+         */
+        void float_pack(typename ProtEngine::Wire* output, const typename ProtEngine::Wire& nonzero, const typename ProtEngine::Wire& sign, const typename ProtEngine::Wire* exponent, const typename ProtEngine::Wire* mantissa, BitWidth exponent_width, BitWidth mantissa_width) {
+            BitWidth width = exponent_width + mantissa_width + 1;
+            ScratchWires result(*this, width);
+            ScratchWires keep(*this, width);
+            std::copy(mantissa, mantissa + mantissa_width, &result[0]);
+            std::copy(exponent, exponent + exponent_width, &result[mantissa_width]);
+            this->protocol.op_copy(result[width - 1], sign);
             for (BitWidth i = 0; i != width; i++) {
-                this->protocol.op_xor(different, input1[i], input2[i]);
-                this->protocol.op_and(temp, different, selector);
-                this->protocol.op_xor(output[i], temp, input2[i]);
+                this->protocol.op_copy(keep[i], nonzero);
+            }
+            this->and_layer(output, result, keep, width);
+        }
+
+        /**
+         * @brief Checks if a signed exponent, computed with extra bits, is
+         * within the range of normal floating-point numbers (i.e., positive).
+         */
+        void float_exponent_positive(typename ProtEngine::Wire& output, const typename ProtEngine::Wire* exponent, BitWidth width) {
+            typename ProtEngine::Wire nonzero;
+            this->any_set(nonzero, exponent, width - 1);
+            typename ProtEngine::Wire nonnegative;
+            this->protocol.op_not(nonnegative, exponent[width - 1]);
+            this->protocol.op_and(output, nonzero, nonnegative);
+        }
+
+        /*
+         * Adds two floating-point numbers. The operands are ordered by
+         * magnitude, the smaller significand is aligned to the larger one
+         * with a barrel shifter, and the significands are added or
+         * subtracted. The sum is normalized by shifting right by one bit on
+         * overflow, or left past any leading zeros from cancellation. Three
+         * guard bits are kept below the mantissa during alignment, and the
+         * result is truncated.
+         */
+        void float_add(typename ProtEngine::Wire* output, const typename ProtEngine::Wire* input1, const typename ProtEngine::Wire* input2, BitWidth exponent_width, BitWidth mantissa_width) {
+            constexpr BitWidth guard_width = 3;
+            BitWidth magnitude_width = exponent_width + mantissa_width;
+            BitWidth width = magnitude_width + 1;
+
+            /* Order the operands so that big has the larger magnitude. */
+            typename ProtEngine::Wire swap;
+            this->less_than(swap, input1, input2, magnitude_width);
+            ScratchWires big(*this, width);
+            ScratchWires small(*this, width);
+            this->select(big, swap, input2, input1, width);
+            for (BitWidth i = 0; i != width; i++) {
+                this->protocol.op_xor(small[i], input1[i], input2[i]);
+                this->protocol.op_xor(small[i], small[i], big[i]);
+            }
+
+            /* Form the significands, with the hidden bit and guard bits. */
+            BitWidth significand_width = guard_width + mantissa_width + 1;
+            ScratchWires big_significand(*this, significand_width);
+            ScratchWires small_significand(*this, significand_width);
+            for (BitWidth i = 0; i != guard_width; i++) {
+                this->protocol.zero(big_significand[i]);
+                this->protocol.zero(small_significand[i]);
+            }
+            std::copy(&big[0], &big[mantissa_width], &big_significand[guard_width]);
+            std::copy(&small[0], &small[mantissa_width], &small_significand[guard_width]);
+            this->any_set(big_significand[significand_width - 1], &big[mantissa_width], exponent_width);
+            this->any_set(small_significand[significand_width - 1], &small[mantissa_width], exponent_width);
+
+            /* Align the smaller significand to the larger one. */
+            ScratchWires distance(*this, exponent_width);
+            this->ripple_sub(distance, &big[mantissa_width], &small[mantissa_width], exponent_width);
+            this->shift_right(small_significand, significand_width, distance, exponent_width);
+
+            /* Add the significands, or subtract them if the signs differ. */
+            typename ProtEngine::Wire subtract;
+            this->protocol.op_xor(subtract, big[magnitude_width], small[magnitude_width]);
+            for (BitWidth i = 0; i != significand_width; i++) {
+                this->protocol.op_xor(small_significand[i], small_significand[i], subtract);
+            }
+            typename ProtEngine::Wire carry;
+            this->ripple_add(big_significand, big_significand, small_significand, significand_width, &subtract, &carry);
+            typename ProtEngine::Wire adding;
+            this->protocol.op_not(adding, subtract);
+            typename ProtEngine::Wire overflow;
+            this->protocol.op_and(overflow, carry, adding);
+
+            /* Normalize the sum. */
+            ScratchWires shifted(*this, significand_width);
+            std::copy(&big_significand[1], &big_significand[significand_width], &shifted[0]);
+            this->protocol.op_copy(shifted[significand_width - 1], overflow);
+            this->select(big_significand, overflow, shifted, big_significand, significand_width);
+            BitWidth shift_width = util::log_base_2(significand_width);
+            ScratchWires leading(*this, shift_width);
+            this->normalize_left(big_significand, significand_width, leading, shift_width);
+
+            /*
+             * Adjust the exponent, with two extra bits to detect underflow. On
+             * overflow, no leading zeros were removed, so XORing the overflow
+             * bit into every bit of the adjustment turns it into -1.
+             */
+            BitWidth exponent_ext_width = std::max(exponent_width, shift_width) + 2;
+            ScratchWires exponent(*this, exponent_ext_width);
+            ScratchWires adjustment(*this, exponent_ext_width);
+            for (BitWidth i = 0; i != exponent_ext_width; i++) {
+                if (i < exponent_width) {
+                    this->protocol.op_copy(exponent[i], big[mantissa_width + i]);
+                } else {
+                    this->protocol.zero(exponent[i]);
+                }
+                if (i < shift_width) {
+                    this->protocol.op_xor(adjustment[i], leading[i], overflow);
+                } else {
+                    this->protocol.op_copy(adjustment[i], overflow);
+                }
+            }
+            this->ripple_sub(exponent, exponent, adjustment, exponent_ext_width);
+
+            typename ProtEngine::Wire nonzero;
+            this->float_exponent_positive(nonzero, exponent, exponent_ext_width);
+            this->protocol.op_and(nonzero, nonzero, big_significand[significand_width - 1]);
+            this->float_pack(output, nonzero, big[magnitude_width], exponent, &big_significand[guard_width], exponent_width, mantissa_width);
+        }
+
+        void execute_float_add(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth mantissa_width = packed_width_low(phys.two_args.width);
+            BitWidth exponent_width = packed_width_high(phys.two_args.width);
+
+            this->float_add(output, input1, input2, exponent_width, mantissa_width);
+        }
+
+        void execute_float_sub(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth mantissa_width = packed_width_low(phys.two_args.width);
+            BitWidth exponent_width = packed_width_high(phys.two_args.width);
+            BitWidth width = exponent_width + mantissa_width + 1;
+
+            ScratchWires negated(*this, width);
+            std::copy(input2, input2 + width, &negated[0]);
+            this->protocol.op_not(negated[width - 1], input2[width - 1]);
+            this->float_add(output, input1, negated, exponent_width, mantissa_width);
+        }
+
+        /*
+         * Multiplies two floating-point numbers. The product of the
+         * significands is in [1, 4), so it is normalized by shifting right by
+         * at most one bit, and the result is truncated.
+         */
+        void execute_float_multiply(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth mantissa_width = packed_width_low(phys.two_args.width);
+            BitWidth exponent_width = packed_width_high(phys.two_args.width);
+            BitWidth magnitude_width = exponent_width + mantissa_width;
+
+            BitWidth significand_width = mantissa_width + 1;
+            ScratchWires significand1(*this, significand_width);
+            ScratchWires significand2(*this, significand_width);
+            std::copy(input1, input1 + mantissa_width, &significand1[0]);
+            std::copy(input2, input2 + mantissa_width, &significand2[0]);
+            this->any_set(significand1[mantissa_width], &input1[mantissa_width], exponent_width);
+            this->any_set(significand2[mantissa_width], &input2[mantissa_width], exponent_width);
+
+            BitWidth product_width = significand_width << 1;
+            ScratchWires product(*this, product_width);
+            this->multiply_truncated(product, significand1, significand2, significand_width, product_width);
+            typename ProtEngine::Wire& overflow = product[product_width - 1];
+            ScratchWires mantissa(*this, mantissa_width);
+            this->select(mantissa, overflow, &product[significand_width], &product[mantissa_width], mantissa_width);
+
+            /* Add the exponents and the overflow, and subtract the bias. */
+            BitWidth exponent_ext_width = exponent_width + 2;
+            ScratchWires exponent(*this, exponent_ext_width);
+            ScratchWires addend(*this, exponent_ext_width);
+            ScratchWires bias(*this, exponent_ext_width);
+            for (BitWidth i = 0; i != exponent_ext_width; i++) {
+                if (i < exponent_width) {
+                    this->protocol.op_copy(exponent[i], input1[mantissa_width + i]);
+                    this->protocol.op_copy(addend[i], input2[mantissa_width + i]);
+                } else {
+                    this->protocol.zero(exponent[i]);
+                    this->protocol.zero(addend[i]);
+                }
+                if (i < exponent_width - 1) {
+                    this->protocol.one(bias[i]);
+                } else {
+                    this->protocol.zero(bias[i]);
+                }
             }
+            this->ripple_add(exponent, exponent, addend, exponent_ext_width, &overflow, nullptr);
+            this->ripple_sub(exponent, exponent, bias, exponent_ext_width);
+
+            typename ProtEngine::Wire nonzero;
+            this->float_exponent_positive(nonzero, exponent, exponent_ext_width);
+            this->protocol.op_and(nonzero, nonzero, significand1[mantissa_width]);
+            this->protocol.op_and(nonzero, nonzero, significand2[mantissa_width]);
+            typename ProtEngine::Wire sign;
+            this->protocol.op_xor(sign, input1[magnitude_width], input2[magnitude_width]);
+            this->float_pack(output, nonzero, sign, exponent, mantissa, exponent_width, mantissa_width);
+        }
+
+        /*
+         * Compares two floating-point numbers. With equal signs, the result
+         * follows from comparing magnitudes (reversed if both are negative).
+         * With different signs, input1 is less if it is negative, unless both
+         * are zero.
+         */
+        void execute_float_less(const PackedPhysInstruction& phys) {
+            typename ProtEngine::Wire* output = &this->wires[phys.two_args.output];
+            typename ProtEngine::Wire* input1 = &this->wires[phys.two_args.input1];
+            typename ProtEngine::Wire* input2 = &this->wires[phys.two_args.input2];
+            BitWidth mantissa_width = packed_width_low(phys.two_args.width);
+            BitWidth exponent_width = packed_width_high(phys.two_args.width);
+            BitWidth magnitude_width = exponent_width + mantissa_width;
+            const typename ProtEngine::Wire& sign1 = input1[magnitude_width];
+            const typename ProtEngine::Wire& sign2 = input2[magnitude_width];
+
+            typename ProtEngine::Wire less;
+            typename ProtEngine::Wire greater;
+            this->less_than(less, input1, input2, magnitude_width);
+            this->less_than(greater, input2, input1, magnitude_width);
+            typename ProtEngine::Wire same_signs;
+            this->select(&same_signs, sign1, &greater, &less, 1);
+
+            ScratchWires either(*this, magnitude_width);
+            ScratchWires temp(*this, magnitude_width);
+            this->and_layer(temp, input1, input2, magnitude_width);
+            for (BitWidth i = 0; i != magnitude_width; i++) {
+                this->protocol.op_xor(either[i], input1[i], input2[i]);
+                this->protocol.op_xor(either[i], either[i], temp[i]);
+            }
+            typename ProtEngine::Wire different_signs;
+            this->any_set(different_signs, either, magnitude_width);
+            this->protocol.op_and(different_signs, different_signs, sign1);
+
+            typename ProtEngine::Wire signs_differ;
+            this->protocol.op_xor(signs_differ, sign1, sign2);
+            this->select(output, signs_differ, &different_signs, &same_signs, 1);
         }
 
         /**
@@ -425,6 +1358,9 @@ namespace mage::engine {
             case OpCode::CopySwap:
                 this->copy_page(phys.swap.storage, phys.swap.memory);
                 return PackedPhysInstruction::size(OpCode::CopySwap);
+            case OpCode::DiscardPage:
+                this->discard_page(phys.swap_finish.memory);
+                return PackedPhysInstruction::size(OpCode::DiscardPage);
             case OpCode::NetworkPostReceive:
                 this->network_post_receive<typename ProtEngine::Wire>(phys.constant.constant, &this->wires[phys.constant.output], phys.constant.width);
                 return PackedPhysInstruction::size(OpCode::NetworkPostReceive);
@@ -450,34 +1386,66 @@ namespace mage::engine {
                 this->execute_copy(phys);
                 return PackedPhysInstruction::size(OpCode::Copy);
             case OpCode::IntAdd:
-                this->execute_int_add<false>(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_int_add_low_depth<false>(phys);
+                } else {
+                    this->execute_int_add<false>(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IntAdd);
             case OpCode::IntAddWithCarry:
-                this->execute_int_add<true>(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_int_add_low_depth<true>(phys);
+                } else {
+                    this->execute_int_add<true>(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IntAddWithCarry);
             case OpCode::IntIncrement:
                 this->execute_int_increment(phys);
                 return PackedPhysInstruction::size(OpCode::IntIncrement);
             case OpCode::IntSub:
-                this->execute_int_sub(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_int_sub_low_depth(phys);
+                } else {
+                    this->execute_int_sub(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IntSub);
             case OpCode::IntDecrement:
                 this->execute_int_decrement(phys);
                 return PackedPhysInstruction::size(OpCode::IntDecrement);
             case OpCode::IntMultiply:
-                this->execute_int_multiply(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_int_multiply_low_depth(phys);
+                } else {
+                    this->execute_int_multiply(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IntMultiply);
             case OpCode::IntLess:
-                this->execute_int_less(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_int_less_low_depth(phys);
+                } else {
+                    this->execute_int_less(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IntLess);
             case OpCode::Equal:
-                this->execute_equal(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_equal_low_depth(phys);
+                } else {
+                    this->execute_equal(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::Equal);
             case OpCode::IsZero:
-                this->execute_is_zero(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_is_zero_low_depth<false>(phys);
+                } else {
+                    this->execute_is_zero(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::IsZero);
             case OpCode::NonZero:
-                this->execute_non_zero(phys);
+                if (this->low_depth_circuits) {
+                    this->execute_is_zero_low_depth<true>(phys);
+                } else {
+                    this->execute_non_zero(phys);
+                }
                 return PackedPhysInstruction::size(OpCode::NonZero);
             case OpCode::BitNOT:
                 this->execute_bit_not(phys);
@@ -494,6 +1462,24 @@ namespace mage::engine {
             case OpCode::ValueSelect:
                 this->execute_value_select(phys);
                 return PackedPhysInstruction::size(OpCode::ValueSelect);
+            case OpCode::IntLessSigned:
+                this->execute_int_less_signed(phys);
+                return PackedPhysInstruction::size(OpCode::IntLessSigned);
+            case OpCode::FixedMultiply:
+                this->execute_fixed_multiply(phys);
+                return PackedPhysInstruction::size(OpCode::FixedMultiply);
+            case OpCode::FloatAdd:
+                this->execute_float_add(phys);
+                return PackedPhysInstruction::size(OpCode::FloatAdd);
+            case OpCode::FloatSub:
+                this->execute_float_sub(phys);
+                return PackedPhysInstruction::size(OpCode::FloatSub);
+            case OpCode::FloatMultiply:
+                this->execute_float_multiply(phys);
+                return PackedPhysInstruction::size(OpCode::FloatMultiply);
+            case OpCode::FloatLess:
+                this->execute_float_less(phys);
+                return PackedPhysInstruction::size(OpCode::FloatLess);
             default:
                 std::cerr << "Instruction " << opcode_to_string(phys.header.operation) << " is not supported." << std::endl;
                 std::abort();
@@ -503,6 +1489,14 @@ namespace mage::engine {
         ProtEngine& protocol;
         typename ProtEngine::Wire* wires;
         PhysProgramFileReader input;
+        bool low_depth_circuits;
+
+        struct ScratchLevel {
+            std::unique_ptr<typename ProtEngine::Wire[]> wires;
+            std::size_t capacity = 0;
+        };
+        std::vector<ScratchLevel> scratch;
+        std::size_t scratch_depth = 0;
     };
 }
 
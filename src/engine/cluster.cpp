@@ -33,6 +33,7 @@
 #include <utility>
 #include <vector>
 #include "engine/cluster.hpp"
+#include "platform/affinity.hpp"
 #include "platform/filesystem.hpp"
 #include "platform/network.hpp"
 #include "util/config.hpp"
@@ -41,7 +42,7 @@
 
 namespace mage::engine {
     MessageChannel::MessageChannel(int fd, std::size_t buffer_size) : reader(fd, false, buffer_size), writer(fd, false, buffer_size), socket_fd(fd),
-        posted_reads(1 << 14), num_posted_reads(0) {
+        posted_reads(1 << 14), num_posted_reads(0), bytes_sent(0), bytes_received(0) {
         if (fd != -1) {
             this->start_reading_daemon();
         }
@@ -64,11 +65,14 @@ namespace mage::engine {
     void MessageChannel::start_reading_daemon() {
         assert(!this->reading_daemon.joinable());
         this->reading_daemon = std::thread([this]() {
+            platform::pin_thread(platform::ThreadRole::Network);
+
             const AsyncRead* read_op;
             while ((read_op = this->posted_reads.start_read_in_place(1)) != nullptr) {
                 std::uint8_t* buffer = &(this->reader.start_read<std::uint8_t>(read_op->length));
                 std::copy(buffer, buffer + read_op->length, static_cast<std::uint8_t*>(read_op->into));
                 this->reader.finish_read(read_op->length);
+                this->bytes_received.fetch_add(read_op->length, std::memory_order_relaxed);
                 this->posted_reads.finish_read_in_place(1);
 
                 {
@@ -82,8 +86,9 @@ namespace mage::engine {
         });
     }
 
-    const std::uint32_t ClusterNetwork::max_connection_tries = 20;
-    const std::chrono::duration<std::uint32_t, std::milli> ClusterNetwork::delay_between_connection_tries(3000);
+    const std::chrono::duration<std::uint32_t, std::milli> ClusterNetwork::initial_connection_backoff(1);
+    const std::chrono::duration<std::uint32_t, std::milli> ClusterNetwork::max_connection_backoff(250);
+    const std::chrono::duration<std::uint32_t, std::milli> ClusterNetwork::connection_deadline(60000);
 
     ClusterNetwork::ClusterNetwork(WorkerID self, std::size_t buffer_size) : channels(), channel_buffer_size(buffer_size), self_id(self) {
     }
@@ -117,14 +122,27 @@ namespace mage::engine {
         std::fill(&success[0], &success[num_workers], false);
         success[this->self_id] = true;
 
-        /* Connect to all workers with smaller index. */
+        /*
+         * Start listening before connecting to anyone, so that workers with a
+         * larger index can connect to us (their connections are queued by the
+         * kernel) while we wait on workers with a smaller index.
+         */
+        WorkerID remaining = num_workers - self_id - 1;
+        int server_socket = -1;
+        if (remaining != 0) {
+            server_socket = platform::network_listen(party["workers"][this->self_id]["internal_port"].as_string().c_str());
+        }
+
+        /* Connect to all workers with smaller index, in parallel. */
         /* TODO: use an event loop or bounded thread pool to do this. */
         std::vector<std::thread> connectors;
         connectors.resize(self_id);
         for (WorkerID j = 0; j != self_id; j++) {
             connectors[j] = std::thread([&](WorkerID i) {
                 const util::ConfigValue& worker = party["workers"][i];
-                for (std::uint32_t k = 0; k != ClusterNetwork::max_connection_tries; k++) {
+                auto deadline = std::chrono::steady_clock::now() + ClusterNetwork::connection_deadline;
+                std::chrono::milliseconds backoff = ClusterNetwork::initial_connection_backoff;
+                while (true) {
                     platform::NetworkError err;
                     platform::network_connect(worker["internal_host"].as_string().c_str(), worker["internal_port"].as_string().c_str(), &fds[i], &err);
                     if (err == platform::NetworkError::Success) {
@@ -132,7 +150,11 @@ namespace mage::engine {
                         success[i] = true;
                         return;
                     } else if (err == platform::NetworkError::ConnectionRefused) {
-                        std::this_thread::sleep_for(ClusterNetwork::delay_between_connection_tries);
+                        if (std::chrono::steady_clock::now() + backoff > deadline) {
+                            break;
+                        }
+                        std::this_thread::sleep_for(backoff);
+                        backoff = std::min<std::chrono::milliseconds>(2 * backoff, ClusterNetwork::max_connection_backoff);
                     } else if (err == platform::NetworkError::TimedOut) {
                         break;
                     } else {
@@ -140,12 +162,12 @@ namespace mage::engine {
                         std::abort();
                     }
                 }
+                fds[i] = -1;
                 success[i] = false;
             }, j);
         }
 
         /* Accept connections from all workers with a larger index. */
-        WorkerID remaining = num_workers - self_id - 1;
         std::vector<int> accept_fds;
         accept_fds.resize(remaining);
 
@@ -154,7 +176,8 @@ namespace mage::engine {
          * specified in the configuration file.
          */
         if (remaining != 0) {
-            platform::network_accept(party["workers"][this->self_id]["internal_port"].as_string().c_str(), accept_fds.data(), remaining);
+            platform::network_accept_on(server_socket, accept_fds.data(), remaining);
+            platform::network_close(server_socket);
             for (WorkerID i = 0; i != remaining; i++) {
                 WorkerID from;
                 platform::read_from_file(accept_fds[i], &from, sizeof(from));
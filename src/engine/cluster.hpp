@@ -29,6 +29,7 @@
 #define MAGE_ENGINE_CLUSTER_HPP_
 
 #include <cstdint>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <memory>
@@ -152,6 +153,7 @@ namespace mage::engine {
         template <typename T>
         T* write(std::size_t count) {
             T& buffer = this->writer.write<T>(count * sizeof(T));
+            this->bytes_sent += count * sizeof(T);
             return &buffer;
         }
 
@@ -163,6 +165,29 @@ namespace mage::engine {
             this->writer.flush();
         }
 
+        /**
+         * @brief Returns the number of bytes written to this MessageChannel
+         * so far, including data still buffered for sending.
+         *
+         * This must be called from the thread that writes to this
+         * MessageChannel.
+         *
+         * @return The number of bytes written to this MessageChannel.
+         */
+        std::uint64_t get_bytes_sent() const {
+            return this->bytes_sent;
+        }
+
+        /**
+         * @brief Returns the number of bytes received on this MessageChannel
+         * so far, for asynchronous reads that have completed.
+         *
+         * @return The number of bytes received on this MessageChannel.
+         */
+        std::uint64_t get_bytes_received() const {
+            return this->bytes_received.load(std::memory_order_relaxed);
+        }
+
     private:
         void start_reading_daemon();
 
@@ -175,6 +200,9 @@ namespace mage::engine {
         std::mutex num_posted_reads_mutex;
         std::condition_variable no_posted_reads;
         std::thread reading_daemon;
+
+        std::uint64_t bytes_sent;
+        std::atomic<std::uint64_t> bytes_received;
     };
 
     /*
@@ -224,6 +252,13 @@ namespace mage::engine {
          * @brief Establishes network communication with other workers in this
          * party.
          *
+         * This worker starts listening for connections from workers with a
+         * larger index before connecting to workers with a smaller index, and
+         * connects to all of them in parallel, retrying with exponential
+         * backoff. Thus, the time to set up the cluster is bounded by the
+         * time for the slowest worker to start, rather than by the interval
+         * between retries.
+         *
          * @param party The configuration value for this party, providing the
          * internal network host and port numbers of the other workers in the
          * party.
@@ -250,16 +285,23 @@ namespace mage::engine {
         }
 
         /**
-         * @brief The maximum number of connection attempts when connecting to
-         * other workers.
+         * @brief The delay after the first failed connection attempt when
+         * connecting to other workers. The delay doubles after each failed
+         * attempt, up to @p max_connection_backoff.
+         */
+        static const std::chrono::duration<std::uint32_t, std::milli> initial_connection_backoff;
+
+        /**
+         * @brief The maximum delay between connection attempts when connecting
+         * to other workers.
          */
-        static const std::uint32_t max_connection_tries;
+        static const std::chrono::duration<std::uint32_t, std::milli> max_connection_backoff;
 
         /**
-         * @brief The delay between connection attempts when connecting to
-         * other workers.
+         * @brief The total time for which to keep trying to connect to another
+         * worker before giving up.
          */
-        static const std::chrono::duration<std::uint32_t, std::milli> delay_between_connection_tries;
+        static const std::chrono::duration<std::uint32_t, std::milli> connection_deadline;
 
     private:
         std::vector<std::unique_ptr<MessageChannel>> channels;
@@ -26,17 +26,23 @@
 #include <cstdlib>
 #include <cstring>
 #include <libaio.h>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <tuple>
+#include <utility>
 #include "addr.hpp"
 #include "instruction.hpp"
+#include "engine/remotememory.hpp"
 #include "opcode.hpp"
 #include "platform/filesystem.hpp"
+#include "util/config.hpp"
 #include "util/stats.hpp"
 
 namespace mage::engine {
-    void Engine::init(const std::string& storage_file, PageSize page_size_in_bytes, std::uint64_t num_pages, std::uint64_t swap_pages, std::uint32_t concurrent_swaps) {
+    void Engine::init(const util::ConfigValue& worker, PageSize page_size_in_bytes, std::uint64_t num_pages, const std::uint64_t (&swap_pages)[max_storage_tiers], std::uint32_t concurrent_swaps, bool populate_memory) {
         assert(this->memory == nullptr);
         auto start = std::chrono::steady_clock::now();
 
@@ -48,12 +54,96 @@ namespace mage::engine {
 
         this->memory_size = num_pages * page_size_in_bytes;
         auto mem_start = std::chrono::steady_clock::now();
-        this->memory = platform::allocate_resident_memory<std::uint8_t>(this->memory_size);
+        this->memory = platform::allocate_resident_memory<std::uint8_t>(this->memory_size, !populate_memory);
         auto mem_end = std::chrono::steady_clock::now();
-        std::uint64_t required_size = swap_pages * page_size_in_bytes;
-        if (storage_file.rfind("/dev/", 0) != std::string::npos) {
+        this->page_size_bytes = page_size_in_bytes;
+
+        /*
+         * Either a single storage_path, or one storage_path per tier (fastest
+         * first), each with an optional limit on concurrent transfers.
+         */
+        if (worker.get("swap_tiers") != nullptr) {
+            const util::ConfigValue& tiers = worker["swap_tiers"];
+            for (std::size_t i = 0; i != tiers.get_size(); i++) {
+                SwapTier& tier = this->swap_tiers.emplace_back(SwapTier {});
+                if (tiers[i].get("memory_server") != nullptr) {
+                    tier.path = tiers[i]["memory_server"].as_string();
+                    tier.memory_server = true;
+                } else if (tiers[i].get("storage_path") != nullptr) {
+                    tier.path = tiers[i]["storage_path"].as_string();
+                } else {
+                    std::cerr << "No storage path is specified for swap tier " << i << std::endl;
+                    std::abort();
+                }
+                tier.max_in_flight = concurrent_swaps;
+                if (tiers[i].get("concurrent_swaps") != nullptr) {
+                    tier.max_in_flight = std::max<std::int64_t>(tiers[i]["concurrent_swaps"].as_int(), 1);
+                }
+            }
+        } else if (worker.get("memory_server") != nullptr) {
+            SwapTier& tier = this->swap_tiers.emplace_back(SwapTier {});
+            tier.path = worker["memory_server"].as_string();
+            tier.memory_server = true;
+            tier.max_in_flight = concurrent_swaps;
+        } else if (worker.get("storage_path") != nullptr) {
+            SwapTier& tier = this->swap_tiers.emplace_back(SwapTier {});
+            tier.path = worker["storage_path"].as_string();
+            tier.max_in_flight = concurrent_swaps;
+        } else {
+            std::cerr << "No storage path is specified for this worker" << std::endl;
+            std::abort();
+        }
+        for (std::uint8_t i = this->swap_tiers.size(); i != max_storage_tiers; i++) {
+            if (swap_pages[i] != 0) {
+                std::cerr << "Program swaps to storage tier " << static_cast<int>(i) << ", but only " << this->swap_tiers.size() << " tiers are configured" << std::endl;
+                std::abort();
+            }
+        }
+
+        bool pretouch = (worker.get("storage_pretouch") != nullptr && worker["storage_pretouch"].as_int() != 0);
+        auto swap_start = std::chrono::steady_clock::now();
+        for (std::uint8_t i = 0; i != this->swap_tiers.size(); i++) {
+            this->open_swap_tier(this->swap_tiers[i], swap_pages[i] * page_size_in_bytes, pretouch);
+        }
+        auto swap_end = std::chrono::steady_clock::now();
+
+        if (worker.get("status_file") != nullptr) {
+            this->status_path = worker["status_file"].as_string();
+            this->status_interval = 1 << 16;
+            if (worker.get("status_interval") != nullptr) {
+                std::int64_t temp = worker["status_interval"].as_int();
+                if (temp <= 0) {
+                    std::cerr << "Specified \"status_interval\" is " << temp << ", but it must be positive" << std::endl;
+                    std::abort();
+                }
+                this->status_interval = static_cast<InstructionNumber>(temp);
+            }
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "Memory alloc time: " << std::chrono::duration_cast<std::chrono::milliseconds>(mem_end - mem_start).count() << " ms" << std::endl;
+        std::cout << "Swap prepare time: " << std::chrono::duration_cast<std::chrono::milliseconds>(swap_end - swap_start).count() << " ms" << std::endl;
+        std::cout << "Total init time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+    }
+
+    void Engine::open_swap_tier(SwapTier& tier, std::uint64_t required_size, bool pretouch) {
+        if (tier.memory_server) {
+            std::size_t colon = tier.path.rfind(':');
+            if (colon == std::string::npos) {
+                std::cerr << "Memory server " << tier.path << " is not of the form host:port" << std::endl;
+                std::abort();
+            }
+            tier.fd = -1;
+            tier.remote = std::make_unique<RemoteMemory>(tier.path.substr(0, colon), tier.path.substr(colon + 1), required_size);
+            std::cout << "Swap space " << tier.path << ": " << (required_size >> 20) << " MiB on memory server" << std::endl;
+            return;
+        }
+
+        const std::string& storage_file = tier.path;
+        bool device = (storage_file.rfind("/dev/", 0) != std::string::npos);
+        if (device) {
             std::uint64_t length;
-            this->swapfd = platform::open_file(storage_file.c_str(), &length, true);
+            tier.fd = platform::open_file(storage_file.c_str(), &length, true);
             if (length < required_size) {
                 std::cerr << "Disk too small: size is " << length << " B, requires " << required_size << " B" << std::endl;
                 std::abort();
@@ -62,26 +152,55 @@ namespace mage::engine {
             bool create = false;
             if (std::filesystem::exists(storage_file)) {
                 std::uint64_t length;
-                this->swapfd = platform::open_file(storage_file.c_str(), &length, true);
+                tier.fd = platform::open_file(storage_file.c_str(), &length, true);
                 if (length < required_size) {
-                    platform::close_file(this->swapfd);
+                    platform::close_file(tier.fd);
                     create = true;
                 }
             } else {
                 create = true;
             }
             if (create) {
-                this->swapfd = platform::create_file(storage_file.c_str(), required_size, true, true);
+                tier.fd = platform::create_file(storage_file.c_str(), required_size, true, false);
             }
         }
-        this->page_size_bytes = page_size_in_bytes;
 
-        auto end = std::chrono::steady_clock::now();
-        std::cout << "Memory alloc time: " << std::chrono::duration_cast<std::chrono::milliseconds>(mem_end - mem_start).count() << " ms" << std::endl;
-        std::cout << "Total init time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+        /*
+         * Swaps use O_DIRECT, so every page must start on, and be a multiple
+         * of, the device's logical block size (or the file system's direct
+         * I/O alignment).
+         */
+        std::uint64_t alignment = platform::direct_io_alignment(tier.fd);
+        if (this->page_size_bytes % alignment != 0 || reinterpret_cast<std::uintptr_t>(this->memory) % alignment != 0) {
+            std::cerr << "Page size of " << this->page_size_bytes << " B is incompatible with the direct I/O alignment of " << alignment << " B for " << storage_file << std::endl;
+            std::abort();
+        }
+
+        if (!device && required_size != 0) {
+            /*
+             * Allocate the full extent up front (whether the file is new or
+             * reused), so that swap-outs never hit holes. If preallocation
+             * is unsupported, fall back to writing zeros.
+             */
+            if (!platform::preallocate_file(tier.fd, required_size)) {
+                pretouch = true;
+            }
+            if (pretouch) {
+                platform::zero_file(tier.fd, required_size);
+            }
+            std::uint64_t extents;
+            std::uint64_t unwritten;
+            if (platform::count_file_extents(tier.fd, required_size, extents, unwritten)) {
+                std::cout << "Swap file " << storage_file << ": " << (required_size >> 20) << " MiB in " << extents << " extents (" << unwritten << " unwritten), direct I/O alignment " << alignment << " B" << std::endl;
+            }
+        }
     }
 
     Engine::~Engine()  {
+        for (SwapTier& tier : this->swap_tiers) {
+            /* Remote reads must not land in memory after it is freed. */
+            tier.remote.reset();
+        }
         if (this->aio_ctx != 0 && io_destroy(this->aio_ctx) != 0) {
             std::perror("io_destroy");
             std::abort();
@@ -89,55 +208,123 @@ namespace mage::engine {
         if (this->memory_size != 0) {
             platform::deallocate_resident_memory(this->memory, this->memory_size);
         }
-        if (this->swapfd != -1) {
-            platform::close_file(this->swapfd);
+        for (SwapTier& tier : this->swap_tiers) {
+            if (tier.fd != -1) {
+                platform::close_file(tier.fd);
+            }
         }
     }
 
+    Engine::SwapTier& Engine::reserve_swap_slot(StoragePageNumber spn) {
+        SwapTier& tier = this->swap_tiers[storage_tier(spn)];
+        if (tier.remote != nullptr) {
+            /* Transfers to a memory server complete in the order issued. */
+            if (tier.remote->get_num_in_flight() >= tier.max_in_flight) {
+                auto start = std::chrono::steady_clock::now();
+                tier.remote->wait(tier.remote->get_num_issued() - tier.max_in_flight + 1);
+                auto end = std::chrono::steady_clock::now();
+                this->swap_throttled.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+            return tier;
+        }
+        if (tier.num_in_flight == tier.max_in_flight) {
+            /* This tier is at its concurrency limit, so wait for a slot. */
+            auto start = std::chrono::steady_clock::now();
+            do {
+                this->reap_swaps(invalid_paddr);
+            } while (tier.num_in_flight == tier.max_in_flight);
+            auto end = std::chrono::steady_clock::now();
+            this->swap_throttled.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+        tier.num_in_flight++;
+        return tier;
+    }
+
     void Engine::issue_swap_in(StoragePageNumber spn, PhysPageNumber ppn) {
+        SwapTier& tier = this->reserve_swap_slot(spn);
+
         /* These are byte addresses (not wire addresses). */
-        StorageAddr saddr = spn * this->page_size_bytes;
+        StorageAddr saddr = storage_tier_frame(spn) * this->page_size_bytes;
         PhysAddr paddr = ppn * this->page_size_bytes;
 
         auto start = std::chrono::steady_clock::now();
         assert(this->in_flight_swaps.find(paddr) == this->in_flight_swaps.end());
-        struct iocb& op = this->in_flight_swaps[paddr];
-        struct iocb* op_ptr = &op;
-        // io_prep_pread(op_ptr, this->swapfd, &this->memory[paddr], pg_size(this->page_shift) * sizeof(typename ProtEngine::Wire), saddr * sizeof(typename ProtEngine::Wire));
-        io_prep_pread(op_ptr, this->swapfd, &this->memory[paddr], this->page_size_bytes, saddr);
-        op_ptr->data = &this->memory[paddr];
-        int rv = io_submit(this->aio_ctx, 1, &op_ptr);
-        if (rv != 1) {
-            std::cerr << "io_submit: " << std::strerror(-rv) << std::endl;
-            std::abort();
+        InFlightSwap& swap = this->in_flight_swaps[paddr];
+        swap.tier = storage_tier(spn);
+        if (tier.remote != nullptr) {
+            swap.ticket = tier.remote->read(&this->memory[paddr], saddr, this->page_size_bytes);
+        } else {
+            struct iocb* op_ptr = &swap.op;
+            io_prep_pread(op_ptr, tier.fd, &this->memory[paddr], this->page_size_bytes, saddr);
+            op_ptr->data = &this->memory[paddr];
+            int rv = io_submit(this->aio_ctx, 1, &op_ptr);
+            if (rv != 1) {
+                std::cerr << "io_submit: " << std::strerror(-rv) << std::endl;
+                std::abort();
+            }
         }
-        // platform::read_from_file_at(this->swapfd, &this->memory[paddr], pg_size(this->page_shift) * sizeof(typename ProtEngine::Wire), saddr * sizeof(typename ProtEngine::Wire));
+        tier.num_swap_ins++;
         auto end = std::chrono::steady_clock::now();
         this->swap_in.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
     }
 
     void Engine::issue_swap_out(PhysPageNumber ppn, StoragePageNumber spn) {
+        SwapTier& tier = this->reserve_swap_slot(spn);
+
         /* These are byte addresses (not wire addresses). */
         PhysAddr paddr = ppn * this->page_size_bytes;
-        StorageAddr saddr = spn * this->page_size_bytes;
+        StorageAddr saddr = storage_tier_frame(spn) * this->page_size_bytes;
 
         auto start = std::chrono::steady_clock::now();
         assert(this->in_flight_swaps.find(paddr) == this->in_flight_swaps.end());
-        struct iocb& op = this->in_flight_swaps[paddr];
-        struct iocb* op_ptr = &op;
-        // io_prep_pwrite(op_ptr, this->swapfd, &this->memory[paddr], pg_size(this->page_shift) * sizeof(typename ProtEngine::Wire), saddr * sizeof(typename ProtEngine::Wire));
-        io_prep_pwrite(op_ptr, this->swapfd, &this->memory[paddr], this->page_size_bytes, saddr);
-        op_ptr->data = &this->memory[paddr];
-        int rv = io_submit(this->aio_ctx, 1, &op_ptr);
-        if (rv != 1) {
-            std::cerr << "io_submit: " << std::strerror(-rv) << std::endl;
-            std::abort();
+        InFlightSwap& swap = this->in_flight_swaps[paddr];
+        swap.tier = storage_tier(spn);
+        if (tier.remote != nullptr) {
+            swap.ticket = tier.remote->write(&this->memory[paddr], saddr, this->page_size_bytes);
+        } else {
+            struct iocb* op_ptr = &swap.op;
+            io_prep_pwrite(op_ptr, tier.fd, &this->memory[paddr], this->page_size_bytes, saddr);
+            op_ptr->data = &this->memory[paddr];
+            int rv = io_submit(this->aio_ctx, 1, &op_ptr);
+            if (rv != 1) {
+                std::cerr << "io_submit: " << std::strerror(-rv) << std::endl;
+                std::abort();
+            }
         }
-        //platform::write_to_file_at(this->swapfd, &this->memory[paddr], pg_size(this->page_shift) * sizeof(typename ProtEngine::Wire), saddr * sizeof(typename ProtEngine::Wire));
+        tier.num_swap_outs++;
         auto end = std::chrono::steady_clock::now();
         this->swap_out.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
     }
 
+    bool Engine::reap_swaps(PhysAddr paddr) {
+        bool found = false;
+        struct io_event events[aio_process_batch_size];
+        int rv = io_getevents(this->aio_ctx, 1, aio_process_batch_size, events, nullptr);
+        if (rv < 1) {
+            std::cerr << "io_getevents: " << std::strerror(-rv) << std::endl;
+            std::abort();
+        }
+        for (int i = 0; i != rv; i++) {
+            struct io_event& event = events[i];
+            std::uint8_t* page_start = reinterpret_cast<std::uint8_t*>(event.data);
+            assert(page_start != nullptr);
+            PhysAddr found_paddr = page_start - this->memory;
+
+            auto iter = this->in_flight_swaps.find(found_paddr);
+            assert(iter != this->in_flight_swaps.end());
+            assert(event.obj == &iter->second.op);
+            this->swap_tiers[iter->second.tier].num_in_flight--;
+            this->in_flight_swaps.erase(iter);
+            if (event.res < 0) {
+                std::cerr << "Swap failed" << std::endl;
+                std::abort();
+            }
+
+            found = (found || (found_paddr == paddr));
+        }
+        return found;
+    }
+
     void Engine::wait_for_finish_swap(PhysPageNumber ppn) {
         PhysAddr paddr = ppn * this->page_size_bytes;
 
@@ -148,32 +335,14 @@ namespace mage::engine {
 
         auto start = std::chrono::steady_clock::now();
 
-        bool found = false;
-        do {
-            struct io_event events[aio_process_batch_size];
-            int rv = io_getevents(this->aio_ctx, 1, aio_process_batch_size, events, nullptr);
-            if (rv < 1) {
-                std::cerr << "io_getevents: " << std::strerror(-rv) << std::endl;
-                std::abort();
-            }
-            for (int i = 0; i != rv; i++) {
-                struct io_event& event = events[i];
-                std::uint8_t* page_start = reinterpret_cast<std::uint8_t*>(event.data);
-                assert(page_start != nullptr);
-                PhysAddr found_paddr = page_start - this->memory;
-
-                iter = this->in_flight_swaps.find(found_paddr);
-                assert(iter != this->in_flight_swaps.end());
-                assert(event.obj == &iter->second);
-                this->in_flight_swaps.erase(iter);
-                if (event.res < 0) {
-                    std::cerr << "Swap failed" << std::endl;
-                    std::abort();
-                }
-
-                found = (found || (found_paddr == paddr));
+        RemoteMemory* remote = this->swap_tiers[iter->second.tier].remote.get();
+        if (remote != nullptr) {
+            remote->wait(iter->second.ticket);
+            this->in_flight_swaps.erase(iter);
+        } else {
+            while (!this->reap_swaps(paddr)) {
             }
-        } while (!found);
+        }
 
         auto end = std::chrono::steady_clock::now();
         this->swap_blocked.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
@@ -189,6 +358,59 @@ namespace mage::engine {
         this->swap_copy.event(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
     }
 
+    void Engine::discard_page(PhysPageNumber ppn) {
+        /* Pages smaller than the system's page size are left in place. */
+        if (this->page_size_bytes % platform::system_page_size() == 0) {
+            platform::release_resident_memory(&this->memory[ppn * this->page_size_bytes], this->page_size_bytes);
+        }
+    }
+
+    void Engine::start_status(InstructionNumber num_instructions) {
+        if (this->status_path.empty()) {
+            return;
+        }
+        this->status = std::make_unique<StatusFile>(this->status_path, this->cluster->get_self(), this->cluster->get_num_workers());
+        this->status->header()->num_instructions = num_instructions;
+        this->status_start = std::chrono::steady_clock::now();
+        this->publish_status(0);
+    }
+
+    void Engine::publish_status(InstructionNumber completed) {
+        auto now = std::chrono::steady_clock::now();
+        std::uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->status_start).count();
+        StatusHeader* header = this->status->header();
+        InstructionNumber num_instructions = header->num_instructions;
+
+        this->status->begin_update();
+        header->instruction = completed;
+        header->elapsed_ns = elapsed;
+        if (completed != 0) {
+            /* Assume the remaining instructions run at the average rate so far. */
+            header->eta_ns = static_cast<std::uint64_t>(static_cast<double>(elapsed) * (num_instructions - completed) / completed);
+        }
+        header->swap_blocked_ns = this->swap_blocked.get_sum();
+        header->swap_throttled_ns = this->swap_throttled.get_sum();
+        std::tie(header->protocol_bytes_sent, header->protocol_bytes_received) = this->get_protocol_traffic();
+        for (WorkerID i = 0; i != header->num_workers; i++) {
+            MessageChannel* channel = this->cluster->contact_worker(i);
+            if (channel != nullptr) {
+                StatusPeer* peer = this->status->peer(i);
+                peer->bytes_sent = channel->get_bytes_sent();
+                peer->bytes_received = channel->get_bytes_received();
+            }
+        }
+        this->status->end_update();
+
+        this->next_status_update = std::min(completed + this->status_interval, num_instructions);
+        if (this->next_status_update == completed) {
+            this->next_status_update = UINT64_MAX;
+        }
+    }
+
+    std::pair<std::uint64_t, std::uint64_t> Engine::get_protocol_traffic() const {
+        return std::make_pair(0, 0);
+    }
+
     MessageChannel& Engine::contact_worker_checked(WorkerID worker_id) {
         MessageChannel* channel = this->cluster->contact_worker(worker_id);
         if (channel == nullptr) {
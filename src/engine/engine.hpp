@@ -36,10 +36,17 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include "addr.hpp"
 #include "instruction.hpp"
 #include "engine/cluster.hpp"
+#include "engine/remotememory.hpp"
+#include "engine/status.hpp"
+#include "platform/affinity.hpp"
 #include "platform/filesystem.hpp"
 #include "platform/memory.hpp"
+#include "util/config.hpp"
 #include "util/progress.hpp"
 #include "util/stats.hpp"
 
@@ -71,9 +78,11 @@ namespace mage::engine {
          * subclasses call Engine::init() in their constructors.
          */
         Engine(const std::shared_ptr<ClusterNetwork>& network) : memory(nullptr),
-            memory_size(0), swapfd(-1), swap_in("SWAP-IN (ns)", true),
+            memory_size(0), swap_in("SWAP-IN (ns)", true),
             swap_out("SWAP-OUT (ns)", true), swap_blocked("SWAP-BLOCKED (ns)", true),
+            swap_throttled("SWAP-THROTTLED (ns)", true),
             swap_copy("SWAP-COPY (ns)", true), cluster(network), aio_ctx(0),
+            status_interval(0), next_status_update(UINT64_MAX),
             progress_bar("Execution", 1024) {
         }
 
@@ -84,17 +93,32 @@ namespace mage::engine {
          * @brief Initializes this Engine instance (necessary before it can
          * perform useful work).
          *
-         * @param storage_file The file path of the file or device used for
-         * swap space.
+         * Swap space is either a single file or device, given by the
+         * worker's storage_path, or a list of storage tiers given by the
+         * worker's swap_tiers, each with its own storage_path and an optional
+         * limit (concurrent_swaps) on outstanding transfers to that tier. In
+         * place of a storage_path, a tier (or the worker) may give a
+         * memory_server, as "host:port", to swap to the memory of another
+         * machine instead.
+         *
+         * @param worker Value in the configuration file describing this
+         * worker's swap space.
          * @param page_size_in_byte The size of a page (unit of transfer
          * between memory and storage) in bytes.
          * @param num_pages The total number of pages resident in memory.
-         * @param swap_pages The total size of the swap file or swap device,
-         * in pages.
+         * @param swap_pages For each storage tier, the size of the swap file
+         * or swap device, in pages.
          * @param concurrent_swaps The maximum number of outstanding transfers
          * between memory and storage at any one point in time.
+         * @param populate_memory If true, all pages are made resident up
+         * front; if false, they are populated on first access (used for
+         * programs whose resident memory limit varies).
+         *
+         * If the worker has a status_file, the engine publishes its progress
+         * there during execution (see start_status()), every status_interval
+         * instructions.
          */
-        void init(const std::string& storage_file, PageSize page_size_in_bytes, std::uint64_t num_pages, std::uint64_t swap_pages, std::uint32_t concurrent_swaps);
+        void init(const util::ConfigValue& worker, PageSize page_size_in_bytes, std::uint64_t num_pages, const std::uint64_t (&swap_pages)[max_storage_tiers], std::uint32_t concurrent_swaps, bool populate_memory = true);
 
         /**
          * @brief Initiates the transfer of a page from storage to memory.
@@ -135,6 +159,15 @@ namespace mage::engine {
          */
         void copy_page(PhysPageNumber from, PhysPageNumber to);
 
+        /**
+         * @brief Returns the memory backing a page frame, whose contents are
+         * no longer needed, to the operating system, so that co-located
+         * workers can use it.
+         *
+         * @param ppn The page number identifying the page frame.
+         */
+        void discard_page(PhysPageNumber ppn);
+
         /**
          * @brief Initiates asynchronous receipt of data into the specified
          * memory.
@@ -197,13 +230,53 @@ namespace mage::engine {
         /**
          * @brief Prints statistics on the performance of transferring data
          * between memory and storage to standard output, in human-readable
-         * form.
+         * form, along with the CPUs each thread role was placed on, if
+         * configured.
          */
         void print_stats() {
             std::cout << this->swap_in << std::endl;
             std::cout << this->swap_out << std::endl;
             std::cout << this->swap_blocked << std::endl;
+            std::cout << this->swap_throttled << std::endl;
             std::cout << this->swap_copy << std::endl;
+            if (this->swap_tiers.size() > 1) {
+                for (std::size_t i = 0; i != this->swap_tiers.size(); i++) {
+                    const SwapTier& tier = this->swap_tiers[i];
+                    std::cout << "Swap tier " << i << " (" << tier.path << "): " << tier.num_swap_ins << " swap-ins, " << tier.num_swap_outs << " swap-outs" << std::endl;
+                }
+            }
+            if (platform::thread_placement_configured()) {
+                platform::print_thread_placement(std::cout);
+                std::cout << std::endl;
+            }
+        }
+
+        /**
+         * @brief Begins publishing this engine's progress to the status file
+         * named in the worker's configuration, if any.
+         *
+         * The status block holds the number of instructions executed so far,
+         * time spent blocked or throttled on swaps, bytes exchanged with the
+         * other party and with each other worker, and an estimate of the
+         * remaining time based on the throughput so far.
+         *
+         * @param num_instructions The total number of instructions in the
+         * program being executed.
+         */
+        void start_status(InstructionNumber num_instructions);
+
+        /**
+         * @brief Records that the specified number of instructions have been
+         * executed, publishing the status if an update is due.
+         *
+         * This is cheap enough to call after every instruction.
+         *
+         * @param completed The number of instructions executed so far.
+         */
+        void update_status(InstructionNumber completed) {
+            if (completed == this->next_status_update) {
+                this->publish_status(completed);
+            }
         }
 
         /**
@@ -233,26 +306,73 @@ namespace mage::engine {
         }
 
     private:
+        /**
+         * @brief A file, device, or memory server holding swap space for one
+         * storage tier.
+         */
+        struct SwapTier {
+            std::string path;
+            int fd;
+            bool memory_server;
+            std::unique_ptr<RemoteMemory> remote;
+            std::uint32_t max_in_flight;
+            std::uint32_t num_in_flight;
+            std::uint64_t num_swap_ins;
+            std::uint64_t num_swap_outs;
+        };
+
+        /**
+         * @brief A transfer between memory and storage that has been issued
+         * but has not yet been reaped.
+         */
+        struct InFlightSwap {
+            struct iocb op;
+            std::uint64_t ticket;
+            std::uint8_t tier;
+        };
+
         MessageChannel& contact_worker_checked(WorkerID worker_id);
+        void open_swap_tier(SwapTier& tier, std::uint64_t required_size, bool pretouch);
+        SwapTier& reserve_swap_slot(StoragePageNumber spn);
+        bool reap_swaps(PhysAddr paddr);
+        void publish_status(InstructionNumber completed);
 
         util::StreamStats swap_in;
         util::StreamStats swap_out;
         util::StreamStats swap_blocked;
+        util::StreamStats swap_throttled;
         util::StreamStats swap_copy;
 
         std::uint8_t* memory;
         PageSize page_size_bytes;
         std::size_t memory_size;
-        int swapfd;
+        std::vector<SwapTier> swap_tiers;
 
         std::chrono::steady_clock::time_point current_timer_value;
 
         std::shared_ptr<ClusterNetwork> cluster;
 
         io_context_t aio_ctx;
-        std::unordered_map<PhysAddr, struct iocb> in_flight_swaps;
+        std::unordered_map<PhysAddr, InFlightSwap> in_flight_swaps;
+
+        std::string status_path;
+        std::unique_ptr<StatusFile> status;
+        InstructionNumber status_interval;
+        InstructionNumber next_status_update;
+        std::chrono::steady_clock::time_point status_start;
 
     protected:
+        /**
+         * @brief Obtains the number of bytes that the protocol driver has sent
+         * to and received from the other party so far, for the status file.
+         *
+         * The default implementation reports none, as is correct for
+         * protocols that do not communicate with another party.
+         *
+         * @return The number of bytes sent and the number of bytes received.
+         */
+        virtual std::pair<std::uint64_t, std::uint64_t> get_protocol_traffic() const;
+
         util::ProgressBar progress_bar;
     };
 }
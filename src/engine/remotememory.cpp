@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "engine/remotememory.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "platform/affinity.hpp"
+#include "platform/filesystem.hpp"
+#include "platform/memory.hpp"
+#include "platform/network.hpp"
+
+namespace mage::engine {
+    RemoteMemory::RemoteMemory(const std::string& host, const std::string& port, std::uint64_t size)
+        : num_issued(0), num_completed(0), closing(false) {
+        platform::NetworkError err;
+        platform::network_connect(host.c_str(), port.c_str(), &this->socket_fd, &err);
+        if (err != platform::NetworkError::Success) {
+            std::cerr << "Could not connect to memory server at " << host << ":" << port << std::endl;
+            std::abort();
+        }
+        platform::network_set_nodelay(this->socket_fd);
+
+        /* Reserve the space synchronously, before pipelining any requests. */
+        this->send_request(RemoteMemoryOp::Allocate, size, 0);
+        std::uint8_t status;
+        if (platform::read_from_file(this->socket_fd, &status, sizeof(status)) != sizeof(status) || status != 0) {
+            std::cerr << "Memory server at " << host << ":" << port << " could not provide " << size << " bytes" << std::endl;
+            std::abort();
+        }
+
+        this->receiver = std::thread(&RemoteMemory::receive_responses, this);
+    }
+
+    RemoteMemory::~RemoteMemory() {
+        {
+            std::lock_guard<std::mutex> lock(this->state_mutex);
+            this->closing = true;
+        }
+        this->request_posted.notify_all();
+        this->receiver.join();
+        platform::network_close(this->socket_fd);
+    }
+
+    void RemoteMemory::send_request(RemoteMemoryOp op, std::uint64_t offset, std::uint32_t length) {
+        RemoteMemoryRequest request;
+        request.offset = offset;
+        request.length = length;
+        request.op = op;
+        platform::write_to_file(this->socket_fd, &request, sizeof(request));
+    }
+
+    std::uint64_t RemoteMemory::read(void* into, std::uint64_t offset, std::uint32_t length) {
+        {
+            std::lock_guard<std::mutex> lock(this->state_mutex);
+            this->pending.push_back(PendingRequest { into, length, RemoteMemoryOp::Read });
+        }
+        this->request_posted.notify_one();
+        this->send_request(RemoteMemoryOp::Read, offset, length);
+        return ++this->num_issued;
+    }
+
+    std::uint64_t RemoteMemory::write(const void* from, std::uint64_t offset, std::uint32_t length) {
+        {
+            std::lock_guard<std::mutex> lock(this->state_mutex);
+            this->pending.push_back(PendingRequest { nullptr, length, RemoteMemoryOp::Write });
+        }
+        this->request_posted.notify_one();
+        this->send_request(RemoteMemoryOp::Write, offset, length);
+        platform::write_to_file(this->socket_fd, from, length);
+        return ++this->num_issued;
+    }
+
+    void RemoteMemory::wait(std::uint64_t ticket) {
+        assert(ticket <= this->num_issued);
+        std::unique_lock<std::mutex> lock(this->state_mutex);
+        this->request_completed.wait(lock, [this, ticket]() { return this->num_completed >= ticket; });
+    }
+
+    std::uint64_t RemoteMemory::get_num_in_flight() {
+        std::lock_guard<std::mutex> lock(this->state_mutex);
+        return this->num_issued - this->num_completed;
+    }
+
+    void RemoteMemory::receive_response(const PendingRequest& request) {
+        std::uint8_t status;
+        if (platform::read_from_file(this->socket_fd, &status, sizeof(status)) != sizeof(status)) {
+            std::cerr << "Memory server closed the connection" << std::endl;
+            std::abort();
+        }
+        if (status != 0) {
+            std::cerr << "Memory server rejected a request (status " << static_cast<int>(status) << ")" << std::endl;
+            std::abort();
+        }
+        if (request.op == RemoteMemoryOp::Read && platform::read_from_file(this->socket_fd, request.into, request.length) != request.length) {
+            std::cerr << "Memory server closed the connection" << std::endl;
+            std::abort();
+        }
+    }
+
+    void RemoteMemory::receive_responses() {
+        platform::pin_thread(platform::ThreadRole::Network);
+
+        std::unique_lock<std::mutex> lock(this->state_mutex);
+        while (true) {
+            this->request_posted.wait(lock, [this]() { return !this->pending.empty() || this->closing; });
+            if (this->pending.empty()) {
+                return;
+            }
+            PendingRequest request = this->pending.front();
+            lock.unlock();
+
+            this->receive_response(request);
+
+            lock.lock();
+            this->pending.pop_front();
+            this->num_completed++;
+            this->request_completed.notify_all();
+        }
+    }
+
+    static void send_status(int fd, std::uint8_t status) {
+        platform::write_to_file(fd, &status, sizeof(status));
+    }
+
+    void serve_remote_memory_client(int fd, std::atomic<std::uint64_t>& available_bytes) {
+        RemoteMemoryRequest request;
+        std::uint8_t* region = nullptr;
+        std::uint64_t region_size = 0;
+
+        /* The first request on each connection reserves the client's region. */
+        if (platform::read_from_file(fd, &request, sizeof(request)) != sizeof(request) || request.op != RemoteMemoryOp::Allocate) {
+            platform::network_close(fd);
+            return;
+        }
+        /* The size is 64 bits wide, so it is carried in the offset field. */
+        std::uint64_t requested = request.offset;
+        if (request.length != 0) {
+            std::cerr << "Rejecting client: malformed allocation request" << std::endl;
+            send_status(fd, 2);
+            platform::network_close(fd);
+            return;
+        }
+        std::uint64_t available = available_bytes.load();
+        do {
+            if (available < requested) {
+                std::cerr << "Rejecting client: requested " << requested << " bytes, but only " << available << " are available" << std::endl;
+                send_status(fd, 1);
+                platform::network_close(fd);
+                return;
+            }
+        } while (!available_bytes.compare_exchange_weak(available, available - requested));
+        region_size = requested;
+        if (region_size != 0) {
+            region = platform::allocate_resident_memory<std::uint8_t>(region_size, true);
+        }
+        send_status(fd, 0);
+        std::cout << "Client connected: reserved " << region_size << " bytes" << std::endl;
+
+        /* Requests are served in order, which is what gives clients their consistency. */
+        while (platform::read_from_file(fd, &request, sizeof(request)) == sizeof(request)) {
+            bool in_bounds = (request.offset <= region_size && request.length <= region_size - request.offset);
+            if (request.op == RemoteMemoryOp::Read && in_bounds) {
+                send_status(fd, 0);
+                platform::write_to_file(fd, &region[request.offset], request.length);
+            } else if (request.op == RemoteMemoryOp::Write && in_bounds) {
+                if (platform::read_from_file(fd, &region[request.offset], request.length) != request.length) {
+                    break;
+                }
+                send_status(fd, 0);
+            } else {
+                std::cerr << "Invalid request: op = " << static_cast<int>(request.op) << ", offset = " << request.offset << ", length = " << request.length << std::endl;
+                send_status(fd, 2);
+                break;
+            }
+        }
+
+        if (region_size != 0) {
+            platform::deallocate_resident_memory(region, region_size);
+        }
+        available_bytes += region_size;
+        platform::network_close(fd);
+        std::cout << "Client disconnected: released " << region_size << " bytes" << std::endl;
+    }
+}
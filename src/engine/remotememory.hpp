@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file engine/remotememory.hpp
+ * @brief Swap space held in the memory of another machine, served over TCP
+ * by a memory server (see executables/memory_server.cpp).
+ *
+ * A remote memory tier sits between local RAM and local storage: transfers
+ * cost a network round trip rather than a disk access. Requests are
+ * pipelined on a single connection, and the memory server processes them in
+ * order, so a read issued after a write to the same location observes that
+ * write.
+ */
+
+#ifndef MAGE_ENGINE_REMOTEMEMORY_HPP_
+#define MAGE_ENGINE_REMOTEMEMORY_HPP_
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mage::engine {
+    /**
+     * @brief Operations that a client may request of a memory server.
+     */
+    enum class RemoteMemoryOp : std::uint8_t {
+        Allocate = 0,
+        Read = 1,
+        Write = 2
+    };
+
+    /**
+     * @brief Header for a request sent to a memory server.
+     *
+     * An Allocate request must come first on each connection, and is
+     * answered with a status byte. It carries the number of bytes to reserve
+     * in @p offset, which (unlike @p length) is wide enough for swap areas
+     * of 4 GiB or more; its @p length must be zero.
+     * A Read request is answered with a status byte followed by @p length
+     * bytes of data. A Write request is followed by @p length bytes of data
+     * and is answered with a status byte once the data are stored. A status
+     * of zero indicates success.
+     */
+    struct RemoteMemoryRequest {
+        std::uint64_t offset;
+        std::uint32_t length;
+        RemoteMemoryOp op;
+    } __attribute__((packed));
+
+    /**
+     * @brief A connection to a memory server, used as swap space.
+     *
+     * Reads and writes are issued asynchronously and complete in the order
+     * in which they were issued. Each one is identified by a ticket (a
+     * sequence number, starting at 1), and a thread is dedicated to receiving
+     * the server's responses, so that the server never blocks on sending
+     * them.
+     */
+    class RemoteMemory {
+    public:
+        /**
+         * @brief Connects to a memory server and reserves space on it.
+         *
+         * If the connection fails or the server cannot provide the requested
+         * space, the process is aborted.
+         *
+         * @param host The hostname of the memory server.
+         * @param port The port on which the memory server listens.
+         * @param size The amount of space, in bytes, to reserve.
+         */
+        RemoteMemory(const std::string& host, const std::string& port, std::uint64_t size);
+
+        /**
+         * @brief Waits for outstanding requests to complete and closes the
+         * connection, releasing the reserved space on the memory server.
+         */
+        ~RemoteMemory();
+
+        /**
+         * @brief Issues an asynchronous read from remote memory.
+         *
+         * @param into The buffer into which to read; it must not be accessed
+         * until the read completes.
+         * @param offset The offset in remote memory at which to read.
+         * @param length The number of bytes to read.
+         * @return The ticket identifying the read.
+         */
+        std::uint64_t read(void* into, std::uint64_t offset, std::uint32_t length);
+
+        /**
+         * @brief Issues an asynchronous write to remote memory.
+         *
+         * The data are sent before this function returns, so @p from may be
+         * modified immediately, but the write is not complete (durable on
+         * the memory server) until its ticket is waited on.
+         *
+         * @param from The buffer containing the data to write.
+         * @param offset The offset in remote memory at which to write.
+         * @param length The number of bytes to write.
+         * @return The ticket identifying the write.
+         */
+        std::uint64_t write(const void* from, std::uint64_t offset, std::uint32_t length);
+
+        /**
+         * @brief Blocks until the request with the specified ticket, and all
+         * requests issued before it, have completed.
+         *
+         * @param ticket The ticket of the request.
+         */
+        void wait(std::uint64_t ticket);
+
+        /**
+         * @brief Obtains the number of requests issued so far, which is also
+         * the ticket of the most recently issued request.
+         *
+         * @return The number of requests issued.
+         */
+        std::uint64_t get_num_issued() const {
+            return this->num_issued;
+        }
+
+        /**
+         * @brief Obtains the number of requests that have been issued but
+         * have not yet completed.
+         *
+         * @return The number of requests in flight.
+         */
+        std::uint64_t get_num_in_flight();
+
+    private:
+        /**
+         * @brief Describes a request whose response has not been received.
+         */
+        struct PendingRequest {
+            void* into;
+            std::uint32_t length;
+            RemoteMemoryOp op;
+        };
+
+        void send_request(RemoteMemoryOp op, std::uint64_t offset, std::uint32_t length);
+        void receive_response(const PendingRequest& request);
+        void receive_responses();
+
+        int socket_fd;
+        std::uint64_t num_issued;
+        std::thread receiver;
+
+        std::mutex state_mutex;
+        std::condition_variable request_posted;
+        std::condition_variable request_completed;
+        std::deque<PendingRequest> pending;
+        std::uint64_t num_completed;
+        bool closing;
+    };
+
+    /**
+     * @brief Serves a client of a memory server, on the calling thread,
+     * until the client closes its connection.
+     *
+     * The client's region is reserved from @p available_bytes when it
+     * connects and returned to it when it disconnects, so a single counter
+     * can be shared by all clients of a memory server.
+     *
+     * @param fd The socket connected to the client, which is closed when
+     * this function returns.
+     * @param available_bytes The amount of memory, in bytes, that the memory
+     * server has not yet reserved for any client.
+     */
+    void serve_remote_memory_client(int fd, std::atomic<std::uint64_t>& available_bytes);
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "engine/status.hpp"
+#include <cstdint>
+#include <new>
+#include <string>
+#include "addr.hpp"
+#include "platform/memory.hpp"
+
+namespace mage::engine {
+    StatusFile::StatusFile(const std::string& path, WorkerID self, WorkerID num_workers)
+        : file(path.c_str(), sizeof(StatusHeader) + num_workers * sizeof(StatusPeer)) {
+        /* The file is created empty, so every field other than these is zero. */
+        StatusHeader* h = new (this->file.mapping()) StatusHeader {};
+        h->self = self;
+        h->num_workers = num_workers;
+        h->version = status_file_version;
+        h->magic = status_file_magic;
+    }
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file engine/status.hpp
+ * @brief Live status of a running engine, published to a memory-mapped file
+ * so that monitoring tools can observe a long execution without attaching
+ * to the process or parsing its output.
+ */
+
+#ifndef MAGE_ENGINE_STATUS_HPP_
+#define MAGE_ENGINE_STATUS_HPP_
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include "addr.hpp"
+#include "platform/memory.hpp"
+
+namespace mage::engine {
+    /**
+     * @brief Magic number at the start of a status file ("MAGS" in little
+     * endian byte order).
+     */
+    constexpr const std::uint32_t status_file_magic = UINT32_C(0x5347414d);
+
+    /**
+     * @brief Version of the status file layout described by StatusHeader and
+     * StatusPeer.
+     */
+    constexpr const std::uint32_t status_file_version = 2;
+
+    /**
+     * @brief Layout of the beginning of a status file. It is followed by one
+     * StatusPeer for each worker in the party (including this one, whose
+     * entry stays zero).
+     *
+     * The fields are updated in place under a sequence lock: the writer makes
+     * @p sequence odd before modifying the remaining fields and even again
+     * afterward. A reader should copy the status block, and retry if
+     * @p sequence was odd or changed during the copy.
+     */
+    struct StatusHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::atomic<std::uint64_t> sequence;
+        std::uint32_t self;
+        std::uint32_t num_workers;
+        std::uint64_t instruction;
+        std::uint64_t num_instructions;
+        std::uint64_t elapsed_ns;
+        std::uint64_t eta_ns;
+        std::uint64_t swap_blocked_ns;
+        std::uint64_t swap_throttled_ns;
+
+        /* Traffic on the protocol's connections to the other party. */
+        std::uint64_t protocol_bytes_sent;
+        std::uint64_t protocol_bytes_received;
+    };
+
+    /**
+     * @brief Per-worker network counters in a status file, covering
+     * communication with another worker in the same party.
+     */
+    struct StatusPeer {
+        std::uint64_t bytes_sent;
+        std::uint64_t bytes_received;
+    };
+
+    /**
+     * @brief Status file that an engine periodically updates with its
+     * progress, for consumption by external monitoring tools.
+     *
+     * The file is memory-mapped, so publishing an update is a handful of
+     * stores to memory; the operating system writes the page back lazily.
+     */
+    class StatusFile {
+    public:
+        /**
+         * @brief Creates (or truncates) the status file at the specified path
+         * and maps it into memory.
+         *
+         * @param path The path at which to create the status file.
+         * @param self The ID of this worker.
+         * @param num_workers The number of workers in this party.
+         */
+        StatusFile(const std::string& path, WorkerID self, WorkerID num_workers);
+
+        /**
+         * @brief Begins an update of the status block. The fields returned by
+         * header() and peer() may be modified until end_update() is called.
+         */
+        void begin_update() {
+            StatusHeader* h = this->header();
+            h->sequence.store(h->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        /**
+         * @brief Ends an update of the status block, making the new values
+         * visible to readers as a consistent snapshot.
+         */
+        void end_update() {
+            StatusHeader* h = this->header();
+            h->sequence.store(h->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns a pointer to the header of the status block.
+         *
+         * @return A pointer to the header of the status block.
+         */
+        StatusHeader* header() const {
+            return reinterpret_cast<StatusHeader*>(this->file.mapping());
+        }
+
+        /**
+         * @brief Returns a pointer to the network counters for the specified
+         * worker.
+         *
+         * @param worker_id The ID of the specified worker.
+         * @return A pointer to the network counters for @p worker_id.
+         */
+        StatusPeer* peer(WorkerID worker_id) const {
+            StatusPeer* peers = reinterpret_cast<StatusPeer*>(this->file.mapping() + sizeof(StatusHeader));
+            return &peers[worker_id];
+        }
+
+    private:
+        platform::MappedFile<std::uint8_t> file;
+    };
+}
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "addr.hpp"
+#include "memprog/pipeline.hpp"
+#include "programs/registry.hpp"
+#include "protocols/registry.hpp"
+#include "util/config.hpp"
+
+using mage::programs::ProgramOptions;
+using mage::programs::RegisteredProgram;
+using mage::protocols::RegisteredProtocol;
+using mage::protocols::RegisteredPlacementPlugin;
+using mage::util::Registry;
+
+/*
+ * Allocations larger than a page are planned as multi-page spans, so any page
+ * size is valid. Still, the page size in the configuration file is treated as
+ * the smallest swap worth issuing to storage, so we only try it and larger
+ * pages.
+ */
+constexpr mage::PageShift num_page_shifts = 3;
+constexpr std::uint64_t prefetch_buffer_divisors[] = { 64, 32, 16, 8 };
+constexpr std::uint64_t lookahead_multipliers[] = { 1, 2, 4, 8, 16 };
+constexpr mage::VirtPageNumber min_num_pages = 16;
+
+/*
+ * Simple cost model for a memory program. Asynchronous swaps overlap with
+ * computation, so the estimated running time is the larger of the two, plus
+ * the time spent stalled on synchronous swap-ins.
+ */
+struct CostModel {
+    std::uint64_t instruction_ns;
+    std::uint64_t storage_bytes_per_us;
+    std::uint64_t swap_latency_us;
+
+    double estimate_us(const mage::memprog::DefaultPipelineStats& stats, mage::PageShift page_shift) const {
+        double page_us = static_cast<double>(UINT64_C(1) << page_shift) / this->storage_bytes_per_us;
+        double compute_us = stats.num_instructions * (this->instruction_ns / 1000.0);
+        double swap_us = (stats.num_swapins + stats.num_swapouts) * page_us;
+        double stall_us = stats.num_synchronous_swapins * (this->swap_latency_us + page_us);
+        return std::max(compute_us, swap_us) + stall_us;
+    }
+};
+
+struct Candidate {
+    mage::PageShift page_shift;
+    mage::VirtPageNumber num_pages;
+    mage::VirtPageNumber prefetch_buffer_size;
+    mage::InstructionNumber prefetch_lookahead;
+    mage::memprog::DefaultPipelineStats stats;
+    double cost_us;
+};
+
+int main(int argc, char** argv) {
+    if (argc != 8 && argc != 9) {
+        std::cerr << "Usage: " << argv[0] << " program_name protocol/plugin config.yaml party_id worker_index input_size memory_budget_bytes [output.yaml]" << std::endl;
+        Registry<RegisteredProgram>::print_all("programs", std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    std::string program_name(argv[1]);
+    const RegisteredProgram* prog = Registry<RegisteredProgram>::look_up_by_name(program_name);
+    if (prog == nullptr) {
+        std::cerr << program_name << " is not a valid program name. "; // lack of std::endl is intentional
+        Registry<RegisteredProgram>::print_all("programs", std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    std::string protocol(argv[2]);
+    mage::memprog::PlacementPlugin plugin;
+    const RegisteredProtocol* prot = Registry<RegisteredProtocol>::look_up_by_name(protocol);
+    if (prot == nullptr) {
+        const RegisteredPlacementPlugin* plug = Registry<RegisteredPlacementPlugin>::look_up_by_name(protocol);
+        if (plug == nullptr) {
+            std::cerr << protocol << " is not a valid protocol name or plugin name. "; // lack of std::endl is intentional
+            Registry<RegisteredProtocol>::print_all("protocols", std::cerr);
+            Registry<RegisteredPlacementPlugin>::print_all("plugins", std::cerr);
+            return EXIT_FAILURE;
+        }
+        plugin = plug->get_placement_plugin();
+    } else {
+        plugin = prot->get_placement_plugin();
+    }
+
+    mage::util::Configuration c(argv[3]);
+
+    std::optional<std::uint32_t> party_id = mage::protocols::parse_party_id(argv[4]);
+    if (!party_id.has_value()) {
+        std::cerr << "Invalid party_id (try \"garbler\", \"evaluator\", or an integer)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    mage::WorkerID num_workers = c["parties"][*party_id]["workers"].get_size();
+
+    errno = 0;
+    mage::WorkerID index = std::strtoull(argv[5], nullptr, 10);
+    if (errno != 0) {
+        std::perror("Fifth argument (index)");
+        return EXIT_FAILURE;
+    }
+    if (index >= num_workers) {
+        std::cerr << "Worker index is " << index << " but there are only " << num_workers << " workers" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    errno = 0;
+    std::uint64_t problem_size = std::strtoull(argv[6], nullptr, 10);
+    if (errno != 0 || problem_size == 0) {
+        std::cerr << "Bad sixth argument (input size)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    errno = 0;
+    std::uint64_t memory_budget = std::strtoull(argv[7], nullptr, 10);
+    if (errno != 0 || memory_budget == 0) {
+        std::cerr << "Bad seventh argument (memory budget)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const mage::util::ConfigValue& w = c["parties"][*party_id]["workers"][index];
+
+    CostModel model;
+    model.instruction_ns = 100;
+    model.storage_bytes_per_us = 500;
+    model.swap_latency_us = 100;
+    if (w.get("autotune") != nullptr) {
+        const mage::util::ConfigValue& m = w["autotune"];
+        if (m.get("instruction_ns") != nullptr) {
+            model.instruction_ns = m["instruction_ns"].as_int();
+        }
+        if (m.get("storage_bytes_per_us") != nullptr) {
+            model.storage_bytes_per_us = m["storage_bytes_per_us"].as_int();
+        }
+        if (m.get("swap_latency_us") != nullptr) {
+            model.swap_latency_us = m["swap_latency_us"].as_int();
+        }
+    }
+
+    mage::PageShift min_page_shift = w["page_shift"].as_int();
+    mage::InstructionNumber base_lookahead = w["prefetch_lookahead"].as_int();
+
+    ProgramOptions args = {};
+    args.worker_config = &w;
+    args.num_workers = num_workers;
+    args.worker_index = index;
+    args.problem_size = problem_size;
+
+    std::string problem_name = program_name + "_" + std::to_string(problem_size) + "_" + std::to_string(index);
+
+    /*
+     * The virtual bytecode and annotations depend only on the page size, so
+     * run placement and annotation once per page size.
+     */
+    std::vector<Candidate> candidates;
+    std::vector<std::string> temp_files;
+    for (mage::PageShift shift = min_page_shift; shift != min_page_shift + num_page_shifts; shift++) {
+        std::uint64_t total_frames = memory_budget >> shift;
+        std::string shift_name = problem_name + "_autotune_" + std::to_string(shift);
+
+        mage::memprog::DefaultPipeline placement(shift_name, shift, total_frames, 0, base_lookahead);
+        placement.program(&mage::programs::program_ptr, plugin, [prog, &args]() {
+            (*prog)(args);
+        }, shift_name + ".prog");
+        placement.annotate(shift_name + ".prog", shift_name + ".ann");
+        temp_files.push_back(shift_name + ".prog");
+        temp_files.push_back(shift_name + ".ann");
+        mage::InstructionNumber num_instructions = placement.get_stats().num_instructions;
+        std::cout << "Placed program with page_shift = " << static_cast<std::uint32_t>(shift) << " (" << num_instructions << " instructions)" << std::endl;
+
+        for (std::uint64_t divisor : prefetch_buffer_divisors) {
+            mage::VirtPageNumber prefetch_buffer_size = std::max<std::uint64_t>(total_frames / divisor, 1);
+            if (total_frames < prefetch_buffer_size + min_num_pages) {
+                continue;
+            }
+            for (std::uint64_t multiplier : lookahead_multipliers) {
+                Candidate cand = {};
+                cand.page_shift = shift;
+                cand.num_pages = total_frames - prefetch_buffer_size;
+                cand.prefetch_buffer_size = prefetch_buffer_size;
+                cand.prefetch_lookahead = base_lookahead * multiplier;
+                cand.stats.num_instructions = num_instructions;
+                candidates.push_back(cand);
+            }
+        }
+    }
+
+    if (candidates.empty()) {
+        std::cerr << "Memory budget of " << memory_budget << " bytes is too small to plan with page_shift = " << static_cast<std::uint32_t>(min_page_shift) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    /*
+     * The replacement stage depends only on the page size and number of page
+     * frames, so candidates that differ only in prefetch_lookahead share a
+     * single run of it. Each group is handled by one thread.
+     */
+    std::vector<std::size_t> groups;
+    for (std::size_t i = 0; i != candidates.size(); i++) {
+        if (i == 0 || candidates[i].page_shift != candidates[i - 1].page_shift || candidates[i].num_pages != candidates[i - 1].num_pages) {
+            groups.push_back(i);
+        }
+    }
+    groups.push_back(candidates.size());
+
+    std::atomic<std::size_t> next_group(0);
+    auto worker = [&]() {
+        std::size_t g;
+        while ((g = next_group.fetch_add(1)) < groups.size() - 1) {
+            Candidate& first = candidates[groups[g]];
+            std::string shift_name = problem_name + "_autotune_" + std::to_string(first.page_shift);
+            std::string group_name = shift_name + "_" + std::to_string(first.num_pages);
+            mage::memprog::DefaultPipeline replacement(group_name, first.page_shift, first.num_pages, first.prefetch_buffer_size, first.prefetch_lookahead);
+            replacement.replace(shift_name + ".prog", shift_name + ".ann", group_name + ".repprog");
+            mage::memprog::DefaultPipelineStats replacement_stats = replacement.get_stats();
+
+            for (std::size_t i = groups[g]; i != groups[g + 1]; i++) {
+                Candidate& cand = candidates[i];
+                mage::memprog::DefaultPipeline scheduling(group_name, cand.page_shift, cand.num_pages, cand.prefetch_buffer_size, cand.prefetch_lookahead);
+                scheduling.schedule(group_name + ".repprog", group_name + ".memprog");
+                const mage::memprog::DefaultPipelineStats& scheduling_stats = scheduling.get_stats();
+                cand.stats.num_swapouts = replacement_stats.num_swapouts;
+                cand.stats.num_swapins = replacement_stats.num_swapins;
+                cand.stats.num_storage_frames = replacement_stats.num_storage_frames;
+                cand.stats.num_prefetch_alloc_failures = scheduling_stats.num_prefetch_alloc_failures;
+                cand.stats.num_synchronous_swapins = scheduling_stats.num_synchronous_swapins;
+                cand.cost_us = model.estimate_us(cand.stats, cand.page_shift);
+            }
+            std::remove((group_name + ".repprog").c_str());
+            std::remove((group_name + ".memprog").c_str());
+        }
+    };
+
+    unsigned num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i != num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    for (const std::string& file : temp_files) {
+        std::remove(file.c_str());
+    }
+
+    std::cout << "page_shift num_pages prefetch_buffer_size prefetch_lookahead swapouts swapins synchronous_swapins estimated_ms" << std::endl;
+    const Candidate* best = nullptr;
+    for (const Candidate& cand : candidates) {
+        std::cout << static_cast<std::uint32_t>(cand.page_shift) << " " << cand.num_pages << " " << cand.prefetch_buffer_size << " " << cand.prefetch_lookahead << " "
+            << cand.stats.num_swapouts << " " << cand.stats.num_swapins << " " << cand.stats.num_synchronous_swapins << " " << (cand.cost_us / 1000.0) << std::endl;
+        if (best == nullptr || cand.cost_us < best->cost_us) {
+            best = &cand;
+        }
+    }
+
+    std::ofstream output_file;
+    if (argc == 9) {
+        output_file.open(argv[8]);
+        if (!output_file) {
+            std::cerr << "Could not open " << argv[8] << " for writing" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& output = (argc == 9) ? output_file : std::cout;
+    if (argc != 9) {
+        std::cout << std::endl << "Best configuration:" << std::endl;
+    }
+    output << "page_shift: " << static_cast<std::uint32_t>(best->page_shift) << std::endl;
+    output << "num_pages: " << best->num_pages << std::endl;
+    output << "prefetch_buffer_size: " << best->prefetch_buffer_size << std::endl;
+    output << "prefetch_lookahead: " << best->prefetch_lookahead << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -22,9 +22,11 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <seal/seal.h>
 #include "util/binaryfile.hpp"
@@ -125,15 +127,29 @@ int main(int argc, char** argv) {
             std::ofstream ciphertext_file(argv[2], std::ios::binary);
             ciphertext.save(ciphertext_file);
         }
-    } else if (std::strcmp(argv[1], "encrypt_file") == 0) {
+    } else if (std::strcmp(argv[1], "encrypt_file") == 0 || std::strcmp(argv[1], "encrypt_file_symmetric") == 0) {
         if (argc < 3) {
-            std::cerr << "Usage: " << argv[0] << " encrypt_file batch_size level [file1] ..." << std::endl;
+            std::cerr << "Usage: " << argv[0] << " " << argv[1] << " batch_size level [file1] ..." << std::endl;
             std::abort();
         }
         seal::EncryptionParameters parms = parms_from_file("parms.ckks");
         seal::SEALContext context(parms);
-        seal::PublicKey public_key = from_file<seal::PublicKey>(context, "publickey.ckks");
-        seal::Encryptor encryptor(context, public_key);
+
+        /*
+         * Symmetric (secret-key) encryptions are written with the second
+         * polynomial replaced by the seed used to generate it, which halves
+         * the size of each ciphertext. SEAL expands the seed when the
+         * ciphertext is loaded.
+         */
+        bool symmetric = (std::strcmp(argv[1], "encrypt_file_symmetric") == 0);
+        std::unique_ptr<seal::Encryptor> encryptor;
+        if (symmetric) {
+            seal::SecretKey secret_key = from_file<seal::SecretKey>(context, "secretkey.ckks");
+            encryptor = std::make_unique<seal::Encryptor>(context, secret_key);
+        } else {
+            seal::PublicKey public_key = from_file<seal::PublicKey>(context, "publickey.ckks");
+            encryptor = std::make_unique<seal::Encryptor>(context, public_key);
+        }
 
         int batch_size = std::stoi(argv[2]);
         if (batch_size <= 0) {
@@ -178,10 +194,69 @@ int main(int argc, char** argv) {
                     seal::Plaintext plaintext;
                     encoder.encode(batch_data, target_level_parms_id, ckks_scale, plaintext);
 
-                    seal::Ciphertext ciphertext;
-                    encryptor.encrypt(plaintext, ciphertext);
-                    ciphertext.save(target);
+                    if (symmetric) {
+                        encryptor->encrypt_symmetric(plaintext).save(target);
+                    } else {
+                        seal::Ciphertext ciphertext;
+                        encryptor->encrypt(plaintext, ciphertext);
+                        ciphertext.save(target);
+                    }
+
+                    batch_data.clear();
+                }
+            }
+        }
+    } else if (std::strcmp(argv[1], "encode_file") == 0) {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " encode_file batch_size level [file1] ..." << std::endl;
+            std::abort();
+        }
+        seal::EncryptionParameters parms = parms_from_file("parms.ckks");
+        seal::SEALContext context(parms);
+
+        int batch_size = std::stoi(argv[2]);
+        if (batch_size <= 0) {
+            std::cerr << "Batch size must be positive" << std::endl;
+            std::abort();
+        }
+
+        int level = std::stoi(argv[3]);
+        if (level < 0) {
+            std::cerr << "Level must be nonnegative" << std::endl;
+            std::abort();
+        }
+        auto context_data = context.first_context_data();
+        while (context_data->chain_index() > level) {
+            context_data = context_data->next_context_data();
+        }
+        if (context_data->chain_index() != level) {
+            std::cout << "Could not find params for level " << level << " (max level is " << context.first_context_data()->chain_index() << ")" << std::endl;
+            std::abort();
+        }
+        auto target_level_parms_id = context_data->parms_id();
+
+        seal::CKKSEncoder encoder(context);
+
+        for (int i = 4; i != argc; i++) {
+            std::string filename(argv[i]);
+
+            std::string temp_name = filename + ".plain";
+            std::filesystem::rename(filename, temp_name);
+
+            std::ofstream target(argv[i], std::ios::binary);
 
+            std::vector<double> batch_data;
+
+            mage::util::BinaryFileReader reader(temp_name.c_str());
+            std::uint64_t num_bytes = reader.get_file_length();
+            std::uint64_t num_uint32s = num_bytes >> 2;
+            for (std::uint64_t i = 0; i != num_uint32s; i++) {
+                double value = reader.BinaryReader::read<float>();
+                batch_data.push_back(value);
+                if (batch_data.size() == batch_size || i + 1 == num_uint32s) {
+                    seal::Plaintext plaintext;
+                    encoder.encode(batch_data, target_level_parms_id, ckks_scale, plaintext);
+                    plaintext.save(target);
 
                     batch_data.clear();
                 }
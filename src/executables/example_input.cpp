@@ -27,8 +27,10 @@
 #include <numeric>
 #include <random>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
+#include "dsl/shuffle.hpp"
 #include "util/binaryfile.hpp"
 #include "util/misc.hpp"
 
@@ -182,11 +184,122 @@ int main(int argc, char** argv) {
         } else {
             std::cerr << "Unkown option " << option << std::endl;
         }
-    } else if (problem_name == "loop_join") {
+    } else if (problem_name == "full_shuffle") {
+        /* The evaluator picks random switch bits; compute the resulting permutation. */
+        std::default_random_engine generator;
+        std::uniform_int_distribution<std::uint8_t> distribution(0, 1);
+        std::vector<std::uint32_t> array(input_size);
+        std::iota(array.begin(), array.end(), 0);
+        auto shuffle_at = [&](std::vector<std::uint64_t> indices, std::uint64_t worker) {
+            auto apply_switch = [&](std::uint64_t i, std::uint64_t j) {
+                std::uint8_t control = distribution(generator);
+                evaluator_writers[worker]->write1(control);
+                if (control == 1) {
+                    std::swap(array[indices[i]], array[indices[j]]);
+                }
+            };
+            mage::dsl::waksman_network(0, indices.size(), apply_switch);
+        };
+        auto shuffle_blocks = [&]() {
+            for (std::uint64_t w = 0; w != num_workers; w++) {
+                std::vector<std::uint64_t> block;
+                for (std::uint64_t i = 0; i != input_size; i++) {
+                    if (get_blocked_worker(i, num_workers, input_size) == w) {
+                        block.push_back(i);
+                    }
+                }
+                shuffle_at(block, w);
+            }
+        };
+
+        shuffle_blocks();
+        if (num_workers != 1) {
+            std::uint64_t num_groups = input_size / (num_workers * num_workers);
+            for (std::uint64_t w = 0; w != num_workers; w++) {
+                for (std::uint64_t t = 0; t != num_groups; t++) {
+                    std::vector<std::uint64_t> group;
+                    for (std::uint64_t v = 0; v != num_workers; v++) {
+                        group.push_back(w + (v * num_groups + t) * num_workers);
+                    }
+                    shuffle_at(group, w);
+                }
+            }
+            shuffle_blocks();
+        }
+
+        for (std::uint64_t i = 0; i != input_size; i++) {
+            std::uint64_t blocked_party = get_blocked_worker(i, num_workers, input_size);
+            write_record(garbler_writers[blocked_party].get(), i);
+            write_record(expected_writers[blocked_party].get(), array[i]);
+        }
+    } else if (problem_name == "group_by_sum" || problem_name == "group_by_count" || problem_name == "group_by_min" || problem_name == "group_by_max") {
+        std::default_random_engine generator;
+        std::uniform_int_distribution<std::uint32_t> key_distribution(0, std::max<std::uint64_t>(input_size / 2, 1));
+        std::uniform_int_distribution<std::uint32_t> value_distribution(0, 1000);
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> records;
+        for (std::uint64_t i = 0; i != input_size * 2; i++) {
+            std::uint64_t cyclic_party = get_cyclic_worker(i, num_workers, input_size * 2);
+            std::uint32_t key = key_distribution(generator);
+            std::uint32_t value = value_distribution(generator);
+            mage::util::BinaryFileWriter* writer = (i < input_size) ? garbler_writers[cyclic_party].get() : evaluator_writers[cyclic_party].get();
+            writer->write32(key);
+            writer->write32(value);
+            records.push_back(std::make_pair(key, value));
+        }
+
+        /* Only the last record of each group reveals its aggregate. */
+        std::sort(records.begin(), records.end());
+        std::uint32_t aggregate = 0;
+        for (std::uint64_t i = 0; i != records.size(); i++) {
+            bool first = (i == 0 || records[i - 1].first != records[i].first);
+            bool last = (i + 1 == records.size() || records[i + 1].first != records[i].first);
+            std::uint32_t value = records[i].second;
+            if (problem_name == "group_by_sum") {
+                aggregate = first ? value : aggregate + value;
+            } else if (problem_name == "group_by_count") {
+                aggregate = first ? 1 : aggregate + 1;
+            } else if (problem_name == "group_by_min") {
+                aggregate = first ? value : std::min(aggregate, value);
+            } else {
+                aggregate = first ? value : std::max(aggregate, value);
+            }
+            mage::util::BinaryFileWriter* writer = expected_writers[get_blocked_worker(i, num_workers, records.size())].get();
+            writer->write32(records[i].first);
+            writer->write1(last ? 1 : 0);
+            writer->write32(last ? aggregate : 0);
+        }
+    } else if (problem_name == "loop_join" || problem_name == "loop_join_compact") {
         std::vector<std::uint32_t> table1_keys(input_size);
         std::iota(table1_keys.begin(), table1_keys.end(), 0);
         std::vector<std::uint32_t> table2_keys(input_size);
         std::iota(table2_keys.begin(), table2_keys.end(), 0);
+
+        /*
+         * The compacted join outputs each worker's part of the result with
+         * the matches first, in their original order. This assumes that
+         * join_result_size is not set (see loop_join.cpp).
+         */
+        bool compact = (problem_name == "loop_join_compact");
+        std::size_t join_size = table1_keys.size() * table2_keys.size();
+        std::uint64_t records_per_worker = join_size / num_workers;
+
+        /* Records of each worker's part of the result, in output order, as (valid, t1 key, t2 key). */
+        std::vector<std::vector<std::tuple<bool, std::uint32_t, std::uint32_t>>> expected_records(num_workers);
+        for (std::uint64_t i = 0, k = 0; i != table1_keys.size(); i++) {
+            for (std::uint64_t j = 0; j != table2_keys.size(); j++, k++) {
+                std::uint64_t blocked_party = get_blocked_worker(k, num_workers, join_size);
+                bool valid = (table1_keys[i] < table2_keys[j]);
+                if (valid) {
+                    expected_records[blocked_party].emplace_back(true, table1_keys[i], table2_keys[j]);
+                } else if (!compact) {
+                    expected_records[blocked_party].emplace_back(false, 0, 0);
+                }
+            }
+        }
+        for (auto& records : expected_records) {
+            records.resize(records_per_worker, std::make_tuple(false, 0, 0));
+        }
+
         if (option == "") {
             for (std::uint64_t i = 0; i != table1_keys.size(); i++) {
                 std::uint64_t blocked_party = get_blocked_worker(i, num_workers, table1_keys.size());
@@ -198,40 +311,27 @@ int main(int argc, char** argv) {
                 write_record(evaluator_writers[blocked_party].get(), table2_keys[i]);
             }
 
-            std::size_t join_size = table1_keys.size() * table2_keys.size();
-            for (std::uint64_t i = 0, k = 0; i != table1_keys.size(); i++) {
-                for (std::uint64_t j = 0; j != table2_keys.size(); j++, k++) {
-                    std::uint64_t blocked_party = get_blocked_worker(k, num_workers, join_size);
-                    bool valid = (table1_keys[i] < table2_keys[j]);
-                    if (valid) {
-                        expected_writers[blocked_party]->write1(1);
-                        write_record(expected_writers[blocked_party].get(), table1_keys[i]);
-                        write_record(expected_writers[blocked_party].get(), table2_keys[j]);
-                    } else {
-                        expected_writers[blocked_party]->write1(0);
-                        write_record(expected_writers[blocked_party].get(), 0);
-                        write_record(expected_writers[blocked_party].get(), 0);
-                    }
+            for (int w = 0; w != num_workers; w++) {
+                for (const auto& [valid, t1_key, t2_key] : expected_records[w]) {
+                    expected_writers[w]->write1(valid ? 1 : 0);
+                    write_record(expected_writers[w].get(), t1_key);
+                    write_record(expected_writers[w].get(), t2_key);
                 }
             }
         } else if (option == "check") {
-            std::size_t join_size = table1_keys.size() * table2_keys.size();
             std::vector<std::pair<std::uint32_t, uint32_t>> expected;
-            for (std::uint64_t i = 0, k = 0; i != table1_keys.size(); i++) {
-                for (std::uint64_t j = 0; j != table2_keys.size(); j++, k++) {
-                    std::uint64_t blocked_party = get_blocked_worker(k, num_workers, join_size);
-                    bool valid = (table1_keys[i] < table2_keys[j]);
+            for (int w = 0; w != num_workers; w++) {
+                for (const auto& [valid, t1_key, t2_key] : expected_records[w]) {
                     if (valid) {
-                        expected.push_back(std::make_pair(table1_keys[i], table2_keys[j]));
+                        expected.push_back(std::make_pair(t1_key, t2_key));
                     }
                 }
             }
+            std::sort(expected.begin(), expected.end());
 
             bool fail = false;
             std::vector<std::pair<std::uint32_t, uint32_t>> actual;
-            std::uint64_t actual_total = 0;
-            std::uint64_t expected_records_per_worker = join_size / num_workers;
-            std::uint64_t expected_bits_per_worker = expected_records_per_worker * 257;
+            std::uint64_t expected_bits_per_worker = records_per_worker * 257;
             std::uint64_t expected_bytes_per_worker = mage::util::ceil_div(expected_bits_per_worker, 8).first;
             for (int w = 0; w != num_workers; w++) {
                 std::string output_file_name(problem_name + "_" + std::to_string(input_size) + "_" + std::to_string(w) + ".output");
@@ -241,7 +341,7 @@ int main(int argc, char** argv) {
                     fail = true;
                     continue;
                 }
-                for (std::uint64_t i = 0; i != expected_records_per_worker; i++) {
+                for (std::uint64_t i = 0; i != records_per_worker; i++) {
                     std::uint8_t valid = r.read1();
                     std::uint32_t t1_record[4];
                     std::uint32_t t2_record[4];
@@ -373,6 +473,32 @@ int main(int argc, char** argv) {
         } else {
             std::cerr << "Unknown option " << option << std::endl;
         }
+    } else if (problem_name == "fixed_dot_product" || problem_name == "float_dot_product") {
+        /*
+         * Elements are small multiples of 1/2 and 1/4, so every partial sum
+         * is exact in both formats and the expected output does not depend
+         * on the order in which the workers add them.
+         */
+        bool fixed = (problem_name == "fixed_dot_product");
+        double expected = 0.0;
+        for (std::uint64_t i = 0; i != input_size; i++) {
+            std::uint64_t w = get_blocked_worker(i, num_workers, input_size);
+            double a = 0.5 * (static_cast<double>(i % 13) - 6.0);
+            double b = 0.25 * (static_cast<double>(i % 5) - 2.0);
+            if (fixed) {
+                garbler_writers[w]->write32(static_cast<std::uint32_t>(static_cast<std::int32_t>(a * 65536.0)));
+                evaluator_writers[w]->write32(static_cast<std::uint32_t>(static_cast<std::int32_t>(b * 65536.0)));
+            } else {
+                garbler_writers[w]->write_float(a);
+                evaluator_writers[w]->write_float(b);
+            }
+            expected += a * b;
+        }
+        if (fixed) {
+            expected_writers[0]->write32(static_cast<std::uint32_t>(static_cast<std::int32_t>(expected * 65536.0)));
+        } else {
+            expected_writers[0]->write_float(expected);
+        }
     } else if (problem_name == "binary_fc_layer") {
         constexpr std::uint64_t batch_size = 256;
         if (input_size % batch_size != 0) {
@@ -444,13 +570,26 @@ int main(int argc, char** argv) {
         } else {
             std::cerr << "Unknown option " << option << std::endl;
         }
-    } else if (problem_name == "real_cpir") {
+    } else if (problem_name == "real_cpir" || problem_name == "real_cpir_preencoded") {
         if (option == "") {
             std::size_t output_index = 3;
             for (std::size_t i = 0; i != input_size; i++) {
                 std::uint64_t w = get_blocked_worker(i, num_workers, input_size);
                 garbler_writers[w]->write_float(i == output_index ? 1.0 : 0.0);
             }
+            if (problem_name == "real_cpir_preencoded") {
+                /* Encode these with "ckks_utils encode_file 1 1 [file] ..." */
+                std::vector<std::unique_ptr<mage::util::BinaryFileWriter>> plaintext_writers(num_workers);
+                for (int i = 0; i != num_workers; i++) {
+                    std::string common_prefix = problem_name + "_" + std::to_string(input_size) + "_" + std::to_string(i);
+                    plaintext_writers[i] = std::make_unique<mage::util::BinaryFileWriter>((common_prefix + "_plaintext.input").c_str());
+                }
+                std::size_t database_size = input_size * input_size;
+                for (std::size_t i = 0; i != database_size; i++) {
+                    std::uint64_t w = get_blocked_worker(i, num_workers, database_size);
+                    plaintext_writers[w]->write_float(static_cast<float>(i + 1));
+                }
+            }
             for (std::size_t i = 0; i != input_size; i++) {
                 expected_writers[0]->write_float(static_cast<float>(1 + (i * input_size) + output_index));
             }
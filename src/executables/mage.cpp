@@ -19,13 +19,18 @@
  * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 #include "addr.hpp"
 #include "protocols/registry.hpp"
+#include "platform/affinity.hpp"
 #include "platform/network.hpp"
 #include "util/config.hpp"
 
@@ -68,6 +73,30 @@ int main(int argc, char** argv) {
     std::istringstream self_id_stream(argv[4]);
     self_id_stream >> self_id;
 
+    /* Place the engine, OT daemon, and network threads on CPUs. */
+
+    const util::ConfigValue& worker = c["parties"][*party_id]["workers"][self_id];
+    if (worker.get("cpu_affinity") != nullptr) {
+        const std::pair<const char*, platform::ThreadRole> roles[] = {
+            { "engine", platform::ThreadRole::Engine },
+            { "ot_daemons", platform::ThreadRole::OTDaemon },
+            { "network", platform::ThreadRole::Network }
+        };
+        for (const auto& [key, child] : worker["cpu_affinity"].as_map()) {
+            auto role = std::find_if(std::begin(roles), std::end(roles), [&](const auto& r) { return key == r.first; });
+            std::vector<std::uint32_t> cpus;
+            if (role == std::end(roles)) {
+                std::cerr << "Unknown thread role " << key << " in cpu_affinity (try \"engine\", \"ot_daemons\", or \"network\")" << std::endl;
+                return EXIT_FAILURE;
+            } else if (!platform::parse_cpu_set(child->as_string(), cpus)) {
+                std::cerr << "Invalid CPU set " << child->as_string() << " for " << key << " (try \"0-3,8\" or \"node1\")" << std::endl;
+                return EXIT_FAILURE;
+            }
+            platform::set_thread_role_cpus(role->second, cpus);
+        }
+        platform::pin_thread(platform::ThreadRole::Engine);
+    }
+
     /* Establish cluster networking. */
 
     std::size_t buffer_size = 1 << 18;
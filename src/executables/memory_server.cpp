@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A memory server lends its RAM to MAGE workers, which use it as a swap tier
+ * (see engine/remotememory.hpp). Each connection reserves its own region,
+ * which is released when the connection closes.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "engine/remotememory.hpp"
+#include "platform/network.hpp"
+
+static std::atomic<std::uint64_t> available_bytes;
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "Usage: " << argv[0] << " port capacity_in_mib" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    available_bytes = std::stoull(argv[2]) << 20;
+    int server_socket = mage::platform::network_listen(argv[1]);
+    std::cout << "Serving " << argv[2] << " MiB on port " << argv[1] << std::endl;
+
+    while (true) {
+        int fd;
+        mage::platform::network_accept_on(server_socket, &fd);
+        mage::platform::network_set_nodelay(fd);
+        std::thread(mage::engine::serve_remote_memory_client, fd, std::ref(available_bytes)).detach();
+    }
+
+    return EXIT_SUCCESS;
+}
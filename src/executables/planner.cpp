@@ -19,11 +19,16 @@
  * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 #include "addr.hpp"
+#include "memprog/budget.hpp"
 #include "memprog/pipeline.hpp"
 #include "programs/registry.hpp"
 #include "protocols/registry.hpp"
@@ -37,7 +42,7 @@ using mage::util::Registry;
 
 int main(int argc, char** argv) {
     if (argc != 7) {
-        std::cerr << "Usage: " << argv[0] << " program_name protocol/plugin config.yaml party_id worker_index input_size" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " program_name protocol/plugin config.yaml party_id worker_index[,worker_index...] input_size" << std::endl;
         Registry<RegisteredProgram>::print_all("programs", std::cerr);
         return EXIT_FAILURE;
     }
@@ -77,15 +82,26 @@ int main(int argc, char** argv) {
 
     mage::WorkerID num_workers = c["parties"][*party_id]["workers"].get_size();
 
-    errno = 0;
-    mage::WorkerID index = std::strtoull(argv[5], nullptr, 10);
-    if (errno != 0) {
-        std::perror("Fourth argument (index)");
-        return EXIT_FAILURE;
-    }
-    if (index >= num_workers) {
-        std::cerr << "Worker index is " << index << " but there are only " << num_workers << " workers" << std::endl;
-        return EXIT_FAILURE;
+    /*
+     * Several comma-separated indices name workers that share a host; they
+     * are planned together, dividing the host's memory among them.
+     */
+    std::vector<mage::WorkerID> indices;
+    std::string index_list(argv[5]);
+    for (std::size_t pos = 0; pos <= index_list.size();) {
+        std::size_t comma = std::min(index_list.find(',', pos), index_list.size());
+        errno = 0;
+        mage::WorkerID index = std::strtoull(index_list.substr(pos, comma - pos).c_str(), nullptr, 10);
+        if (errno != 0) {
+            std::perror("Fourth argument (index)");
+            return EXIT_FAILURE;
+        }
+        if (index >= num_workers) {
+            std::cerr << "Worker index is " << index << " but there are only " << num_workers << " workers" << std::endl;
+            return EXIT_FAILURE;
+        }
+        indices.push_back(index);
+        pos = comma + 1;
     }
 
     errno = 0;
@@ -95,28 +111,75 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    const mage::util::ConfigValue& w = c["parties"][*party_id]["workers"][index];
+    if (indices.size() == 1) {
+        mage::WorkerID index = indices[0];
+        const mage::util::ConfigValue& w = c["parties"][*party_id]["workers"][index];
+
+        ProgramOptions args = {};
+        args.worker_config = &w;
+        args.num_workers = num_workers;
+        args.worker_index = index;
+        args.problem_size = problem_size;
 
-    ProgramOptions args = {};
-    args.worker_config = &w;
-    args.num_workers = num_workers;
-    args.worker_index = index;
-    args.problem_size = problem_size;
+        std::string problem_name = program_name + "_" + std::to_string(problem_size) + "_" + std::to_string(index);
 
-    std::string problem_name = program_name + "_" + std::to_string(problem_size) + "_" + std::to_string(index);
+        mage::memprog::DefaultPipeline planner(problem_name, w);
+        planner.set_verbose(true);
+        planner.plan(&mage::programs::program_ptr, prot->get_placement_plugin(), [prog, &args]() {
+            (*prog)(args);
+        });
 
-    mage::memprog::DefaultPipeline planner(problem_name, w);
-    planner.set_verbose(true);
-    planner.plan(&mage::programs::program_ptr, prot->get_placement_plugin(), [prog, &args]() {
-        (*prog)(args);
-    });
+        std::cout << std::endl;
 
-    std::cout << std::endl;
+        const mage::memprog::DefaultPipelineStats& stats = planner.get_stats();
 
-    const mage::memprog::DefaultPipelineStats& stats = planner.get_stats();
+        std::cout << "Phase Times (ms): " << stats.placement_duration.count() << " "
+            << stats.replacement_duration.count() << " " << stats.scheduling_duration.count() << std::endl;
 
-    std::cout << "Phase Times (ms): " << stats.placement_duration.count() << " "
-        << stats.replacement_duration.count() << " " << stats.scheduling_duration.count() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    const mage::util::ConfigValue& first = c["parties"][*party_id]["workers"][indices[0]];
+    if (first.get("host_num_pages") == nullptr) {
+        std::cerr << "Planning co-located workers requires host_num_pages for worker " << indices[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::uint64_t host_pages = first["host_num_pages"].as_int();
+
+    std::vector<std::unique_ptr<mage::memprog::DefaultPipeline>> planners;
+    std::vector<std::vector<mage::memprog::PhaseDemand>> demands;
+    std::vector<std::uint64_t> prefetch_buffer_sizes;
+    for (mage::WorkerID index : indices) {
+        const mage::util::ConfigValue& w = c["parties"][*party_id]["workers"][index];
+
+        ProgramOptions args = {};
+        args.worker_config = &w;
+        args.num_workers = num_workers;
+        args.worker_index = index;
+        args.problem_size = problem_size;
+
+        std::string problem_name = program_name + "_" + std::to_string(problem_size) + "_" + std::to_string(index);
+
+        std::cout << "Worker " << index << ":" << std::endl;
+        mage::memprog::DefaultPipeline& planner = *planners.emplace_back(std::make_unique<mage::memprog::DefaultPipeline>(problem_name, w));
+        planner.set_verbose(true);
+        planner.plan_placement(&mage::programs::program_ptr, prot->get_placement_plugin(), [prog, &args]() {
+            (*prog)(args);
+        });
+        demands.push_back(planner.profile(problem_name + ".prog"));
+        prefetch_buffer_sizes.push_back(w["prefetch_buffer_size"].as_int());
+    }
+
+    std::vector<std::vector<mage::memprog::ResidentLimit>> limits = mage::memprog::split_host_budget(demands, prefetch_buffer_sizes, host_pages);
+    for (std::size_t i = 0; i != indices.size(); i++) {
+        std::cout << std::endl << "Worker " << indices[i] << ": " << limits[i].size() << " resident limits over " << demands[i].size() << " phases" << std::endl;
+        planners[i]->set_resident_limits(limits[i]);
+        planners[i]->plan_memory();
+
+        const mage::memprog::DefaultPipelineStats& stats = planners[i]->get_stats();
+        std::cout << "Phase Times (ms): " << stats.placement_duration.count() << " "
+            << stats.replacement_duration.count() << " " << stats.scheduling_duration.count() << std::endl;
+    }
 
     return EXIT_SUCCESS;
 }
@@ -53,6 +53,7 @@ namespace mage {
         FlagOutputPageFirstUse = 0x8,
         FlagEvaluatorInput = 0x10,
         FlagNotNormalized = 0x20,
+        FlagPlaintextInput = 0x40,
     };
 
     /**
@@ -67,6 +68,44 @@ namespace mage {
         return (... | static_cast<std::uint8_t>(flags));
     }
 
+    /**
+     * @brief Packs two parameters of an operation into the width field of an
+     * instruction.
+     *
+     * Operations on fixed-point and floating-point numbers are described by
+     * two widths (e.g., the total and fractional bits of a fixed-point
+     * number), so they store one in each byte of the width field.
+     *
+     * @param low The parameter to store in the low byte.
+     * @param high The parameter to store in the high byte.
+     * @return The packed width.
+     */
+    constexpr BitWidth pack_widths(std::uint8_t low, std::uint8_t high) {
+        return static_cast<BitWidth>(low) | (static_cast<BitWidth>(high) << 8);
+    }
+
+    /**
+     * @brief Extracts the parameter stored in the low byte of a width packed
+     * with pack_widths().
+     *
+     * @param packed The packed width.
+     * @return The parameter stored in the low byte.
+     */
+    constexpr std::uint8_t packed_width_low(BitWidth packed) {
+        return static_cast<std::uint8_t>(packed & 0xFF);
+    }
+
+    /**
+     * @brief Extracts the parameter stored in the high byte of a width packed
+     * with pack_widths().
+     *
+     * @param packed The packed width.
+     * @return The parameter stored in the high byte.
+     */
+    constexpr std::uint8_t packed_width_high(BitWidth packed) {
+        return static_cast<std::uint8_t>(packed >> 8);
+    }
+
     /**
      * @brief Structure describing the instruction encoding used in MAGE's
      * bytecodes.
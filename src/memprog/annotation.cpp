@@ -43,7 +43,12 @@ namespace mage::memprog {
         std::unordered_map<VirtPageNumber, InstructionNumber> next_access;
         std::uint64_t max_working_set_size = 0;
 
+        PageSpanTable span_table;
+        span_table.load(program, instructions.get_header());
+
         std::array<VirtPageNumber, 5> vpns;
+        std::array<PageSpan, 5> spans;
+        std::array<std::uint8_t, 5> index;
         do {
             inum--;
 
@@ -51,6 +56,13 @@ namespace mage::memprog {
             PackedVirtInstruction& current = instructions.read_instruction(current_size);
             Annotation& ann = output.start_write<Annotation>();
             ann.header.num_pages = current.store_page_numbers(vpns.data(), page_shift);
+            if (!span_table.empty()) {
+                /* Track each multi-page allocation by its first page. */
+                ann.header.num_pages = span_table.canonicalize(vpns.data(), ann.header.num_pages, spans.data(), index.data());
+                for (std::uint16_t i = 0; i != ann.header.num_pages; i++) {
+                    vpns[i] = spans[i].first;
+                }
+            }
             for (std::uint16_t i = 0; i != ann.header.num_pages; i++) {
                 /* Re-profile the code if you modify this inner loop. */
                 auto iter = next_access.find(vpns[i]);
@@ -70,7 +82,7 @@ namespace mage::memprog {
                  * Instruction format must be NoArgs, OneArg, TwoArgs,
                  * ThreeArgs, or Constant in order to get this flag.
                  */
-                next_access.erase(pg_num(current.no_args.output, page_shift));
+                next_access.erase(span_table.lookup(pg_num(current.no_args.output, page_shift)).first);
             }
         } while (inum != 0);
 
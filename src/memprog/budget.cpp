@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "memprog/budget.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "addr.hpp"
+#include "instruction.hpp"
+#include "memprog/program.hpp"
+#include "opcode.hpp"
+#include "programfile.hpp"
+#include "util/progress.hpp"
+
+namespace mage::memprog {
+    std::vector<PhaseDemand> profile_phase_demand(const std::string& program, PageShift page_shift, util::ProgressBar* progress_bar) {
+        VirtProgramReverseFileReader instructions(program);
+        instructions.set_progress_bar(progress_bar);
+        InstructionNumber inum = instructions.get_header().num_instructions;
+
+        PageSpanTable span_table;
+        span_table.load(program, instructions.get_header());
+
+        /* Pages (or multi-page allocations, by first page) that are live. */
+        std::unordered_set<VirtPageNumber> live;
+        std::uint64_t live_pages = 0;
+
+        std::vector<PhaseDemand> phases;
+        PhaseDemand phase = {};
+        bool phase_has_work = false;
+
+        std::array<VirtPageNumber, 5> vpns;
+        std::array<PageSpan, 5> spans;
+        std::array<std::uint8_t, 5> index;
+        while (inum != 0) {
+            inum--;
+
+            std::size_t current_size;
+            PackedVirtInstruction& current = instructions.read_instruction(current_size);
+
+            /*
+             * A phase ends with each synchronization point (or with each run
+             * of consecutive ones).
+             */
+            if (current.header.operation == OpCode::NetworkFinishReceive) {
+                if (phase_has_work) {
+                    phase.start = inum + 1;
+                    phases.push_back(phase);
+                    phase = {};
+                    phase_has_work = false;
+                }
+            } else {
+                phase_has_work = true;
+            }
+
+            std::uint8_t num_pages = current.store_page_numbers(vpns.data(), page_shift);
+            if (span_table.empty()) {
+                for (std::uint8_t i = 0; i != num_pages; i++) {
+                    spans[i] = PageSpan { vpns[i], 1 };
+                }
+            } else {
+                num_pages = span_table.canonicalize(vpns.data(), num_pages, spans.data(), index.data());
+            }
+
+            /* Going backward, a page becomes live at its last use... */
+            std::uint64_t accessed_pages = 0;
+            for (std::uint8_t i = 0; i != num_pages; i++) {
+                if (live.insert(spans[i].first).second) {
+                    live_pages += spans[i].num_pages;
+                }
+                accessed_pages += spans[i].num_pages;
+            }
+            phase.peak_pages = std::max(phase.peak_pages, live_pages);
+            phase.min_pages = std::max(phase.min_pages, accessed_pages);
+
+            /* ... and dies at its first use. */
+            if ((current.header.flags & FlagOutputPageFirstUse) != 0) {
+                PageSpan output = span_table.lookup(pg_num(current.no_args.output, page_shift));
+                if (live.erase(output.first) != 0) {
+                    live_pages -= output.num_pages;
+                }
+            }
+        }
+        if (phase_has_work || phases.empty()) {
+            phase.start = 0;
+            phases.push_back(phase);
+        } else {
+            /* Leading synchronization points belong to the first phase. */
+            phases.back().start = 0;
+            phases.back().peak_pages = std::max(phases.back().peak_pages, phase.peak_pages);
+            phases.back().min_pages = std::max(phases.back().min_pages, phase.min_pages);
+        }
+
+        std::reverse(phases.begin(), phases.end());
+        return phases;
+    }
+
+    std::vector<std::vector<ResidentLimit>> split_host_budget(const std::vector<std::vector<PhaseDemand>>& demands, const std::vector<std::uint64_t>& prefetch_buffer_sizes, std::uint64_t host_pages, std::size_t max_phases) {
+        std::size_t num_workers = demands.size();
+        std::size_t num_phases = 0;
+        for (const std::vector<PhaseDemand>& worker_demand : demands) {
+            num_phases = std::max(num_phases, worker_demand.size());
+        }
+
+        /* Merge adjacent phases, in the same way for every worker. */
+        std::size_t group_size = std::max<std::size_t>((num_phases + max_phases - 1) / max_phases, 1);
+        std::size_t num_groups = (num_phases + group_size - 1) / group_size;
+        std::vector<std::vector<PhaseDemand>> grouped(num_workers);
+        for (std::size_t w = 0; w != num_workers; w++) {
+            for (std::size_t p = 0; p < demands[w].size(); p += group_size) {
+                PhaseDemand merged = demands[w][p];
+                for (std::size_t q = p + 1; q != std::min(p + group_size, demands[w].size()); q++) {
+                    merged.peak_pages = std::max(merged.peak_pages, demands[w][q].peak_pages);
+                    merged.min_pages = std::max(merged.min_pages, demands[w][q].min_pages);
+                }
+                grouped[w].push_back(merged);
+            }
+        }
+
+        std::vector<std::vector<ResidentLimit>> limits(num_workers);
+        std::vector<std::uint64_t> minimum(num_workers);
+        std::vector<std::uint64_t> need(num_workers);
+        std::vector<std::size_t> order(num_workers);
+        for (std::size_t g = 0; g != num_groups; g++) {
+            /*
+             * A worker that has run out of phases stays in its last one. The
+             * prefetch buffers are resident throughout, so they count toward
+             * the minimum but are not part of any worker's limit.
+             */
+            std::uint64_t total_minimum = std::accumulate(prefetch_buffer_sizes.begin(), prefetch_buffer_sizes.end(), UINT64_C(0));
+            for (std::size_t w = 0; w != num_workers; w++) {
+                const PhaseDemand& phase = grouped[w].empty() ? PhaseDemand {} : grouped[w][std::min(g, grouped[w].size() - 1)];
+                minimum[w] = std::max<std::uint64_t>(phase.min_pages, 1);
+                need[w] = std::max(phase.peak_pages, minimum[w]) - minimum[w];
+                total_minimum += minimum[w];
+            }
+            if (total_minimum > host_pages) {
+                std::cerr << "Host budget of " << host_pages << " pages is too small: phase " << g << " requires at least " << total_minimum << " pages, including prefetch buffers" << std::endl;
+                std::abort();
+            }
+
+            /* Water-filling: serve the workers with the least need first. */
+            std::uint64_t remaining = host_pages - total_minimum;
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&need](std::size_t a, std::size_t b) {
+                return need[a] < need[b];
+            });
+            for (std::size_t k = 0; k != num_workers; k++) {
+                std::size_t w = order[k];
+                std::uint64_t share = remaining / (num_workers - k);
+                std::uint64_t given = std::min(need[w], share);
+                remaining -= given;
+
+                if (g < grouped[w].size()) {
+                    PhysPageNumber num_pages = minimum[w] + given;
+                    if (limits[w].empty() || limits[w].back().num_pages != num_pages) {
+                        limits[w].push_back(ResidentLimit { limits[w].empty() ? 0 : grouped[w][g].start, num_pages });
+                    }
+                }
+            }
+        }
+
+        return limits;
+    }
+}
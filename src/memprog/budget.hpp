@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file memprog/budget.hpp
+ * @brief Sharing a host's memory among co-located workers in MAGE's planner
+ *
+ * When several workers run on the same host, giving each a fixed number of
+ * page frames leaves memory idle whenever one worker needs less than its
+ * share (e.g., while it waits on the network) and another needs more. The
+ * planner can instead take a budget of page frames for the whole host and
+ * divide it among the co-located workers separately for each phase of the
+ * program, where phases are delimited by network synchronization points
+ * (finishing a receive), at which the workers' relative progress is known.
+ *
+ * Workers are assumed to proceed through their phases in lockstep, so the
+ * k-th phase of each worker is taken to run concurrently with the k-th phase
+ * of every other worker.
+ */
+
+#ifndef MAGE_MEMPROG_BUDGET_HPP_
+#define MAGE_MEMPROG_BUDGET_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "addr.hpp"
+#include "util/progress.hpp"
+
+namespace mage::memprog {
+    /**
+     * @brief The default limit on the number of phases into which a program
+     * is divided for the purpose of sharing memory. If there are more
+     * synchronization points, adjacent phases are merged.
+     */
+    constexpr std::size_t default_max_budget_phases = 256;
+
+    /**
+     * @brief The number of page frames a worker may keep resident, starting
+     * at a particular instruction.
+     */
+    struct ResidentLimit {
+        InstructionNumber start;
+        PhysPageNumber num_pages;
+    };
+
+    /**
+     * @brief The memory demand of one phase of a program.
+     */
+    struct PhaseDemand {
+        /* The number (index) of the first instruction in the phase. */
+        InstructionNumber start;
+
+        /*
+         * The largest number of pages live (used both at or before, and at or
+         * after, some instruction) at once during the phase; with this many
+         * page frames, the phase would not swap.
+         */
+        std::uint64_t peak_pages;
+
+        /*
+         * The largest number of pages accessed by a single instruction in the
+         * phase; the phase cannot run with fewer page frames.
+         */
+        std::uint64_t min_pages;
+    };
+
+    /**
+     * @brief Computes the memory demand of each phase of a virtual bytecode.
+     *
+     * This involves iterating over the virtual bytecode in reverse order.
+     *
+     * @param program The file name containing the virtual bytecode to read.
+     * This sequence of instructions should be reverse-iterable.
+     * @param page_shift Base-2 logarithm of the page size.
+     * @param progress_bar Progress bar to use to show progress, or nullptr if
+     * none should be used.
+     * @return The demand of each phase, in program order.
+     */
+    std::vector<PhaseDemand> profile_phase_demand(const std::string& program, PageShift page_shift, util::ProgressBar* progress_bar = nullptr);
+
+    /**
+     * @brief Divides a host's page frames among co-located workers, for each
+     * phase of their programs.
+     *
+     * Phases are matched by index: the k-th phase of each worker is assumed
+     * to run concurrently with the k-th phase of every other worker, which
+     * holds only if the workers proceed in lockstep (e.g., because they
+     * exchange data at every synchronization point).
+     *
+     * Each worker's prefetch buffer frames are set aside first, since they
+     * are resident in addition to the frames used for replacement. In each
+     * phase, every worker then receives the minimum it needs to run; the
+     * remainder is divided by max-min fairness on the workers' remaining
+     * demand (water-filling), so a worker never receives more than its peak
+     * demand and memory left over by idle workers goes to busy ones.
+     *
+     * If the budget is too small to give every worker its prefetch buffer
+     * and its minimum in some phase, the process is aborted.
+     *
+     * @param demands The per-phase demand of each worker, as computed by
+     * @p profile_phase_demand.
+     * @param prefetch_buffer_sizes The number of prefetch buffer frames of
+     * each worker.
+     * @param host_pages The total number of page frames available on the
+     * host, including prefetch buffers.
+     * @param max_phases The largest number of distinct phases to use; if
+     * the programs have more, adjacent phases are merged (in the same way for
+     * every worker).
+     * @return For each worker, its resident limits (not counting its
+     * prefetch buffer), ordered by starting instruction, the first of which
+     * starts at instruction 0.
+     */
+    std::vector<std::vector<ResidentLimit>> split_host_budget(const std::vector<std::vector<PhaseDemand>>& demands, const std::vector<std::uint64_t>& prefetch_buffer_sizes, std::uint64_t host_pages, std::size_t max_phases = default_max_budget_phases);
+}
+
+#endif
@@ -20,26 +20,45 @@
  */
 
 #include "memprog/pipeline.hpp"
+#include <cstdlib>
 #include <chrono>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 #include "memprog/annotation.hpp"
+#include "memprog/budget.hpp"
 #include "memprog/placement.hpp"
 #include "memprog/program.hpp"
 #include "memprog/replacement.hpp"
 #include "memprog/scheduling.hpp"
+#include "memprog/storage.hpp"
+#include "programfile.hpp"
 
 namespace mage::memprog {
+    /*
+     * Number of instructions, beyond the prefetch lookahead, that the
+     * replacement stage may run ahead of the scheduling stage when the two
+     * run concurrently.
+     */
+    static constexpr InstructionNumber concurrent_scheduling_slack = 1 << 16;
+
     DefaultPipeline::DefaultPipeline(const std::string& name) : Pipeline(name),
         page_shift(12), num_pages(1 << 10), prefetch_buffer_size(256), prefetch_lookahead(10000),
-        stats({}), verbose(false) {
+        swap_extent_pages(0), swap_reuse_window(1 << 12), concurrent_scheduling(false), stall_aware_replacement(false), predicted_swap_latency(10000), stats({}), verbose(false) {
     }
 
-    DefaultPipeline::DefaultPipeline(const std::string& name, const util::ConfigValue& worker) : Pipeline(name) {
+    DefaultPipeline::DefaultPipeline(const std::string& name, const util::ConfigValue& worker) : Pipeline(name), stats({}), verbose(false) {
         this->read_config(worker);
     }
 
+    DefaultPipeline::DefaultPipeline(const std::string& name, PageShift shift, VirtPageNumber num_page_frames, VirtPageNumber prefetch_buffer_frames, InstructionNumber lookahead)
+        : Pipeline(name), page_shift(shift), num_pages(num_page_frames), prefetch_buffer_size(prefetch_buffer_frames), prefetch_lookahead(lookahead),
+        swap_extent_pages(0), swap_reuse_window(1 << 12), concurrent_scheduling(false), stall_aware_replacement(false), predicted_swap_latency(lookahead), stats({}), verbose(false) {
+    }
+
     void DefaultPipeline::set_verbose(bool be_verbose) {
         this->verbose = be_verbose;
     }
@@ -49,6 +68,64 @@ namespace mage::memprog {
         this->num_pages = worker["num_pages"].as_int();
         this->prefetch_buffer_size = worker["prefetch_buffer_size"].as_int();
         this->prefetch_lookahead = worker["prefetch_lookahead"].as_int();
+
+        /*
+         * Optional: group swapped-out pages into extents of storage frames by
+         * the time at which they are next used.
+         */
+        this->swap_extent_pages = 0;
+        this->swap_reuse_window = 1 << 12;
+        if (worker.get("swap_extent_pages") != nullptr) {
+            this->swap_extent_pages = worker["swap_extent_pages"].as_int();
+        }
+        if (worker.get("swap_reuse_window") != nullptr) {
+            this->swap_reuse_window = worker["swap_reuse_window"].as_int();
+        }
+
+        /*
+         * Optional: run the replacement and scheduling stages concurrently,
+         * streaming the physical bytecode between them in memory.
+         */
+        this->concurrent_scheduling = false;
+        if (worker.get("concurrent_scheduling") != nullptr) {
+            this->concurrent_scheduling = (worker["concurrent_scheduling"].as_int() != 0);
+        }
+
+        /*
+         * Optional: choose evictions to minimize the predicted time stalled
+         * on swaps, given the prefetch buffer and lookahead, rather than the
+         * number of swaps. The predicted swap latency, in instructions,
+         * defaults to the lookahead.
+         */
+        this->stall_aware_replacement = false;
+        this->predicted_swap_latency = this->prefetch_lookahead;
+        if (worker.get("stall_aware_replacement") != nullptr) {
+            this->stall_aware_replacement = (worker["stall_aware_replacement"].as_int() != 0);
+        }
+        if (worker.get("predicted_swap_latency") != nullptr) {
+            this->predicted_swap_latency = worker["predicted_swap_latency"].as_int();
+        }
+
+        /*
+         * Optional: swap to multiple storage tiers, fastest first, placing
+         * each page by its reuse distance. Every tier but the last must give
+         * the largest reuse distance of pages placed in it.
+         */
+        this->swap_tier_max_reuse_distances.clear();
+        if (worker.get("swap_tiers") != nullptr) {
+            const util::ConfigValue& tiers = worker["swap_tiers"];
+            if (tiers.get_size() == 0 || tiers.get_size() > max_storage_tiers) {
+                std::cerr << "Number of swap tiers must be between 1 and " << static_cast<int>(max_storage_tiers) << std::endl;
+                std::abort();
+            }
+            for (std::size_t i = 0; i + 1 < tiers.get_size(); i++) {
+                if (tiers[i].get("max_reuse_distance") == nullptr) {
+                    std::cerr << "Swap tier " << i << " needs a max_reuse_distance" << std::endl;
+                    std::abort();
+                }
+                this->swap_tier_max_reuse_distances.push_back(tiers[i]["max_reuse_distance"].as_int());
+            }
+        }
     }
 
     void DefaultPipeline::program(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> dsl_program, const std::string& prog_file) {
@@ -63,30 +140,60 @@ namespace mage::memprog {
         }
     }
 
-    void DefaultPipeline::allocate(const std::string& prog_file, const std::string& repprog_file) {
+    void DefaultPipeline::annotate(const std::string& prog_file, const std::string& ann_file) {
         this->progress_bar.set_label("Annotations Pass");
-        std::string ann_file = this->program_name + ".ann";
-        annotate_program(ann_file, prog_file, this->page_shift, &this->progress_bar);
+        annotate_program(ann_file, prog_file, this->page_shift, this->get_progress_bar());
         this->progress_bar.finish();
         if (this->verbose) {
             std::cout << "Computed annotations" << std::endl;
         }
+    }
 
-        this->progress_bar.set_label("Replacement Pass");
-        BeladyAllocator allocator(repprog_file, prog_file, ann_file, this->num_pages, this->page_shift);
-        allocator.allocate(&this->progress_bar);
-        this->progress_bar.finish();
+    template <typename Output>
+    std::unique_ptr<BeladyAllocator> DefaultPipeline::make_allocator(Output& output, const std::string& prog_file, const std::string& ann_file) {
+        TieredStorageAllocator storage_frames(StorageFrameAllocator(this->swap_extent_pages, this->swap_reuse_window), this->swap_tier_max_reuse_distances);
+        if (this->stall_aware_replacement) {
+            return std::make_unique<StallAwareAllocator>(output, prog_file, ann_file, this->num_pages, this->page_shift, this->prefetch_buffer_size, this->prefetch_lookahead, this->predicted_swap_latency, storage_frames, this->resident_limits);
+        }
+        return std::make_unique<BeladyAllocator>(output, prog_file, ann_file, this->num_pages, this->page_shift, storage_frames, this->resident_limits);
+    }
+
+    void DefaultPipeline::record_replacement_stats(const BeladyAllocator& allocator) {
         this->stats.num_swapouts = allocator.get_num_swapouts();
         this->stats.num_swapins = allocator.get_num_swapins();
+        this->stats.num_storage_frames = allocator.get_num_storage_frames();
+        const StallAwareAllocator* stall_aware = dynamic_cast<const StallAwareAllocator*>(&allocator);
+        if (stall_aware != nullptr) {
+            this->stats.predicted_swap_stall = stall_aware->get_predicted_stall();
+            this->stats.num_replacement_substitutions = stall_aware->get_num_substitutions();
+            this->stats.predicted_synchronous_swaps = stall_aware->get_num_synchronous_swaps();
+        }
+    }
+
+    void DefaultPipeline::replace(const std::string& prog_file, const std::string& ann_file, const std::string& repprog_file) {
+        this->progress_bar.set_label("Replacement Pass");
+        std::unique_ptr<BeladyAllocator> allocator = this->make_allocator(repprog_file, prog_file, ann_file);
+        allocator->allocate(this->get_progress_bar());
+        this->progress_bar.finish();
+        this->record_replacement_stats(*allocator);
         if (this->verbose) {
-            std::cout << "Finished replacement stage: " << allocator.get_num_swapouts() << " swapouts, " << allocator.get_num_swapins() << " swapins" << std::endl;
+            std::cout << "Finished replacement stage: " << allocator->get_num_swapouts() << " swapouts, " << allocator->get_num_swapins() << " swapins" << std::endl;
+            if (this->stall_aware_replacement) {
+                std::cout << "Evicted " << this->stats.num_replacement_substitutions << " pages in place of those chosen by Belady's algorithm; predicted stall of " << this->stats.predicted_swap_stall << " instructions and " << this->stats.predicted_synchronous_swaps << " synchronous swaps" << std::endl;
+            }
         }
     }
 
+    void DefaultPipeline::allocate(const std::string& prog_file, const std::string& repprog_file) {
+        std::string ann_file = this->program_name + ".ann";
+        this->annotate(prog_file, ann_file);
+        this->replace(prog_file, ann_file, repprog_file);
+    }
+
     void DefaultPipeline::schedule(const std::string& repprog_file, const std::string& memprog_file) {
         this->progress_bar.set_label("Scheduling Pass");
         BackdatingScheduler scheduler(repprog_file, memprog_file, this->prefetch_lookahead, this->prefetch_buffer_size);
-        scheduler.schedule(&this->progress_bar);
+        scheduler.schedule(this->get_progress_bar());
         this->progress_bar.finish();
         this->stats.num_prefetch_alloc_failures = scheduler.get_num_allocation_failures();
         this->stats.num_synchronous_swapins = scheduler.get_num_synchronous_swapins();
@@ -95,11 +202,67 @@ namespace mage::memprog {
         }
     }
 
-    void DefaultPipeline::plan(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> program) {
+    void DefaultPipeline::replace_and_schedule(const std::string& prog_file, const std::string& ann_file, const std::string& memprog_file) {
+        this->progress_bar.set_label("Replacement and Scheduling Pass");
+        PhysProgramPipe repprog(this->prefetch_lookahead, concurrent_scheduling_slack);
+
+        /* The replacement stage's progress bar tracks the overall progress. */
+        std::chrono::steady_clock::time_point replacement_end;
+        std::thread replacement([&]() {
+            std::unique_ptr<BeladyAllocator> allocator = this->make_allocator(repprog, prog_file, ann_file);
+            allocator->allocate(this->get_progress_bar());
+            this->record_replacement_stats(*allocator);
+            replacement_end = std::chrono::steady_clock::now();
+        });
+
+        BackdatingScheduler scheduler(repprog, memprog_file, this->prefetch_lookahead, this->prefetch_buffer_size);
+        scheduler.schedule();
+        replacement.join();
+        auto scheduling_end = std::chrono::steady_clock::now();
+        this->stats.scheduling_duration = std::chrono::duration_cast<std::chrono::milliseconds>(scheduling_end - replacement_end);
+        this->progress_bar.finish();
+        this->stats.num_prefetch_alloc_failures = scheduler.get_num_allocation_failures();
+        this->stats.num_synchronous_swapins = scheduler.get_num_synchronous_swapins();
+        if (this->verbose) {
+            std::cout << "Finished replacement stage: " << this->stats.num_swapouts << " swapouts, " << this->stats.num_swapins << " swapins" << std::endl;
+            if (this->stall_aware_replacement) {
+                std::cout << "Evicted " << this->stats.num_replacement_substitutions << " pages in place of those chosen by Belady's algorithm; predicted stall of " << this->stats.predicted_swap_stall << " instructions and " << this->stats.predicted_synchronous_swaps << " synchronous swaps" << std::endl;
+            }
+            std::cout << "Finished scheduling swaps: " << scheduler.get_num_allocation_failures() << " allocation failures, " << scheduler.get_num_synchronous_swapins() << " synchronous swapins" << std::endl;
+        }
+    }
+
+    std::vector<PhaseDemand> DefaultPipeline::profile(const std::string& prog_file) {
+        this->progress_bar.set_label("Demand Profiling Pass");
+        std::vector<PhaseDemand> demand = profile_phase_demand(prog_file, this->page_shift, this->get_progress_bar());
+        this->progress_bar.finish();
+        if (this->verbose) {
+            std::cout << "Profiled memory demand of " << demand.size() << " phases" << std::endl;
+        }
+        return demand;
+    }
+
+    void DefaultPipeline::set_resident_limits(const std::vector<ResidentLimit>& limits) {
+        this->resident_limits = limits;
+    }
+
+    void DefaultPipeline::plan_placement(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> program) {
         auto program_start = std::chrono::steady_clock::now();
         this->program(p, plugin, program, this->program_name + ".prog");
         auto program_end = std::chrono::steady_clock::now();
         this->stats.placement_duration = std::chrono::duration_cast<std::chrono::milliseconds>(program_end - program_start);
+    }
+
+    void DefaultPipeline::plan_memory() {
+        if (this->concurrent_scheduling) {
+            auto start = std::chrono::steady_clock::now();
+            std::string ann_file = this->program_name + ".ann";
+            this->annotate(this->program_name + ".prog", ann_file);
+            this->replace_and_schedule(this->program_name + ".prog", ann_file, this->program_name + ".memprog");
+            auto end = std::chrono::steady_clock::now();
+            this->stats.replacement_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start) - this->stats.scheduling_duration;
+            return;
+        }
 
         auto replacement_start = std::chrono::steady_clock::now();
         this->allocate(this->program_name + ".prog", this->program_name + ".repprog");
@@ -112,6 +275,19 @@ namespace mage::memprog {
         this->stats.scheduling_duration = std::chrono::duration_cast<std::chrono::milliseconds>(scheduling_end - scheduling_start);
     }
 
+    void DefaultPipeline::plan(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> program) {
+        this->plan_placement(p, plugin, program);
+        this->plan_memory();
+    }
+
+    PageShift DefaultPipeline::get_page_shift() const {
+        return this->page_shift;
+    }
+
+    util::ProgressBar* DefaultPipeline::get_progress_bar() {
+        return this->verbose ? &this->progress_bar : nullptr;
+    }
+
     const DefaultPipelineStats& DefaultPipeline::get_stats() const {
         return this->stats;
     }
@@ -30,8 +30,11 @@
 #include <cstdint>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 #include "memprog/annotation.hpp"
+#include "memprog/budget.hpp"
 #include "memprog/placement.hpp"
 #include "memprog/replacement.hpp"
 #include "util/config.hpp"
@@ -81,8 +84,9 @@ namespace mage::memprog {
         /**
          * @brief Sets the verbosity of memory program generation.
          *
-         * @param be_verbose If true, status information is printed out after
-         * each stage of the pipeline; if false, nothing is printed out.
+         * @param be_verbose If true, progress bars and status information are
+         * printed out for each stage of the pipeline; if false, nothing is
+         * printed out.
          */
         virtual void set_verbose(bool be_verbose) = 0;
 
@@ -124,7 +128,17 @@ namespace mage::memprog {
         std::uint64_t num_prefetch_alloc_failures;
         std::uint64_t num_synchronous_swapins;
 
+        /* Collected only if stall-aware replacement is configured. */
+        InstructionNumber predicted_swap_stall;
+        std::uint64_t num_replacement_substitutions;
+        std::uint64_t predicted_synchronous_swaps;
+
         std::chrono::milliseconds placement_duration;
+
+        /*
+         * If replacement and scheduling run concurrently, the scheduling
+         * duration covers only the time after replacement finishes.
+         */
         std::chrono::milliseconds replacement_duration;
         std::chrono::milliseconds scheduling_duration;
     };
@@ -153,6 +167,21 @@ namespace mage::memprog {
          */
         DefaultPipeline(const std::string& name, const util::ConfigValue& worker);
 
+        /**
+         * @brief Creates an instance of the default pipeline to create a
+         * memory program with the given name and planning parameters.
+         *
+         * @param name The name of the memory program to create.
+         * @param shift Base-2 logarithm of the page size.
+         * @param num_page_frames The number of page frames in memory
+         * available to the replacement stage.
+         * @param prefetch_buffer_frames The number of additional page frames
+         * in memory reserved for prefetching.
+         * @param lookahead The number of instructions ahead of time at which
+         * to issue prefetches.
+         */
+        DefaultPipeline(const std::string& name, PageShift shift, VirtPageNumber num_page_frames, VirtPageNumber prefetch_buffer_frames, InstructionNumber lookahead);
+
         void set_verbose(bool be_verbose) override;
 
         void read_config(const util::ConfigValue& worker) override;
@@ -171,6 +200,35 @@ namespace mage::memprog {
          */
         virtual void program(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> dsl_program, const std::string& prog_file);
 
+        /**
+         * @brief Runs the reverse pass that annotates the virtual bytecode with
+         * next-use information for the "Replacement" stage.
+         *
+         * The annotations depend only on the virtual bytecode and the page
+         * size, so they can be reused across multiple runs of the
+         * "Replacement" stage with different numbers of page frames.
+         *
+         * @param prog_file The name of the file containing the virtual
+         * bytecode (output of the "Placement" stage).
+         * @param ann_file The name of the file to which to write the
+         * annotations.
+         */
+        virtual void annotate(const std::string& prog_file, const std::string& ann_file);
+
+        /**
+         * @brief Runs the "Replacement" stage of the planning pipeline using
+         * previously computed annotations.
+         *
+         * @param prog_file The name of the file containing the virtual
+         * bytecode (output of the "Placement" stage), which is read as input
+         * in this stage.
+         * @param ann_file The name of the file containing the annotations
+         * (output of @p annotate) for the virtual bytecode.
+         * @param repprog_file The name of the file to which to write the
+         * output of the "Replacement" stage (physical bytecode).
+         */
+        virtual void replace(const std::string& prog_file, const std::string& ann_file, const std::string& repprog_file);
+
         /**
          * @brief Runs the "Replacement" stage of the planning pipeline,
          * including the preceding reverse pass to annotate the proram. Invoked
@@ -187,6 +245,26 @@ namespace mage::memprog {
          */
         virtual void allocate(const std::string& prog_file, const std::string& repprog_file);
 
+        /**
+         * @brief Runs the "Replacement" and "Scheduling" stages of the
+         * planning pipeline concurrently, on separate threads, using
+         * previously computed annotations. Invoked by the @p plan function if
+         * concurrent scheduling is configured.
+         *
+         * The physical bytecode is streamed from one stage to the other
+         * through a bounded in-memory pipe instead of being written to a
+         * file, so planning takes about as long as the slower of the two
+         * stages, rather than their sum.
+         *
+         * @param prog_file The name of the file containing the virtual
+         * bytecode (output of the "Placement" stage).
+         * @param ann_file The name of the file containing the annotations
+         * (output of @p annotate) for the virtual bytecode.
+         * @param memprog_file The name of the file to which to write the
+         * output of the "Scheduling" stage (the final memory program).
+         */
+        virtual void replace_and_schedule(const std::string& prog_file, const std::string& ann_file, const std::string& memprog_file);
+
         /**
          * @brief Runs the "Scheduling" stage of the planning pipeline. Invoked
          * by the @p plan function.
@@ -200,8 +278,57 @@ namespace mage::memprog {
          */
         virtual void schedule(const std::string& repprog_file, const std::string& memprog_file);
 
+        /**
+         * @brief Computes the memory demand of each phase of the virtual
+         * bytecode, used to divide a host's memory among co-located workers.
+         *
+         * @param prog_file The name of the file containing the virtual
+         * bytecode (output of the "Placement" stage).
+         * @return The demand of each phase, in program order.
+         */
+        virtual std::vector<PhaseDemand> profile(const std::string& prog_file);
+
+        /**
+         * @brief Makes the number of page frames available to the
+         * "Replacement" stage vary over the program, instead of using the
+         * configured number of pages throughout.
+         *
+         * @param limits The number of page frames available starting at each
+         * listed instruction (see mage::memprog::split_host_budget), or an
+         * empty list to use the configured number of pages.
+         */
+        void set_resident_limits(const std::vector<ResidentLimit>& limits);
+
+        /**
+         * @brief Runs the "Placement" stage of the planning pipeline. The
+         * remaining stages can then be run with @p plan_memory, possibly
+         * after choosing resident limits based on the output of
+         * @p profile.
+         *
+         * @param p Pointer to the program object pointer used by the DSL in
+         * which the program is written.
+         * @param plugin Plugin for the target protocol, used for placement of
+         * data in the MAGE-virtual address space.
+         * @param program The program whose execution to plan.
+         */
+        void plan_placement(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> program);
+
+        /**
+         * @brief Runs the "Replacement" and "Scheduling" stages of the
+         * planning pipeline, after @p plan_placement.
+         */
+        void plan_memory();
+
         void plan(Program<BinnedPlacer>** p, PlacementPlugin plugin, std::function<void()> program) override;
 
+        /**
+         * @brief Returns the base-2 logarithm of the page size used by this
+         * pipeline.
+         *
+         * @return The base-2 logarithm of the page size.
+         */
+        PageShift get_page_shift() const;
+
         /**
          * @brief Returns statistics collected during the planning phase.
          *
@@ -211,10 +338,41 @@ namespace mage::memprog {
         const DefaultPipelineStats& get_stats() const;
 
     private:
+        util::ProgressBar* get_progress_bar();
+
+        /**
+         * @brief Creates the allocator for the "Replacement" stage, according
+         * to the configured replacement policy.
+         *
+         * @param output The name of the file, or the pipe, to which to write
+         * the physical bytecode.
+         * @param prog_file The name of the file containing the virtual
+         * bytecode.
+         * @param ann_file The name of the file containing the annotations for
+         * the virtual bytecode.
+         * @return The allocator.
+         */
+        template <typename Output>
+        std::unique_ptr<BeladyAllocator> make_allocator(Output& output, const std::string& prog_file, const std::string& ann_file);
+
+        /**
+         * @brief Records statistics from a completed "Replacement" stage.
+         *
+         * @param allocator The allocator that ran the stage.
+         */
+        void record_replacement_stats(const BeladyAllocator& allocator);
+
         PageShift page_shift;
         VirtPageNumber num_pages;
         VirtPageNumber prefetch_buffer_size;
         InstructionNumber prefetch_lookahead;
+        StoragePageNumber swap_extent_pages;
+        InstructionNumber swap_reuse_window;
+        std::vector<InstructionNumber> swap_tier_max_reuse_distances;
+        std::vector<ResidentLimit> resident_limits;
+        bool concurrent_scheduling;
+        bool stall_aware_replacement;
+        InstructionNumber predicted_swap_latency;
 
         DefaultPipelineStats stats;
         util::ProgressBar progress_bar;
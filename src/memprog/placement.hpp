@@ -32,6 +32,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <stdexcept>
 #include <unordered_map>
@@ -83,6 +84,19 @@ namespace mage::memprog {
      */
     using PlacementPlugin = std::function<AllocationSize(std::uint64_t, PlaceableType)>;
 
+    /**
+     * @brief Describes a range of contiguous MAGE-virtual pages that hold a
+     * single allocation larger than a page.
+     *
+     * The replacement stage keeps the pages contiguous in memory and swaps
+     * them as a group, so instructions may address any part of the
+     * allocation relative to its start.
+     */
+    struct PageSpan {
+        VirtPageNumber first;
+        VirtPageNumber num_pages;
+    };
+
     /**
      * @brief Exception type that indicates that placement of a variable was
      * attempted, but it could not be completed with the current configuration.
@@ -135,6 +149,14 @@ namespace mage::memprog {
          * @return The number of pages used in the MAGE-virtual address space.
          */
         virtual VirtPageNumber get_num_pages() const = 0;
+
+        /**
+         * @brief Returns the ranges of pages holding allocations that span
+         * multiple pages.
+         *
+         * @return A reference to a vector of all such ranges.
+         */
+        virtual const std::vector<PageSpan>& get_page_spans() const = 0;
     };
 
     /**
@@ -160,6 +182,13 @@ namespace mage::memprog {
             }
             this->next_free_address = addr + width;
             fresh_page = (pg_offset(addr, this->page_shift) == 0);
+            if (width > pg_size(this->page_shift)) {
+                /* Don't let later allocations share the span's last page. */
+                VirtPageNumber first = pg_num(addr, this->page_shift);
+                VirtPageNumber end = pg_num(addr + width - 1, this->page_shift) + 1;
+                this->spans.push_back(PageSpan { first, end - first });
+                this->next_free_address = pg_addr(end, this->page_shift);
+            }
             return addr;
         }
 
@@ -175,7 +204,12 @@ namespace mage::memprog {
             return num_pages;
         }
 
+        const std::vector<PageSpan>& get_page_spans() const {
+            return this->spans;
+        }
+
     private:
+        std::vector<PageSpan> spans;
         VirtAddr next_free_address;
         PageShift page_shift;
     };
@@ -229,7 +263,13 @@ namespace mage::memprog {
             return this->next_page;
         }
 
+        const std::vector<PageSpan>& get_page_spans() const {
+            /* Allocations larger than a page are not supported. */
+            return this->spans;
+        }
+
     private:
+        std::vector<PageSpan> spans;
         std::unordered_map<AllocationSize, std::vector<VirtAddr>> slot_map;
         std::unordered_set<VirtAddr> allocated;
         VirtPageNumber next_page;
@@ -282,6 +322,11 @@ namespace mage::memprog {
      * In addition to the equal-width heuristic used by the @p FIFOPlacer, it
      * aims to reduce fragmentation by trying to avoid keeping pages only
      * partially filled.
+     *
+     * Allocations larger than a page are placed on a range of contiguous
+     * fresh pages (see @p PageSpan). A range is only ever reused for another
+     * allocation needing the same number of pages, so each range has a fixed
+     * length for the lifetime of the program.
      */
     class BinnedPlacer {
     public:
@@ -294,6 +339,10 @@ namespace mage::memprog {
         }
 
         VirtAddr allocate_virtual(AllocationSize width, bool& fresh_page) {
+            if (width > pg_size(this->page_shift)) {
+                return this->allocate_span(width, fresh_page);
+            }
+
             AllocationSizeInfo& bwi = this->get_info(width);
 
             VirtAddr result;
@@ -348,6 +397,12 @@ namespace mage::memprog {
         }
 
         void deallocate_virtual(VirtAddr addr, AllocationSize width) {
+            if (width > pg_size(this->page_shift)) {
+                VirtPageNumber num_pages = (width + pg_size(this->page_shift) - 1) >> this->page_shift;
+                this->free_spans[num_pages].push_back(pg_num(addr, this->page_shift));
+                return;
+            }
+
             AllocationSizeInfo& bwi = this->get_info(width);
             VirtPageNumber page = pg_num(addr, this->page_shift);
 
@@ -400,7 +455,35 @@ namespace mage::memprog {
             return this->next_page;
         }
 
+        const std::vector<PageSpan>& get_page_spans() const {
+            return this->spans;
+        }
+
     private:
+        /**
+         * @brief Places an allocation larger than a page on a range of
+         * contiguous pages.
+         *
+         * Reusing a free range still counts as a fresh page, because the
+         * previous allocation on it has been freed and nothing else shares
+         * those pages.
+         */
+        VirtAddr allocate_span(AllocationSize width, bool& fresh_page) {
+            VirtPageNumber num_pages = (width + pg_size(this->page_shift) - 1) >> this->page_shift;
+            std::vector<VirtPageNumber>& free_list = this->free_spans[num_pages];
+            VirtPageNumber first;
+            if (free_list.empty()) {
+                first = this->next_page;
+                this->next_page += num_pages;
+                this->spans.push_back(PageSpan { first, num_pages });
+            } else {
+                first = free_list.back();
+                free_list.pop_back();
+            }
+            fresh_page = true;
+            return pg_addr(first, this->page_shift);
+        }
+
         /**
          * @brief Obtains a reference to the @p AllocationSizeInfo object for a
          * given allocation size, creating the @p AllocationSizeInfo object for
@@ -416,6 +499,8 @@ namespace mage::memprog {
         }
 
         std::unordered_map<AllocationSize, AllocationSizeInfo> slot_map;
+        std::unordered_map<VirtPageNumber, std::vector<VirtPageNumber>> free_spans;
+        std::vector<PageSpan> spans;
         VirtPageNumber next_page;
         PageShift page_shift;
     };
@@ -35,14 +35,124 @@
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "addr.hpp"
 #include "instruction.hpp"
 #include "memprog/placement.hpp"
 #include "opcode.hpp"
+#include "platform/filesystem.hpp"
 #include "programfile.hpp"
 
 namespace mage::memprog {
+    /**
+     * @brief Obtains the name of the file listing the multi-page allocations
+     * (see @p PageSpan) in a virtual bytecode.
+     *
+     * The file is only written if the virtual bytecode's header has the
+     * @p ProgramFlagPageSpans flag set.
+     *
+     * @param program_file The name of the file containing the virtual
+     * bytecode.
+     * @return The name of the corresponding file of page spans.
+     */
+    inline std::string page_spans_file_name(const std::string& program_file) {
+        return program_file + ".spans";
+    }
+
+    /**
+     * @brief Lookup table for the multi-page allocations (see @p PageSpan) in
+     * a virtual bytecode, used by the stages after placement.
+     *
+     * Instructions may refer to any page in a multi-page allocation (e.g., if
+     * they operate on a slice of it), so every page is mapped to the first
+     * page of its allocation, which represents the whole allocation.
+     */
+    class PageSpanTable {
+    public:
+        /**
+         * @brief Loads the multi-page allocations for a virtual bytecode, if
+         * it has any.
+         *
+         * @param program_file The name of the file containing the virtual
+         * bytecode.
+         * @param header The metadata header of the virtual bytecode.
+         */
+        void load(const std::string& program_file, const ProgramFileHeader& header) {
+            this->spans_by_page.clear();
+            if ((header.flags & ProgramFlagPageSpans) == 0) {
+                return;
+            }
+            std::uint64_t length;
+            int fd = platform::open_file(page_spans_file_name(program_file).c_str(), &length);
+            std::vector<PageSpan> spans(length / sizeof(PageSpan));
+            platform::read_from_file_at(fd, spans.data(), spans.size() * sizeof(PageSpan), 0);
+            platform::close_file(fd);
+            for (const PageSpan& span : spans) {
+                for (VirtPageNumber i = 0; i != span.num_pages; i++) {
+                    this->spans_by_page[span.first + i] = span;
+                }
+            }
+        }
+
+        /**
+         * @brief Returns true if there are no multi-page allocations.
+         */
+        bool empty() const {
+            return this->spans_by_page.empty();
+        }
+
+        /**
+         * @brief Obtains the allocation containing the specified page.
+         *
+         * @param vpn The page number of the specified page.
+         * @return The range of pages of the allocation containing @p vpn, or
+         * a range containing only @p vpn if it is not part of a multi-page
+         * allocation.
+         */
+        PageSpan lookup(VirtPageNumber vpn) const {
+            if (!this->spans_by_page.empty()) {
+                auto iter = this->spans_by_page.find(vpn);
+                if (iter != this->spans_by_page.end()) {
+                    return iter->second;
+                }
+            }
+            return PageSpan { vpn, 1 };
+        }
+
+        /**
+         * @brief Maps the pages accessed by an instruction to the distinct
+         * allocations that contain them.
+         *
+         * @param vpns The pages accessed by the instruction, as computed by
+         * @p store_page_numbers.
+         * @param num_vpns The number of pages in @p vpns.
+         * @param[out] spans The distinct allocations, in order of first
+         * appearance in @p vpns.
+         * @param[out] index For each page in @p vpns, the index of its
+         * allocation in @p spans.
+         * @return The number of distinct allocations.
+         */
+        std::uint8_t canonicalize(const VirtPageNumber* vpns, std::uint8_t num_vpns, PageSpan* spans, std::uint8_t* index) const {
+            std::uint8_t num_spans = 0;
+            for (std::uint8_t i = 0; i != num_vpns; i++) {
+                PageSpan span = this->lookup(vpns[i]);
+                std::uint8_t j;
+                for (j = 0; j != num_spans && spans[j].first != span.first; j++) {
+                }
+                if (j == num_spans) {
+                    spans[num_spans++] = span;
+                }
+                index[i] = j;
+            }
+            return num_spans;
+        }
+
+    private:
+        std::unordered_map<VirtPageNumber, PageSpan> spans_by_page;
+    };
+
     /**
      * @brief Used by DSLs to emit virtual bytecode instructions and interact
      * with MAGE's planner's placement module as they execute.
@@ -62,7 +172,7 @@ namespace mage::memprog {
          * @param prot Plugin with sizing information specific to the target
          * protocol, used for placement.
          */
-        Program(std::string filename, PageShift shift, PlacementPlugin prot) : VirtProgramFileWriter(filename, shift), placer(shift), protocol(prot) {
+        Program(std::string filename, PageShift shift, PlacementPlugin prot) : VirtProgramFileWriter(filename, shift), placer(shift), protocol(prot), spans_file(page_spans_file_name(filename)) {
         }
 
         /**
@@ -70,6 +180,13 @@ namespace mage::memprog {
          */
         ~Program() {
             this->set_page_count(this->placer.get_num_pages());
+            const std::vector<PageSpan>& spans = this->placer.get_page_spans();
+            if (!spans.empty()) {
+                int fd = platform::create_file(this->spans_file.c_str(), 0);
+                platform::write_to_file(fd, spans.data(), spans.size() * sizeof(PageSpan));
+                platform::close_file(fd);
+                this->set_flags(ProgramFlagPageSpans);
+            }
             if (Program<Placer>::current_working_program == this) {
                 Program<Placer>::current_working_program = nullptr;
             }
@@ -232,6 +349,7 @@ namespace mage::memprog {
         Instruction current;
         Placer placer;
         PlacementPlugin protocol;
+        std::string spans_file;
         static Program<Placer>* current_working_program;
     };
 
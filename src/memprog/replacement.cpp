@@ -20,28 +20,63 @@
  */
 
 #include "memprog/replacement.hpp"
+#include <cassert>
 #include <cstdint>
+#include <cstdlib>
+#include <algorithm>
 #include <array>
+#include <deque>
+#include <iostream>
 #include <string>
+#include <vector>
 #include "addr.hpp"
 #include "instruction.hpp"
 #include "memprog/annotation.hpp"
+#include "memprog/storage.hpp"
 #include "opcode.hpp"
+#include "platform/filesystem.hpp"
 
 namespace mage::memprog {
-    Allocator::Allocator(std::string output_file, PhysPageNumber num_page_frames, PageShift shift)
-        : next_storage_frame(0), pages_end(0), page_shift(shift), num_swapouts(0), num_swapins(0), phys_prog(output_file, 0, num_page_frames) {
+    /*
+     * Number of pages, in order of next use, that the stall-aware allocator
+     * considers when looking for one to evict in place of Belady's choice.
+     */
+    static constexpr std::size_t stall_aware_candidates = 8;
+
+    /*
+     * Resolution of the stall-aware allocator's calendar of committed
+     * swap-ins, in intervals per prefetch lookahead.
+     */
+    static constexpr InstructionNumber calendar_intervals_per_lookahead = 8;
+
+    Allocator::Allocator(std::string output_file, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage)
+        : page_frame_free(num_page_frames, true), num_free_page_frames(num_page_frames), page_frame_limit(num_page_frames), num_allocated_page_frames(0), storage_frames(storage), pages_end(0), page_shift(shift), num_swapouts(0), num_swapins(0), phys_prog(output_file, 0, num_page_frames) {
         this->free_page_frames.reserve(num_page_frames);
-        PhysPageNumber curr = num_page_frames;
-        do {
-            curr--;
-            this->free_page_frames.push_back(curr);
-        } while (curr != 0);
+        this->compact_free_page_frames();
+    }
+
+    Allocator::Allocator(PhysProgramPipe& output, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage)
+        : page_frame_free(num_page_frames, true), num_free_page_frames(num_page_frames), page_frame_limit(num_page_frames), num_allocated_page_frames(0), storage_frames(storage), pages_end(0), page_shift(shift), num_swapouts(0), num_swapins(0), phys_prog(output, 0, num_page_frames) {
+        this->free_page_frames.reserve(num_page_frames);
+        this->compact_free_page_frames();
     }
 
     Allocator::~Allocator() {
         this->phys_prog.set_page_count(this->pages_end);
-        this->phys_prog.set_swap_page_count(this->next_storage_frame);
+        for (std::uint8_t tier = 0; tier != this->storage_frames.get_num_tiers(); tier++) {
+            this->phys_prog.set_swap_page_count(this->storage_frames.get_num_frames(tier), tier);
+        }
+    }
+
+    void Allocator::compact_free_page_frames() {
+        this->free_page_frames.clear();
+        PhysPageNumber ppn = this->page_frame_limit;
+        while (ppn != 0) {
+            ppn--;
+            if (this->page_frame_free[ppn]) {
+                this->free_page_frames.push_back(ppn);
+            }
+        }
     }
 
     void Allocator::set_page_shift(PageShift shift) {
@@ -57,10 +92,10 @@ namespace mage::memprog {
     }
 
     StoragePageNumber Allocator::get_num_storage_frames() const {
-        return this->next_storage_frame;
+        return this->storage_frames.get_num_frames();
     }
 
-    void Allocator::emit_swapout(PhysPageNumber primary, StoragePageNumber secondary) {
+    void Allocator::finish_pending_receives(PhysPageNumber primary) {
         /*
          * Before swapping out this page, make sure to finish any outstanding
          * network receives for this page. Otherwise, the receive may complete
@@ -98,6 +133,10 @@ namespace mage::memprog {
                 pending.clear();
             }
         }
+    }
+
+    void Allocator::emit_swapout(PhysPageNumber primary, StoragePageNumber secondary) {
+        this->finish_pending_receives(primary);
 
         constexpr std::size_t length = PackedPhysInstruction::size(InstructionFormat::Swap);
 
@@ -124,6 +163,51 @@ namespace mage::memprog {
         this->num_swapins++;
     }
 
+    void Allocator::emit_page_move(PhysPageNumber from, PhysPageNumber to) {
+        this->finish_pending_receives(from);
+
+        constexpr std::size_t length = PackedPhysInstruction::size(InstructionFormat::Swap);
+
+        PackedPhysInstruction& phys = this->phys_prog.start_instruction(length);
+        phys.header.operation = OpCode::CopySwap;
+        phys.header.flags = 0;
+        phys.swap.memory = to;
+        phys.swap.storage = from;
+        this->phys_prog.finish_instruction(length);
+    }
+
+    void Allocator::discard_page_frames(PhysPageNumber start, PhysPageNumber end) {
+        /* Frames that were never used have no memory to give back. */
+        constexpr std::size_t length = PackedPhysInstruction::size(InstructionFormat::SwapFinish);
+        for (PhysPageNumber ppn = start; ppn < std::min(end, this->pages_end); ppn++) {
+            PackedPhysInstruction& phys = this->phys_prog.start_instruction(length);
+            phys.header.operation = OpCode::DiscardPage;
+            phys.header.flags = 0;
+            phys.swap_finish.memory = ppn;
+            this->phys_prog.finish_instruction(length);
+        }
+    }
+
+    void Allocator::set_page_frame_limit(PhysPageNumber limit) {
+        assert(limit <= this->page_frame_free.size());
+        if (limit > this->page_frame_limit) {
+            for (PhysPageNumber ppn = limit; ppn != this->page_frame_limit; ppn--) {
+                if (this->page_frame_free[ppn - 1]) {
+                    this->free_page_frames.push_back(ppn - 1);
+                    this->num_free_page_frames++;
+                }
+            }
+        } else {
+            /* Entries for these frames in the free list are skipped lazily. */
+            for (PhysPageNumber ppn = limit; ppn != this->page_frame_limit; ppn++) {
+                if (this->page_frame_free[ppn]) {
+                    this->num_free_page_frames--;
+                }
+            }
+        }
+        this->page_frame_limit = limit;
+    }
+
     void Allocator::update_network_state(const PackedPhysInstruction& phys) {
         WorkerID other;
         switch (phys.header.operation) {
@@ -160,9 +244,250 @@ namespace mage::memprog {
         }
     }
 
-    BeladyAllocator::BeladyAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift)
-        : Allocator(output_file, num_page_frames, shift), virt_prog(virtual_program_file.c_str()), annotations(annotations_file.c_str()) {
+    static PhysPageNumber max_resident_limit(const std::vector<ResidentLimit>& limits, PhysPageNumber num_page_frames) {
+        if (limits.empty()) {
+            return num_page_frames;
+        }
+        return std::max_element(limits.begin(), limits.end(), [](const ResidentLimit& a, const ResidentLimit& b) {
+            return a.num_pages < b.num_pages;
+        })->num_pages;
+    }
+
+    BeladyAllocator::BeladyAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage_frames, std::vector<ResidentLimit> limits)
+        : Allocator(output_file, max_resident_limit(limits, num_page_frames), shift, storage_frames), virt_prog(virtual_program_file.c_str()), annotations(annotations_file.c_str()),
+        frame_owner(max_resident_limit(limits, num_page_frames)), free_run_cursor(0), resident_limits(limits) {
+        this->init(virtual_program_file);
+    }
+
+    BeladyAllocator::BeladyAllocator(PhysProgramPipe& output, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage_frames, std::vector<ResidentLimit> limits)
+        : Allocator(output, max_resident_limit(limits, num_page_frames), shift, storage_frames), virt_prog(virtual_program_file.c_str()), annotations(annotations_file.c_str()),
+        frame_owner(max_resident_limit(limits, num_page_frames)), free_run_cursor(0), resident_limits(limits) {
+        this->init(virtual_program_file);
+    }
+
+    void BeladyAllocator::init(const std::string& virtual_program_file) {
         this->set_page_shift(this->virt_prog.get_header().page_shift);
+        if (!this->resident_limits.empty()) {
+            this->phys_prog.set_flags(ProgramFlagMemoryBudget);
+        }
+
+        this->span_table.load(virtual_program_file, this->virt_prog.get_header());
+        if (!this->span_table.empty()) {
+            this->phys_prog.set_flags(ProgramFlagPageSpans);
+        }
+    }
+
+    void BeladyAllocator::heap_insert(VirtPageNumber vpn, VirtPageNumber length, InstructionNumber next_use) {
+        this->next_use_heap.insert(next_use, vpn);
+        if (length != 1) {
+            this->span_heaps[length].insert(next_use, vpn);
+        }
+    }
+
+    void BeladyAllocator::heap_decrease_key(VirtPageNumber vpn, VirtPageNumber length, InstructionNumber next_use) {
+        this->next_use_heap.decrease_key(next_use, vpn);
+        if (length != 1) {
+            this->span_heaps[length].decrease_key(next_use, vpn);
+        }
+    }
+
+    void BeladyAllocator::heap_erase(VirtPageNumber vpn, VirtPageNumber length) {
+        this->next_use_heap.erase(vpn);
+        if (length != 1) {
+            this->span_heaps[length].erase(vpn);
+        }
+    }
+
+    std::pair<BeladyScore, VirtPageNumber> BeladyAllocator::remove_victim(InstructionNumber) {
+        return this->next_use_heap.remove_min();
+    }
+
+    void BeladyAllocator::evict(VirtPageNumber vpn, InstructionNumber next_use, InstructionNumber current) {
+        auto k = this->page_table.find(vpn);
+        assert(k != this->page_table.end());
+        PageTableEntry& evict_pte = k->second;
+        assert(evict_pte.resident);
+        assert(next_use != invalid_instr);
+        VirtPageNumber length = this->span_table.lookup(vpn).num_pages;
+        if (length != 1) {
+            this->span_heaps[length].erase(vpn);
+        }
+        evict_pte.resident = false;
+        if (evict_pte.dirty) {
+            evict_pte.dirty = false;
+            if (length != 1) {
+                if (evict_pte.spn_allocated && !this->can_keep_storage_run(evict_pte.spn, current, next_use)) {
+                    this->free_storage_run(evict_pte.spn, length);
+                    evict_pte.spn_allocated = false;
+                }
+                if (!evict_pte.spn_allocated) {
+                    evict_pte.spn = this->alloc_storage_run(current, next_use, length);
+                    evict_pte.spn_allocated = true;
+                }
+            } else {
+                if (evict_pte.spn_allocated && !this->can_keep_storage_frame(evict_pte.spn, current, next_use)) {
+                    /*
+                     * The page's old contents in storage are stale, so move it
+                     * to the storage tier for its reuse distance, or to a
+                     * frame near other pages that are next used around the
+                     * same time.
+                     */
+                    this->free_storage_frame(evict_pte.spn);
+                    evict_pte.spn_allocated = false;
+                }
+                if (!evict_pte.spn_allocated) {
+                    evict_pte.spn = this->alloc_storage_frame(current, next_use);
+                    evict_pte.spn_allocated = true;
+                }
+            }
+            /* Swap out the first page first; see emit_swapout. */
+            for (VirtPageNumber t = 0; t != length; t++) {
+                this->emit_swapout(evict_pte.ppn + t, evict_pte.spn + t);
+            }
+        }
+
+        /*
+         * Free the frames in reverse order, so that for a single page, the
+         * next call to alloc_page_frame() returns its frame.
+         */
+        VirtPageNumber t = length;
+        do {
+            t--;
+            this->free_page_frame(evict_pte.ppn + t);
+        } while (t != 0);
+    }
+
+    bool BeladyAllocator::find_free_run(VirtPageNumber length, PhysPageNumber& start) {
+        PhysPageNumber num_frames = this->get_num_page_frames();
+        if (length > num_frames) {
+            return false;
+        }
+        PhysPageNumber f = this->free_run_cursor;
+        VirtPageNumber run = 0;
+        /* Go a bit more than once around, to find runs that contain the cursor. */
+        for (PhysPageNumber scanned = 0; scanned != num_frames + length - 1; scanned++) {
+            if (f == 0) {
+                run = 0;
+            }
+            if (this->page_frame_is_free(f)) {
+                run++;
+                if (run == length) {
+                    start = f + 1 - length;
+                    this->free_run_cursor = (f + 1 == num_frames) ? 0 : f + 1;
+                    return true;
+                }
+            } else {
+                run = 0;
+            }
+            f = (f + 1 == num_frames) ? 0 : f + 1;
+        }
+        return false;
+    }
+
+    PhysPageNumber BeladyAllocator::alloc_span_frames(VirtPageNumber length, InstructionNumber current) {
+        PhysPageNumber start;
+        if (this->get_num_free_page_frames() < length || !this->find_free_run(length, start)) {
+            /*
+             * Pages used by the current instruction have the current
+             * instruction as their next use, or have not yet been added to the
+             * heap; neither kind of page may be evicted.
+             */
+            auto h = this->span_heaps.find(length);
+            if (h != this->span_heaps.end() && !h->second.empty() && h->second.min().first.get_usage_time() != current) {
+                std::pair<BeladyScore, VirtPageNumber> pair = h->second.min();
+                start = this->page_table.at(pair.second).ppn;
+                this->next_use_heap.erase(pair.second);
+                this->evict(pair.second, pair.first.get_usage_time(), current);
+            } else {
+                /*
+                 * Find the range of frames whose earliest next use is furthest
+                 * in the future, using a sliding-window minimum.
+                 */
+                PhysPageNumber num_frames = this->get_num_page_frames();
+                std::vector<InstructionNumber> score(num_frames);
+                for (PhysPageNumber f = 0; f != num_frames; f++) {
+                    if (this->page_frame_is_free(f)) {
+                        score[f] = invalid_instr;
+                    } else if (this->next_use_heap.contains(this->frame_owner[f])) {
+                        score[f] = this->next_use_heap.get_key(this->frame_owner[f]).get_usage_time();
+                    } else {
+                        score[f] = 0;
+                    }
+                }
+                std::deque<PhysPageNumber> window;
+                InstructionNumber best_score = 0;
+                for (PhysPageNumber f = 0; f != num_frames; f++) {
+                    while (!window.empty() && score[window.back()] >= score[f]) {
+                        window.pop_back();
+                    }
+                    window.push_back(f);
+                    if (window.front() + length <= f) {
+                        window.pop_front();
+                    }
+                    if (f + 1 >= length && score[window.front()] > best_score) {
+                        best_score = score[window.front()];
+                        start = f + 1 - length;
+                    }
+                }
+                if (best_score <= current) {
+                    std::cerr << "Not enough page frames to keep a " << length << "-page allocation contiguous" << std::endl;
+                    std::abort();
+                }
+                for (PhysPageNumber f = start; f != start + length; f++) {
+                    if (!this->page_frame_is_free(f)) {
+                        VirtPageNumber owner = this->frame_owner[f];
+                        InstructionNumber next_use = this->next_use_heap.get_key(owner).get_usage_time();
+                        this->next_use_heap.erase(owner);
+                        this->evict(owner, next_use, current);
+                    }
+                }
+            }
+        }
+
+        for (PhysPageNumber f = start; f != start + length; f++) {
+            this->claim_page_frame(f);
+        }
+        return start;
+    }
+
+    void BeladyAllocator::apply_resident_limit(PhysPageNumber limit, InstructionNumber current) {
+        PhysPageNumber old_limit = this->get_num_page_frames();
+        this->set_page_frame_limit(limit);
+        if (limit >= old_limit) {
+            return;
+        }
+        if (this->free_run_cursor >= limit) {
+            this->free_run_cursor = 0;
+        }
+
+        /* Keep the pages whose next use is soonest. */
+        while (this->get_num_allocated_page_frames() > limit) {
+            std::pair<BeladyScore, VirtPageNumber> pair = this->next_use_heap.remove_min();
+            this->evict(pair.second, pair.first.get_usage_time(), current);
+        }
+
+        /* Move the remaining pages above the limit into free frames below it. */
+        for (PhysPageNumber f = limit; f != old_limit; f++) {
+            if (this->page_frame_is_free(f)) {
+                continue;
+            }
+            VirtPageNumber owner = this->frame_owner[f];
+            PageTableEntry& pte = this->page_table.at(owner);
+            if (this->span_table.lookup(owner).num_pages != 1) {
+                /* Multi-page allocations would need a free run; evict them. */
+                InstructionNumber next_use = this->next_use_heap.get_key(owner).get_usage_time();
+                this->next_use_heap.erase(owner);
+                this->evict(owner, next_use, current);
+                continue;
+            }
+            PhysPageNumber to = this->alloc_page_frame();
+            this->emit_page_move(f, to);
+            this->frame_owner[to] = owner;
+            pte.ppn = to;
+            this->free_page_frame(f);
+        }
+
+        this->discard_page_frames(limit, old_limit);
     }
 
     void BeladyAllocator::allocate(util::ProgressBar* progress_bar) {
@@ -171,15 +496,41 @@ namespace mage::memprog {
         std::array<bool, 5> just_swapped_in;
         std::array<PhysPageNumber, 5> ppns;
         std::array<VirtPageNumber, 5> vpns;
+        std::array<VirtPageNumber, 5> lengths;
+        std::array<VirtPageNumber, 5> operand_vpns;
+        std::array<PhysPageNumber, 5> operand_ppns;
+        std::array<PageSpan, 5> spans;
+        std::array<std::uint8_t, 5> index;
+        auto next_limit = this->resident_limits.begin();
         for (InstructionNumber i = 0; i != num_instructions; i++) {
+            if (next_limit != this->resident_limits.end() && next_limit->start == i) {
+                this->apply_resident_limit(next_limit->num_pages, i);
+                next_limit++;
+            }
             PackedVirtInstruction& current = this->virt_prog.start_instruction();
             OpInfo info(current.header.operation);
-            std::uint8_t num_pages = current.store_page_numbers(vpns.data(), this->page_shift);
+            std::uint8_t num_operand_pages = current.store_page_numbers(operand_vpns.data(), this->page_shift);
+            std::uint8_t num_pages = num_operand_pages;
+            if (this->span_table.empty()) {
+                vpns = operand_vpns;
+                lengths.fill(1);
+            } else {
+                /*
+                 * Operands may refer to any page of a multi-page allocation;
+                 * manage each such allocation as a unit, via its first page.
+                 */
+                num_pages = this->span_table.canonicalize(operand_vpns.data(), num_operand_pages, spans.data(), index.data());
+                for (std::uint8_t j = 0; j != num_pages; j++) {
+                    vpns[j] = spans[j].first;
+                    lengths[j] = spans[j].num_pages;
+                }
+            }
             std::size_t ann_size;
             Annotation& ann = this->annotations.read<Annotation>(ann_size);
             assert(num_pages == ann.header.num_pages);
             for (std::uint8_t j = 0; j != num_pages; j++) {
                 VirtPageNumber vpn = vpns[j];
+                VirtPageNumber length = lengths[j];
                 bool dirties_page = (j == 0) && info.has_variable_output();
 
                 auto iter = this->page_table.find(vpn);
@@ -201,17 +552,24 @@ namespace mage::memprog {
                      */
                     if (ann.slots[j].next_use == invalid_instr) {
                         if (pte.spn_allocated) {
-                            this->free_storage_frame(pte.spn);
+                            if (length != 1) {
+                                this->free_storage_run(pte.spn, length);
+                            } else {
+                                this->free_storage_frame(pte.spn);
+                            }
                         }
                         this->page_table.erase(iter);
-                        this->next_use_heap.erase(vpn);
+                        this->heap_erase(vpn, length);
                     }
                 } else {
                     /* Page is not resident. */
                     PhysPageNumber ppn;
                     just_swapped_in[j] = true;
 
-                    if (this->page_frame_available()) {
+                    if (length != 1) {
+                        /* Multi-page allocation; needs contiguous frames. */
+                        ppn = this->alloc_span_frames(length, i);
+                    } else if (this->page_frame_available()) {
                         /* Grab page frame from free list. */
                         ppn = this->alloc_page_frame();
                     } else {
@@ -222,23 +580,12 @@ namespace mage::memprog {
                          * have i as their key, whereas all other VPNs in the
                          * heap will have some later instruction.
                          */
-                        std::pair<BeladyScore, VirtPageNumber> pair = this->next_use_heap.remove_min();
-                        VirtPageNumber evict_vpn = pair.second;
-                        auto k = this->page_table.find(evict_vpn);
-                        assert(k != this->page_table.end());
-                        PageTableEntry& evict_pte = k->second;
-                        assert(evict_pte.resident);
-                        ppn = evict_pte.ppn;
-                        assert(pair.first.get_usage_time() != invalid_instr);
-                        evict_pte.resident = false;
-                        if (evict_pte.dirty) {
-                            evict_pte.dirty = false;
-                            if (!evict_pte.spn_allocated) {
-                                evict_pte.spn = this->alloc_storage_frame();
-                                evict_pte.spn_allocated = true;
-                            }
-                            this->emit_swapout(ppn, evict_pte.spn);
-                        }
+                        std::pair<BeladyScore, VirtPageNumber> pair = this->remove_victim(i);
+                        this->evict(pair.second, pair.first.get_usage_time(), i);
+                        ppn = this->alloc_page_frame();
+                    }
+                    for (VirtPageNumber t = 0; t != length; t++) {
+                        this->frame_owner[ppn + t] = vpn;
                     }
 
                     /* Now, swap the desired vpn into the page frame. */
@@ -269,7 +616,9 @@ namespace mage::memprog {
                         PageTableEntry& pte = iter->second;
                         assert(!pte.resident);
                         assert(pte.spn_allocated);
-                        this->emit_swapin(pte.spn, ppn);
+                        for (VirtPageNumber t = 0; t != length; t++) {
+                            this->emit_swapin(pte.spn + t, ppn + t);
+                        }
                         if (ann.slots[j].next_use == invalid_instr) {
                             this->page_table.erase(iter);
                         } else {
@@ -281,12 +630,18 @@ namespace mage::memprog {
                     ppns[j] = ppn;
                 }
             }
-
             PackedPhysInstruction& phys = this->phys_prog.start_instruction();
             phys.header.operation = current.header.operation;
             phys.no_args.width = current.no_args.width;
             phys.header.flags = current.header.flags;
-            phys.restore_page_numbers(current, ppns.data(), this->page_shift);
+            if (this->span_table.empty()) {
+                phys.restore_page_numbers(current, ppns.data(), this->page_shift);
+            } else {
+                for (std::uint8_t m = 0; m != num_operand_pages; m++) {
+                    operand_ppns[m] = ppns[index[m]] + (operand_vpns[m] - vpns[index[m]]);
+                }
+                phys.restore_page_numbers(current, operand_ppns.data(), this->page_shift);
+            }
             this->update_network_state(phys);
             this->phys_prog.finish_instruction(phys.size());
 
@@ -316,15 +671,213 @@ namespace mage::memprog {
                  * page table).
                  */
                 if (next_use == invalid_instr) {
-                    this->free_page_frame(ppns[j]);
+                    for (VirtPageNumber t = 0; t != lengths[j]; t++) {
+                        this->free_page_frame(ppns[j] + t);
+                    }
                 } else if (just_swapped_in[j]) {
-                    this->next_use_heap.insert(next_use, vpns[j]);
+                    this->heap_insert(vpns[j], lengths[j], next_use);
                 } else {
-                    this->next_use_heap.decrease_key(next_use, vpns[j]);
+                    this->heap_decrease_key(vpns[j], lengths[j], next_use);
                 }
             }
 
             this->virt_prog.finish_instruction(current.size());
         }
     }
+
+    SwapBudgetModel::SwapBudgetModel(std::uint32_t swap_budget, InstructionNumber swapin_lookahead, InstructionNumber swap_latency)
+        : budget(swap_budget), lookahead(swapin_lookahead), latency(swap_latency), predicted_stall(0), num_synchronous_swaps(0) {
+    }
+
+    bool SwapBudgetModel::acquire(InstructionNumber at, InstructionNumber until) {
+        while (!this->holds.empty() && this->holds.top() <= at) {
+            this->holds.pop();
+        }
+        if (this->holds.size() == this->budget) {
+            this->predicted_stall += this->latency;
+            this->num_synchronous_swaps++;
+            return false;
+        }
+        this->holds.push(until);
+        return true;
+    }
+
+    void SwapBudgetModel::issue_swapouts(InstructionNumber position) {
+        while (!this->pending_swapouts.empty() && this->pending_swapouts.front() <= position) {
+            InstructionNumber issued = this->pending_swapouts.front();
+            this->pending_swapouts.pop_front();
+            this->acquire(issued, issued + this->lookahead);
+        }
+    }
+
+    void SwapBudgetModel::swapin(InstructionNumber position) {
+        InstructionNumber issued = (position > this->lookahead) ? position - this->lookahead : 0;
+
+        /*
+         * The scheduler issues a swap-out when it executes it, but a swap-in
+         * a lookahead early, so this swap-in is issued after the swap-outs
+         * emitted up to that point and before those emitted since.
+         */
+        this->issue_swapouts(issued);
+        if (this->acquire(issued, position)) {
+            InstructionNumber lead = position - issued;
+            if (this->latency > lead) {
+                this->predicted_stall += this->latency - lead;
+            }
+        }
+
+        this->recent_swapins.push_back(position);
+        while (!this->recent_swapins.empty() && this->recent_swapins.front() + this->lookahead <= position) {
+            this->recent_swapins.pop_front();
+        }
+    }
+
+    void SwapBudgetModel::swapout(InstructionNumber position) {
+        this->pending_swapouts.push_back(position);
+    }
+
+    bool SwapBudgetModel::swapout_would_stall(InstructionNumber position) {
+        /*
+         * Frames held by swap-ins emitted so far are released by now, as are
+         * those held by swap-outs issued a lookahead ago, so the frames in use
+         * are those of the pending swap-outs and of swap-ins yet to come.
+         */
+        if (position > this->lookahead) {
+            this->issue_swapouts(position - this->lookahead);
+        }
+        while (!this->recent_swapins.empty() && this->recent_swapins.front() + this->lookahead <= position) {
+            this->recent_swapins.pop_front();
+        }
+        return this->pending_swapouts.size() + this->recent_swapins.size() + 1 > this->budget;
+    }
+
+    void SwapBudgetModel::finish() {
+        this->issue_swapouts(invalid_instr);
+    }
+
+    StallAwareAllocator::StallAwareAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, std::uint32_t prefetch_buffer_size, InstructionNumber swapin_lookahead, InstructionNumber swap_latency, TieredStorageAllocator storage_frames, std::vector<ResidentLimit> limits)
+        : BeladyAllocator(output_file, virtual_program_file, annotations_file, num_page_frames, shift, storage_frames, limits),
+        model(prefetch_buffer_size, swapin_lookahead, swap_latency), budget(prefetch_buffer_size), lookahead(swapin_lookahead), latency(swap_latency),
+        calendar_interval(std::max<InstructionNumber>(swapin_lookahead / calendar_intervals_per_lookahead, 1)), num_substitutions(0) {
+    }
+
+    StallAwareAllocator::StallAwareAllocator(PhysProgramPipe& output, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, std::uint32_t prefetch_buffer_size, InstructionNumber swapin_lookahead, InstructionNumber swap_latency, TieredStorageAllocator storage_frames, std::vector<ResidentLimit> limits)
+        : BeladyAllocator(output, virtual_program_file, annotations_file, num_page_frames, shift, storage_frames, limits),
+        model(prefetch_buffer_size, swapin_lookahead, swap_latency), budget(prefetch_buffer_size), lookahead(swapin_lookahead), latency(swap_latency),
+        calendar_interval(std::max<InstructionNumber>(swapin_lookahead / calendar_intervals_per_lookahead, 1)), num_substitutions(0) {
+    }
+
+    void StallAwareAllocator::allocate(util::ProgressBar* progress_bar) {
+        this->BeladyAllocator::allocate(progress_bar);
+        this->model.finish();
+    }
+
+    InstructionNumber StallAwareAllocator::get_predicted_stall() const {
+        return this->model.get_predicted_stall();
+    }
+
+    std::uint64_t StallAwareAllocator::get_num_substitutions() const {
+        return this->num_substitutions;
+    }
+
+    std::uint64_t StallAwareAllocator::get_num_synchronous_swaps() const {
+        return this->model.get_num_synchronous_swaps();
+    }
+
+    void StallAwareAllocator::emit_swapout(PhysPageNumber primary, StoragePageNumber secondary) {
+        this->Allocator::emit_swapout(primary, secondary);
+        this->model.swapout(this->phys_prog.num_instructions() - 1);
+    }
+
+    void StallAwareAllocator::emit_swapin(StoragePageNumber secondary, PhysPageNumber primary) {
+        this->Allocator::emit_swapin(secondary, primary);
+        this->model.swapin(this->phys_prog.num_instructions() - 1);
+    }
+
+    void StallAwareAllocator::evict(VirtPageNumber vpn, InstructionNumber next_use, InstructionNumber current) {
+        this->swapin_calendar[next_use / this->calendar_interval]++;
+        this->BeladyAllocator::evict(vpn, next_use, current);
+    }
+
+    std::uint64_t StallAwareAllocator::committed_swaps(InstructionNumber use) const {
+        /*
+         * A swap for this instruction holds a prefetch buffer frame for the
+         * lookahead before it, which overlaps with those of swaps committed
+         * for instructions up to a lookahead before or after it.
+         */
+        InstructionNumber from = (use > this->lookahead) ? use - this->lookahead : 0;
+        std::uint64_t committed = 0;
+        for (auto iter = this->swapin_calendar.lower_bound(from / this->calendar_interval); iter != this->swapin_calendar.end() && iter->first <= (use + this->lookahead) / this->calendar_interval; iter++) {
+            committed += iter->second;
+        }
+        return committed;
+    }
+
+    InstructionNumber StallAwareAllocator::predicted_deferral_stall(InstructionNumber use) const {
+        /*
+         * Evicting a clean page in place of Belady's (dirty) choice adds a
+         * swap-in at the clean page's next use, and defers the swap-out of
+         * Belady's choice to about that time, when a frame is needed again.
+         * Each of the two swaps stalls if the budget is used up by then.
+         */
+        std::uint64_t committed = this->committed_swaps(use);
+        InstructionNumber stall = (this->latency > this->lookahead) ? this->latency - this->lookahead : 0;
+        if (committed + 1 > this->budget) {
+            stall += this->latency;
+        }
+        if (committed + 2 > this->budget) {
+            stall += this->latency;
+        }
+        return stall;
+    }
+
+    std::pair<BeladyScore, VirtPageNumber> StallAwareAllocator::remove_victim(InstructionNumber current) {
+        /* Forget swaps committed for instructions that have executed. */
+        while (!this->swapin_calendar.empty() && this->swapin_calendar.begin()->first < current / this->calendar_interval) {
+            this->swapin_calendar.erase(this->swapin_calendar.begin());
+        }
+
+        /*
+         * Evicting Belady's choice only costs more than the alternatives if
+         * it is dirty and swapping it out now is predicted to stall; in any
+         * other case, another page would add a swap-in without saving one.
+         * The heap is left untouched unless a substitution is made, so that
+         * this behaves exactly like BeladyAllocator otherwise.
+         */
+        const std::pair<BeladyScore, VirtPageNumber>& belady = this->next_use_heap.min();
+        if (!this->page_table.at(belady.second).dirty || !this->model.swapout_would_stall(this->phys_prog.num_instructions())) {
+            return this->next_use_heap.remove_min();
+        }
+
+        /*
+         * Consider clean pages in Belady order whose next use is beyond the
+         * lookahead, and evict the one with the least predicted stall, but
+         * only if that is less than the predicted stall of Belady's choice.
+         */
+        this->next_use_heap.find_smallest(stall_aware_candidates, this->candidates);
+        std::size_t best = 0;
+        InstructionNumber best_stall = this->latency;
+        for (std::size_t k = 1; k != this->candidates.size(); k++) {
+            const std::pair<BeladyScore, VirtPageNumber>& candidate = this->candidates[k];
+            if (candidate.first.get_usage_time() <= current + this->lookahead) {
+                break;
+            }
+            if (!this->page_table.at(candidate.second).dirty) {
+                InstructionNumber stall = this->predicted_deferral_stall(candidate.first.get_usage_time());
+                if (stall < best_stall) {
+                    best = k;
+                    best_stall = stall;
+                }
+            }
+        }
+        if (best == 0) {
+            return this->next_use_heap.remove_min();
+        }
+
+        /* Account for the deferred swap-out of Belady's choice. */
+        this->swapin_calendar[this->candidates[best].first.get_usage_time() / this->calendar_interval]++;
+        this->num_substitutions++;
+        this->next_use_heap.erase(this->candidates[best].second);
+        return this->candidates[best];
+    }
 }
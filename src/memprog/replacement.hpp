@@ -22,10 +22,23 @@
 #ifndef MAGE_MEMPROG_REPLACEMENT_HPP_
 #define MAGE_MEMPROG_REPLACEMENT_HPP_
 
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include "addr.hpp"
 #include "instruction.hpp"
 #include "memprog/annotation.hpp"
+#include "memprog/budget.hpp"
+#include "memprog/storage.hpp"
 #include "opcode.hpp"
 #include "platform/memory.hpp"
 #include "programfile.hpp"
@@ -57,8 +70,24 @@ namespace mage::memprog {
          * physical bytecode.
          * @param num_page_frames The number of physical pages available.
          * @param page_shift Base-2 logarithm of the page size.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
          */
-        Allocator(std::string output_file, PhysPageNumber num_page_frames, PageShift page_shift);
+        Allocator(std::string output_file, PhysPageNumber num_page_frames, PageShift page_shift, TieredStorageAllocator storage_frames = TieredStorageAllocator());
+
+        /**
+         * @brief Initiailzes an @p Allocator that computes replacement for
+         * the specified memory constraints and streams the resulting physical
+         * bytecode through the specified pipe (e.g., to a scheduler running
+         * concurrently).
+         *
+         * @param output The pipe to which to write the physical bytecode.
+         * @param num_page_frames The number of physical pages available.
+         * @param page_shift Base-2 logarithm of the page size.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
+         */
+        Allocator(PhysProgramPipe& output, PhysPageNumber num_page_frames, PageShift page_shift, TieredStorageAllocator storage_frames = TieredStorageAllocator());
 
         /**
          * @brief Destructor.
@@ -122,7 +151,7 @@ namespace mage::memprog {
          * @param secondary The frame number in storage to which to write the
          * page.
          */
-        void emit_swapout(PhysPageNumber primary, StoragePageNumber secondary);
+        virtual void emit_swapout(PhysPageNumber primary, StoragePageNumber secondary);
 
         /**
          * @brief Emits one or more instructions to the physical bytecode to
@@ -134,7 +163,29 @@ namespace mage::memprog {
          * @param primary The physical page number in memory to which to write
          * the page.
          */
-        void emit_swapin(StoragePageNumber secondary, PhysPageNumber primary);
+        virtual void emit_swapin(StoragePageNumber secondary, PhysPageNumber primary);
+
+        /**
+         * @brief Emits an instruction to the physical bytecode to move a page
+         * from one page frame in memory to another, first waiting for any
+         * outstanding network receives into the page to finish.
+         *
+         * @param from The physical page number of the page's current frame.
+         * @param to The physical page number of the frame to which to move
+         * the page.
+         */
+        void emit_page_move(PhysPageNumber from, PhysPageNumber to);
+
+        /**
+         * @brief Emits instructions to the physical bytecode to return the
+         * memory backing a range of unallocated page frames to the operating
+         * system.
+         *
+         * @param start The physical page number of the first page frame.
+         * @param end One plus the physical page number of the last page
+         * frame.
+         */
+        void discard_page_frames(PhysPageNumber start, PhysPageNumber end);
 
         /**
          * @brief Update the allocator's bookkeeping of outstanding network
@@ -150,18 +201,18 @@ namespace mage::memprog {
          *
          * The storage frame may either be fresh (never-before-used) storage
          * frame, or it may be a frame that was allocated earlier and then
-         * freed.
+         * freed. The storage tier is chosen by the page's reuse distance, and
+         * depending on the configured @p StorageFrameAllocator, pages with
+         * similar next-use times may be placed near each other.
          *
+         * @param current The number (index) of the instruction being
+         * processed.
+         * @param next_use The number (index) of the next instruction that
+         * will use the page being swapped out.
          * @return The frame number in storage of the allocated page frame.
          */
-        StoragePageNumber alloc_storage_frame() {
-            if (this->free_storage_frames.empty()) {
-                return this->next_storage_frame++;
-            } else {
-                StoragePageNumber spn = this->free_storage_frames.back();
-                this->free_storage_frames.pop_back();
-                return spn;
-            }
+        StoragePageNumber alloc_storage_frame(InstructionNumber current, InstructionNumber next_use) {
+            return this->storage_frames.allocate(current, next_use);
         }
 
         /**
@@ -173,7 +224,69 @@ namespace mage::memprog {
          * @param spn The page frame in storage to deallocate.
          */
         void free_storage_frame(StoragePageNumber spn) {
-            this->free_storage_frames.push_back(spn);
+            this->storage_frames.deallocate(spn);
+        }
+
+        /**
+         * @brief Returns true if a dirty page being swapped out again can be
+         * written back to the storage frame it already has.
+         *
+         * If this returns false, the page should be given a new storage
+         * frame (e.g., in a different storage tier) rather than reusing its
+         * old one.
+         *
+         * @param spn The storage frame the page already has.
+         * @param current The number (index) of the instruction being
+         * processed.
+         * @param next_use The number (index) of the next instruction that
+         * will use the page being swapped out.
+         * @return True if the page can keep its storage frame.
+         */
+        bool can_keep_storage_frame(StoragePageNumber spn, InstructionNumber current, InstructionNumber next_use) const {
+            return this->storage_frames.can_keep(spn, current, next_use);
+        }
+
+        /**
+         * @brief Returns true if a group of pages being swapped out again can
+         * be written back to the range of storage frames it already has.
+         *
+         * @param spn The first storage frame of the range.
+         * @param current The number (index) of the instruction being
+         * processed.
+         * @param next_use The number (index) of the next instruction that
+         * will use the pages being swapped out.
+         * @return True if the pages can keep their storage frames.
+         */
+        bool can_keep_storage_run(StoragePageNumber spn, InstructionNumber current, InstructionNumber next_use) const {
+            return storage_tier(spn) == this->storage_frames.choose_tier(current, next_use);
+        }
+
+        /**
+         * @brief Allocates a range of contiguous page frames in storage to
+         * which a group of pages holding a multi-page allocation can be
+         * swapped out.
+         *
+         * @param current The number (index) of the instruction being
+         * processed.
+         * @param next_use The number (index) of the next instruction that
+         * will use the pages being swapped out.
+         * @param count The number of page frames to allocate.
+         * @return The frame number in storage of the first page frame.
+         */
+        StoragePageNumber alloc_storage_run(InstructionNumber current, InstructionNumber next_use, StoragePageNumber count) {
+            return this->storage_frames.allocate_run(current, next_use, count);
+        }
+
+        /**
+         * @brief Deallocates a range of contiguous page frames in storage.
+         *
+         * @pre The range should have been previously allocated using
+         * @p alloc_storage_run with the same @p count.
+         * @param spn The first page frame in storage to deallocate.
+         * @param count The number of page frames to deallocate.
+         */
+        void free_storage_run(StoragePageNumber spn, StoragePageNumber count) {
+            this->storage_frames.deallocate_run(spn, count);
         }
 
         /**
@@ -187,7 +300,82 @@ namespace mage::memprog {
          * not allocated.
          */
         bool page_frame_available() const {
-            return !this->free_page_frames.empty();
+            return this->num_free_page_frames != 0;
+        }
+
+        /**
+         * @brief Obtains the number of MAGE-physical page frames in memory
+         * that are currently unallocated.
+         *
+         * @return The number of unallocated MAGE-physical page frames.
+         */
+        PhysPageNumber get_num_free_page_frames() const {
+            return this->num_free_page_frames;
+        }
+
+        /**
+         * @brief Obtains the number of MAGE-physical page frames in memory
+         * that may currently be used.
+         *
+         * @return The number of MAGE-physical page frames below the current
+         * limit (see @p set_page_frame_limit).
+         */
+        PhysPageNumber get_num_page_frames() const {
+            return this->page_frame_limit;
+        }
+
+        /**
+         * @brief Obtains the number of MAGE-physical page frames in memory
+         * that are currently allocated, including any above the current
+         * limit.
+         *
+         * @return The number of allocated MAGE-physical page frames.
+         */
+        PhysPageNumber get_num_allocated_page_frames() const {
+            return this->num_allocated_page_frames;
+        }
+
+        /**
+         * @brief Limits allocation to the page frames numbered below the
+         * specified limit, which lets the number of resident pages vary over
+         * the course of the program.
+         *
+         * Lowering the limit does not free frames above it; the caller must
+         * vacate them, after which @p alloc_page_frame never returns them
+         * until the limit is raised again.
+         *
+         * @param limit The new limit, which must not exceed the number of
+         * page frames with which this allocator was created.
+         */
+        void set_page_frame_limit(PhysPageNumber limit);
+
+        /**
+         * @brief Checks if the specified MAGE-physical page frame is
+         * unallocated.
+         *
+         * @param ppn The physical page number of the page frame to check.
+         * @return True if the page frame is unallocated.
+         */
+        bool page_frame_is_free(PhysPageNumber ppn) const {
+            return this->page_frame_free[ppn];
+        }
+
+        /**
+         * @brief Allocates a specific MAGE-physical page frame in memory,
+         * which is used to obtain contiguous frames for multi-page
+         * allocations.
+         *
+         * @pre The page frame is not allocated (i.e., @p page_frame_is_free
+         * returns true for @p ppn).
+         * @param ppn The physical page number of the page frame to allocate.
+         */
+        void claim_page_frame(PhysPageNumber ppn) {
+            assert(this->page_frame_free[ppn] && ppn < this->page_frame_limit);
+            /* Its entry in the free list is skipped lazily. */
+            this->page_frame_free[ppn] = false;
+            this->num_free_page_frames--;
+            this->num_allocated_page_frames++;
+            this->pages_end = std::max(this->pages_end, ppn + 1);
         }
 
         /**
@@ -200,8 +388,14 @@ namespace mage::memprog {
          * frame.
          */
         PhysPageNumber alloc_page_frame() {
-            PhysPageNumber ppn = this->free_page_frames.back();
-            this->free_page_frames.pop_back();
+            PhysPageNumber ppn;
+            do {
+                ppn = this->free_page_frames.back();
+                this->free_page_frames.pop_back();
+            } while (!this->page_frame_free[ppn] || ppn >= this->page_frame_limit);
+            this->page_frame_free[ppn] = false;
+            this->num_free_page_frames--;
+            this->num_allocated_page_frames++;
             this->pages_end = std::max(this->pages_end, ppn + 1);
             return ppn;
         }
@@ -215,6 +409,16 @@ namespace mage::memprog {
          * to deallocate.
          */
         void free_page_frame(PhysPageNumber ppn) {
+            assert(!this->page_frame_free[ppn]);
+            this->page_frame_free[ppn] = true;
+            this->num_allocated_page_frames--;
+            if (ppn >= this->page_frame_limit) {
+                return;
+            }
+            this->num_free_page_frames++;
+            if (this->free_page_frames.size() >= 2 * this->page_frame_free.size()) {
+                this->compact_free_page_frames();
+            }
             this->free_page_frames.push_back(ppn);
         }
 
@@ -222,9 +426,28 @@ namespace mage::memprog {
         PageShift page_shift;
 
     private:
+        /**
+         * @brief Removes entries for allocated page frames from the free list,
+         * which may accumulate if page frames are allocated using
+         * @p claim_page_frame.
+         */
+        void compact_free_page_frames();
+
+        /**
+         * @brief Emits instructions to wait for any outstanding network
+         * receives into the specified page frame, flushing send buffers
+         * first to avoid deadlock.
+         *
+         * @param primary The physical page number of the page frame.
+         */
+        void finish_pending_receives(PhysPageNumber primary);
+
         std::vector<PhysPageNumber> free_page_frames;
-        std::vector<StoragePageNumber> free_storage_frames;
-        StoragePageNumber next_storage_frame;
+        std::vector<bool> page_frame_free;
+        PhysPageNumber num_free_page_frames;
+        PhysPageNumber page_frame_limit;
+        PhysPageNumber num_allocated_page_frames;
+        TieredStorageAllocator storage_frames;
         PhysPageNumber pages_end;
 
         /*
@@ -319,6 +542,18 @@ namespace mage::memprog {
      *
      * This Replacement module uses Belady's theoretically-optimal paging
      * algorithm (MIN) to optimize for storage bandwidth.
+     *
+     * Allocations that span multiple pages (see @p PageSpan) are kept in
+     * contiguous page frames and are swapped in and out as a group. To make
+     * room for one, the allocator uses free contiguous frames if there are
+     * any, then evicts the resident span of the same length whose next use is
+     * furthest in the future, and otherwise evicts the range of frames whose
+     * earliest next use is furthest in the future.
+     *
+     * If the number of page frames varies over the program (e.g., because
+     * co-located workers share a host's memory), the allocator vacates frames
+     * above a lowered limit and emits instructions to discard them, so the
+     * engine can return their memory to the operating system.
      */
     class BeladyAllocator : public Allocator {
     public:
@@ -339,16 +574,383 @@ namespace mage::memprog {
          * next-use annotations for the virtual bytecode.
          * @param num_page_frames The number of physical pages available.
          * @param shift Base-2 logarithm of the page size.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
+         * @param resident_limits If nonempty, the number of physical pages
+         * available varies over the program as given, overriding
+         * @p num_page_frames (see mage::memprog::split_host_budget).
          */
-        BeladyAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift);
+        BeladyAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage_frames = TieredStorageAllocator(), std::vector<ResidentLimit> resident_limits = {});
+
+        /**
+         * @brief Creates a @p BeladyAllocator instance like the above, but
+         * that streams the resulting physical bytecode through the specified
+         * pipe instead of writing it to a file.
+         *
+         * @param output The pipe to which to write the resulting physical
+         * bytecode.
+         * @param virtual_program_file The name of the file from which to read
+         * the virtual bytecode.
+         * @param annotations_file The name of the file from which to read the
+         * next-use annotations for the virtual bytecode.
+         * @param num_page_frames The number of physical pages available.
+         * @param shift Base-2 logarithm of the page size.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
+         * @param resident_limits If nonempty, the number of physical pages
+         * available varies over the program as given, overriding
+         * @p num_page_frames (see mage::memprog::split_host_budget).
+         */
+        BeladyAllocator(PhysProgramPipe& output, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, TieredStorageAllocator storage_frames = TieredStorageAllocator(), std::vector<ResidentLimit> resident_limits = {});
 
         void allocate(util::ProgressBar* progress_bar = nullptr) override;
 
-    private:
+    protected:
+        /**
+         * @brief Chooses a resident page (or group of pages) to evict to make
+         * room for a single page used by the current instruction, and removes
+         * it from @p next_use_heap.
+         *
+         * The default implementation follows Belady's algorithm, choosing the
+         * page whose next use is furthest in the future.
+         *
+         * @param current The number (index) of the current instruction.
+         * @return The score (next use) and virtual page number of the page to
+         * evict.
+         */
+        virtual std::pair<BeladyScore, VirtPageNumber> remove_victim(InstructionNumber current);
+
+        /**
+         * @brief Swaps out a resident page (or group of pages) and frees its
+         * page frames. The page must already have been removed from
+         * @p next_use_heap.
+         *
+         * @param vpn The (first) virtual page number to evict.
+         * @param next_use The number (index) of the next instruction that
+         * uses the page.
+         * @param current The number (index) of the current instruction.
+         */
+        virtual void evict(VirtPageNumber vpn, InstructionNumber next_use, InstructionNumber current);
+
         std::unordered_map<VirtPageNumber, PageTableEntry> page_table;
         util::PriorityQueue<BeladyScore, VirtPageNumber> next_use_heap;
+
+    private:
+        void init(const std::string& virtual_program_file);
+        void heap_insert(VirtPageNumber vpn, VirtPageNumber length, InstructionNumber next_use);
+        void heap_decrease_key(VirtPageNumber vpn, VirtPageNumber length, InstructionNumber next_use);
+        void heap_erase(VirtPageNumber vpn, VirtPageNumber length);
+
+        /**
+         * @brief Allocates contiguous page frames for a multi-page allocation,
+         * evicting pages as necessary.
+         *
+         * @param length The number of contiguous page frames to allocate.
+         * @param current The number (index) of the current instruction.
+         * @return The physical page number of the first page frame.
+         */
+        PhysPageNumber alloc_span_frames(VirtPageNumber length, InstructionNumber current);
+
+        bool find_free_run(VirtPageNumber length, PhysPageNumber& start);
+
+        /**
+         * @brief Changes the number of page frames available. If it shrinks,
+         * pages are evicted in Belady order until the rest fit, and those
+         * left above the new limit are moved below it.
+         *
+         * @param limit The new number of page frames.
+         * @param current The number (index) of the current instruction.
+         */
+        void apply_resident_limit(PhysPageNumber limit, InstructionNumber current);
+
         VirtProgramFileReader virt_prog;
         util::BufferedReverseFileReader<true> annotations;
+
+        /* Bookkeeping for multi-page allocations. */
+        PageSpanTable span_table;
+        std::unordered_map<VirtPageNumber, util::PriorityQueue<BeladyScore, VirtPageNumber>> span_heaps;
+        std::vector<VirtPageNumber> frame_owner;
+        PhysPageNumber free_run_cursor;
+
+        std::vector<ResidentLimit> resident_limits;
+    };
+
+    /**
+     * @brief Predicts how long execution of a physical bytecode stalls on
+     * swaps, by simulating how the scheduling stage (see
+     * BackdatingScheduler) overlaps them with computation.
+     *
+     * The scheduler issues each swap-in a fixed number of instructions (the
+     * lookahead) before the page is used, and each swap-out when the page is
+     * evicted, reaping it a lookahead later. Every swap in flight holds one of
+     * a fixed number of prefetch buffer frames, which is also the swap
+     * device's budget of concurrent transfers. A swap that finds no free frame
+     * is done synchronously and stalls execution for the full swap latency;
+     * an asynchronous swap-in stalls only for the part of the latency that
+     * the lookahead does not hide.
+     *
+     * Times are positions (indices) of instructions in the physical bytecode.
+     * Swaps must be reported in the order in which they are emitted.
+     */
+    class SwapBudgetModel {
+    public:
+        /**
+         * @brief Creates a model of the scheduling stage.
+         *
+         * @param budget The number of swaps that may be in flight at once
+         * (i.e., the number of prefetch buffer frames).
+         * @param lookahead The number of instructions ahead of time at which
+         * swap-ins are issued.
+         * @param latency The predicted time, in instructions, for a swap to
+         * complete.
+         */
+        SwapBudgetModel(std::uint32_t budget, InstructionNumber lookahead, InstructionNumber latency);
+
+        /**
+         * @brief Accounts for a swap-in emitted at the specified position.
+         *
+         * @param position The position of the swap-in in the physical
+         * bytecode.
+         */
+        void swapin(InstructionNumber position);
+
+        /**
+         * @brief Accounts for a swap-out emitted at the specified position.
+         *
+         * @param position The position of the swap-out in the physical
+         * bytecode.
+         */
+        void swapout(InstructionNumber position);
+
+        /**
+         * @brief Predicts whether a swap-out emitted at the specified position
+         * would exhaust the budget of concurrent swaps, causing it or a
+         * swap-in issued while it is in flight to be done synchronously.
+         *
+         * Swap-ins that will be issued while the swap-out is in flight are not
+         * yet known, so their number is estimated from the number issued over
+         * the preceding lookahead.
+         *
+         * @param position The position of the swap-out in the physical
+         * bytecode.
+         * @return True if the swap-out is predicted to cause a stall.
+         */
+        bool swapout_would_stall(InstructionNumber position);
+
+        /**
+         * @brief Accounts for swap-outs still in flight at the end of the
+         * physical bytecode.
+         */
+        void finish();
+
+        /**
+         * @brief Obtains the predicted time spent stalled on swaps.
+         *
+         * @return The predicted stall time, in instructions.
+         */
+        InstructionNumber get_predicted_stall() const {
+            return this->predicted_stall;
+        }
+
+        /**
+         * @brief Obtains the number of swaps predicted to be done
+         * synchronously because the budget of concurrent swaps is exhausted.
+         *
+         * @return The predicted number of synchronous swaps.
+         */
+        std::uint64_t get_num_synchronous_swaps() const {
+            return this->num_synchronous_swaps;
+        }
+
+    private:
+        /**
+         * @brief Obtains a prefetch buffer frame at the specified time, if one
+         * is free, and holds it until the specified later time.
+         *
+         * @param at The time at which the frame is needed.
+         * @param until The time at which the frame is released.
+         * @return True if a frame was free, or false if the swap must be done
+         * synchronously.
+         */
+        bool acquire(InstructionNumber at, InstructionNumber until);
+
+        /**
+         * @brief Issues the swap-outs emitted up to and including the
+         * specified position, which the scheduler issues before any swap-in
+         * issued after that position.
+         *
+         * @param position The position up to which to issue swap-outs.
+         */
+        void issue_swapouts(InstructionNumber position);
+
+        std::uint32_t budget;
+        InstructionNumber lookahead;
+        InstructionNumber latency;
+
+        /* Times at which the prefetch buffer frames in use are released. */
+        std::priority_queue<InstructionNumber, std::vector<InstructionNumber>, std::greater<InstructionNumber>> holds;
+
+        /* Swap-outs emitted but not yet issued, by position. */
+        std::deque<InstructionNumber> pending_swapouts;
+
+        /* Positions of swap-ins emitted within the last lookahead. */
+        std::deque<InstructionNumber> recent_swapins;
+
+        InstructionNumber predicted_stall;
+        std::uint64_t num_synchronous_swaps;
+    };
+
+    /**
+     * @brief A Replacement module that integrates replacement with the
+     * scheduling of prefetches, choosing evictions to minimize the predicted
+     * time spent stalled on swaps rather than the number of swaps.
+     *
+     * Following Belady's algorithm minimizes the number of swap-ins, but
+     * whether a swap stalls execution depends on how many others are in
+     * flight: the scheduling stage can overlap only as many swaps with
+     * computation as it has prefetch buffer frames (see SwapBudgetModel).
+     * When Belady's choice is dirty and swapping it out now is predicted to
+     * stall, evicting a clean page instead avoids that swap-out, at the cost
+     * of an extra swap-in at the clean page's next use and of swapping out
+     * Belady's choice around then. The allocator keeps a calendar of the
+     * swaps committed so far to predict the stall of those two swaps, and
+     * evicts the clean page only if their predicted stall is less than that
+     * of the swap-out it avoids. Otherwise, it evicts Belady's choice, so it
+     * behaves exactly like BeladyAllocator unless swap bandwidth is the
+     * bottleneck.
+     *
+     * Following the "do no harm" rule of Cao et al.'s integrated prefetching
+     * and caching algorithms, a page other than Belady's choice is only
+     * evicted if its next use is beyond the prefetch lookahead, so that
+     * swapping it back in can be overlapped with computation.
+     */
+    class StallAwareAllocator : public BeladyAllocator {
+    public:
+        /**
+         * @brief Creates a @p StallAwareAllocator instance that consumes the
+         * specified virtual bytecode and annotations, and writes the resulting
+         * physical bytecode to a file with the specified name.
+         *
+         * @param output_file The name of the file to which to write the
+         * resulting physical bytecode.
+         * @param virtual_program_file The name of the file from which to read
+         * the virtual bytecode.
+         * @param annotations_file The name of the file from which to read the
+         * next-use annotations for the virtual bytecode.
+         * @param num_page_frames The number of physical pages available.
+         * @param shift Base-2 logarithm of the page size.
+         * @param prefetch_buffer_size The number of page frames that the
+         * scheduling stage reserves for swaps in flight.
+         * @param lookahead The number of instructions ahead of time at which
+         * the scheduling stage issues swap-ins.
+         * @param swap_latency The predicted time, in instructions, for a swap
+         * to complete.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
+         * @param resident_limits If nonempty, the number of physical pages
+         * available varies over the program as given, overriding
+         * @p num_page_frames (see mage::memprog::split_host_budget).
+         */
+        StallAwareAllocator(std::string output_file, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, std::uint32_t prefetch_buffer_size, InstructionNumber lookahead, InstructionNumber swap_latency, TieredStorageAllocator storage_frames = TieredStorageAllocator(), std::vector<ResidentLimit> resident_limits = {});
+
+        /**
+         * @brief Creates a @p StallAwareAllocator instance like the above, but
+         * that streams the resulting physical bytecode through the specified
+         * pipe instead of writing it to a file.
+         *
+         * @param output The pipe to which to write the resulting physical
+         * bytecode.
+         * @param virtual_program_file The name of the file from which to read
+         * the virtual bytecode.
+         * @param annotations_file The name of the file from which to read the
+         * next-use annotations for the virtual bytecode.
+         * @param num_page_frames The number of physical pages available.
+         * @param shift Base-2 logarithm of the page size.
+         * @param prefetch_buffer_size The number of page frames that the
+         * scheduling stage reserves for swaps in flight.
+         * @param lookahead The number of instructions ahead of time at which
+         * the scheduling stage issues swap-ins.
+         * @param swap_latency The predicted time, in instructions, for a swap
+         * to complete.
+         * @param storage_frames Allocator used to choose the frames in
+         * storage to which pages are swapped out.
+         * @param resident_limits If nonempty, the number of physical pages
+         * available varies over the program as given, overriding
+         * @p num_page_frames (see mage::memprog::split_host_budget).
+         */
+        StallAwareAllocator(PhysProgramPipe& output, std::string virtual_program_file, std::string annotations_file, PhysPageNumber num_page_frames, PageShift shift, std::uint32_t prefetch_buffer_size, InstructionNumber lookahead, InstructionNumber swap_latency, TieredStorageAllocator storage_frames = TieredStorageAllocator(), std::vector<ResidentLimit> resident_limits = {});
+
+        void allocate(util::ProgressBar* progress_bar = nullptr) override;
+
+        /**
+         * @brief Obtains the predicted time that execution of the emitted
+         * physical bytecode stalls on swaps.
+         *
+         * @return The predicted stall time, in instructions.
+         */
+        InstructionNumber get_predicted_stall() const;
+
+        /**
+         * @brief Obtains the number of times that a page other than the one
+         * chosen by Belady's algorithm was evicted.
+         *
+         * @return The number of such evictions.
+         */
+        std::uint64_t get_num_substitutions() const;
+
+        /**
+         * @brief Obtains the number of swaps in the emitted physical bytecode
+         * that are predicted to be done synchronously because the budget of
+         * concurrent swaps is exhausted.
+         *
+         * @return The predicted number of synchronous swaps.
+         */
+        std::uint64_t get_num_synchronous_swaps() const;
+
+    protected:
+        void emit_swapout(PhysPageNumber primary, StoragePageNumber secondary) override;
+        void emit_swapin(StoragePageNumber secondary, PhysPageNumber primary) override;
+        std::pair<BeladyScore, VirtPageNumber> remove_victim(InstructionNumber current) override;
+        void evict(VirtPageNumber vpn, InstructionNumber next_use, InstructionNumber current) override;
+
+    private:
+        /**
+         * @brief Counts the swaps already committed whose prefetch buffer
+         * frames may be held at the same time as those of a swap for the
+         * specified instruction.
+         *
+         * @param use The number (index) of the instruction that needs the
+         * swap.
+         * @return The number of such swaps.
+         */
+        std::uint64_t committed_swaps(InstructionNumber use) const;
+
+        /**
+         * @brief Predicts the stall caused by evicting a clean page, next used
+         * by the specified instruction, in place of Belady's choice.
+         *
+         * @param use The number (index) of the instruction that next uses the
+         * clean page.
+         * @return The predicted stall, in instructions.
+         */
+        InstructionNumber predicted_deferral_stall(InstructionNumber use) const;
+
+        SwapBudgetModel model;
+        std::uint32_t budget;
+        InstructionNumber lookahead;
+        InstructionNumber latency;
+
+        /*
+         * Number of swaps committed for instructions in each interval of
+         * calendar_interval instructions, indexed by interval.
+         */
+        std::map<InstructionNumber, std::uint32_t> swapin_calendar;
+        InstructionNumber calendar_interval;
+
+        /* Pages considered for eviction, reused across evictions. */
+        std::vector<std::pair<BeladyScore, VirtPageNumber>> candidates;
+
+        std::uint64_t num_substitutions;
     };
 }
 
@@ -24,18 +24,27 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
 #include "addr.hpp"
 #include "instruction.hpp"
 #include "opcode.hpp"
 #include "programfile.hpp"
 
 namespace mage::memprog {
-    static constexpr bool elide_page_copies = true;
+    /*
+     * Eliding page copies remaps pages to other page frames, which would break
+     * up multi-page allocations, so it is only done if there are none.
+     */
+    static constexpr bool elide_page_copies_by_default = true;
 
     Scheduler::Scheduler(std::string input_file, std::string output_file)
         : input(input_file), output(output_file) {
     }
 
+    Scheduler::Scheduler(PhysProgramPipe& input_pipe, std::string output_file)
+        : input(input_pipe, true), output(output_file) {
+    }
+
     Scheduler::~Scheduler() {
     }
 
@@ -92,12 +101,23 @@ namespace mage::memprog {
         this->output.finish_instruction(length);
     }
 
+    void Scheduler::emit_discard_page(PhysPageNumber ppn) {
+        constexpr std::size_t length = PackedPhysInstruction::size(InstructionFormat::SwapFinish);
+
+        PackedPhysInstruction& discard = this->output.start_instruction();
+        discard.header.operation = OpCode::DiscardPage;
+        discard.header.flags = 0;
+        discard.swap_finish.memory = ppn;
+        this->output.finish_instruction(length);
+    }
+
     NOPScheduler::NOPScheduler(std::string input_file, std::string output_file)
         : Scheduler(input_file, output_file) {
         const ProgramFileHeader& header = this->input.get_header();
         this->output.set_page_count(header.num_pages);
-        this->output.set_swap_page_count(header.num_swap_pages);
+        this->output.set_swap_page_counts(header.num_swap_pages);
         this->output.set_page_shift(header.page_shift);
+        this->output.set_flags(header.flags);
     }
 
     void NOPScheduler::schedule(util::ProgressBar* progress_bar) {
@@ -125,9 +145,20 @@ namespace mage::memprog {
 
     BackdatingScheduler::BackdatingScheduler(std::string input_file, std::string output_file, std::uint64_t lookahead, std::uint32_t prefetch_buffer_size)
         : Scheduler(input_file, output_file), readahead(input_file), gap(lookahead), current_instruction(0), num_allocation_failures(0), num_synchronous_swapins(0) {
+        this->init(prefetch_buffer_size);
+    }
+
+    BackdatingScheduler::BackdatingScheduler(PhysProgramPipe& input_pipe, std::string output_file, std::uint64_t lookahead, std::uint32_t prefetch_buffer_size)
+        : Scheduler(input_pipe, output_file), readahead(input_pipe, false), gap(lookahead), current_instruction(0), num_allocation_failures(0), num_synchronous_swapins(0) {
+        this->init(prefetch_buffer_size);
+    }
+
+    void BackdatingScheduler::init(std::uint32_t prefetch_buffer_size) {
         const ProgramFileHeader& header = this->input.get_header();
+        this->elide_page_copies = elide_page_copies_by_default && (header.flags & ProgramFlagPageSpans) == 0;
+        this->output.set_flags(header.flags);
         this->output.set_page_count(header.num_pages + prefetch_buffer_size);
-        this->output.set_swap_page_count(header.num_swap_pages);
+        this->output.set_swap_page_counts(header.num_swap_pages);
         /*
          * The "+ 1" is to account for a "synchronous swap" operation that
          * bypasses the prefetch buffer when the prefetch buffer is full.
@@ -252,7 +283,7 @@ namespace mage::memprog {
             StoragePageNumber spn = phys.swap.storage;
             auto iter = this->in_flight_swapins.find(spn);
             if (iter != this->in_flight_swapins.end()) {
-                if constexpr (elide_page_copies) {
+                if (this->elide_page_copies) {
                     this->emit_finish_swapin(iter->second);
                     this->translation_map[phys.swap.memory] = iter->second;
                     this->deallocate_page_frame(ppn);
@@ -313,7 +344,7 @@ namespace mage::memprog {
                 }
             }
             if (this->allocate_page_frame(ppn)) {
-                if constexpr (elide_page_copies) {
+                if (this->elide_page_copies) {
                     this->emit_issue_swapout(this->translation_map[phys.swap.memory], spn);
                     this->in_flight_swapouts[spn] = std::make_pair(i, this->translation_map[phys.swap.memory]);
                     this->translation_map[phys.swap.memory] = ppn;
@@ -327,6 +358,20 @@ namespace mage::memprog {
                 this->emit_issue_swapout(this->translation_map[phys.swap.memory], spn);
                 this->emit_finish_swapout(this->translation_map[phys.swap.memory]);
             }
+        } else if (phys.header.operation == OpCode::CopySwap) {
+            /*
+             * The replacement stage moves a page to another frame when its
+             * memory budget shrinks; the source frame is discarded afterward,
+             * so with copy elision, exchanging the frames suffices.
+             */
+            if (this->elide_page_copies) {
+                std::swap(this->translation_map[phys.swap.storage], this->translation_map[phys.swap.memory]);
+            } else {
+                this->emit_page_copy(this->translation_map[phys.swap.storage], this->translation_map[phys.swap.memory]);
+            }
+        } else if (phys.header.operation == OpCode::DiscardPage) {
+            /* Discard whichever frame currently backs the page frame. */
+            this->emit_discard_page(this->translation_map[phys.swap_finish.memory]);
         } else {
             /* Copy instruction to output. */
             const std::uint8_t* phys_start = reinterpret_cast<const std::uint8_t*>(&phys);
@@ -349,18 +394,22 @@ namespace mage::memprog {
     void BackdatingScheduler::schedule(util::ProgressBar* progress_bar) {
         this->input.set_progress_bar(progress_bar);
 
-        std::uint64_t num_instructions = this->input.get_header().num_instructions;
+        /*
+         * The input may be streamed from a replacement stage running
+         * concurrently, so the number of instructions is known only once the
+         * read-ahead cursor reaches the end.
+         */
         InstructionNumber i;
 
         // First, create a gap
-        for (i = 0; i != this->gap && i != num_instructions; i++) {
+        for (i = 0; i != this->gap && !this->readahead.at_end(); i++) {
             PackedPhysInstruction& phys = this->readahead.start_instruction();
             this->process_gap_increase(phys, i);
             this->readahead.finish_instruction(phys.size());
         }
 
         // Process the remaining instructions
-        for (; i != num_instructions; i++, this->current_instruction++) {
+        for (; !this->readahead.at_end(); i++, this->current_instruction++) {
             PackedPhysInstruction& current = this->input.start_instruction();
             this->process_gap_decrease(current, this->current_instruction);
             this->input.finish_instruction(current.size());
@@ -371,11 +420,14 @@ namespace mage::memprog {
         }
 
         // Drain the gap
-        for (; this->current_instruction != num_instructions; this->current_instruction++) {
+        for (; this->current_instruction != i; this->current_instruction++) {
             PackedPhysInstruction& current = this->input.start_instruction();
             this->process_gap_decrease(current, this->current_instruction);
             this->input.finish_instruction(current.size());
         }
 
+        /* Swap space is only known once the replacement stage finishes. */
+        this->output.set_swap_page_counts(this->readahead.get_header().num_swap_pages);
+
     }
 }
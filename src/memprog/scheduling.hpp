@@ -61,6 +61,18 @@ namespace mage::memprog {
          */
         Scheduler(std::string input_file, std::string output_file);
 
+        /**
+         * @brief Initializes a @p Scheduler that reads physical bytecode from
+         * the specified pipe, as it is produced by a replacement stage
+         * running concurrently, and writes a memory program to the specified
+         * output file.
+         *
+         * @param input_pipe The pipe from which to read the physical bytecode.
+         * @param output_file The name of the file to which to write the memory
+         * program.
+         */
+        Scheduler(PhysProgramPipe& input_pipe, std::string output_file);
+
         /**
          * @brief Destructor.
          */
@@ -128,6 +140,16 @@ namespace mage::memprog {
          */
         void emit_finish_swapout(PhysPageNumber ppn);
 
+        /**
+         * @brief Emits a "discard page" instruction to the memory program.
+         *
+         * This instruction causes the engine to release the memory backing a
+         * page frame whose contents are no longer needed.
+         *
+         * @param ppn The physical page number of the page frame in memory.
+         */
+        void emit_discard_page(PhysPageNumber ppn);
+
         PhysProgramFileReader input;
         PhysProgramFileWriter output;
     };
@@ -190,6 +212,26 @@ namespace mage::memprog {
          */
         BackdatingScheduler(std::string input_file, std::string output_file, std::uint64_t lookahead, std::uint32_t prefetch_buffer_size);
 
+        /**
+         * @brief Initializes a @p BackdatingScheduler that reads physical
+         * bytecode from the specified pipe and writes a memory program to the
+         * specified output file.
+         *
+         * The scheduler reads ahead of the instruction it is processing by
+         * @p lookahead instructions, so the pipe's maximum distance between
+         * readers must be at least @p lookahead.
+         *
+         * @param input_pipe The pipe from which to read the physical bytecode.
+         * @param output_file The name of the file to which to write the memory
+         * program.
+         * @param lookahead The number of instructions by which to prefetch
+         * each "swap in" operation.
+         * @param prefetch_buffer_size The number of extra MAGE-physical page
+         * frames (beyond those used in the replacement phase) used for
+         * scheduling swap operations.
+         */
+        BackdatingScheduler(PhysProgramPipe& input_pipe, std::string output_file, std::uint64_t lookahead, std::uint32_t prefetch_buffer_size);
+
         /**
          * @brief Obtains the number of times the scheduler was unable to
          * allocate a page from from the prefetch buffer.
@@ -287,6 +329,8 @@ namespace mage::memprog {
         void schedule(util::ProgressBar* progress_bar = nullptr) override;
 
     private:
+        void init(std::uint32_t prefetch_buffer_size);
+
         PhysProgramFileReader readahead;
         // util::PriorityQueue<InstructionNumber, std::pair<StoragePageNumber, PhysPageNumber>> queued_swapins;
         std::unordered_map<StoragePageNumber, PhysPageNumber> finished_swapout_elisions;
@@ -301,6 +345,7 @@ namespace mage::memprog {
 
         std::vector<PhysPageNumber> translation_map;
         PageShift page_shift;
+        bool elide_page_copies;
 
         std::uint64_t num_allocation_failures;
         std::uint64_t num_synchronous_swapins;
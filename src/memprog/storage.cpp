@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "memprog/storage.hpp"
+#include <cassert>
+#include <cstdint>
+#include "addr.hpp"
+
+namespace mage::memprog {
+    StorageFrameAllocator::StorageFrameAllocator(StoragePageNumber extent_frames, InstructionNumber reuse_window)
+        : extent_size(extent_frames), window(reuse_window == 0 ? 1 : reuse_window), next_frame(0) {
+    }
+
+    StoragePageNumber StorageFrameAllocator::allocate(InstructionNumber current, InstructionNumber next_use) {
+        if (!this->uses_extents()) {
+            if (this->free_frames.empty()) {
+                return this->next_frame++;
+            }
+            StoragePageNumber spn = this->free_frames.back();
+            this->free_frames.pop_back();
+            return spn;
+        }
+
+        this->close_stale_extents(current);
+
+        std::uint64_t bucket = next_use / this->window;
+        auto iter = this->open_extents.find(bucket);
+        if (iter == this->open_extents.end()) {
+            std::uint64_t extent = this->open_extent();
+            StoragePageNumber start = extent * this->extent_size;
+            iter = this->open_extents.emplace(bucket, OpenExtent { start, start + this->extent_size }).first;
+        }
+
+        OpenExtent& open = iter->second;
+        StoragePageNumber spn = open.next++;
+        std::uint64_t extent = spn / this->extent_size;
+        this->live_frames[extent]++;
+        if (open.next == open.end) {
+            this->open_extents.erase(iter);
+            this->close_extent(extent);
+        }
+        return spn;
+    }
+
+    void StorageFrameAllocator::deallocate(StoragePageNumber spn) {
+        if (!this->uses_extents()) {
+            this->free_frames.push_back(spn);
+            return;
+        }
+
+        std::uint64_t extent = spn / this->extent_size;
+        assert(this->live_frames[extent] != 0);
+        this->live_frames[extent]--;
+        if (this->live_frames[extent] == 0 && !this->extent_open[extent]) {
+            this->free_extents.push_back(extent);
+        }
+    }
+
+    StoragePageNumber StorageFrameAllocator::allocate_run(StoragePageNumber count) {
+        std::vector<StoragePageNumber>& free_list = this->free_runs[count];
+        if (free_list.empty()) {
+            /* Keep extents aligned, so they can still be found from an SPN. */
+            if (this->uses_extents()) {
+                StoragePageNumber num_extents = (count + this->extent_size - 1) / this->extent_size;
+                StoragePageNumber spn = this->next_frame;
+                for (StoragePageNumber i = 0; i != num_extents; i++) {
+                    this->live_frames.push_back(0);
+                    this->extent_open.push_back(false);
+                }
+                this->next_frame += num_extents * this->extent_size;
+                return spn;
+            }
+            StoragePageNumber spn = this->next_frame;
+            this->next_frame += count;
+            return spn;
+        }
+        StoragePageNumber spn = free_list.back();
+        free_list.pop_back();
+        return spn;
+    }
+
+    void StorageFrameAllocator::deallocate_run(StoragePageNumber spn, StoragePageNumber count) {
+        this->free_runs[count].push_back(spn);
+    }
+
+    void StorageFrameAllocator::close_stale_extents(InstructionNumber current) {
+        /*
+         * Pages are always evicted before their next use, so once the current
+         * instruction is past a bucket, no more pages will be placed in it.
+         */
+        std::uint64_t current_bucket = current / this->window;
+        auto iter = this->open_extents.begin();
+        while (iter != this->open_extents.end() && iter->first < current_bucket) {
+            this->close_extent(iter->second.next / this->extent_size);
+            iter = this->open_extents.erase(iter);
+        }
+    }
+
+    void StorageFrameAllocator::close_extent(std::uint64_t extent) {
+        this->extent_open[extent] = false;
+        if (this->live_frames[extent] == 0) {
+            this->free_extents.push_back(extent);
+        }
+    }
+
+    std::uint64_t StorageFrameAllocator::open_extent() {
+        std::uint64_t extent;
+        if (this->free_extents.empty()) {
+            extent = this->live_frames.size();
+            this->live_frames.push_back(0);
+            this->extent_open.push_back(false);
+            this->next_frame += this->extent_size;
+        } else {
+            extent = this->free_extents.back();
+            this->free_extents.pop_back();
+        }
+        this->extent_open[extent] = true;
+        return extent;
+    }
+
+    TieredStorageAllocator::TieredStorageAllocator(const StorageFrameAllocator& tier_frames, const std::vector<InstructionNumber>& tier_max_reuse_distances)
+        : tiers(tier_max_reuse_distances.size() + 1, tier_frames), max_reuse_distances(tier_max_reuse_distances) {
+        assert(this->tiers.size() <= max_storage_tiers);
+    }
+
+    std::uint8_t TieredStorageAllocator::choose_tier(InstructionNumber current, InstructionNumber next_use) const {
+        InstructionNumber distance = next_use - current;
+        std::uint8_t tier = 0;
+        while (tier != this->max_reuse_distances.size() && distance > this->max_reuse_distances[tier]) {
+            tier++;
+        }
+        return tier;
+    }
+
+    StoragePageNumber TieredStorageAllocator::allocate(InstructionNumber current, InstructionNumber next_use) {
+        std::uint8_t tier = this->choose_tier(current, next_use);
+        return storage_page_number(tier, this->tiers[tier].allocate(current, next_use));
+    }
+
+    void TieredStorageAllocator::deallocate(StoragePageNumber spn) {
+        this->tiers[storage_tier(spn)].deallocate(storage_tier_frame(spn));
+    }
+
+    StoragePageNumber TieredStorageAllocator::allocate_run(InstructionNumber current, InstructionNumber next_use, StoragePageNumber count) {
+        std::uint8_t tier = this->choose_tier(current, next_use);
+        return storage_page_number(tier, this->tiers[tier].allocate_run(count));
+    }
+
+    void TieredStorageAllocator::deallocate_run(StoragePageNumber spn, StoragePageNumber count) {
+        this->tiers[storage_tier(spn)].deallocate_run(storage_tier_frame(spn), count);
+    }
+
+    bool TieredStorageAllocator::can_keep(StoragePageNumber spn, InstructionNumber current, InstructionNumber next_use) const {
+        std::uint8_t tier = storage_tier(spn);
+        return !this->tiers[tier].uses_extents() && tier == this->choose_tier(current, next_use);
+    }
+
+    StoragePageNumber TieredStorageAllocator::get_num_frames() const {
+        StoragePageNumber total = 0;
+        for (const StorageFrameAllocator& tier : this->tiers) {
+            total += tier.get_num_frames();
+        }
+        return total;
+    }
+}
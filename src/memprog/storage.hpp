@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file memprog/storage.hpp
+ * @brief Allocation of storage (swap) page frames for MAGE's planner
+ *
+ * The replacement stage decides which pages are swapped out, and uses a
+ * storage frame allocator to decide where in the swap file or device each
+ * swapped-out page is written.
+ */
+
+#ifndef MAGE_MEMPROG_STORAGE_HPP_
+#define MAGE_MEMPROG_STORAGE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "addr.hpp"
+
+namespace mage::memprog {
+    /**
+     * @brief Allocates page frames in storage to which pages are swapped out.
+     *
+     * By default, storage frames are handed out from a LIFO free list, which
+     * keeps the swap space compact but pays no attention to locality. If an
+     * extent size is provided, the allocator instead divides storage into
+     * aligned extents of contiguous frames and fills each extent with pages
+     * whose next use falls in the same window of instructions (a "reuse
+     * bucket"). Pages that are swapped back in at around the same time then
+     * sit next to each other in storage, so the resulting swap I/O is mostly
+     * sequential, which benefits device readahead and merging of adjacent
+     * requests.
+     *
+     * An extent is returned to the free pool only once every frame in it has
+     * been freed, so the extent-based policy trades some swap space for
+     * locality.
+     */
+    class StorageFrameAllocator {
+    public:
+        /**
+         * @brief Creates a storage frame allocator.
+         *
+         * @param extent_frames The number of contiguous storage frames in
+         * each extent, or 0 (or 1) to use a simple LIFO free list.
+         * @param reuse_window The width, in instructions, of each reuse
+         * bucket. Ignored if @p extent_frames is 0 or 1.
+         */
+        StorageFrameAllocator(StoragePageNumber extent_frames = 0, InstructionNumber reuse_window = 1 << 12);
+
+        /**
+         * @brief Allocates a storage frame for a page that is being swapped
+         * out.
+         *
+         * @param current The number (index) of the instruction being
+         * processed when the page is swapped out.
+         * @param next_use The number (index) of the instruction at which the
+         * page will next be accessed (i.e., swapped back in).
+         * @return The frame number in storage of the allocated frame.
+         */
+        StoragePageNumber allocate(InstructionNumber current, InstructionNumber next_use);
+
+        /**
+         * @brief Deallocates a storage frame.
+         *
+         * @pre The frame @p spn was previously allocated using @p allocate.
+         * @param spn The frame number in storage of the frame to deallocate.
+         */
+        void deallocate(StoragePageNumber spn);
+
+        /**
+         * @brief Allocates a range of contiguous storage frames, used to swap
+         * out a group of pages holding a single multi-page allocation.
+         *
+         * Such ranges are kept on free lists by length, separately from
+         * the frames used for individual pages.
+         *
+         * @param count The number of contiguous frames to allocate.
+         * @return The frame number in storage of the first allocated frame.
+         */
+        StoragePageNumber allocate_run(StoragePageNumber count);
+
+        /**
+         * @brief Deallocates a range of contiguous storage frames.
+         *
+         * @pre The range was previously allocated using @p allocate_run with
+         * the same @p count.
+         * @param spn The frame number in storage of the first frame.
+         * @param count The number of frames in the range.
+         */
+        void deallocate_run(StoragePageNumber spn, StoragePageNumber count);
+
+        /**
+         * @brief Obtains the amount of storage space, in frames, that has been
+         * used so far.
+         *
+         * @return One plus the largest frame number ever allocated.
+         */
+        StoragePageNumber get_num_frames() const {
+            return this->next_frame;
+        }
+
+        /**
+         * @brief Returns true if this allocator places storage frames
+         * according to reuse time (i.e., it is not a simple LIFO free list).
+         *
+         * @return True if storage frames are allocated from extents.
+         */
+        bool uses_extents() const {
+            return this->extent_size > 1;
+        }
+
+    private:
+        /**
+         * @brief Range of frames in an extent that have not yet been handed
+         * out since the extent was opened for a reuse bucket.
+         */
+        struct OpenExtent {
+            StoragePageNumber next;
+            StoragePageNumber end;
+        };
+
+        void close_stale_extents(InstructionNumber current);
+        void close_extent(std::uint64_t extent);
+        std::uint64_t open_extent();
+
+        StoragePageNumber extent_size;
+        InstructionNumber window;
+        StoragePageNumber next_frame;
+
+        /* Used for the LIFO policy. */
+        std::vector<StoragePageNumber> free_frames;
+
+        /* Free ranges of contiguous frames, by length. */
+        std::unordered_map<StoragePageNumber, std::vector<StoragePageNumber>> free_runs;
+
+        /* Used for the extent-based policy. */
+        std::map<std::uint64_t, OpenExtent> open_extents;
+        std::vector<std::uint64_t> free_extents;
+        std::vector<std::uint32_t> live_frames;
+        std::vector<bool> extent_open;
+    };
+
+    /**
+     * @brief Allocates page frames across multiple storage tiers (e.g., a
+     * small, fast NVMe drive and a larger, slower disk), choosing the tier
+     * for each swapped-out page by how soon it will be needed again.
+     *
+     * Tier 0 is the fastest. Each tier except the last has a limit on reuse
+     * distance (the number of instructions until the page's next use, which
+     * the replacement stage knows exactly); a page goes to the first tier
+     * whose limit is at least its reuse distance, so pages that come back soon
+     * stay on fast storage and cold pages go to slow storage. Within a tier,
+     * frames are allocated by a StorageFrameAllocator, and the tier is encoded
+     * in the high bits of the returned storage page number (see
+     * mage::storage_tier).
+     *
+     * With no limits, there is a single tier, and storage page numbers are
+     * the same as those of the underlying StorageFrameAllocator.
+     */
+    class TieredStorageAllocator {
+    public:
+        /**
+         * @brief Creates an allocator for tiered storage.
+         *
+         * @param tier_frames Allocator (with its policy) used for each tier.
+         * @param tier_max_reuse_distances For each tier except the last, the
+         * largest reuse distance, in instructions, of pages placed in it. The
+         * number of tiers is one more than the length of this list.
+         */
+        TieredStorageAllocator(const StorageFrameAllocator& tier_frames = StorageFrameAllocator(), const std::vector<InstructionNumber>& tier_max_reuse_distances = {});
+
+        /**
+         * @brief Chooses the storage tier for a page being swapped out.
+         *
+         * @param current The number (index) of the instruction being
+         * processed when the page is swapped out.
+         * @param next_use The number (index) of the instruction at which the
+         * page will next be accessed.
+         * @return The storage tier for the page.
+         */
+        std::uint8_t choose_tier(InstructionNumber current, InstructionNumber next_use) const;
+
+        /**
+         * @brief Allocates a storage frame, in the tier chosen by reuse
+         * distance, for a page that is being swapped out.
+         *
+         * @param current The number (index) of the instruction being
+         * processed when the page is swapped out.
+         * @param next_use The number (index) of the instruction at which the
+         * page will next be accessed.
+         * @return The storage page number of the allocated frame.
+         */
+        StoragePageNumber allocate(InstructionNumber current, InstructionNumber next_use);
+
+        /**
+         * @brief Deallocates a storage frame.
+         *
+         * @param spn The storage page number of the frame to deallocate.
+         */
+        void deallocate(StoragePageNumber spn);
+
+        /**
+         * @brief Allocates a range of contiguous storage frames, all in the
+         * tier chosen by reuse distance, for a multi-page allocation.
+         *
+         * @param current The number (index) of the instruction being
+         * processed when the pages are swapped out.
+         * @param next_use The number (index) of the instruction at which the
+         * pages will next be accessed.
+         * @param count The number of contiguous frames to allocate.
+         * @return The storage page number of the first allocated frame.
+         */
+        StoragePageNumber allocate_run(InstructionNumber current, InstructionNumber next_use, StoragePageNumber count);
+
+        /**
+         * @brief Deallocates a range of contiguous storage frames.
+         *
+         * @param spn The storage page number of the first frame.
+         * @param count The number of frames in the range.
+         */
+        void deallocate_run(StoragePageNumber spn, StoragePageNumber count);
+
+        /**
+         * @brief Returns true if a dirty page that already has a storage frame
+         * can be written back to it, rather than being given a new frame.
+         *
+         * This is false if the frame is in the wrong tier for the page's new
+         * reuse distance, or if frames are placed by reuse time within a
+         * tier.
+         *
+         * @param spn The storage page number of the page's current frame.
+         * @param current The number (index) of the instruction being
+         * processed when the page is swapped out.
+         * @param next_use The number (index) of the instruction at which the
+         * page will next be accessed.
+         * @return True if the page can keep its storage frame.
+         */
+        bool can_keep(StoragePageNumber spn, InstructionNumber current, InstructionNumber next_use) const;
+
+        /**
+         * @brief Obtains the number of storage tiers.
+         *
+         * @return The number of storage tiers.
+         */
+        std::uint8_t get_num_tiers() const {
+            return static_cast<std::uint8_t>(this->tiers.size());
+        }
+
+        /**
+         * @brief Obtains the amount of storage space, in frames, that has been
+         * used so far in the specified tier.
+         *
+         * @param tier The specified tier.
+         * @return One plus the largest frame number ever allocated in the
+         * specified tier.
+         */
+        StoragePageNumber get_num_frames(std::uint8_t tier) const {
+            return this->tiers[tier].get_num_frames();
+        }
+
+        /**
+         * @brief Obtains the amount of storage space, in frames, that has been
+         * used so far across all tiers.
+         *
+         * @return The total number of storage frames used.
+         */
+        StoragePageNumber get_num_frames() const;
+
+    private:
+        std::vector<StorageFrameAllocator> tiers;
+        std::vector<InstructionNumber> max_reuse_distances;
+    };
+}
+
+#endif
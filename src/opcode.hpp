@@ -78,6 +78,16 @@ namespace mage {
         MultiplyPlaintextRaw, // 2 arguments
         Renormalize, // 1 argument
         Encode, // 1 argument
+        MultiplyAccumulateRaw, // 2 arguments (output field is an input)
+        MultiplyPlaintextAccumulateRaw, // 2 arguments (output field is an input)
+        StoreAccumulator, // 0 arguments
+        IntLessSigned, // 2 arguments
+        FixedMultiply, // 2 arguments (width packs total and fraction bits)
+        FloatAdd, // 2 arguments (width packs mantissa and exponent bits)
+        FloatSub, // 2 arguments (width packs mantissa and exponent bits)
+        FloatMultiply, // 2 arguments (width packs mantissa and exponent bits)
+        FloatLess, // 2 arguments (width packs mantissa and exponent bits)
+        DiscardPage,
     };
 
     /**
@@ -166,6 +176,26 @@ namespace mage {
             return "Renormalize";
         case OpCode::Encode:
             return "Encode";
+        case OpCode::MultiplyAccumulateRaw:
+            return "MultiplyAccumulateRaw";
+        case OpCode::MultiplyPlaintextAccumulateRaw:
+            return "MultiplyPlaintextAccumulateRaw";
+        case OpCode::StoreAccumulator:
+            return "StoreAccumulator";
+        case OpCode::IntLessSigned:
+            return "IntLessSigned";
+        case OpCode::FixedMultiply:
+            return "FixedMultiply";
+        case OpCode::FloatAdd:
+            return "FloatAdd";
+        case OpCode::FloatSub:
+            return "FloatSub";
+        case OpCode::FloatMultiply:
+            return "FloatMultiply";
+        case OpCode::FloatLess:
+            return "FloatLess";
+        case OpCode::DiscardPage:
+            return "DiscardPage";
         default:
             std::abort();
         }
@@ -313,6 +343,7 @@ namespace mage {
                 break;
             case OpCode::FinishSwapIn:
             case OpCode::FinishSwapOut:
+            case OpCode::DiscardPage:
                 this->layout = InstructionFormat::SwapFinish;
                 this->single_bit = false;
                 this->has_output = false;
@@ -352,6 +383,10 @@ namespace mage {
             case OpCode::IntAddWithCarry:
             case OpCode::IntSub:
             case OpCode::IntMultiply:
+            case OpCode::FixedMultiply:
+            case OpCode::FloatAdd:
+            case OpCode::FloatSub:
+            case OpCode::FloatMultiply:
             case OpCode::BitAND:
             case OpCode::BitOR:
             case OpCode::BitXOR:
@@ -373,6 +408,8 @@ namespace mage {
                 this->has_output = true;
                 break;
             case OpCode::IntLess:
+            case OpCode::IntLessSigned:
+            case OpCode::FloatLess:
             case OpCode::Equal:
                 this->layout = InstructionFormat::TwoArgs;
                 this->single_bit = true;
@@ -389,6 +426,17 @@ namespace mage {
                 this->single_bit = false;
                 this->has_output = true;
                 break;
+            case OpCode::MultiplyAccumulateRaw:
+            case OpCode::MultiplyPlaintextAccumulateRaw:
+                this->layout = InstructionFormat::OneArg;
+                this->single_bit = false;
+                this->has_output = false;
+                break;
+            case OpCode::StoreAccumulator:
+                this->layout = InstructionFormat::NoArgs;
+                this->single_bit = false;
+                this->has_output = true;
+                break;
             default:
                 std::abort();
             }
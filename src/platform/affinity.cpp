@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2021 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2021 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "platform/affinity.hpp"
+#include <sched.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mage::platform {
+    /*
+     * These are written only before any thread with a role is started (see
+     * set_thread_role_cpus), so reading them from those threads is safe.
+     */
+    static bool placement_configured = false;
+    static cpu_set_t original_cpus;
+    static std::array<std::vector<std::uint32_t>, num_thread_roles> role_cpus;
+
+    static const char* thread_role_names[num_thread_roles] = { "engine", "ot_daemons", "network" };
+
+    static bool parse_cpu_list(const std::string& list, std::vector<std::uint32_t>& cpus) {
+        std::istringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty() || range == "\n") {
+                continue;
+            }
+            std::size_t dash = range.find('-');
+            try {
+                unsigned long first = std::stoul(range.substr(0, dash));
+                unsigned long last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+                if (last < first || last >= CPU_SETSIZE) {
+                    return false;
+                }
+                for (unsigned long cpu = first; cpu <= last; cpu++) {
+                    cpus.push_back(cpu);
+                }
+            } catch (const std::logic_error& le) {
+                return false;
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return !cpus.empty();
+    }
+
+    bool parse_cpu_set(const std::string& spec, std::vector<std::uint32_t>& cpus) {
+        cpus.clear();
+        if (spec.rfind("node", 0) == 0) {
+            std::string node = spec.substr(4);
+            if (node.empty() || node.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            std::ifstream cpulist("/sys/devices/system/node/node" + node + "/cpulist");
+            std::string list;
+            if (!std::getline(cpulist, list)) {
+                return false;
+            }
+            return parse_cpu_list(list, cpus);
+        }
+        return parse_cpu_list(spec, cpus);
+    }
+
+    void set_thread_role_cpus(ThreadRole role, const std::vector<std::uint32_t>& cpus) {
+        if (!placement_configured) {
+            if (sched_getaffinity(0, sizeof(original_cpus), &original_cpus) != 0) {
+                std::perror("set_thread_role_cpus -> sched_getaffinity");
+                std::abort();
+            }
+            placement_configured = true;
+        }
+        role_cpus[static_cast<std::uint8_t>(role)] = cpus;
+    }
+
+    void pin_thread(ThreadRole role) {
+        if (!placement_configured) {
+            return;
+        }
+        const std::vector<std::uint32_t>& cpus = role_cpus[static_cast<std::uint8_t>(role)];
+        cpu_set_t set;
+        if (cpus.empty()) {
+            set = original_cpus;
+        } else {
+            CPU_ZERO(&set);
+            for (std::uint32_t cpu : cpus) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::perror("pin_thread -> sched_setaffinity");
+            std::abort();
+        }
+    }
+
+    bool thread_placement_configured() {
+        return placement_configured;
+    }
+
+    void print_thread_placement(std::ostream& out) {
+        out << "CPU placement:";
+        for (std::uint8_t i = 0; i != num_thread_roles; i++) {
+            out << " " << thread_role_names[i] << "=";
+            const std::vector<std::uint32_t>& cpus = role_cpus[i];
+            if (cpus.empty()) {
+                out << "any";
+                continue;
+            }
+            /* Print maximal ranges, in the same format accepted as input. */
+            for (std::size_t j = 0; j != cpus.size();) {
+                std::size_t k = j;
+                while (k + 1 != cpus.size() && cpus[k + 1] == cpus[k] + 1) {
+                    k++;
+                }
+                out << (j == 0 ? "" : ",") << cpus[j];
+                if (k != j) {
+                    out << "-" << cpus[k];
+                }
+                j = k + 1;
+            }
+        }
+    }
+}
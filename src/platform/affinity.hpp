@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2021 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file platform/affinity.hpp
+ * @brief System-level utilities for placing threads on CPU cores.
+ *
+ * Each thread started by MAGE has a role (the engine thread, an OT daemon, or
+ * a network thread), and each role may be pinned to a set of CPUs given in
+ * the configuration file. The placement is configured once, before any of
+ * these threads are started, and each thread applies the placement for its
+ * role when it starts.
+ */
+
+#ifndef MAGE_PLATFORM_AFFINITY_HPP_
+#define MAGE_PLATFORM_AFFINITY_HPP_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mage::platform {
+    /**
+     * @brief The role of a thread, which determines the CPUs it runs on.
+     */
+    enum class ThreadRole : std::uint8_t {
+        Engine = 0,
+        OTDaemon = 1,
+        Network = 2
+    };
+
+    /**
+     * @brief Number of distinct thread roles.
+     */
+    constexpr const std::uint8_t num_thread_roles = 3;
+
+    /**
+     * @brief Parses a set of CPUs, given either as a list of CPU numbers and
+     * ranges (e.g., "0-3,8,10-11") or as a NUMA node (e.g., "node1"), in
+     * which case the set consists of the CPUs on that node.
+     *
+     * @param spec The specification of the set of CPUs.
+     * @param[out] cpus Populated with the CPUs in the set, in ascending order.
+     * @return True on success, or false if @p spec is malformed or names a
+     * NUMA node that does not exist.
+     */
+    bool parse_cpu_set(const std::string& spec, std::vector<std::uint32_t>& cpus);
+
+    /**
+     * @brief Sets the CPUs on which threads with the specified role run.
+     *
+     * This must be called before threads with any role are started. The
+     * first call records the CPUs the process was allowed to run on, which
+     * are used for roles whose CPUs are never set.
+     *
+     * @param role The role whose placement to set.
+     * @param cpus The CPUs on which threads with that role may run.
+     */
+    void set_thread_role_cpus(ThreadRole role, const std::vector<std::uint32_t>& cpus);
+
+    /**
+     * @brief Restricts the calling thread to the CPUs for the specified role.
+     *
+     * New threads inherit the CPUs of the thread that creates them, so every
+     * thread with a role calls this when it starts; a thread whose role has
+     * no configured CPUs is returned to the CPUs the process started with.
+     * If no placement has been configured, this does nothing.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param role The role of the calling thread.
+     */
+    void pin_thread(ThreadRole role);
+
+    /**
+     * @brief Checks whether the placement of any thread role has been set.
+     *
+     * @return True if set_thread_role_cpus has been called, otherwise false.
+     */
+    bool thread_placement_configured();
+
+    /**
+     * @brief Writes a description of the configured placement of each
+     * thread role to the specified stream.
+     *
+     * @param out The stream to which to write the description.
+     */
+    void print_thread_placement(std::ostream& out);
+}
+
+#endif
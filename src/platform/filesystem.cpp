@@ -19,13 +19,18 @@
  * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cerrno>
 #include <cstdio>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
 #include <unistd.h>
 #include <algorithm>
 #include "memory.hpp"
@@ -46,19 +51,7 @@ namespace mage::platform {
             std::abort();
         }
         if (unsparsify) {
-            static constexpr const std::uint64_t buf_size = 4096;
-            std::uint8_t* buf = allocate_resident_memory<std::uint8_t>(buf_size);
-            std::fill(buf, buf + buf_size, 0x00);
-            std::uint64_t left = length;
-            while (left != 0) {
-                ssize_t rv = write(fd, buf, std::min(left, buf_size));
-                if (rv < 0) {
-                    std::perror("create_file -> write");
-                    std::abort();
-                }
-                left -= rv;
-            }
-            deallocate_resident_memory(buf, buf_size);
+            zero_file(fd, length);
         }
         return fd;
     }
@@ -191,6 +184,97 @@ namespace mage::platform {
         }
     }
 
+    bool preallocate_file(int fd, std::uint64_t length) {
+        if (fallocate(fd, 0, 0, (off_t) length) != 0) {
+            if (errno == EOPNOTSUPP) {
+                return false;
+            }
+            std::perror("preallocate_file -> fallocate");
+            std::abort();
+        }
+        return true;
+    }
+
+    void zero_file(int fd, std::uint64_t length) {
+        static constexpr const std::uint64_t buf_size = 1 << 20;
+        std::uint8_t* buf = allocate_resident_memory<std::uint8_t>(buf_size);
+        std::fill(buf, buf + buf_size, 0x00);
+        std::uint64_t offset = 0;
+        while (offset != length) {
+            ssize_t rv = pwrite(fd, buf, std::min(length - offset, buf_size), (off_t) offset);
+            if (rv <= 0) {
+                if (rv < 0) {
+                    std::perror("zero_file -> pwrite");
+                }
+                std::abort();
+            }
+            offset += rv;
+        }
+        deallocate_resident_memory(buf, buf_size);
+    }
+
+    std::uint64_t direct_io_alignment(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            std::perror("direct_io_alignment -> fstat");
+            std::abort();
+        }
+        if (S_ISBLK(st.st_mode)) {
+            int logical_block_size;
+            if (ioctl(fd, BLKSSZGET, &logical_block_size) != 0) {
+                std::perror("direct_io_alignment -> ioctl");
+                std::abort();
+            }
+            return logical_block_size;
+        }
+#ifdef STATX_DIOALIGN
+        struct statx stx;
+        if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN) != 0 && stx.stx_dio_offset_align != 0) {
+            return std::max(stx.stx_dio_offset_align, stx.stx_dio_mem_align);
+        }
+#endif
+        struct statvfs vfs;
+        if (fstatvfs(fd, &vfs) != 0) {
+            std::perror("direct_io_alignment -> fstatvfs");
+            std::abort();
+        }
+        return vfs.f_bsize;
+    }
+
+    bool count_file_extents(int fd, std::uint64_t length, std::uint64_t& extents, std::uint64_t& unwritten) {
+        static constexpr const std::uint32_t batch_size = 256;
+        std::uint8_t buffer[sizeof(struct fiemap) + batch_size * sizeof(struct fiemap_extent)];
+        struct fiemap* map = reinterpret_cast<struct fiemap*>(buffer);
+
+        extents = 0;
+        unwritten = 0;
+        std::uint64_t offset = 0;
+        while (offset < length) {
+            std::fill(buffer, buffer + sizeof(buffer), 0x00);
+            map->fm_start = offset;
+            map->fm_length = length - offset;
+            map->fm_extent_count = batch_size;
+            if (ioctl(fd, FS_IOC_FIEMAP, map) != 0) {
+                return false;
+            }
+            if (map->fm_mapped_extents == 0) {
+                break;
+            }
+            for (std::uint32_t i = 0; i != map->fm_mapped_extents; i++) {
+                const struct fiemap_extent& extent = map->fm_extents[i];
+                extents++;
+                if ((extent.fe_flags & FIEMAP_EXTENT_UNWRITTEN) != 0) {
+                    unwritten++;
+                }
+                offset = extent.fe_logical + extent.fe_length;
+                if ((extent.fe_flags & FIEMAP_EXTENT_LAST) != 0) {
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+
     std::uint64_t tell_file(int fd) {
         off_t rv = lseek(fd, 0, SEEK_CUR);
         if (rv == -1) {
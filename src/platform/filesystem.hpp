@@ -173,6 +173,73 @@ namespace mage::platform {
      */
     void prefetch_from_file_at(int fd, std::uint64_t start, std::size_t length);
 
+    /**
+     * @brief Asks the file system to allocate space for the specified range
+     * of the file associated with the provided file descriptor, without
+     * writing to it.
+     *
+     * Unlike writing zeros, this is fast, but the allocated extents may be
+     * marked "unwritten" by the file system, in which case the first write
+     * to each of them is somewhat slower than subsequent writes.
+     *
+     * If an error other than lack of support occurs, the process is aborted.
+     *
+     * @param fd The provided file descriptor.
+     * @param length The number of bytes, starting at offset 0, for which to
+     * allocate space.
+     * @return True if the space was allocated, or false if the file system
+     * does not support preallocation.
+     */
+    bool preallocate_file(int fd, std::uint64_t length);
+
+    /**
+     * @brief Writes zero bytes to the specified range of the file associated
+     * with the provided file descriptor, so that the file is not sparse and
+     * none of its extents are left unwritten.
+     *
+     * The writes are done with page-aligned buffers in multiples of 4 KiB
+     * (except possibly at the end), so this works on file descriptors opened
+     * for direct I/O as long as @p length is suitably aligned.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param fd The provided file descriptor.
+     * @param length The number of bytes, starting at offset 0, to zero.
+     */
+    void zero_file(int fd, std::uint64_t length);
+
+    /**
+     * @brief Obtains the alignment, in bytes, required for offsets, lengths,
+     * and buffers of direct I/O operations on the file or block device
+     * associated with the provided file descriptor.
+     *
+     * For block devices, this is the device's logical block size. For
+     * regular files, the alignment is obtained from the file system if it
+     * reports it, and is otherwise conservatively taken to be the file
+     * system's block size.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param fd The provided file descriptor.
+     * @return The required alignment, in bytes.
+     */
+    std::uint64_t direct_io_alignment(int fd);
+
+    /**
+     * @brief Counts the extents backing the specified range of the file
+     * associated with the provided file descriptor, as a measure of how
+     * fragmented it is on disk.
+     *
+     * @param fd The provided file descriptor.
+     * @param length The number of bytes, starting at offset 0, to examine.
+     * @param[out] extents Populated with the number of extents.
+     * @param[out] unwritten Populated with the number of those extents that
+     * are allocated but unwritten.
+     * @return True on success, or false if the file system cannot report
+     * the file's extents.
+     */
+    bool count_file_extents(int fd, std::uint64_t length, std::uint64_t& extents, std::uint64_t& unwritten);
+
     /**
      * @brief Changes the offset associated with a file descriptor that
      * corresponds to a file.
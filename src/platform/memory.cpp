@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <cstdlib>
 #include <sys/mman.h>
+#include <unistd.h>
 
 namespace mage::platform {
     void* allocate_resident_memory(std::size_t num_bytes, bool lazy) {
@@ -45,6 +46,18 @@ namespace mage::platform {
         }
     }
 
+    std::size_t system_page_size() {
+        static const std::size_t size = sysconf(_SC_PAGESIZE);
+        return size;
+    }
+
+    void release_resident_memory(void* memory, std::size_t num_bytes) {
+        if (madvise(memory, num_bytes, MADV_DONTNEED) != 0) {
+            std::perror("release_resident_memory -> madvise");
+            std::abort();
+        }
+    }
+
     void* map_file(int fd, std::size_t length, bool mutate) {
         void* region = mmap(NULL, length, PROT_READ | PROT_WRITE, mutate ? MAP_SHARED : MAP_PRIVATE, fd, 0);
         if (region == MAP_FAILED) {
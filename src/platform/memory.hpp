@@ -59,6 +59,27 @@ namespace mage::platform {
      */
     void deallocate_resident_memory(void* memory, std::size_t num_bytes);
 
+    /**
+     * @brief Obtains the size of the operating system's virtual memory pages.
+     *
+     * @return The system page size, in bytes.
+     */
+    std::size_t system_page_size();
+
+    /**
+     * @brief Returns the physical memory backing part of a region allocated
+     * with @p allocate_resident_memory to the operating system, without
+     * unmapping it. Its contents are lost, and it reads as zeros (and is
+     * populated again) the next time it is accessed.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param memory A pointer to the start of the memory to release, which
+     * must be page-aligned.
+     * @param num_bytes The number of bytes to release.
+     */
+    void release_resident_memory(void* memory, std::size_t num_bytes);
+
     /**
      * @brief Allocates memory directly from the operating system, returning
      * a pointer of the specified type.
@@ -21,12 +21,15 @@
 
 #include "platform/network.hpp"
 
+#include <cerrno>
 #include <cstddef>
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -35,6 +38,12 @@
 
 namespace mage::platform {
     void network_accept(const char* port, int* into, std::uint32_t count) {
+        int server_socket = network_listen(port);
+        network_accept_on(server_socket, into, count);
+        network_close(server_socket);
+    }
+
+    int network_listen(const char* port) {
         struct addrinfo hints = { 0 };
         hints.ai_flags = AI_PASSIVE;
         hints.ai_family = AF_INET;
@@ -43,29 +52,43 @@ namespace mage::platform {
         struct addrinfo* info;
         int rv = getaddrinfo(NULL, port, &hints, &info);
         if (rv != 0) {
-            std::cerr << "network_accept -> getaddrinfo: " << gai_strerror(rv) << std::endl;
+            std::cerr << "network_listen -> getaddrinfo: " << gai_strerror(rv) << std::endl;
             std::abort();
         }
 
         int server_socket = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
         if (server_socket == -1) {
-            std::perror("network_accept -> socket");
+            std::perror("network_listen -> socket");
             std::abort();
         }
 
+        /* Allow quick restarts while old connections are in TIME_WAIT. */
+        int reuseaddr = 1;
+        if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &reuseaddr, sizeof(reuseaddr)) == -1) {
+            std::perror("network_listen -> setsockopt");
+            std::abort();
+        }
 
         if (bind(server_socket, info->ai_addr, info->ai_addrlen) == -1) {
-            std::perror("network_accept -> bind");
+            std::perror("network_listen -> bind");
             std::abort();
         }
 
         freeaddrinfo(info);
 
-        if (listen(server_socket, 0) == -1) {
-            std::perror("network_accept -> listen");
+        /*
+         * Use a full-size backlog so that many peers can connect at once
+         * without being refused before we get around to accepting them.
+         */
+        if (listen(server_socket, SOMAXCONN) == -1) {
+            std::perror("network_listen -> listen");
             std::abort();
         }
 
+        return server_socket;
+    }
+
+    void network_accept_on(int server_socket, int* into, std::uint32_t count) {
         for (std::uint32_t i = 0; i != count; i++) {
             into[i] = accept(server_socket, NULL, NULL);
             if (into[i] == -1) {
@@ -76,15 +99,10 @@ namespace mage::platform {
             /* Maintain firewall state through idle periods. */
             int keepalive = 1;
             if (setsockopt(into[i], SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive)) == -1) {
-                std::perror("network_connect -> setsockopt");
+                std::perror("network_accept -> setsockopt");
                 std::abort();
             }
         }
-
-        if (close(server_socket) == -1) {
-            std::perror("network_accept -> close");
-            std::abort();
-        }
     }
 
     void network_connect(const char* host, const char* port, int* into, NetworkError* err, std::uint32_t count) {
@@ -122,6 +140,9 @@ namespace mage::platform {
                     std::perror("network_connect -> connect");
                     std::abort();
                 }
+                /* Don't leak the socket; the caller may retry many times. */
+                close(into[i]);
+                into[i] = -1;
             } else if (err != nullptr) {
                 err[i] = NetworkError::Success;
             }
@@ -130,6 +151,14 @@ namespace mage::platform {
         freeaddrinfo(info);
     }
 
+    void network_set_nodelay(int socket) {
+        int nodelay = 1;
+        if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+            std::perror("network_set_nodelay -> setsockopt");
+            std::abort();
+        }
+    }
+
     void network_close(int socket) {
         if (close(socket) == -1) {
             std::perror("network_close -> close");
@@ -54,6 +54,34 @@ namespace mage::platform {
      */
     void network_accept(const char* port, int* into, std::uint32_t count = 1);
 
+    /**
+     * @brief Creates a socket that listens for incoming TCP connections on
+     * the specified port.
+     *
+     * Connections that arrive before they are accepted are queued by the
+     * kernel, so peers can connect as soon as this function returns. If an
+     * error occurs, then the process is aborted.
+     *
+     * @param port The port on which to listen for incoming connections,
+     * provided as a string.
+     * @return A file descriptor for the listening socket, which should be
+     * closed using @p network_close once no more connections are expected.
+     */
+    int network_listen(const char* port);
+
+    /**
+     * @brief Accepts the specified number of TCP connections on a socket
+     * created using @p network_listen.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param server_socket The file descriptor of the listening socket.
+     * @param[out] into An array into which to write file descriptors for the
+     * accepted connections.
+     * @param count The number of incoming connections to accept.
+     */
+    void network_accept_on(int server_socket, int* into, std::uint32_t count = 1);
+
     /**
      * @brief Creates the specified number of TCP connections to the endpoint
      * the specified hostname and port.
@@ -78,6 +106,16 @@ namespace mage::platform {
      */
     void network_connect(const char* host, const char* port, int* into, NetworkError* err, std::uint32_t count = 1);
 
+    /**
+     * @brief Disables Nagle's algorithm on a TCP connection, so that small
+     * messages are sent without waiting for earlier data to be acknowledged.
+     *
+     * If an error occurs, then the process is aborted.
+     *
+     * @param socket The file descriptor of the TCP connection.
+     */
+    void network_set_nodelay(int socket);
+
     /**
      * @brief Closes a file descriptor corresponding to a TCP connection,
      * shutting down the connection.
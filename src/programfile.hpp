@@ -27,17 +27,41 @@
 #ifndef MAGE_PROGRAMFILE_HPP_
 #define MAGE_PROGRAMFILE_HPP_
 
+#include <cassert>
 #include <cstdint>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "addr.hpp"
 #include "instruction.hpp"
 #include "util/filebuffer.hpp"
+#include "util/misc.hpp"
+#include "util/userpipe.hpp"
 #include "platform/filesystem.hpp"
 
 namespace mage {
+    /**
+     * @brief Flags stored in the metadata header of a bytecode.
+     */
+    enum ProgramFileFlags : std::uint8_t {
+        /**
+         * @brief Set if some allocations in the program span multiple
+         * contiguous pages, which must be kept contiguous in memory.
+         */
+        ProgramFlagPageSpans = 0x1,
+
+        /**
+         * @brief Set if the program's resident memory limit varies over its
+         * execution, so page frames above the current limit are discarded and
+         * memory should be populated on demand rather than up front.
+         */
+        ProgramFlagMemoryBudget = 0x2,
+    };
+
     /**
      * @brief Header containing metadata at the start of any of MAGE's
      * bytecodes.
@@ -45,9 +69,173 @@ namespace mage {
     struct ProgramFileHeader {
         InstructionNumber num_instructions;
         std::uint64_t num_pages;
-        std::uint64_t num_swap_pages;
+        std::uint64_t num_swap_pages[max_storage_tiers];
         std::uint32_t max_concurrent_swaps;
         PageShift page_shift;
+        std::uint8_t flags;
+    };
+
+    /**
+     * @brief Bounded in-memory queue that carries a bytecode from one stage of
+     * the planner to the next, so that the two stages can run concurrently
+     * without writing the bytecode to a file in between.
+     *
+     * Each instruction occupies a fixed-size slot, so that it can be written
+     * and read in place, and instructions are handed over in batches. A ProgramFileWriter constructed with a ProgramPipe
+     * writes into it, and any number of ProgramFileReader instances
+     * constructed with it, all on the same thread, read from it at their own
+     * positions; exactly one of them, which must never be ahead of the
+     * others, removes instructions from the pipe as it reads them. The
+     * distance between the furthest-behind and furthest-ahead readers must not
+     * exceed the maximum distance given when creating the pipe.
+     *
+     * The metadata header becomes available once the writer writes its first
+     * instruction, with the fields that the writer knows up front (e.g., the
+     * page shift and flags), and is updated with the remaining fields (e.g.,
+     * the number of instructions) when the writer is destroyed.
+     *
+     * @tparam addr_bits,storage_bits Parameters of the type of instruction
+     * carried by the pipe.
+     */
+    template <std::uint8_t addr_bits, std::uint8_t storage_bits>
+    class ProgramPipe {
+    public:
+        /**
+         * @brief The number of instructions handed from the writer to the
+         * readers at a time, to amortize synchronization.
+         */
+        static const constexpr std::size_t batch_size = 1 << 12;
+
+        /**
+         * @brief Creates a ProgramPipe.
+         *
+         * @param max_distance The maximum distance, in instructions, between
+         * the furthest-behind and furthest-ahead readers.
+         * @param slack The number of additional instructions that the writer
+         * may run ahead of the furthest-behind reader.
+         */
+        ProgramPipe(std::size_t max_distance, std::size_t slack)
+            : instructions(util::ceil_div(max_distance + slack, batch_size).first * batch_size + 2 * batch_size),
+            write_batch(nullptr), num_written_in_batch(0), header_ready(false), num_removed(0),
+            num_removed_in_batch(0), num_available(0) {
+        }
+
+        /**
+         * @brief Sets the metadata header, making it available to readers.
+         *
+         * @param h The metadata header.
+         */
+        void publish_header(const ProgramFileHeader& h) {
+            std::lock_guard<std::mutex> lock(this->header_mutex);
+            this->header = h;
+            this->header_ready = true;
+            this->header_published.notify_all();
+        }
+
+        /**
+         * @brief Blocks until the metadata header is available, and then
+         * returns it.
+         *
+         * @return The most recently published metadata header.
+         */
+        ProgramFileHeader wait_for_header() {
+            std::unique_lock<std::mutex> lock(this->header_mutex);
+            while (!this->header_ready) {
+                this->header_published.wait(lock);
+            }
+            return this->header;
+        }
+
+        /**
+         * @brief Hands any remaining instructions to the readers, publishes
+         * the final metadata header, and indicates that no more instructions
+         * will be written.
+         *
+         * @param h The final metadata header.
+         */
+        void close(const ProgramFileHeader& h) {
+            if (this->num_written_in_batch != 0) {
+                this->instructions.finish_write_in_place(this->num_written_in_batch);
+            }
+            this->publish_header(h);
+            this->instructions.close();
+        }
+
+        /**
+         * @brief Returns a reference to a free slot in the pipe, to be
+         * initialized with the next instruction, waiting for free space if
+         * necessary.
+         *
+         * @return A reference to the slot for the next instruction.
+         */
+        PackedInstruction<addr_bits, storage_bits>& start_write() {
+            if (this->num_written_in_batch == 0) {
+                this->write_batch = this->instructions.start_write_in_place(batch_size);
+            }
+            return this->write_batch[this->num_written_in_batch];
+        }
+
+        /**
+         * @brief Adds the instruction initialized via start_write() to the
+         * pipe. Instructions become visible to readers a batch at a time.
+         */
+        void finish_write() {
+            this->num_written_in_batch++;
+            if (this->num_written_in_batch == batch_size) {
+                this->instructions.finish_write_in_place(batch_size);
+                this->num_written_in_batch = 0;
+            }
+        }
+
+        /**
+         * @brief Waits until the instruction with the specified number is in
+         * the pipe, and returns a pointer to it.
+         *
+         * @pre The instruction has not been removed via remove().
+         * @param i The number (index) of the instruction in the bytecode.
+         * @return A pointer to the instruction, or a null pointer if the
+         * bytecode has fewer than @p i + 1 instructions.
+         */
+        const PackedInstruction<addr_bits, storage_bits>* peek(InstructionNumber i) {
+            std::size_t offset = i - this->num_removed;
+            if (offset >= this->num_available) {
+                this->num_available = this->instructions.wait_until_occupied(offset + 1);
+                if (offset >= this->num_available) {
+                    return nullptr;
+                }
+            }
+            return this->instructions.peek_in_place(offset);
+        }
+
+        /**
+         * @brief Removes the oldest instruction from the pipe. Space is
+         * returned to the writer a batch at a time.
+         */
+        void remove() {
+            this->num_removed_in_batch++;
+            if (this->num_removed_in_batch == batch_size) {
+                this->instructions.finish_read_in_place(batch_size);
+                this->num_removed += batch_size;
+                this->num_available -= batch_size;
+                this->num_removed_in_batch = 0;
+            }
+        }
+
+    private:
+        util::UserPipe<PackedInstruction<addr_bits, storage_bits>> instructions;
+
+        /* Used by the writer. */
+        PackedInstruction<addr_bits, storage_bits>* write_batch;
+        std::size_t num_written_in_batch;
+        std::mutex header_mutex;
+        std::condition_variable header_published;
+        ProgramFileHeader header;
+        bool header_ready;
+
+        /* Used by the readers. */
+        InstructionNumber num_removed;
+        std::size_t num_removed_in_batch;
+        std::size_t num_available;
     };
 
     /**
@@ -75,25 +263,43 @@ namespace mage {
          * on).
          */
         ProgramFileWriter(std::string filename, PageShift shift = 0, std::uint64_t num_pages = 0)
-            : util::BufferedFileWriter<backwards_readable>(filename.c_str()), instruction_count(0), page_shift(shift), page_count(num_pages), swap_page_count(0), concurrent_swaps(1) {
-            ProgramFileHeader header = { 0 };
+            : util::BufferedFileWriter<backwards_readable>(filename.c_str()), pipe(nullptr), instruction_count(0), page_shift(shift), page_count(num_pages), swap_page_count{}, concurrent_swaps(1), flags(0) {
+            ProgramFileHeader header = {};
             platform::write_to_file(this->fd, &header, sizeof(header));
         }
 
+        /**
+         * @brief Creates a ProgramFileWriter set up to write to the provided
+         * ProgramPipe instead of a file.
+         *
+         * @param to The ProgramPipe to which to write.
+         * @param shift Describes the page size, and is included in the
+         * metadata header (can be set later on).
+         * @num_pages The number of pages of the address space used by this
+         * bytecode program, included in the metadata header (can be set later
+         * on).
+         */
+        ProgramFileWriter(ProgramPipe<addr_bits, storage_bits>& to, PageShift shift = 0, std::uint64_t num_pages = 0)
+            : pipe(&to), instruction_count(0), page_shift(shift), page_count(num_pages), swap_page_count{}, concurrent_swaps(1), flags(0) {
+        }
+
         /**
          * @brief Writes any remaining buffered data to the file, and then
          * writes the metadata header to the beginning of the file.
+         *
+         * If writing to a ProgramPipe, this instead closes the pipe with the
+         * final metadata header.
          */
         virtual ~ProgramFileWriter() {
+            if (this->pipe != nullptr) {
+                this->pipe->close(this->make_header());
+                return;
+            }
+
             this->flush();
             platform::seek_file(this->fd, 0);
 
-            ProgramFileHeader header = { 0 };
-            header.num_instructions = this->instruction_count;
-            header.num_pages = this->page_count;
-            header.num_swap_pages = this->swap_page_count;
-            header.max_concurrent_swaps = this->concurrent_swaps;
-            header.page_shift = this->page_shift;
+            ProgramFileHeader header = this->make_header();
             platform::write_to_file(this->fd, &header, sizeof(header));
         }
 
@@ -118,13 +324,27 @@ namespace mage {
         }
 
         /**
-         * @brief Sets the number of swap pages used by this program, which
-         * is written to the file as part of the metadata header.
+         * @brief Sets the number of swap pages used by this program in the
+         * specified storage tier, which is written to the file as part of the
+         * metadata header.
          *
          * @param num_swap_pages The number of swap pages uesd by this program.
+         * @param tier The storage tier (see mage::storage_tier).
+         */
+        void set_swap_page_count(std::uint64_t num_swap_pages, std::uint8_t tier = 0) {
+            this->swap_page_count[tier] = num_swap_pages;
+        }
+
+        /**
+         * @brief Sets the number of swap pages used by this program in every
+         * storage tier, which is written to the file as part of the metadata
+         * header.
+         *
+         * @param num_swap_pages Array with the number of swap pages used in
+         * each storage tier.
          */
-        void set_swap_page_count(std::uint64_t num_swap_pages) {
-            this->swap_page_count = num_swap_pages;
+        void set_swap_page_counts(const std::uint64_t (&num_swap_pages)[max_storage_tiers]) {
+            std::copy(&num_swap_pages[0], &num_swap_pages[max_storage_tiers], &this->swap_page_count[0]);
         }
 
         /**
@@ -139,6 +359,16 @@ namespace mage {
             this->concurrent_swaps = max_concurrent_swaps;
         }
 
+        /**
+         * @brief Sets the specified flags (see @p ProgramFileFlags) in the
+         * metadata header.
+         *
+         * @param to_set The flags to set.
+         */
+        void set_flags(std::uint8_t to_set) {
+            this->flags |= to_set;
+        }
+
         /**
          * @brief Sets the page shift, describing the page size, which is
          * written to the file as part of the metadata header.
@@ -158,6 +388,13 @@ namespace mage {
          * initialized with the new instruction.
          */
         PackedInstruction<addr_bits, storage_bits>& start_instruction(std::size_t maximum_size = sizeof(PackedInstruction<addr_bits, storage_bits>)) {
+            if (this->pipe != nullptr) {
+                /* By now, the caller has set every field it knows up front. */
+                if (this->instruction_count == 0) {
+                    this->pipe->publish_header(this->make_header());
+                }
+                return this->pipe->start_write();
+            }
             return this->template start_write<PackedInstruction<addr_bits, storage_bits>>(maximum_size);
         }
 
@@ -170,7 +407,11 @@ namespace mage {
          * which may be less than the size allocated by start_instruction().
          */
         void finish_instruction(std::size_t actual_size) {
-            this->finish_write(actual_size);
+            if (this->pipe != nullptr) {
+                this->pipe->finish_write();
+            } else {
+                this->finish_write(actual_size);
+            }
             this->instruction_count++;
         }
 
@@ -187,17 +428,33 @@ namespace mage {
         }
 
     private:
+        ProgramFileHeader make_header() const {
+            ProgramFileHeader header = {};
+            header.num_instructions = this->instruction_count;
+            header.num_pages = this->page_count;
+            std::copy(&this->swap_page_count[0], &this->swap_page_count[max_storage_tiers], &header.num_swap_pages[0]);
+            header.max_concurrent_swaps = this->concurrent_swaps;
+            header.page_shift = this->page_shift;
+            header.flags = this->flags;
+            return header;
+        }
+
+        ProgramPipe<addr_bits, storage_bits>* pipe;
         std::uint64_t instruction_count;
         std::uint64_t page_count;
-        std::uint64_t swap_page_count;
+        std::uint64_t swap_page_count[max_storage_tiers];
         std::uint32_t concurrent_swaps;
         PageShift page_shift;
+        std::uint8_t flags;
     };
 
     /**
      * @brief Tool for reading a bytecode (sometimes referred to as a
      * program file).
      *
+     * The next chunk of the file is read on a helper thread while the current
+     * one is being processed.
+     *
      * @tparam addr_bits,storage_bits Parameters of the type of instruction
      * being read.
      * @tparam backwards_readable True if size markers are present in the file
@@ -213,9 +470,23 @@ namespace mage {
          * @param filename The name of the file containing the MAGE bytecode
          * program to read.
          */
-        ProgramFileReader(std::string filename) : util::BufferedFileReader<backwards_readable>(filename.c_str()) {
+        ProgramFileReader(std::string filename) : util::BufferedFileReader<backwards_readable>(filename.c_str()), pipe(nullptr), remove_read(false), num_read(0) {
             platform::read_from_file(this->fd, &this->header, sizeof(this->header));
-            this->set_readahead(true); // reset prefetch offset
+            this->enable_background_readahead();
+        }
+
+        /**
+         * @brief Creates a ProgramFileReader to read instructions from the
+         * provided ProgramPipe instead of a file.
+         *
+         * This blocks until the pipe's metadata header is available.
+         *
+         * @param from The ProgramPipe from which to read.
+         * @param remove If true, instructions are removed from the pipe once
+         * read; exactly one reader of each pipe must do so.
+         */
+        ProgramFileReader(ProgramPipe<addr_bits, storage_bits>& from, bool remove) : pipe(&from), remove_read(remove), num_read(0) {
+            this->header = from.wait_for_header();
         }
 
         /**
@@ -239,6 +510,10 @@ namespace mage {
          * progress bar should be advanced.
          */
         void set_progress_bar(util::ProgressBar* pb) {
+            /* The length of a pipe is not known in advance. */
+            if (this->pipe != nullptr) {
+                return;
+            }
             if (pb != nullptr) {
                 pb->reset(platform::length_file(this->fd) - sizeof(this->header));
             }
@@ -249,12 +524,20 @@ namespace mage {
          * @brief Reads data containing the next instruction into a local
          * buffer and return a reference to it.
          *
+         * @pre There is a next instruction (i.e., at_end() is false).
          * @param maximum_size An upper bound on the size of the next
          * instruction.
          * @return A reference to a local buffer containing the next
          * instruction.
          */
         PackedInstruction<addr_bits, storage_bits>& start_instruction(std::size_t maximum_size = sizeof(PackedInstruction<addr_bits, storage_bits>)) {
+            if (this->pipe != nullptr) {
+                const PackedInstruction<addr_bits, storage_bits>* next = this->pipe->peek(this->num_read);
+                assert(next != nullptr);
+                const std::uint8_t* next_start = reinterpret_cast<const std::uint8_t*>(next);
+                std::copy(next_start, next_start + next->size(), reinterpret_cast<std::uint8_t*>(&this->current));
+                return this->current;
+            }
             return this->template start_read<PackedInstruction<addr_bits, storage_bits>>(maximum_size);
         }
 
@@ -266,7 +549,36 @@ namespace mage {
          * may be smaller than the maximum size given to start_instruction().
          */
         void finish_instruction(std::size_t actual_size) {
-            this->finish_read(actual_size);
+            if (this->pipe != nullptr) {
+                if (this->remove_read) {
+                    this->pipe->remove();
+                }
+            } else {
+                this->finish_read(actual_size);
+            }
+            this->num_read++;
+        }
+
+        /**
+         * @brief Checks if every instruction in the bytecode program has been
+         * read.
+         *
+         * When reading from a ProgramPipe, this blocks until either the next
+         * instruction is written or the pipe is closed, in which case the
+         * metadata header is updated with its final contents.
+         *
+         * @return True if there are no more instructions to read, otherwise
+         * false.
+         */
+        bool at_end() {
+            if (this->pipe != nullptr) {
+                if (this->pipe->peek(this->num_read) != nullptr) {
+                    return false;
+                }
+                this->header = this->pipe->wait_for_header();
+                return true;
+            }
+            return this->num_read == this->header.num_instructions;
         }
 
         /**
@@ -289,6 +601,10 @@ namespace mage {
 
     private:
         ProgramFileHeader header;
+        ProgramPipe<addr_bits, storage_bits>* pipe;
+        bool remove_read;
+        InstructionNumber num_read;
+        PackedInstruction<addr_bits, storage_bits> current;
     };
 
     /**
@@ -316,6 +632,7 @@ namespace mage {
         ProgramReverseFileReader(std::string filename) : util::BufferedReverseFileReader<backwards_readable>(filename.c_str()) {
             platform::seek_file(this->fd, 0);
             platform::read_from_file(this->fd, &this->header, sizeof(this->header));
+            this->enable_background_readahead();
         }
 
         /**
@@ -397,6 +714,12 @@ namespace mage {
       * instructions referencing physical addresses (physical byte code).
       */
      using PhysProgramFileReader = ProgramFileReader<physical_address_bits, storage_address_bits, false>;
+
+     /**
+      * @brief Instantiation of the ProgramPipe template to carry instructions
+      * referencing physical addresses (physical byte code).
+      */
+     using PhysProgramPipe = ProgramPipe<physical_address_bits, storage_address_bits>;
 }
 
 #endif
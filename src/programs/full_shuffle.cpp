@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dsl/array.hpp"
+#include "dsl/integer.hpp"
+#include "dsl/shuffle.hpp"
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+
+using namespace mage::dsl;
+
+namespace mage::programs::full_shuffle {
+    template <BitWidth key_width = 32, BitWidth record_width = 128>
+    void create_full_shuffle_circuit(const ProgramOptions& args) {
+        ShardedArray<Record<key_width, record_width>> list(args.problem_size, args.worker_index, args.num_workers, Layout::Blocked);
+        list.for_each([=](std::size_t i, auto& elem) {
+            elem.data.mark_input(Party::Garbler);
+        });
+
+        program_ptr->print_stats();
+        program_ptr->start_timer();
+
+        /* The evaluator chooses the permutation. */
+        auto get_switch = []() -> Bit {
+            Bit control;
+            control.mark_input(Party::Evaluator);
+            return control;
+        };
+        parallel_waksman_shuffle(list, get_switch);
+
+        program_ptr->stop_timer();
+        program_ptr->print_stats();
+
+        list.for_each([=](std::size_t i, auto& elem) {
+            elem.data.mark_output();
+        });
+    }
+
+    RegisterProgram full_shuffle("full_shuffle", "Oblivious shuffle with a Waksman/Clos network (problem_size = number of elements)", create_full_shuffle_circuit<>);
+}
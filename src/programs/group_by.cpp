@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dsl/array.hpp"
+#include "dsl/groupby.hpp"
+#include "dsl/integer.hpp"
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+
+using namespace mage::dsl;
+
+namespace mage::programs::group_by {
+    template <Aggregate op, BitWidth key_width = 32, BitWidth value_width = 32>
+    void create_group_by_circuit(const ProgramOptions& args) {
+        using Entry = GroupByEntry<key_width, value_width, DefaultPlacer, default_program>;
+        int input_array_length = args.problem_size * 2;
+
+        ShardedArray<Entry> entries(input_array_length, args.worker_index, args.num_workers, Layout::Cyclic);
+        entries.for_each([=](std::size_t i, auto& entry) {
+            entry.key.mark_input(i < args.problem_size ? Party::Garbler : Party::Evaluator);
+            entry.value.mark_input(i < args.problem_size ? Party::Garbler : Party::Evaluator);
+        });
+
+        program_ptr->print_stats();
+        program_ptr->start_timer();
+
+        parallel_group_by_aggregate(entries, op);
+
+        program_ptr->stop_timer();
+        program_ptr->print_stats();
+
+        /* Only reveal the aggregate of each group. */
+        Integer<value_width> zero(0);
+        entries.for_each([&](std::size_t i, auto& entry) {
+            entry.key.mark_output();
+            entry.last.mark_output();
+            Integer<value_width> aggregate = Integer<value_width>::select(entry.last, entry.value, zero);
+            aggregate.mark_output();
+        });
+    }
+
+    RegisterProgram group_by_sum("group_by_sum", "Sum of values grouped by key (problem_size = number of records per party)", create_group_by_circuit<Aggregate::Sum>);
+    RegisterProgram group_by_count("group_by_count", "Number of records grouped by key (problem_size = number of records per party)", create_group_by_circuit<Aggregate::Count>);
+    RegisterProgram group_by_min("group_by_min", "Minimum value grouped by key (problem_size = number of records per party)", create_group_by_circuit<Aggregate::Min>);
+    RegisterProgram group_by_max("group_by_max", "Maximum value grouped by key (problem_size = number of records per party)", create_group_by_circuit<Aggregate::Max>);
+}
@@ -19,9 +19,14 @@
  * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <iostream>
 #include <vector>
 #include "dsl/array.hpp"
+#include "dsl/compact.hpp"
 #include "dsl/integer.hpp"
 #include "dsl/parallel.hpp"
 #include "dsl/sort.hpp"
@@ -36,6 +41,13 @@ namespace mage::programs::loop_join {
         Bit valid;
         Record<t1_key_width, t1_record_width> t1_record;
         Record<t2_key_width, t2_record_width> t2_record;
+
+        template <bool predicate_sliced>
+        static void swap_if(const mage::dsl::Bit<predicate_sliced, DefaultPlacer, default_program>& predicate, JoinedRecords& arg0, JoinedRecords& arg1) {
+            Bit::swap_if(predicate, arg0.valid, arg1.valid);
+            Record<t1_key_width, t1_record_width>::swap_if(predicate, arg0.t1_record, arg1.t1_record);
+            Record<t2_key_width, t2_record_width>::swap_if(predicate, arg0.t2_record, arg1.t2_record);
+        }
     };
 
     template <BitWidth t1_key_width = 32, BitWidth t1_record_width = 128, BitWidth t2_key_width = 32, BitWidth t2_record_width = 128>
@@ -63,7 +75,34 @@ namespace mage::programs::loop_join {
         return joined;
     }
 
-    template <BitWidth key_width = 32, BitWidth record_width = 128>
+    /**
+     * @brief Computes how many records of its compacted part of the join
+     * each worker outputs.
+     *
+     * By default, each worker outputs all of its compacted part of the
+     * result. If the join_result_size key is set in the worker's
+     * configuration, only that prefix of the compacted result is output; it
+     * must then be a public upper bound on the number of matches in each
+     * worker's part of the result (see create_loop_join_circuit for how a
+     * violation of that bound is reported).
+     *
+     * @param args The options with which the program was invoked.
+     * @param local_join_size The size of this worker's part of the result.
+     * @return The number of records that this worker outputs.
+     */
+    std::size_t compacted_result_size(const ProgramOptions& args, std::size_t local_join_size) {
+        if (args.worker_config == nullptr || args.worker_config->get("join_result_size") == nullptr) {
+            return local_join_size;
+        }
+        std::int64_t result_size = (*args.worker_config)["join_result_size"].as_int();
+        if (result_size <= 0) {
+            std::cerr << "join_result_size must be positive" << std::endl;
+            std::abort();
+        }
+        return std::min(static_cast<std::size_t>(result_size), local_join_size);
+    }
+
+    template <BitWidth key_width = 32, BitWidth record_width = 128, bool compact_result = false>
     void create_loop_join_circuit(const ProgramOptions& args) {
         int input_array_length = args.problem_size * 2;
 
@@ -188,15 +227,36 @@ namespace mage::programs::loop_join {
             return key1 < key2;
         });
 
+        std::size_t result_size = joined.size();
+        if constexpr (compact_result) {
+            /* Move the matching records to the front of this worker's part of the result. */
+            compact<Integer<32>>(joined, [](auto& record) -> Bit& {
+                return record.valid;
+            });
+            result_size = compacted_result_size(args, joined.size());
+        }
+
         program_ptr->stop_timer();
         program_ptr->print_stats();
 
-        for (int i = 0; i != joined.size(); i++) {
+        for (int i = 0; i != result_size; i++) {
             joined[i].valid.mark_output();
             joined[i].t1_record.data.mark_output();
             joined[i].t2_record.data.mark_output();
         }
+
+        if (result_size != joined.size()) {
+            /*
+             * The number of matches is secret, so the planner cannot check it
+             * against join_result_size. Since the matches are at the front
+             * after compaction, the first record past the output prefix is
+             * valid exactly when matches were dropped. Output that bit last;
+             * if it is set, the output is a partial join and must be rejected.
+             */
+            joined[result_size].valid.mark_output();
+        }
     }
 
     RegisterProgram loop_join("loop_join", "Join two tables on non-equality condition (problem_size = number of records per party)", create_loop_join_circuit<>);
+    RegisterProgram loop_join_compact("loop_join_compact", "Join two tables on non-equality condition, outputting a compacted prefix of each worker's result (problem_size = number of records per party)", create_loop_join_circuit<32, 128, true>);
 }
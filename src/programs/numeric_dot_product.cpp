@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dsl/array.hpp"
+#include "dsl/fixed.hpp"
+#include "dsl/float.hpp"
+#include "dsl/parallel.hpp"
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+
+using namespace mage::dsl;
+
+namespace mage::programs::numeric_dot_product {
+    template <typename Number>
+    void create_dot_product_circuit(const ProgramOptions& args) {
+        using Raw = typename Number::Raw;
+        std::uint64_t vector_size = args.problem_size;
+
+        ClusterUtils utils;
+        utils.self_id = args.worker_index;
+        utils.num_proc = args.num_workers;
+
+        /* Blocked vectors, one provided by each party. */
+        ShardedArray<Number> vector_a(vector_size, args.worker_index, args.num_workers, Layout::Blocked);
+        vector_a.for_each([=](std::size_t i, auto& elem) {
+            elem.mark_input(Party::Garbler);
+        });
+        ShardedArray<Number> vector_b(vector_size, args.worker_index, args.num_workers, Layout::Blocked);
+        vector_b.for_each([=](std::size_t i, auto& elem) {
+            elem.mark_input(Party::Evaluator);
+        });
+
+        program_ptr->print_stats();
+        program_ptr->start_timer();
+
+        std::vector<Number>& locals_a = vector_a.get_locals();
+        std::vector<Number>& locals_b = vector_b.get_locals();
+        Number local_result(0.0);
+        for (std::size_t i = 0; i != locals_a.size(); i++) {
+            local_result += locals_a[i] * locals_b[i];
+        }
+
+        /* Workers exchange the underlying representations of partial sums. */
+        std::optional<Raw> global_result = utils.reduce_aggregates<Raw>(0, local_result.raw(), [](Raw& a, Raw& b) -> Raw {
+            Number sum = Number(std::move(a)) + Number(std::move(b));
+            return std::move(sum.raw());
+        });
+
+        program_ptr->stop_timer();
+        program_ptr->print_stats();
+
+        if (args.worker_index == 0) {
+            global_result->mark_output();
+        }
+    }
+
+    RegisterProgram fixed_dot_product("fixed_dot_product", "Dot product of fixed-point vectors with 16 integer and 16 fractional bits (problem_size = number of elements in each vector)", create_dot_product_circuit<Fixed<16, 16>>);
+    RegisterProgram float_dot_product("float_dot_product", "Dot product of single-precision floating-point vectors (problem_size = number of elements in each vector)", create_dot_product_circuit<Float>);
+}
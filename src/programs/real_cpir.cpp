@@ -29,6 +29,7 @@
 using namespace mage::dsl;
 
 namespace mage::programs::real_cpir {
+    template <bool preencoded>
     void create_real_cpir_circuit(const ProgramOptions& args) {
         int num_sets = args.problem_size;
         int set_size = args.problem_size;
@@ -40,7 +41,11 @@ namespace mage::programs::real_cpir {
 
         ShardedArray<LeveledPlaintextBatch<1>> inputs(input_array_length, args.worker_index, args.num_workers, Layout::Blocked);
         inputs.for_each([=](std::size_t i, auto& input) {
-            input = LeveledPlaintextBatch<1>(static_cast<double>(i + 1));
+            if constexpr(preencoded) {
+                input.mark_input();
+            } else {
+                input = LeveledPlaintextBatch<1>(static_cast<double>(i + 1));
+            }
         });
 
         program_ptr->print_stats();
@@ -59,10 +64,7 @@ namespace mage::programs::real_cpir {
         }
 
         for (std::size_t i = 0; i != locals.size(); i += set_size) {
-            LeveledBatch<1, false> set_response = set_request[0].multiply_without_normalizing(locals[i]);
-            for (std::size_t j = 1; j != set_size; j++) {
-                set_response = set_response + set_request[j].multiply_without_normalizing(locals[i + j]);
-            }
+            LeveledBatch<1, false> set_response = LeveledBatch<1, true>::dot_product_without_normalizing(set_request.data(), &locals[i], set_size);
             set_response.renormalize().mark_output();
         }
 
@@ -70,5 +72,6 @@ namespace mage::programs::real_cpir {
         program_ptr->print_stats();
     }
 
-    RegisterProgram real_cpir("real_cpir", "Perform computational PIR on an array of real numbers (problem_size = square root of the number of elements)", create_real_cpir_circuit);
+    RegisterProgram real_cpir("real_cpir", "Perform computational PIR on an array of real numbers (problem_size = square root of the number of elements)", create_real_cpir_circuit<false>);
+    RegisterProgram real_cpir_preencoded("real_cpir_preencoded", "Perform computational PIR on an array of real numbers, reading the database as pre-encoded plaintexts (problem_size = square root of the number of elements)", create_real_cpir_circuit<true>);
 }
@@ -74,10 +74,9 @@ namespace mage::programs::real_statistics {
             local.sum = LeveledBatch<2, true>(0);
             local.sum_squares = LeveledBatch<1, true>(0);
         } else {
-            LeveledBatch<2, false> temp = locals[0].multiply_without_normalizing(locals[0]);
+            LeveledBatch<2, false> temp = LeveledBatch<2, true>::dot_product_without_normalizing(locals.data(), locals.data(), locals.size());
             local.sum = std::move(locals[0]);
             for (std::size_t i = 1; i != locals.size(); i++) {
-                temp = temp + locals[i].multiply_without_normalizing(locals[i]);
                 local.sum = local.sum + locals[i];
             }
             local.sum_squares = temp.renormalize();
@@ -23,6 +23,8 @@
 #define MAGE_PROGRAMS_UTIL_HPP_
 
 #include "dsl/leveledbatch.hpp"
+#include "dsl/fixed.hpp"
+#include "dsl/float.hpp"
 #include "dsl/integer.hpp"
 
 using namespace mage::dsl;
@@ -40,6 +42,12 @@ namespace mage::programs {
     using Bit = Integer<1>;
     using BitSlice = IntSlice<1>;
 
+    template <BitWidth int_bits, BitWidth frac_bits>
+    using Fixed = mage::dsl::Fixed<int_bits, frac_bits, memprog::BinnedPlacer, default_program>;
+
+    /* Same layout as IEEE 754 single precision. */
+    using Float = mage::dsl::Float<8, 23, memprog::BinnedPlacer, default_program>;
+
     template <std::uint32_t level, bool normalized>
     using LeveledBatch = mage::dsl::LeveledBatch<level, normalized, memprog::BinnedPlacer, default_program>;
 
@@ -59,11 +67,7 @@ namespace mage::programs {
     template <std::int32_t level>
     LeveledBatch<level + 1, false> real_dot_product_not_normalized(LeveledBatch<level + 1, true>* vector_a, LeveledBatch<level + 1, true>* vector_b, std::size_t length) {
         assert(length != 0);
-        LeveledBatch<level + 1, false> total = vector_a[0].multiply_without_normalizing(vector_b[0]);
-        for (std::size_t i = 1; i != length; i++) {
-            total = total + vector_a[i].multiply_without_normalizing(vector_b[i]);
-        }
-        return total;
+        return LeveledBatch<level + 1, true>::dot_product_without_normalizing(vector_a, vector_b, length);
     }
 
     template <std::int32_t level>
@@ -91,6 +95,11 @@ namespace mage::programs {
             Integer<record_width>::swap_if(predicate, arg0.data, arg1.data);
         }
 
+        template <bool predicate_sliced>
+        static void swap_if(const mage::dsl::Bit<predicate_sliced, DefaultPlacer, default_program>& predicate, Record<key_width, record_width>& arg0, Record<key_width, record_width>& arg1) {
+            Integer<record_width>::swap_if(predicate, arg0.data, arg1.data);
+        }
+
         void buffer_send(WorkerID to) {
             this->data.buffer_send(to);
         }
@@ -32,13 +32,14 @@ namespace mage::protocols::ckks {
         std::string prog_file = file_base + ".memprog";
         std::string output_file = file_base + ".output";
         std::string input_file = file_base + "_garbler.input";
+        std::string plaintext_input_file = file_base + "_plaintext.input";
 
         std::chrono::time_point<std::chrono::steady_clock> start;
         std::chrono::time_point<std::chrono::steady_clock> end;
 
         util::Configuration& c = *args.config;
         {
-            CKKSEngine p(input_file.c_str(), output_file.c_str());
+            CKKSEngine p(input_file.c_str(), plaintext_input_file.c_str(), output_file.c_str());
             engine::AddMultiplyEngine executor(args.cluster, c["parties"][args.party_id]["workers"][args.self_id], p, prog_file.c_str());
             start = std::chrono::steady_clock::now();
             executor.execute_program();
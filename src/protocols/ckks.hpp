@@ -51,9 +51,9 @@ namespace mage::protocols::ckks {
     public:
         using Wire = std::uint8_t;
 
-        CKKSEngine(const char* input_file, const char* output_file)
-            : parms(parms_from_file("parms.ckks")), context(parms), evaluator(context), encoder(context),
-              input_reader(input_file, std::ios::binary), output_writer(output_file, std::ios::binary),
+        CKKSEngine(const char* input_file, const char* plaintext_input_file, const char* output_file)
+            : parms(parms_from_file("parms.ckks")), context(parms), evaluator(context), encoder(context), accumulator_valid(false),
+              input_reader(input_file, std::ios::binary), plaintext_input_reader(plaintext_input_file, std::ios::binary), output_writer(output_file, std::ios::binary),
               serialize_stats("CKKS-SERIALIZE", true), deserialize_stats("CKKS-DESERIALIZE", true) {
             std::ifstream relin_file("relinkeys.ckks");
             this->relin_keys.load(this->context, relin_file);
@@ -65,15 +65,30 @@ namespace mage::protocols::ckks {
         }
 
         void input(std::uint8_t* buffer, std::int32_t level, bool normalized) {
-            if (level == -1) {
-                std::cerr << "TODO: handle plaintext" << std::endl;
-                std::abort();
-            }
+            /*
+             * Seeded inputs (from ckks_utils encrypt_file_symmetric) are
+             * expanded to full ciphertexts by load().
+             */
             seal::Ciphertext c;
             c.load(this->context, this->input_reader);
             this->serialize(c, buffer, level, normalized);
         }
 
+        void input_plaintext(std::uint8_t* buffer, std::int32_t level) {
+            if (!this->plaintext_input_reader.is_open()) {
+                std::cerr << "Program reads a pre-encoded plaintext, but there is no plaintext input file" << std::endl;
+                std::abort();
+            }
+            seal::Plaintext p;
+            p.load(this->context, this->plaintext_input_reader);
+            auto context_data = this->context.get_context_data(p.parms_id());
+            if (!context_data || context_data->chain_index() != static_cast<std::size_t>(level)) {
+                std::cerr << "Pre-encoded plaintext is not at level " << level << " (re-encode it with ckks_utils encode_file)" << std::endl;
+                std::abort();
+            }
+            this->serialize(p, buffer, level);
+        }
+
         void output(const std::uint8_t* buffer, std::int32_t level, bool normalized) {
             seal::Ciphertext c;
             this->deserialize(c, buffer, level, normalized);
@@ -163,6 +178,43 @@ namespace mage::protocols::ckks {
             this->serialize(c, output, level, false);
         }
 
+        void op_multiply_accumulate_raw(const std::uint8_t* input1, const std::uint8_t* input2, std::int32_t level) {
+            seal::Ciphertext c;
+
+            seal::Ciphertext a;
+            this->deserialize(a, input1, level, true);
+
+            if (input1 == input2) {
+                this->evaluator.square(a, c);
+            } else {
+                seal::Ciphertext b;
+                this->deserialize(b, input2, level, true);
+                this->evaluator.multiply(a, b, c);
+            }
+            this->accumulate(c);
+        }
+
+        void op_multiply_plaintext_accumulate_raw(const std::uint8_t* input1, const std::uint8_t* input2, std::int32_t level) {
+            seal::Ciphertext a;
+            this->deserialize(a, input1, level, true);
+
+            seal::Plaintext b;
+            this->deserialize(b, input2, level);
+
+            seal::Ciphertext c;
+            this->evaluator.multiply_plain(a, b, c);
+            this->accumulate(c);
+        }
+
+        void op_store_accumulator(std::uint8_t* output, std::int32_t level) {
+            if (!this->accumulator_valid) {
+                std::cerr << "StoreAccumulator executed with no accumulated products" << std::endl;
+                std::abort();
+            }
+            this->serialize(this->accumulator, output, level, false);
+            this->accumulator_valid = false;
+        }
+
         void op_normalize(std::uint8_t* output, const std::uint8_t* input, std::int32_t level) {
             seal::Ciphertext c;
             this->deserialize(c, input, level + 1, false);
@@ -204,6 +256,15 @@ namespace mage::protocols::ckks {
         }
 
     private:
+        void accumulate(seal::Ciphertext& product) {
+            if (this->accumulator_valid) {
+                this->evaluator.add_inplace(this->accumulator, product);
+            } else {
+                this->accumulator = std::move(product);
+                this->accumulator_valid = true;
+            }
+        }
+
         void serialize(seal::Ciphertext& c, std::uint8_t* buffer, std::int32_t level, bool normalized) {
             auto start = std::chrono::steady_clock::now();
             std::size_t buffer_size = ciphertext_size(level, normalized);
@@ -250,7 +311,15 @@ namespace mage::protocols::ckks {
         seal::CKKSEncoder encoder;
         seal::RelinKeys relin_keys;
 
+        /*
+         * Running sum of products for fused dot products, kept in memory
+         * (rather than in MAGE-virtual memory) until StoreAccumulator.
+         */
+        seal::Ciphertext accumulator;
+        bool accumulator_valid;
+
         std::ifstream input_reader;
+        std::ifstream plaintext_input_reader;
         std::ofstream output_writer;
 
         util::StreamStats serialize_stats;
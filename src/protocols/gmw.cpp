@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "protocols/gmw.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "addr.hpp"
+#include "crypto/block.hpp"
+#include "crypto/ot/random.hpp"
+#include "crypto/prg.hpp"
+#include "engine/andxor.hpp"
+#include "platform/affinity.hpp"
+#include "platform/network.hpp"
+#include "protocols/registry.hpp"
+#include "util/filebuffer.hpp"
+
+namespace mage::protocols::gmw {
+    static inline void set_bit(std::uint8_t* bits, std::size_t index, std::uint8_t value) {
+        bits[index >> 3] |= (value << (index & 0x7));
+    }
+
+    static inline std::uint8_t get_bit(const std::uint8_t* bits, std::size_t index) {
+        return (bits[index >> 3] >> (index & 0x7)) & 0x1;
+    }
+
+    GMWEngine::GMWEngine(bool garbler, const char* input_file, const char* output_file, const char* evaluator_host, const char* evaluator_port, const TripleInfo& ti)
+        : is_garbler(garbler), constant_share(garbler ? 0 : 1), input_reader(input_file), sockets(ti.num_daemons + 1),
+        input_mask_bits_left(0), pending_output_bytes(0), triple_daemon_threads(ti.num_daemons), triple_daemon_index(0),
+        triple_batch_size(ti.batch_size), triple_batch_blocks(ti.batch_size / crypto::block_num_bits), triple_batch(nullptr),
+        triple_index(ti.batch_size), round_a(gmw_max_round_size), round_b(gmw_max_round_size), round_c(gmw_max_round_size),
+        round_opened(2 * ((gmw_max_round_size + 7) >> 3)), num_and_gates(0), num_rounds(0) {
+        if (garbler) {
+            this->output_writer = std::make_unique<util::BinaryFileWriter>(output_file);
+            platform::network_connect(evaluator_host, evaluator_port, this->sockets.data(), nullptr, this->sockets.size());
+        } else {
+            platform::network_accept(evaluator_port, this->sockets.data(), this->sockets.size());
+        }
+        this->conn_reader.set_file_descriptor(this->sockets[0], false);
+        this->conn_writer.set_file_descriptor(this->sockets[0], false);
+        for (std::size_t i = 0; i != this->triple_daemon_threads.size(); i++) {
+            this->triple_daemon_threads[i] = std::make_unique<TripleDaemonThread>(this->triple_batch_blocks, ti.pipeline_depth);
+            this->triple_daemon_threads[i]->ot_conn_reader.set_file_descriptor(this->sockets[1 + i], false);
+            this->triple_daemon_threads[i]->ot_conn_writer.set_file_descriptor(this->sockets[1 + i], false);
+        }
+
+        this->conn_reader.enable_stats("GATE-RECV (ns)");
+        crypto::block input_seed;
+        if (garbler) {
+            crypto::PRG seed_prg;
+            seed_prg.random_block(&input_seed);
+            this->conn_writer.write<crypto::block>() = input_seed;
+            this->conn_writer.flush();
+        } else {
+            input_seed = this->conn_reader.read<crypto::block>();
+        }
+        this->input_prg = crypto::PRG(&input_seed);
+
+        this->start_triple_daemons(ti.batch_size);
+    }
+
+    GMWEngine::~GMWEngine() {
+        if (this->is_garbler) {
+            this->receive_pending_output();
+        } else {
+            this->conn_writer.flush();
+        }
+        this->conn_reader.relinquish_file_descriptor();
+        this->conn_writer.relinquish_file_descriptor();
+        for (std::size_t i = 0; i != this->triple_daemon_threads.size(); i++) {
+            this->triple_daemon_threads[i]->triples.close();
+            this->triple_daemon_threads[i]->thread.join();
+            this->triple_daemon_threads[i]->ot_conn_reader.relinquish_file_descriptor();
+            this->triple_daemon_threads[i]->ot_conn_writer.relinquish_file_descriptor();
+        }
+        for (std::size_t i = 0; i != this->sockets.size(); i++) {
+            platform::network_close(this->sockets[i]);
+        }
+    }
+
+    void GMWEngine::print_stats() {
+        std::cout << this->conn_reader.get_stats() << std::endl;
+        std::cout << this->num_and_gates << " AND gates in " << this->num_rounds << " rounds" << std::endl;
+    }
+
+    std::uint64_t GMWEngine::get_bytes_sent() const {
+        std::uint64_t total = this->conn_writer.get_bytes_written();
+        for (const auto& daemon : this->triple_daemon_threads) {
+            total += daemon->ot_conn_writer.get_bytes_written();
+        }
+        return total;
+    }
+
+    std::uint64_t GMWEngine::get_bytes_received() const {
+        std::uint64_t total = this->conn_reader.get_bytes_read();
+        for (const auto& daemon : this->triple_daemon_threads) {
+            total += daemon->ot_conn_reader.get_bytes_read();
+        }
+        return total;
+    }
+
+    void GMWEngine::start_triple_daemons(std::size_t batch_size) {
+        for (std::size_t i = 0; i != this->triple_daemon_threads.size(); i++) {
+            TripleDaemonThread* daemon = this->triple_daemon_threads[i].get();
+            daemon->thread = std::thread([=]() {
+                platform::pin_thread(platform::ThreadRole::OTDaemon);
+
+                util::BufferedFileReader<false>& in = daemon->ot_conn_reader;
+                util::BufferedFileWriter<false>& out = daemon->ot_conn_writer;
+
+                /*
+                 * Each party is the sender in one OT extension instance and
+                 * the chooser in the other; the garbler's sender is paired
+                 * with the evaluator's chooser, and vice versa.
+                 */
+                crypto::ot::RandomExtensionSender ot_sender;
+                crypto::ot::RandomExtensionChooser ot_chooser;
+                if (this->is_garbler) {
+                    ot_sender.initialize(in, out);
+                    ot_chooser.initialize(in, out);
+                } else {
+                    ot_chooser.initialize(in, out);
+                    ot_sender.initialize(in, out);
+                }
+
+                std::size_t num_blocks = this->triple_batch_blocks;
+                std::vector<crypto::block> discard(3 * num_blocks);
+                std::vector<crypto::block> first(num_blocks);
+                std::vector<crypto::block> second(num_blocks);
+                std::vector<crypto::block> chosen(num_blocks);
+                crypto::PRG prg;
+
+                while (true) {
+                    /*
+                     * The garbler decides whether to generate each batch, so
+                     * that both parties' daemons stop after the same batch.
+                     * The evaluator generates the batch even if its engine has
+                     * already finished, discarding the triples.
+                     */
+                    crypto::block* batch;
+                    if (this->is_garbler) {
+                        batch = daemon->triples.start_write_in_place(3 * num_blocks);
+                        out.write<std::uint8_t>() = (batch == nullptr) ? 0 : 1;
+                        out.flush();
+                        if (batch == nullptr) {
+                            break;
+                        }
+                    } else {
+                        if (in.read<std::uint8_t>() == 0) {
+                            break;
+                        }
+                        batch = daemon->triples.start_write_in_place(3 * num_blocks);
+                    }
+                    crypto::block* a = (batch == nullptr) ? discard.data() : batch;
+                    crypto::block* b = a + num_blocks;
+                    crypto::block* c = b + num_blocks;
+
+                    prg.random_block(a, num_blocks);
+                    if (this->is_garbler) {
+                        ot_sender.send_bits(in, first.data(), second.data(), batch_size);
+                        ot_chooser.choose_bits(out, a, chosen.data(), batch_size);
+                    } else {
+                        ot_chooser.choose_bits(out, a, chosen.data(), batch_size);
+                        ot_sender.send_bits(in, first.data(), second.data(), batch_size);
+                    }
+
+                    /*
+                     * With random OT messages (m0, m1), set b = m0 XOR m1, so
+                     * m0 XOR (a' AND b) is what the other party, choosing
+                     * with its own a', received. Then the cross terms of
+                     * (a XOR a') AND (b XOR b') cancel when c is shared as
+                     * (a AND b) XOR chosen XOR m0.
+                     */
+                    for (std::size_t j = 0; j != num_blocks; j++) {
+                        b[j] = crypto::xorBlocks(first[j], second[j]);
+                        c[j] = crypto::xorBlocks(crypto::andBlocks(a[j], b[j]), crypto::xorBlocks(chosen[j], first[j]));
+                    }
+
+                    if (batch != nullptr) {
+                        daemon->triples.finish_write_in_place(3 * num_blocks);
+                    }
+                }
+            });
+        }
+    }
+
+    void GMWEngine::next_triple_batch() {
+        if (this->triple_batch != nullptr) {
+            this->triple_daemon_threads[this->triple_daemon_index]->triples.finish_read_in_place(3 * this->triple_batch_blocks);
+            this->triple_daemon_index++;
+            if (this->triple_daemon_index == this->triple_daemon_threads.size()) {
+                this->triple_daemon_index = 0;
+            }
+        }
+        this->triple_batch = this->triple_daemon_threads[this->triple_daemon_index]->triples.start_read_in_place(3 * this->triple_batch_blocks);
+        if (this->triple_batch == nullptr) {
+            std::cerr << "Beaver triple generation stopped unexpectedly" << std::endl;
+            std::abort();
+        }
+        this->triple_index = 0;
+    }
+
+    void GMWEngine::input(Wire* data, unsigned int length, bool garbler) {
+        bool own_input = (garbler == this->is_garbler);
+        for (unsigned int i = 0; i != length; i++) {
+            if (this->input_mask_bits_left == 0) {
+                this->input_prg.random_block(&this->input_mask);
+                this->input_mask_bits_left = crypto::block_num_bits;
+            }
+            this->input_mask_bits_left--;
+            Wire mask = crypto::block_bit(this->input_mask, this->input_mask_bits_left) ? 1 : 0;
+            if (own_input) {
+                data[i] = this->input_reader.read1() ^ mask;
+            } else {
+                data[i] = mask;
+            }
+        }
+    }
+
+    // HACK: assume all output goes to the garbler
+    void GMWEngine::output(const Wire* data, unsigned int length) {
+        std::size_t num_bytes = (length + 7) >> 3;
+        if (this->is_garbler) {
+            this->pending_output.insert(this->pending_output.end(), data, data + length);
+            this->pending_output_lengths.push_back(length);
+        } else {
+            std::uint8_t* shares = static_cast<std::uint8_t*>(this->conn_writer.start_write(num_bytes));
+            std::fill(shares, shares + num_bytes, 0);
+            for (unsigned int i = 0; i != length; i++) {
+                set_bit(shares, i, data[i]);
+            }
+            this->conn_writer.finish_write(num_bytes);
+        }
+
+        /* Both parties reach this threshold at the same point. */
+        this->pending_output_bytes += num_bytes;
+        if (this->pending_output_bytes >= gmw_output_batch_size) {
+            if (this->is_garbler) {
+                this->receive_pending_output();
+            } else {
+                this->conn_writer.flush();
+                this->pending_output_bytes = 0;
+            }
+        }
+    }
+
+    void GMWEngine::receive_pending_output() {
+        std::size_t offset = 0;
+        for (unsigned int length : this->pending_output_lengths) {
+            std::size_t num_bytes = (length + 7) >> 3;
+            const std::uint8_t* shares = static_cast<const std::uint8_t*>(this->conn_reader.start_read(num_bytes));
+            for (unsigned int i = 0; i != length; i++) {
+                this->output_writer->write1(get_bit(shares, i) ^ this->pending_output[offset + i]);
+            }
+            this->conn_reader.finish_read(num_bytes);
+            offset += length;
+        }
+        this->pending_output.clear();
+        this->pending_output_lengths.clear();
+        this->pending_output_bytes = 0;
+    }
+
+    void GMWEngine::op_and_batch(Wire* output, const Wire* input1, const Wire* input2, std::size_t count) {
+        while (count != 0) {
+            std::size_t round_size = std::min(count, gmw_max_round_size);
+            this->open_round(output, input1, input2, round_size);
+            output += round_size;
+            input1 += round_size;
+            input2 += round_size;
+            count -= round_size;
+        }
+    }
+
+    void GMWEngine::open_round(Wire* output, const Wire* input1, const Wire* input2, std::size_t count) {
+        std::size_t num_bytes = (count + 7) >> 3;
+        Wire* a = this->round_a.data();
+        Wire* b = this->round_b.data();
+        Wire* c = this->round_c.data();
+
+        /* Send x XOR a and y XOR b for each gate, packed as two bit arrays. */
+        std::uint8_t* masked = static_cast<std::uint8_t*>(this->conn_writer.start_write(2 * num_bytes));
+        std::fill(masked, masked + 2 * num_bytes, 0);
+        for (std::size_t i = 0; i != count; i++) {
+            if (this->triple_index == this->triple_batch_size) {
+                this->next_triple_batch();
+            }
+            std::size_t block_index = this->triple_index / crypto::block_num_bits;
+            std::uint8_t bit_index = this->triple_index % crypto::block_num_bits;
+            a[i] = crypto::block_bit(this->triple_batch[block_index], bit_index) ? 1 : 0;
+            b[i] = crypto::block_bit(this->triple_batch[this->triple_batch_blocks + block_index], bit_index) ? 1 : 0;
+            c[i] = crypto::block_bit(this->triple_batch[2 * this->triple_batch_blocks + block_index], bit_index) ? 1 : 0;
+            this->triple_index++;
+
+            set_bit(masked, i, input1[i] ^ a[i]);
+            set_bit(&masked[num_bytes], i, input2[i] ^ b[i]);
+        }
+        std::uint8_t* opened = this->round_opened.data();
+        std::copy(masked, masked + 2 * num_bytes, opened);
+        this->conn_writer.finish_write(2 * num_bytes);
+        this->conn_writer.flush();
+
+        /* Output shares sent before this round precede the openings. */
+        if (this->is_garbler) {
+            this->receive_pending_output();
+        } else {
+            this->pending_output_bytes = 0;
+        }
+
+        const std::uint8_t* theirs = static_cast<const std::uint8_t*>(this->conn_reader.start_read(2 * num_bytes));
+        for (std::size_t i = 0; i != 2 * num_bytes; i++) {
+            opened[i] ^= theirs[i];
+        }
+        this->conn_reader.finish_read(2 * num_bytes);
+
+        for (std::size_t i = 0; i != count; i++) {
+            Wire d = get_bit(opened, i);
+            Wire e = get_bit(&opened[num_bytes], i);
+            output[i] = c[i] ^ (d & b[i]) ^ (e & a[i]) ^ (d & e & this->constant_share);
+        }
+
+        this->num_and_gates += count;
+        this->num_rounds++;
+    }
+
+    void run_gmw(const EngineOptions& args) {
+        std::string file_base = args.problem_name + "_" + std::to_string(args.self_id);
+        std::string prog_file = file_base + ".memprog";
+        std::string output_file = file_base + ".output";
+
+        std::chrono::time_point<std::chrono::steady_clock> start;
+        std::chrono::time_point<std::chrono::steady_clock> end;
+
+        /* Validate the config.yaml file for running the computation. */
+
+        util::Configuration& c = *args.config;
+        if (c["parties"].get(garbler_party_id) == nullptr) {
+            std::cerr << "Garbler not present in configuration file" << std::endl;
+            std::abort();
+        }
+        if (c["parties"].get(evaluator_party_id) == nullptr) {
+            std::cerr << "Evaluator not present in configuration file" << std::endl;
+            std::abort();
+        }
+        if (c["parties"][garbler_party_id]["workers"].get_size() != c["parties"][evaluator_party_id]["workers"].get_size()) {
+            std::cerr << "Garbler has " << c["parties"][garbler_party_id]["workers"].get_size() << " workers but evaluator has " << c["parties"][evaluator_party_id]["workers"].get_size() << " workers --- must be equal" << std::endl;
+            std::abort();
+        }
+        if (args.self_id >= c["parties"][garbler_party_id]["workers"].get_size()) {
+            std::cerr << "Worker index is " << args.self_id << " but only " << c["parties"][garbler_party_id]["workers"].get_size() << " workers are specified" << std::endl;
+            std::abort();
+        }
+
+        const util::ConfigValue& worker = c["parties"][evaluator_party_id]["workers"][args.self_id];
+        if (worker.get("external_host") == nullptr || worker.get("external_port") == nullptr) {
+            std::cerr << "The evaluator's external network information is not specified" << std::endl;
+            std::abort();
+        }
+
+        TripleInfo ti;
+        if (worker.get("oblivious_transfer") != nullptr) {
+            if (worker["oblivious_transfer"].get("max_batch_size") != nullptr) {
+                std::int64_t temp = worker["oblivious_transfer"]["max_batch_size"].as_int();
+                if (temp <= 0 || temp > (1 << 14) || (temp % crypto::block_num_bits) != 0) {
+                    std::cerr << "Specified \"oblivious_transfer/max_batch_size\" is " << temp << ", which is invalid for GMW (must be a multiple of " << crypto::block_num_bits << ", at most " << (1 << 14) << ")" << std::endl;
+                    std::abort();
+                }
+                ti.batch_size = static_cast<std::size_t>(temp);
+            }
+            if (worker["oblivious_transfer"].get("pipeline_depth") != nullptr) {
+                std::int64_t temp = worker["oblivious_transfer"]["pipeline_depth"].as_int();
+                if (temp <= 0 || temp > SIZE_MAX) {
+                    std::cerr << "Specified \"oblivious_transfer/pipeline_depth\" is " << temp << ", which is invalid" << std::endl;
+                    std::abort();
+                }
+                ti.pipeline_depth = static_cast<std::size_t>(temp);
+            }
+            if (worker["oblivious_transfer"].get("num_daemons") != nullptr) {
+                std::int64_t temp = worker["oblivious_transfer"]["num_daemons"].as_int();
+                if (temp <= 0 || temp > SIZE_MAX) {
+                    std::cerr << "Specified \"oblivious_transfer/num_daemons\" is " << temp << ", which is invalid" << std::endl;
+                    std::abort();
+                }
+                ti.num_daemons = static_cast<std::size_t>(temp);
+            }
+        }
+
+        const char* evaluator_host = worker["external_host"].as_string().c_str();
+        const char* evaluator_port = worker["external_port"].as_string().c_str();
+        if (args.party_id == evaluator_party_id) {
+            std::string evaluator_input_file = file_base + "_evaluator.input";
+            GMWEngine p(false, evaluator_input_file.c_str(), nullptr, evaluator_host, evaluator_port, ti);
+            engine::ANDXOREngine executor(args.cluster, c["parties"][evaluator_party_id]["workers"][args.self_id], p, prog_file.c_str());
+            start = std::chrono::steady_clock::now();
+            executor.execute_program();
+        } else if (args.party_id == garbler_party_id) {
+            std::string garbler_input_file = file_base + "_garbler.input";
+            GMWEngine p(true, garbler_input_file.c_str(), output_file.c_str(), evaluator_host, evaluator_port, ti);
+            engine::ANDXOREngine executor(args.cluster, c["parties"][garbler_party_id]["workers"][args.self_id], p, prog_file.c_str());
+            start = std::chrono::steady_clock::now();
+            executor.execute_program();
+        } else {
+            std::cerr << "Party ID must be 0 or 1 (got " << args.party_id << ")" << std::endl;
+            std::abort();
+        }
+        end = std::chrono::steady_clock::now();
+
+        std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        std::cout << ms.count() << " ms" << std::endl;
+    }
+
+    RegisterProtocol gmw("gmw", "GMW with Beaver triples from OT extension", run_gmw, "identity_plugin");
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file protocols/gmw.hpp
+ * @brief Two-party GMW protocol for boolean circuits, with Beaver triples
+ * generated using OT extension.
+ *
+ * Each wire is XOR-shared between the two parties. XOR and NOT gates are
+ * local. Each AND gate consumes a Beaver triple (a, b, c = a AND b) and
+ * requires both parties to open x XOR a and y XOR b, which costs two bits of
+ * communication in each direction. The ANDXOR engine hands the protocol each
+ * layer of independent AND gates at once, and all openings for the layer are
+ * exchanged in a single round.
+ *
+ * Triples are produced ahead of time by daemon threads, each with its own
+ * connection, using two random OTs per triple (one in each direction), so
+ * that their generation overlaps with the computation.
+ */
+
+#ifndef MAGE_PROTOCOLS_GMW_HPP_
+#define MAGE_PROTOCOLS_GMW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "crypto/block.hpp"
+#include "crypto/prg.hpp"
+#include "engine/cluster.hpp"
+#include "util/binaryfile.hpp"
+#include "util/filebuffer.hpp"
+#include "util/userpipe.hpp"
+
+namespace mage::protocols::gmw {
+    /* Maximum number of AND gates whose openings are exchanged in one message. */
+    constexpr const std::size_t gmw_max_round_size = 1 << 16;
+
+    /* Number of bytes of output shares to buffer before sending them. */
+    constexpr const std::size_t gmw_output_batch_size = 1 << 16;
+
+    struct TripleInfo {
+        TripleInfo() : batch_size(64 * crypto::block_num_bits), pipeline_depth(2), num_daemons(1) {
+        }
+
+        std::size_t batch_size;
+        std::size_t pipeline_depth;
+        std::size_t num_daemons;
+    };
+
+    struct TripleDaemonThread {
+        TripleDaemonThread(std::size_t batch_blocks, std::size_t pipeline_depth) : triples(3 * batch_blocks * pipeline_depth) {
+        }
+
+        std::thread thread;
+        util::BufferedFileReader<false> ot_conn_reader;
+        util::BufferedFileWriter<false> ot_conn_writer;
+
+        /*
+         * Each batch of triples is stored as three bit arrays, packed into
+         * blocks: the a bits, then the b bits, then the c bits.
+         */
+        util::UserPipe<crypto::block> triples;
+    };
+
+    class GMWEngine {
+    public:
+        using Wire = std::uint8_t;
+
+        /* Each layer of AND gates costs a round trip. */
+        static constexpr bool prefers_low_depth_circuits = true;
+        static constexpr bool batches_and_gates = true;
+        static constexpr bool exchanges_network_traffic = true;
+
+        /**
+         * @brief Creates a GMW protocol driver and connects to the other
+         * party.
+         *
+         * @param garbler True if this is the garbler party, which receives
+         * the output and connects to the evaluator, or false if this is the
+         * evaluator, which accepts the garbler's connections.
+         * @param input_file Path to the file containing this party's input.
+         * @param output_file Path to the file into which to write the output
+         * (used only by the garbler).
+         * @param evaluator_host Host name of the evaluator (used only by the
+         * garbler).
+         * @param evaluator_port Port on which the evaluator accepts
+         * connections.
+         * @param ti Parameters for Beaver triple generation.
+         */
+        GMWEngine(bool garbler, const char* input_file, const char* output_file, const char* evaluator_host, const char* evaluator_port, const TripleInfo& ti);
+        ~GMWEngine();
+
+        void print_stats();
+
+        /**
+         * @brief Returns the number of bytes sent to the other party so far,
+         * over the main connection and the triple daemons' connections.
+         */
+        std::uint64_t get_bytes_sent() const;
+
+        /**
+         * @brief Returns the number of bytes received from the other party so
+         * far, over the main connection and the triple daemons' connections.
+         */
+        std::uint64_t get_bytes_received() const;
+
+        void input(Wire* data, unsigned int length, bool garbler);
+        void output(const Wire* data, unsigned int length);
+
+        void op_and(Wire& output, const Wire& input1, const Wire& input2) {
+            this->op_and_batch(&output, &input1, &input2, 1);
+        }
+
+        void op_and_batch(Wire* output, const Wire* input1, const Wire* input2, std::size_t count);
+
+        void op_xor(Wire& output, const Wire& input1, const Wire& input2) {
+            output = input1 ^ input2;
+        }
+
+        void op_not(Wire& output, const Wire& input) {
+            output = input ^ this->constant_share;
+        }
+
+        void op_xnor(Wire& output, const Wire& input1, const Wire& input2) {
+            output = input1 ^ input2 ^ this->constant_share;
+        }
+
+        void op_copy(Wire& output, const Wire& input) {
+            output = input;
+        }
+
+        void one(Wire& output) const {
+            output = this->constant_share;
+        }
+
+        void zero(Wire& output) const {
+            output = 0;
+        }
+
+    private:
+        void start_triple_daemons(std::size_t batch_size);
+        void open_round(Wire* output, const Wire* input1, const Wire* input2, std::size_t count);
+        void next_triple_batch();
+        void receive_pending_output();
+
+        bool is_garbler;
+        Wire constant_share;
+
+        util::BinaryFileReader input_reader;
+        std::unique_ptr<util::BinaryFileWriter> output_writer;
+        std::vector<int> sockets;
+        util::BufferedFileReader<false> conn_reader;
+        util::BufferedFileWriter<false> conn_writer;
+
+        /* Both parties expand the same seed to mask inputs. */
+        crypto::PRG input_prg;
+        crypto::block input_mask;
+        std::uint8_t input_mask_bits_left;
+
+        /* The garbler's output shares, not yet combined with the evaluator's. */
+        std::vector<Wire> pending_output;
+        std::vector<unsigned int> pending_output_lengths;
+        std::size_t pending_output_bytes;
+
+        std::vector<std::unique_ptr<TripleDaemonThread>> triple_daemon_threads;
+        std::size_t triple_daemon_index;
+        std::size_t triple_batch_size;
+        std::size_t triple_batch_blocks;
+        const crypto::block* triple_batch;
+        std::size_t triple_index;
+
+        /*
+         * Each round's triples and opened values, sized for the largest round
+         * (gmw_max_round_size gates) rather than held on the stack.
+         */
+        std::vector<Wire> round_a;
+        std::vector<Wire> round_b;
+        std::vector<Wire> round_c;
+        std::vector<std::uint8_t> round_opened;
+
+        std::uint64_t num_and_gates;
+        std::uint64_t num_rounds;
+    };
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include "crypto/ot/correlated.hpp"
 #include "engine/andxor.hpp"
 #include "memprog/program.hpp"
+#include "platform/affinity.hpp"
 #include "protocols/registry.hpp"
 #include "util/filebuffer.hpp"
 #include "util/misc.hpp"
@@ -44,7 +45,24 @@ namespace mage::protocols::halfgates {
         std::mutex mutex;
     };
 
-    void HalfGatesGarblingEngine::start_input_daemon(std::size_t max_batch_size, std::size_t pipeline_depth) {
+    /*
+     * Creates the pool of input labels for an OT daemon that runs the
+     * specified number of OT batches. The total number of evaluator inputs is
+     * known before the program starts, so a daemon can run OT extension for
+     * its inputs well before the engine reaches the corresponding Input
+     * instructions, up to the configured pool size. This way, inputs that
+     * arrive in a burst rarely wait for an OT round trip.
+     */
+    static void create_input_pool(InputDaemonThread* daemon, const OTInfo& oti, std::int64_t num_batches) {
+        std::size_t pool_batches = util::ceil_div(oti.input_pool_size, oti.max_batch_size * oti.num_daemons).first;
+        pool_batches = std::max(pool_batches, static_cast<std::size_t>(1 << 2));
+        pool_batches = std::max(std::min(pool_batches, static_cast<std::size_t>(num_batches)), static_cast<std::size_t>(1));
+        daemon->evaluator_input_labels = std::make_unique<InputBatchPipe<crypto::block>>(pool_batches, oti.max_batch_size);
+    }
+
+    void HalfGatesGarblingEngine::start_input_daemon(const OTInfo& oti) {
+        std::size_t max_batch_size = oti.max_batch_size;
+        std::size_t pipeline_depth = oti.pipeline_depth;
         std::uint64_t num_bytes = this->input_daemon_threads[0]->ot_conn_reader.read<std::uint64_t>();
         std::uint64_t num_bits = num_bytes << 3;
         std::int64_t total_batches, extra_bits;
@@ -57,19 +75,22 @@ namespace mage::protocols::halfgates {
 
         for (int i = 0; i != this->input_daemon_threads.size(); i++) {
             InputDaemonThread* daemon = this->input_daemon_threads[i].get();
-            daemon->thread = std::thread([=]() {
-                auto [ num_batches, num_extra_batches ] = util::floor_div(total_batches, this->input_daemon_threads.size());
-                if (i < num_extra_batches) {
-                    num_batches++;
-                }
-                if (i == num_extra_batches && extra_bits != 0) {
-                    num_batches++;
-                    // This thread will handle the smaller extra batch
-                }
+            auto [ num_batches, num_extra_batches ] = util::floor_div(total_batches, this->input_daemon_threads.size());
+            if (i < num_extra_batches) {
+                num_batches++;
+            }
+            if (i == num_extra_batches && extra_bits != 0) {
+                num_batches++;
+                // This thread will handle the smaller extra batch
+            }
+            create_input_pool(daemon, oti, num_batches);
+
+            daemon->thread = std::thread([=, num_batches = num_batches, num_extra_batches = num_extra_batches]() {
+                platform::pin_thread(platform::ThreadRole::OTDaemon);
 
                 // crypto::ot::CorrelatedExtensionSender ot_sender;
                 // ot_sender.initialize(daemon->ot_conn_reader, daemon->ot_conn_writer);
-                crypto::ot::PipelinedCorrelatedExtSender ot_sender(daemon->ot_conn_reader, daemon->ot_conn_writer, this->garbler.get_delta(), daemon->evaluator_input_labels, max_batch_size, pipeline_depth);
+                crypto::ot::PipelinedCorrelatedExtSender ot_sender(daemon->ot_conn_reader, daemon->ot_conn_writer, this->garbler.get_delta(), *daemon->evaluator_input_labels, max_batch_size, pipeline_depth);
 
                 for (std::int64_t c = 0; c != num_batches; c++) {
                     std::uint64_t batch_size = max_batch_size;
@@ -133,7 +154,9 @@ namespace mage::protocols::halfgates {
         std::vector<std::condition_variable> thread_turn_active;
     };
 
-    void HalfGatesEvaluationEngine::start_input_daemon(std::size_t max_batch_size, std::size_t pipeline_depth) {
+    void HalfGatesEvaluationEngine::start_input_daemon(const OTInfo& oti) {
+        std::size_t max_batch_size = oti.max_batch_size;
+        std::size_t pipeline_depth = oti.pipeline_depth;
         std::uint64_t num_bytes = this->input_reader.get_file_length();
         this->input_daemon_threads[0]->ot_conn_writer.write<std::uint64_t>() = num_bytes;
         this->input_daemon_threads[0]->ot_conn_writer.flush();
@@ -151,20 +174,24 @@ namespace mage::protocols::halfgates {
 
         for (int i = 0; i != this->input_daemon_threads.size(); i++) {
             InputDaemonThread* daemon = this->input_daemon_threads[i].get();
-            daemon->thread = std::thread([=]() {
+            auto [ num_batches, num_extra_batches ] = util::floor_div(total_batches, this->input_daemon_threads.size());
+            if (i < num_extra_batches) {
+                num_batches++;
+            }
+            if (i == num_extra_batches && extra_bits != 0) {
+                num_batches++;
+                // This thread will handle the smaller extra batch
+            }
+            create_input_pool(daemon, oti, num_batches);
+
+            daemon->thread = std::thread([=, num_batches = num_batches, num_extra_batches = num_extra_batches]() {
+                platform::pin_thread(platform::ThreadRole::OTDaemon);
+
                 int next_thread_i = (i + 1) % this->input_daemon_threads.size();
-                auto [ num_batches, num_extra_batches ] = util::floor_div(total_batches, this->input_daemon_threads.size());
-                if (i < num_extra_batches) {
-                    num_batches++;
-                }
-                if (i == num_extra_batches && extra_bits != 0) {
-                    num_batches++;
-                    // This thread will handle the smaller extra batch
-                }
 
                 // crypto::ot::CorrelatedExtensionChooser ot_chooser;
                 // ot_chooser.initialize(daemon->ot_conn_reader, daemon->ot_conn_writer);
-                crypto::ot::PipelinedCorrelatedExtChooser ot_chooser(daemon->ot_conn_reader, daemon->ot_conn_writer, daemon->evaluator_input_labels, max_batch_size, pipeline_depth);
+                crypto::ot::PipelinedCorrelatedExtChooser ot_chooser(daemon->ot_conn_reader, daemon->ot_conn_writer, *daemon->evaluator_input_labels, max_batch_size, pipeline_depth);
 
                 for (std::int64_t c = 0; c != num_batches; c++) {
                     std::uint64_t batch_size = max_batch_size;
@@ -281,6 +308,14 @@ namespace mage::protocols::halfgates {
                 }
                 oti.num_daemons = static_cast<std::size_t>(temp);
             }
+            if (worker["oblivious_transfer"].get("input_pool_size") != nullptr) {
+                std::int64_t temp = worker["oblivious_transfer"]["input_pool_size"].as_int();
+                if (temp < 0 || temp > SIZE_MAX) {
+                    std::cerr << "Specified \"oblivious_transfer/input_pool_size\" is " << temp << ", which is invalid" << std::endl;
+                    std::abort();
+                }
+                oti.input_pool_size = static_cast<std::size_t>(temp);
+            }
         }
 
         if (args.party_id == evaluator_party_id) {
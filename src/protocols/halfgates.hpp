@@ -75,28 +75,42 @@ namespace mage::protocols::halfgates {
     };
 
     struct InputDaemonThread {
-        InputDaemonThread(std::size_t max_batch_size) : evaluator_input_labels((1 << 2), max_batch_size) {
-        }
-
         std::thread thread;
         util::BufferedFileReader<false> ot_conn_reader;
         util::BufferedFileWriter<false> ot_conn_writer;
-        InputBatchPipe<crypto::block> evaluator_input_labels;
+
+        /*
+         * Pool of evaluator input labels that the daemon has computed ahead
+         * of their use. It is sized once the number of evaluator inputs is
+         * known, just before the daemon is started.
+         */
+        std::unique_ptr<InputBatchPipe<crypto::block>> evaluator_input_labels;
     };
 
     struct OTInfo {
-        OTInfo() : max_batch_size(4 * crypto::block_num_bits), pipeline_depth(1), num_daemons(3) {
+        OTInfo() : max_batch_size(4 * crypto::block_num_bits), pipeline_depth(1), num_daemons(3), input_pool_size(1 << 20) {
         }
 
         std::size_t max_batch_size;
         std::size_t pipeline_depth;
         std::size_t num_daemons;
+
+        /*
+         * Maximum number of evaluator input labels, across all daemons, to
+         * compute via OT ahead of their use.
+         */
+        std::size_t input_pool_size;
     };
 
     class HalfGatesGarblingEngine {
     public:
         using Wire = HalfGatesGarbler::Wire;
 
+        /* Each AND gate has a cost, regardless of the circuit's depth. */
+        static constexpr bool prefers_low_depth_circuits = false;
+        static constexpr bool batches_and_gates = false;
+        static constexpr bool exchanges_network_traffic = true;
+
         HalfGatesGarblingEngine(const std::shared_ptr<engine::ClusterNetwork>& network,
             const char* input_file, const char* output_file, const char* evaluator_host,
             const char* evaluator_port, const OTInfo& oti)
@@ -106,7 +120,7 @@ namespace mage::protocols::halfgates {
             this->conn_reader.set_file_descriptor(this->sockets[0], false);
             this->conn_writer.set_file_descriptor(this->sockets[0], false);
             for (int i = 0; i != this->input_daemon_threads.size(); i++) {
-                this->input_daemon_threads[i] = std::make_unique<InputDaemonThread>(oti.max_batch_size);
+                this->input_daemon_threads[i] = std::make_unique<InputDaemonThread>();
                 this->input_daemon_threads[i]->ot_conn_reader.set_file_descriptor(this->sockets[1 + i], false);
                 this->input_daemon_threads[i]->ot_conn_writer.set_file_descriptor(this->sockets[1 + i], false);
             }
@@ -132,7 +146,7 @@ namespace mage::protocols::halfgates {
             this->conn_writer.flush();
 
             /* Once this->garbler is initialized, start the OT daemon. */
-            this->start_input_daemon(oti.max_batch_size, oti.pipeline_depth);
+            this->start_input_daemon(oti);
         }
 
         ~HalfGatesGarblingEngine() {
@@ -153,6 +167,30 @@ namespace mage::protocols::halfgates {
             std::cout << this->conn_writer.get_stats() << std::endl;
         }
 
+        /**
+         * @brief Returns the number of bytes sent to the evaluator so far, over
+         * the main connection and the OT daemons' connections.
+         */
+        std::uint64_t get_bytes_sent() const {
+            std::uint64_t total = this->conn_writer.get_bytes_written();
+            for (const auto& daemon : this->input_daemon_threads) {
+                total += daemon->ot_conn_writer.get_bytes_written();
+            }
+            return total;
+        }
+
+        /**
+         * @brief Returns the number of bytes received from the evaluator so far,
+         * over the main connection and the OT daemons' connections.
+         */
+        std::uint64_t get_bytes_received() const {
+            std::uint64_t total = this->conn_reader.get_bytes_read();
+            for (const auto& daemon : this->input_daemon_threads) {
+                total += daemon->ot_conn_reader.get_bytes_read();
+            }
+            return total;
+        }
+
         void input(Wire* data, unsigned int length, bool garbler) {
             if (garbler) {
                 bool input_bits[length];
@@ -164,7 +202,7 @@ namespace mage::protocols::halfgates {
             } else {
                 std::size_t read_so_far = 0;
                 while (read_so_far != length) {
-                    auto& label_pipe = this->input_daemon_threads[this->evaluator_input_index]->evaluator_input_labels;
+                    auto& label_pipe = *this->input_daemon_threads[this->evaluator_input_index]->evaluator_input_labels;
                     auto [ bytes_read, end_of_batch ] = label_pipe.read_elements_until_end_of_batch(&data[read_so_far], length - read_so_far);
                     read_so_far += bytes_read;
                     if (end_of_batch) {
@@ -230,7 +268,7 @@ namespace mage::protocols::halfgates {
         }
 
     private:
-        void start_input_daemon(std::size_t batch_size, std::size_t pipeline_depth);
+        void start_input_daemon(const OTInfo& oti);
 
         HalfGatesGarbler garbler;
 
@@ -250,6 +288,11 @@ namespace mage::protocols::halfgates {
     public:
         using Wire = HalfGatesEvaluator::Wire;
 
+        /* Each AND gate has a cost, regardless of the circuit's depth. */
+        static constexpr bool prefers_low_depth_circuits = false;
+        static constexpr bool batches_and_gates = false;
+        static constexpr bool exchanges_network_traffic = true;
+
         HalfGatesEvaluationEngine(const char* input_file, const char* evaluator_port, const OTInfo& oti)
             : input_reader(input_file), sockets(oti.num_daemons + 1), conn_output_writer(this->conn_writer), input_daemon_threads(oti.num_daemons), evaluator_input_index(0),
             bits_left_in_output_batch(halfgates_output_batch_size) {
@@ -257,7 +300,7 @@ namespace mage::protocols::halfgates {
             this->conn_reader.set_file_descriptor(this->sockets[0], false);
             this->conn_writer.set_file_descriptor(this->sockets[0], false);
             for (int i = 0; i != this->input_daemon_threads.size(); i++) {
-                this->input_daemon_threads[i] = std::make_unique<InputDaemonThread>(oti.max_batch_size);
+                this->input_daemon_threads[i] = std::make_unique<InputDaemonThread>();
                 this->input_daemon_threads[i]->ot_conn_reader.set_file_descriptor(this->sockets[1 + i], false);
                 this->input_daemon_threads[i]->ot_conn_writer.set_file_descriptor(this->sockets[1 + i], false);
             }
@@ -267,7 +310,7 @@ namespace mage::protocols::halfgates {
             this->evaluator.initialize(input_seed);
 
             /* Once this->evaluator is initialized, start the OT daemon. */
-            this->start_input_daemon(oti.max_batch_size, oti.pipeline_depth);
+            this->start_input_daemon(oti);
         }
 
         ~HalfGatesEvaluationEngine() {
@@ -287,13 +330,37 @@ namespace mage::protocols::halfgates {
             std::cout << this->conn_reader.get_stats() << std::endl;
         }
 
+        /**
+         * @brief Returns the number of bytes sent to the garbler so far, over
+         * the main connection and the OT daemons' connections.
+         */
+        std::uint64_t get_bytes_sent() const {
+            std::uint64_t total = this->conn_writer.get_bytes_written();
+            for (const auto& daemon : this->input_daemon_threads) {
+                total += daemon->ot_conn_writer.get_bytes_written();
+            }
+            return total;
+        }
+
+        /**
+         * @brief Returns the number of bytes received from the garbler so far,
+         * over the main connection and the OT daemons' connections.
+         */
+        std::uint64_t get_bytes_received() const {
+            std::uint64_t total = this->conn_reader.get_bytes_read();
+            for (const auto& daemon : this->input_daemon_threads) {
+                total += daemon->ot_conn_reader.get_bytes_read();
+            }
+            return total;
+        }
+
         void input(Wire* data, unsigned int length, bool garbler) {
             if (garbler) {
                 this->evaluator.input_garbler(data, length);
             } else {
                 std::size_t read_so_far = 0;
                 while (read_so_far != length) {
-                    auto& label_pipe = this->input_daemon_threads[this->evaluator_input_index]->evaluator_input_labels;
+                    auto& label_pipe = *this->input_daemon_threads[this->evaluator_input_index]->evaluator_input_labels;
                     auto [ bytes_read, end_of_batch ] = label_pipe.read_elements_until_end_of_batch(&data[read_so_far], length - read_so_far);
                     read_so_far += bytes_read;
                     if (end_of_batch) {
@@ -351,7 +418,7 @@ namespace mage::protocols::halfgates {
         }
 
     private:
-        void start_input_daemon(std::size_t max_batch_size, std::size_t pipeline_depth);
+        void start_input_daemon(const OTInfo& oti);
 
         HalfGatesEvaluator evaluator;
         util::BinaryFileReader input_reader;
@@ -31,6 +31,10 @@ namespace mage::protocols::plaintext {
     public:
         using Wire = unsigned __int128;
 
+        static constexpr bool prefers_low_depth_circuits = false;
+        static constexpr bool batches_and_gates = false;
+        static constexpr bool exchanges_network_traffic = false;
+
         PlaintextEvaluationEngine(std::string garbler_input_file, std::string evaluator_input_file, std::string output_file)
             : garbler_input_reader(garbler_input_file.c_str()), evaluator_input_reader(evaluator_input_file.c_str()), output_writer(output_file.c_str()) {
         }
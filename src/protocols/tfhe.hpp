@@ -39,6 +39,11 @@ namespace mage::protocols::tfhe {
     public:
         using Wire = TFHEScheme::Wire;
 
+        /* Gates at the same depth can be bootstrapped concurrently. */
+        static constexpr bool prefers_low_depth_circuits = true;
+        static constexpr bool batches_and_gates = false;
+        static constexpr bool exchanges_network_traffic = false;
+
         TFHEEngine(const char* garbler_input_file, const char* evaluator_input_file, const char* output_file)
             : garbler_input_reader(garbler_input_file, std::ios::binary), evaluator_input_reader(evaluator_input_file, std::ios::binary), output_writer(output_file, std::ios::binary) {
             {
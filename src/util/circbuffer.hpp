@@ -313,6 +313,26 @@ namespace mage::util {
             return &buffer[this->read_index];
         }
 
+        /**
+         * @brief Provides a pointer to an element in the circular buffer
+         * other than the oldest one, without removing any elements.
+         *
+         * @pre The circular buffer contains more than @p offset elements.
+         *
+         * @param offset The number of elements between the oldest element and
+         * the element of interest.
+         * @return A pointer to the element that would be read after
+         * @p offset other elements are read.
+         */
+        const T* peek_unchecked(std::size_t offset) const {
+            const T* buffer = this->data.mapping();
+            std::size_t index = this->read_index + offset;
+            if (this->capacity <= index) {
+                index -= this->capacity;
+            }
+            return &buffer[index];
+        }
+
         /**
          * @brief Removes elements from the circular buffer in place, without
          * copying them.
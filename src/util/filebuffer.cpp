@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/filebuffer.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "platform/filesystem.hpp"
+
+namespace mage::util {
+    BackgroundFileReader::BackgroundFileReader(int file_descriptor, std::size_t buffer_size)
+        : fd(file_descriptor), staging { { buffer_size, true }, { buffer_size, true } }, ready(0), request_buffer(nullptr),
+        request_offset(0), request_length(0), result(0),
+        pending(false), requested(false), completed(false), stopping(false) {
+        this->helper = std::thread(&BackgroundFileReader::run, this);
+    }
+
+    BackgroundFileReader::~BackgroundFileReader() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->cond.notify_all();
+        this->helper.join();
+    }
+
+    void BackgroundFileReader::start_read(std::uint64_t offset, std::size_t length) {
+        assert(!this->pending);
+        assert(length <= this->capacity());
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->request_buffer = this->staging[1 - this->ready].mapping();
+            this->request_offset = offset;
+            this->request_length = length;
+            this->requested = true;
+            this->completed = false;
+        }
+        this->pending = true;
+        this->cond.notify_all();
+    }
+
+    std::size_t BackgroundFileReader::finish_read() {
+        assert(this->pending);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cond.wait(lock, [this]() { return this->completed; });
+        this->pending = false;
+        this->ready = 1 - this->ready;
+        return this->result;
+    }
+
+    void BackgroundFileReader::run() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            /* A requested read is always completed, even when stopping. */
+            this->cond.wait(lock, [this]() { return this->requested || this->stopping; });
+            if (!this->requested) {
+                return;
+            }
+            std::uint8_t* into = this->request_buffer;
+            std::uint64_t offset = this->request_offset;
+            std::size_t length = this->request_length;
+            lock.unlock();
+
+            std::size_t rv = platform::read_from_file_at(this->fd, into, length, offset);
+
+            lock.lock();
+            this->result = rv;
+            this->requested = false;
+            this->completed = true;
+            this->cond.notify_all();
+        }
+    }
+}
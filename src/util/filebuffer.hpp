@@ -32,7 +32,13 @@
 #include <cstdint>
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include "platform/filesystem.hpp"
 #include "platform/memory.hpp"
@@ -45,6 +51,112 @@
  */
 
 namespace mage::util {
+    /**
+     * @brief Reads chunks of a file into a staging buffer on a helper thread.
+     *
+     * BufferedFileReader and BufferedReverseFileReader use this to fetch the
+     * next chunk of a file while the current chunk is being processed, so
+     * that a streaming pass over a file that is not in the page cache takes
+     * time max(I/O, CPU) rather than their sum. At most one read is
+     * outstanding at a time, but the staging area is double-buffered: a read
+     * fills one buffer while the caller copies data out of the other. This
+     * lets the caller request the next chunk as soon as a read finishes,
+     * rather than only once it has drained the chunk.
+     */
+    class BackgroundFileReader {
+    public:
+        /**
+         * @brief Creates a BackgroundFileReader for the specified file
+         * descriptor and starts its helper thread.
+         *
+         * @param file_descriptor The file descriptor to read from. It must
+         * refer to a file (not a network connection) and must remain open
+         * until this BackgroundFileReader is destroyed.
+         * @param buffer_size Size of each of the two staging buffers.
+         */
+        BackgroundFileReader(int file_descriptor, std::size_t buffer_size);
+
+        /**
+         * @brief Waits for any outstanding read to complete and stops the
+         * helper thread.
+         */
+        ~BackgroundFileReader();
+
+        /**
+         * @brief Starts reading the specified range of the file into the
+         * start of the staging buffer not returned by data().
+         *
+         * The data from the previously finished read remain accessible via
+         * data() while this read is outstanding.
+         *
+         * @pre No read is outstanding.
+         * @param offset The offset in the file at which to start reading.
+         * @param length The number of bytes to read, which must not exceed
+         * the size of the staging buffer.
+         */
+        void start_read(std::uint64_t offset, std::size_t length);
+
+        /**
+         * @brief Waits for the outstanding read to complete, and makes the
+         * staging buffer into which it read the one returned by data().
+         *
+         * @pre A read is outstanding.
+         * @return The number of bytes read, which is less than requested only
+         * if the end of the file was reached.
+         */
+        std::size_t finish_read();
+
+        /**
+         * @brief Checks if a read is outstanding (i.e., started but not yet
+         * finished by a call to finish_read()).
+         *
+         * @return True if a read is outstanding, otherwise false.
+         */
+        bool read_pending() const {
+            return this->pending;
+        }
+
+        /**
+         * @brief Returns a pointer to the staging buffer holding the data
+         * from the most recently finished read.
+         *
+         * It remains valid, and its contents unchanged, until the next call
+         * to finish_read().
+         *
+         * @return A pointer to the staging buffer.
+         */
+        const std::uint8_t* data() const {
+            return this->staging[this->ready].mapping();
+        }
+
+        /**
+         * @brief Returns the size of each staging buffer.
+         *
+         * @return The size of each staging buffer, in bytes.
+         */
+        std::size_t capacity() const {
+            return this->staging[0].size();
+        }
+
+    private:
+        void run();
+
+        int fd;
+        platform::MappedFile<std::uint8_t> staging[2];
+        unsigned int ready;
+        std::uint8_t* request_buffer;
+        std::uint64_t request_offset;
+        std::size_t request_length;
+        std::size_t result;
+        bool pending;
+        bool requested;
+        bool completed;
+        bool stopping;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread helper;
+    };
+
     /**
      *  @brief Wrapper for a file descriptor, providing in-memory buffering and
      * an API that allows zero-copy writes.
@@ -75,7 +187,7 @@ namespace mage::util {
          * @param buffer_size Size of the in-memory buffer.
          */
         BufferedFileWriter(std::size_t buffer_size = 1 << 18)
-            : fd(-1), owns_fd(false), use_stats(false), position(0), buffer(buffer_size, true) {
+            : fd(-1), owns_fd(false), use_stats(false), position(0), buffer(buffer_size, true), bytes_written(0) {
         }
 
         /**
@@ -89,7 +201,7 @@ namespace mage::util {
          * @param buffer_size Size of the in-memory buffer.
          */
         BufferedFileWriter(const char* filename, std::size_t buffer_size = 1 << 18)
-            : owns_fd(true), use_stats(false), position(0), buffer(buffer_size, true) {
+            : owns_fd(true), use_stats(false), position(0), buffer(buffer_size, true), bytes_written(0) {
             this->fd = platform::create_file(filename, 0);
         }
 
@@ -115,7 +227,8 @@ namespace mage::util {
          */
         BufferedFileWriter(BufferedFileWriter<backwards_readable>&& other)
             : fd(other.fd), owns_fd(other.owns_fd), use_stats(other.use_stats),
-            position(other.position), buffer(std::move(other.buffer)) {
+            position(other.position), buffer(std::move(other.buffer)),
+            bytes_written(other.bytes_written.load(std::memory_order_relaxed)) {
             other.fd = -1;
             other.owns_fd = false;
             other.use_stats = false;
@@ -187,6 +300,18 @@ namespace mage::util {
             return this->stats;
         }
 
+        /**
+         * @brief Returns the number of bytes written to the underlying file
+         * descriptor so far, not counting data still buffered in memory.
+         *
+         * This may be called from a thread other than the one writing.
+         *
+         * @return The number of bytes written to the file descriptor.
+         */
+        std::uint64_t get_bytes_written() const {
+            return this->bytes_written.load(std::memory_order_relaxed);
+        }
+
         /**
          * @brief Provides a reference to a spot in this BufferedFileWriter's
          * internal buffer where the next item can be initialized, and advances
@@ -309,6 +434,7 @@ namespace mage::util {
     private:
         void _flush() {
             platform::write_to_file(this->fd, this->buffer.mapping(), this->position);
+            this->bytes_written.fetch_add(this->position, std::memory_order_relaxed);
             this->position = 0;
         }
 
@@ -321,6 +447,7 @@ namespace mage::util {
     private:
         std::size_t position;
         platform::MappedFile<std::uint8_t> buffer;
+        std::atomic<std::uint64_t> bytes_written;
     };
 
     /**
@@ -352,7 +479,8 @@ namespace mage::util {
          */
         BufferedFileReader(std::size_t buffer_size = 1 << 18)
             : fd(-1), owns_fd(false), use_stats(false), position(0), buffer(buffer_size, true),
-            active_size(0), readahead_pos(-1), progress_bar(nullptr) {
+            active_size(0), readahead_pos(-1), progress_bar(nullptr), next_offset(0), staged_position(0),
+            staged_length(0), bytes_read(0) {
         }
 
         /**
@@ -367,7 +495,8 @@ namespace mage::util {
          */
         BufferedFileReader(const char* filename, std::size_t buffer_size = 1 << 18)
             : owns_fd(true), use_stats(false), position(0), buffer(buffer_size, true), active_size(0),
-            readahead_pos(0), progress_bar(nullptr) {
+            readahead_pos(0), progress_bar(nullptr), next_offset(0), staged_position(0), staged_length(0),
+            bytes_read(0) {
             this->fd = platform::open_file(filename, nullptr);
         }
 
@@ -393,8 +522,10 @@ namespace mage::util {
          */
         BufferedFileReader(BufferedFileReader<backwards_readable>&& other)
             : fd(other.fd), owns_fd(other.owns_fd), use_stats(other.use_stats), position(other.position),
-            buffer(std::move(other.buffer)), active_size(other.active_size), readahead_pos(other.readahead),
-            progress_bar(nullptr) {
+            buffer(std::move(other.buffer)), active_size(other.active_size), readahead_pos(other.readahead_pos),
+            progress_bar(nullptr), background(std::move(other.background)), next_offset(other.next_offset),
+            staged_position(other.staged_position), staged_length(other.staged_length),
+            bytes_read(other.bytes_read.load(std::memory_order_relaxed)) {
             other.fd = -1;
             other.owns_fd = false;
             other.use_stats = false;
@@ -448,11 +579,30 @@ namespace mage::util {
             }
         }
 
+        /**
+         * @brief Enables reading ahead on a helper thread, so that the next
+         * chunk of the file is fetched while the current one is processed.
+         *
+         * Subsequent data is read starting at the current offset of the
+         * underlying file descriptor, which no longer advances. As with
+         * set_readahead(), this should only be used if the underlying file
+         * descriptor refers to a file, and it replaces that form of
+         * readahead. It cannot be disabled, and relinquish_file_descriptor()
+         * should not be used afterwards.
+         */
+        void enable_background_readahead() {
+            this->readahead_pos = -1;
+            this->next_offset = platform::tell_file(this->fd);
+            this->background = std::make_unique<BackgroundFileReader>(this->fd, this->buffer.size());
+            this->background->start_read(this->next_offset, this->background->capacity());
+        }
+
         /**
          * @brief Closes the underlying file descriptor, if this
          * BufferedFileReader has ownership of it.
          */
         virtual ~BufferedFileReader() {
+            this->background.reset();
             if (this->owns_fd) {
                 platform::close_file(this->fd);
             }
@@ -476,6 +626,18 @@ namespace mage::util {
             return this->stats;
         }
 
+        /**
+         * @brief Returns the number of bytes read from the underlying file
+         * descriptor so far, including data buffered but not yet consumed.
+         *
+         * This may be called from a thread other than the one reading.
+         *
+         * @return The number of bytes read from the file descriptor.
+         */
+        std::uint64_t get_bytes_read() const {
+            return this->bytes_read.load(std::memory_order_relaxed);
+        }
+
         /**
          * @brief Sets the progress bar to advance as bytes are read from the
          * file.
@@ -614,9 +776,15 @@ namespace mage::util {
             std::uint8_t* mapping = this->buffer.mapping();
             std::size_t leftover = this->active_size - this->position;
             std::copy(&mapping[this->position], &mapping[this->active_size], mapping);
-            std::size_t rv = platform::read_available_from_file(this->fd, &mapping[leftover], this->buffer.size() - leftover);
+            std::size_t rv;
+            if (this->background) {
+                rv = this->take_staged(&mapping[leftover], this->buffer.size() - leftover);
+            } else {
+                rv = platform::read_available_from_file(this->fd, &mapping[leftover], this->buffer.size() - leftover);
+            }
             this->active_size = leftover + rv;
             this->position = 0;
+            this->bytes_read.fetch_add(rv, std::memory_order_relaxed);
             if (this->readahead_pos != -1 && rv != 0) {
                 this->readahead_pos += rv;
                 platform::prefetch_from_file_at(this->fd, this->readahead_pos, this->buffer.size());
@@ -624,6 +792,32 @@ namespace mage::util {
             return rv != 0;
         }
 
+        /*
+         * Copies up to the specified number of bytes from the staging buffer,
+         * first waiting for the background read if the staging buffer is
+         * empty. As soon as a read finishes, the next chunk of the file is
+         * requested into the other staging buffer, so that it is read while
+         * the caller drains and processes this one.
+         */
+        std::size_t take_staged(std::uint8_t* into, std::size_t length) {
+            if (this->staged_position == this->staged_length) {
+                if (!this->background->read_pending()) {
+                    this->background->start_read(this->next_offset, this->background->capacity());
+                }
+                this->staged_length = this->background->finish_read();
+                this->staged_position = 0;
+                this->next_offset += this->staged_length;
+                if (this->staged_length != 0) {
+                    this->background->start_read(this->next_offset, this->background->capacity());
+                }
+            }
+            std::size_t rv = std::min(length, this->staged_length - this->staged_position);
+            const std::uint8_t* staged = this->background->data();
+            std::copy(&staged[this->staged_position], &staged[this->staged_position + rv], into);
+            this->staged_position += rv;
+            return rv;
+        }
+
     protected:
         int fd;
         bool owns_fd;
@@ -636,6 +830,14 @@ namespace mage::util {
         std::size_t position;
         platform::MappedFile<std::uint8_t> buffer;
         util::ProgressBar* progress_bar;
+
+        /* Used only if background readahead is enabled. */
+        std::unique_ptr<BackgroundFileReader> background;
+        std::uint64_t next_offset;
+        std::size_t staged_position;
+        std::size_t staged_length;
+
+        std::atomic<std::uint64_t> bytes_read;
     };
 
     /**
@@ -644,7 +846,8 @@ namespace mage::util {
      *
      * The stream is interpreted as a sequence of items with interspersed size
      * markers, as would be written by BufferedFileWriter\<true\>. Readahead is
-     * always enabled.
+     * always enabled; enable_background_readahead() additionally moves reads
+     * to a helper thread.
      *
      * @tparam backwards_readable Must be true.
      */
@@ -664,7 +867,7 @@ namespace mage::util {
          */
         BufferedReverseFileReader(const char* filename, std::size_t buffer_size = 1 << 18)
             : owns_fd(true), position(0), buffer(buffer_size, true), progress_bar(nullptr),
-            have_rebuffered(false) {
+            have_rebuffered(false), unfetched(0), staged_length(0) {
             this->fd = platform::open_file(filename, &this->length_left);
         }
 
@@ -679,7 +882,24 @@ namespace mage::util {
          */
         BufferedReverseFileReader(int file_descriptor, std::size_t buffer_size = 1 << 18)
             : fd(file_descriptor), owns_fd(false), length_left(UINT64_MAX), position(0),
-            buffer(buffer_size, true), progress_bar(nullptr), have_rebuffered(false) {
+            buffer(buffer_size, true), progress_bar(nullptr), have_rebuffered(false), unfetched(0),
+            staged_length(0) {
+        }
+
+        /**
+         * @brief Enables reading ahead (backwards) on a helper thread, so that
+         * the preceding chunk of the file is fetched while the current one is
+         * processed.
+         *
+         * This requires the length of the file to be known, so it can only be
+         * used with a BufferedReverseFileReader created from a file name, and
+         * must be called before any data is read.
+         */
+        void enable_background_readahead() {
+            assert(this->length_left != UINT64_MAX && !this->have_rebuffered);
+            this->unfetched = this->length_left;
+            this->background = std::make_unique<BackgroundFileReader>(this->fd, this->buffer.size());
+            this->fetch_preceding();
         }
 
         /**
@@ -687,6 +907,7 @@ namespace mage::util {
          * BufferedReverseFileReader has ownership of it.
          */
         virtual ~BufferedReverseFileReader() {
+            this->background.reset();
             if (this->owns_fd) {
                 platform::close_file(this->fd);
             }
@@ -772,18 +993,62 @@ namespace mage::util {
 
             this->position += to_read;
             this->length_left -= to_read;
-            platform::read_from_file_at(this->fd, mapping, to_read, this->length_left);
-            if (this->length_left < this->buffer.size()) {
-                if (this->length_left != 0) {
-                    platform::prefetch_from_file_at(this->fd, 0, this->length_left);
-                }
+            if (this->background) {
+                this->take_staged(mapping, to_read);
             } else {
-                platform::prefetch_from_file_at(this->fd, this->length_left - this->buffer.size(), this->buffer.size());
+                platform::read_from_file_at(this->fd, mapping, to_read, this->length_left);
+                if (this->length_left < this->buffer.size()) {
+                    if (this->length_left != 0) {
+                        platform::prefetch_from_file_at(this->fd, 0, this->length_left);
+                    }
+                } else {
+                    platform::prefetch_from_file_at(this->fd, this->length_left - this->buffer.size(), this->buffer.size());
+                }
             }
 
             this->have_rebuffered = true;
         }
 
+        /*
+         * Starts a background read of the chunk of the file immediately
+         * preceding the data fetched so far.
+         */
+        void fetch_preceding() {
+            std::size_t length = std::min<std::uint64_t>(this->background->capacity(), this->unfetched);
+            if (length != 0) {
+                this->unfetched -= length;
+                this->background->start_read(this->unfetched, length);
+            }
+        }
+
+        /*
+         * Fills the specified region with the data immediately preceding the
+         * data already taken from the staging buffer, which is consumed from
+         * the end. As soon as a read finishes, the chunk preceding it is
+         * requested into the other staging buffer, so that it is read while
+         * the caller drains and processes this one.
+         */
+        void take_staged(std::uint8_t* into, std::uint64_t length) {
+            while (length != 0) {
+                if (this->staged_length == 0) {
+                    if (!this->background->read_pending()) {
+                        this->fetch_preceding();
+                    }
+                    this->staged_length = this->background->finish_read();
+                    if (this->staged_length == 0) {
+                        std::cerr << "Unexpected end of file in reverse read" << std::endl;
+                        std::abort();
+                    }
+                    this->fetch_preceding();
+                }
+                std::size_t n = std::min<std::uint64_t>(length, this->staged_length);
+                const std::uint8_t* staged = this->background->data();
+                std::copy(&staged[this->staged_length - n], &staged[this->staged_length], &into[length - n]);
+                this->staged_length -= n;
+                length -= n;
+            }
+        }
+
     protected:
         int fd;
         bool owns_fd;
@@ -796,6 +1061,11 @@ namespace mage::util {
         util::ProgressBar* progress_bar;
         bool have_rebuffered;
 
+        /* Used only if background readahead is enabled. */
+        std::unique_ptr<BackgroundFileReader> background;
+        std::uint64_t unfetched;
+        std::size_t staged_length;
+
         /*
          * We need to rebuffer a few bytes early because at some optimization
          * levels, the code for reading a bitfield accesses a few bytes past
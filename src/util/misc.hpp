@@ -90,6 +90,18 @@ namespace mage::util {
         return logarithm;
     }
 
+    /**
+     * @brief Computes the largest power of two that is strictly less than the
+     * specified number.
+     *
+     * @param number The specified number. It must be greater than 1.
+     * @return The largest power of two that is strictly less than
+     * @p number.
+     */
+    static inline std::uint64_t largest_power_of_two_below(std::uint64_t number) {
+        return UINT64_C(1) << (log_base_2(number) - 1);
+    }
+
     /**
      * @brief Computes the floor division of two signed numbers.
      *
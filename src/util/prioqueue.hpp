@@ -28,6 +28,7 @@
 #define MAGE_UTIL_PRIOQUEUE_HPP_
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <algorithm>
 #include <unordered_map>
@@ -153,6 +154,41 @@ namespace mage::util {
             return second;
         }
 
+        /**
+         * @brief Finds up to the specified number of elements (key-value
+         * pairs) with the smallest keys, without modifying the priority queue.
+         *
+         * The first element found is the one that min() returns. Elements
+         * with the same key are found in an unspecified order.
+         *
+         * @param k The maximum number of elements to find.
+         * @param[out] smallest Populated with the elements found, in
+         * nondecreasing order of key.
+         */
+        void find_smallest(std::size_t k, std::vector<std::pair<K, V>>& smallest) const {
+            smallest.clear();
+
+            /* Candidates are the children of the elements found so far. */
+            std::vector<Index> frontier;
+            if (!this->empty()) {
+                frontier.push_back(0);
+            }
+            while (smallest.size() != k && !frontier.empty()) {
+                auto next = std::min_element(frontier.begin(), frontier.end(), [this](Index a, Index b) {
+                    return this->data[a].first < this->data[b].first;
+                });
+                Index i = *next;
+                frontier.erase(next);
+                smallest.push_back(this->data[i]);
+                if (leftChild(i) < this->data.size()) {
+                    frontier.push_back(leftChild(i));
+                }
+                if (rightChild(i) < this->data.size()) {
+                    frontier.push_back(rightChild(i));
+                }
+            }
+        }
+
         /**
          * @brief Inserts an element (key-value pair) into the priority queue.
          *
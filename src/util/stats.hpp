@@ -107,6 +107,15 @@ namespace mage::util {
             }
         }
 
+        /**
+         * @brief Returns the sum of the values of all events recorded so far.
+         *
+         * @return The sum of the values of all recorded events.
+         */
+        std::uint64_t get_sum() const {
+            return this->stat_sum;
+        }
+
     private:
         std::uint64_t stat_max;
         std::uint64_t stat_sum;
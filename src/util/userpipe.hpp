@@ -162,6 +162,38 @@ namespace mage::util {
             return this->start_read_unchecked();
         }
 
+        /**
+         * @brief Waits until the pipe contains at least @p amount elements, or
+         * until it is closed.
+         *
+         * @param amount The number of elements to wait for.
+         * @return The number of elements in the pipe, which may be less than
+         * @p amount if the pipe was closed.
+         */
+        std::size_t wait_until_occupied(std::size_t amount) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            while (this->get_space_occupied() < amount && !this->closed) {
+                this->added.wait(lock);
+            }
+            return this->get_space_occupied();
+        }
+
+        /**
+         * @brief Provides a pointer to the element @p offset positions after
+         * the oldest one in the pipe, without removing any elements.
+         *
+         * This does not acquire the pipe's lock, so it may only be called by
+         * the thread that removes elements from the pipe, and only for
+         * elements known to be present (e.g., via wait_until_occupied()).
+         *
+         * @param offset The number of elements between the oldest element in
+         * the pipe and the element of interest.
+         * @return A pointer to the element in the pipe's internal memory.
+         */
+        const T* peek_in_place(std::size_t offset) const {
+            return this->peek_unchecked(offset);
+        }
+
         /**
          * @brief Removes elements from the pipe in place, without copying
          * them.
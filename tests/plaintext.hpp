@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tests/plaintext.hpp
+ * @brief Harness for running small DSL programs end-to-end on the plaintext
+ * engine, so that circuits can be checked against expected values.
+ */
+
+#ifndef MAGE_TESTS_PLAINTEXT_HPP_
+#define MAGE_TESTS_PLAINTEXT_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine/andxor.hpp"
+#include "engine/cluster.hpp"
+#include "memprog/pipeline.hpp"
+#include "programs/registry.hpp"
+#include "protocols/plaintext.hpp"
+#include "protocols/registry.hpp"
+#include "util/binaryfile.hpp"
+#include "util/config.hpp"
+
+namespace mage::tests {
+    /**
+     * @brief Plans the given DSL program, executes it on the plaintext
+     * engine, and returns the bits that it outputs.
+     *
+     * The program is planned for a single worker with a small amount of
+     * memory, in a scratch directory that is removed afterwards.
+     *
+     * @param program The DSL program to run.
+     * @param garbler_input The bits provided as the garbler's input, in the
+     * order that the program marks them as input.
+     * @param num_output_bits The number of bits that the program outputs.
+     * @param extra_config Additional lines for the worker's configuration,
+     * each of the form "key: value", which take precedence over the default
+     * lines for the same key.
+     * @param stats If not null, receives the statistics collected by the
+     * planner.
+     * @param inspect If not null, called after the program runs with the
+     * common prefix of the names of the files planned for it (e.g., append
+     * ".memprog" for the memory program), before they are removed.
+     * @return The bits output by the program.
+     */
+    inline std::vector<std::uint8_t> run_plaintext(std::function<void()> program, const std::vector<std::uint8_t>& garbler_input, std::size_t num_output_bits, const std::vector<std::string>& extra_config = {}, memprog::DefaultPipelineStats* stats = nullptr, std::function<void(const std::string&)> inspect = nullptr) {
+        char dir_template[] = "/tmp/mage_test_XXXXXX";
+        if (mkdtemp(dir_template) == nullptr) {
+            std::perror("mkdtemp");
+            std::abort();
+        }
+        std::string dir(dir_template);
+        std::string file_base = dir + "/test";
+
+        std::string config_file = dir + "/config.yaml";
+        {
+            std::vector<std::string> lines = {
+                "page_shift: 12",
+                "num_pages: 64",
+                "prefetch_buffer_size: 4",
+                "prefetch_lookahead: 100",
+                "storage_path: " + dir + "/swap",
+                "internal_host: localhost",
+                "internal_port: 50000"
+            };
+            for (const std::string& line : extra_config) {
+                std::string key = line.substr(0, line.find(':'));
+                lines.erase(std::remove_if(lines.begin(), lines.end(), [&key](const std::string& l) {
+                    return l.substr(0, l.find(':')) == key;
+                }), lines.end());
+                lines.push_back(line);
+            }
+
+            std::ofstream config(config_file);
+            config << "parties:" << std::endl;
+            config << "  - workers:" << std::endl;
+            for (std::size_t i = 0; i != lines.size(); i++) {
+                config << (i == 0 ? "      - " : "        ") << lines[i] << std::endl;
+            }
+        }
+        util::Configuration c(config_file);
+        const util::ConfigValue& worker = c["parties"][0]["workers"][0];
+
+        const protocols::RegisteredPlacementPlugin* plugin = util::Registry<protocols::RegisteredPlacementPlugin>::look_up_by_name("identity_plugin");
+        memprog::DefaultPipeline planner(file_base, worker);
+        planner.plan(&programs::program_ptr, plugin->get_placement_plugin(), program);
+        if (stats != nullptr) {
+            *stats = planner.get_stats();
+        }
+
+        {
+            util::BinaryFileWriter garbler(std::string(file_base + "_garbler.input").c_str());
+            for (std::uint8_t bit : garbler_input) {
+                garbler.write1(bit);
+            }
+            util::BinaryFileWriter evaluator(std::string(file_base + "_evaluator.input").c_str());
+        }
+
+        auto cluster = std::make_shared<engine::ClusterNetwork>(0, 1 << 18);
+        std::string err = cluster->establish(c["parties"][0]);
+        if (!err.empty()) {
+            std::cerr << err << std::endl;
+            std::abort();
+        }
+
+        {
+            protocols::plaintext::PlaintextEvaluationEngine p(file_base + "_garbler.input", file_base + "_evaluator.input", file_base + ".output");
+            engine::ANDXOREngine executor(cluster, worker, p, file_base + ".memprog");
+            executor.execute_program();
+        }
+
+        std::vector<std::uint8_t> output(num_output_bits);
+        {
+            util::BinaryFileReader reader(std::string(file_base + ".output").c_str());
+            for (std::size_t i = 0; i != num_output_bits; i++) {
+                output[i] = reader.read1();
+            }
+        }
+
+        if (inspect != nullptr) {
+            inspect(file_base);
+        }
+
+        std::filesystem::remove_all(dir);
+        return output;
+    }
+
+    /**
+     * @brief Appends the low @p width bits of @p value to @p bits, least
+     * significant bit first, as the plaintext engine expects them.
+     */
+    inline void append_bits(std::vector<std::uint8_t>& bits, std::uint64_t value, std::size_t width) {
+        for (std::size_t i = 0; i != width; i++) {
+            bits.push_back(static_cast<std::uint8_t>((value >> i) & 0x1));
+        }
+    }
+
+    /**
+     * @brief Reassembles a @p width -bit value from @p bits starting at
+     * @p offset, which is advanced past the value.
+     */
+    inline std::uint64_t extract_bits(const std::vector<std::uint8_t>& bits, std::size_t& offset, std::size_t width) {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i != width; i++) {
+            value |= static_cast<std::uint64_t>(bits.at(offset + i)) << i;
+        }
+        offset += width;
+        return value;
+    }
+}
+
+#endif
@@ -57,3 +57,22 @@ BOOST_DATA_TEST_CASE(test_circbuffer_wrap, bdata::xrange(circbuf_capacity), step
         }
     }
 }
+
+BOOST_DATA_TEST_CASE(test_circbuffer_peek, bdata::xrange(circbuf_capacity), start) {
+    CircularBuffer<std::uint64_t> cb(circbuf_capacity);
+
+    /* Move the read position so that peeked elements wrap around. */
+    std::vector<std::uint64_t> x(start);
+    cb.write_unchecked(x.data(), start);
+    cb.read_unchecked(x.data(), start);
+
+    std::vector<std::uint64_t> y(circbuf_capacity);
+    for (std::uint64_t i = 0; i != circbuf_capacity; i++) {
+        y[i] = i;
+    }
+    cb.write_unchecked(y.data(), circbuf_capacity);
+    for (std::uint64_t k = 0; k != circbuf_capacity; k++) {
+        BOOST_CHECK_MESSAGE(*cb.peek_unchecked(k) == k, "element " << k << " is " << *cb.peek_unchecked(k));
+    }
+    BOOST_CHECK(cb.get_space_occupied() == circbuf_capacity);
+}
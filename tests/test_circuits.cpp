@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include "boost/test/unit_test.hpp"
+#include "boost/test/data/test_case.hpp"
+#include "boost/test/data/monomorphic.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+#include "plaintext.hpp"
+
+namespace bdata = boost::unit_test::data;
+using namespace mage;
+
+std::vector<std::string> circuit_config(int low_depth) {
+    return { "low_depth_circuits: " + std::to_string(low_depth) };
+}
+
+template <BitWidth width>
+void test_int_sub(int low_depth, const std::vector<std::pair<std::uint64_t, std::uint64_t>>& cases) {
+    std::uint64_t mask = (width == 64) ? ~UINT64_C(0) : ((UINT64_C(1) << width) - 1);
+    std::vector<std::uint8_t> input;
+    for (const auto& [a, b] : cases) {
+        tests::append_bits(input, a, width);
+        tests::append_bits(input, b, width);
+    }
+    std::vector<std::uint8_t> output = tests::run_plaintext([&cases]() {
+        for (std::size_t i = 0; i != cases.size(); i++) {
+            programs::Integer<width> a, b;
+            a.mark_input(Party::Garbler);
+            b.mark_input(Party::Garbler);
+            programs::Integer<width> difference = a - b;
+            difference.mark_output();
+        }
+    }, input, cases.size() * width, circuit_config(low_depth));
+
+    std::size_t offset = 0;
+    for (const auto& [a, b] : cases) {
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), (a - b) & mask);
+    }
+}
+
+template <BitWidth width>
+void test_zero_tests(int low_depth, const std::vector<std::uint64_t>& values) {
+    std::vector<std::uint8_t> input;
+    for (std::uint64_t v : values) {
+        tests::append_bits(input, v, width);
+    }
+    std::vector<std::uint8_t> output = tests::run_plaintext([&values]() {
+        for (std::size_t i = 0; i != values.size(); i++) {
+            programs::Integer<width> a;
+            a.mark_input(Party::Garbler);
+            programs::Bit is_zero = !a;
+            is_zero.mark_output();
+            programs::Bit non_zero = a.nonzero();
+            non_zero.mark_output();
+        }
+    }, input, values.size() * 2, circuit_config(low_depth));
+
+    std::size_t offset = 0;
+    for (std::uint64_t v : values) {
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 1), v == 0 ? 1 : 0);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 1), v == 0 ? 0 : 1);
+    }
+}
+
+template <BitWidth width>
+void test_in_place_increment_decrement(const std::vector<std::uint64_t>& values) {
+    std::uint64_t mask = (width == 64) ? ~UINT64_C(0) : ((UINT64_C(1) << width) - 1);
+    constexpr int num_inputs = 6;
+    std::vector<std::uint8_t> input;
+    for (std::uint64_t v : values) {
+        for (int i = 0; i != num_inputs; i++) {
+            tests::append_bits(input, v, width);
+        }
+    }
+    std::vector<std::uint8_t> output = tests::run_plaintext([&values]() {
+        for (std::size_t i = 0; i != values.size(); i++) {
+            programs::Integer<width> a, b, c, d, e, f;
+            a.mark_input(Party::Garbler);
+            b.mark_input(Party::Garbler);
+            c.mark_input(Party::Garbler);
+            d.mark_input(Party::Garbler);
+            e.mark_input(Party::Garbler);
+            f.mark_input(Party::Garbler);
+
+            ++a;
+            a.mark_output();
+            programs::Integer<width> b_old = b++;
+            b_old.mark_output();
+            b.mark_output();
+            --c;
+            c.mark_output();
+            programs::Integer<width> d_old = d--;
+            d_old.mark_output();
+            d.mark_output();
+            programs::Integer<width> e_incremented = std::move(e).increment();
+            e_incremented.mark_output();
+            programs::Integer<width> f_decremented = std::move(f).decrement();
+            f_decremented.mark_output();
+        }
+    }, input, values.size() * 8 * width);
+
+    std::size_t offset = 0;
+    for (std::uint64_t v : values) {
+        std::uint64_t plus_one = (v + 1) & mask;
+        std::uint64_t minus_one = (v - 1) & mask;
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), plus_one);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), v);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), plus_one);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), minus_one);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), v);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), minus_one);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), plus_one);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), minus_one);
+    }
+}
+
+void test_fixed(int low_depth, const std::vector<std::pair<double, double>>& cases) {
+    using Fixed = programs::Fixed<16, 16>;
+    constexpr BitWidth width = 32;
+    constexpr std::uint64_t mask = (UINT64_C(1) << width) - 1;
+    std::vector<std::uint8_t> input;
+    for (const auto& [a, b] : cases) {
+        tests::append_bits(input, Fixed::encode(a), width);
+        tests::append_bits(input, Fixed::encode(b), width);
+    }
+    std::vector<std::uint8_t> output = tests::run_plaintext([&cases]() {
+        for (std::size_t i = 0; i != cases.size(); i++) {
+            Fixed a, b;
+            a.mark_input(Party::Garbler);
+            b.mark_input(Party::Garbler);
+            Fixed sum = a + b;
+            sum.mark_output();
+            Fixed difference = a - b;
+            difference.mark_output();
+            Fixed product = a * b;
+            product.mark_output();
+            Fixed negation = -a;
+            negation.mark_output();
+            programs::Bit less = a < b;
+            less.mark_output();
+            programs::Bit equal = a == b;
+            equal.mark_output();
+        }
+    }, input, cases.size() * (4 * width + 2), circuit_config(low_depth));
+
+    std::size_t offset = 0;
+    for (const auto& [a, b] : cases) {
+        std::int64_t raw_a = static_cast<std::int64_t>(Fixed::encode(a) << (64 - width)) >> (64 - width);
+        std::int64_t raw_b = static_cast<std::int64_t>(Fixed::encode(b) << (64 - width)) >> (64 - width);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), static_cast<std::uint64_t>(raw_a + raw_b) & mask);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), static_cast<std::uint64_t>(raw_a - raw_b) & mask);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), static_cast<std::uint64_t>((raw_a * raw_b) >> 16) & mask);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), static_cast<std::uint64_t>(-raw_a) & mask);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 1), raw_a < raw_b ? 1 : 0);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 1), raw_a == raw_b ? 1 : 0);
+    }
+}
+
+/* Rounds toward zero to the 24 significant bits of a single-precision float. */
+double truncate_to_float(double x) {
+    if (x == 0.0) {
+        return 0.0;
+    }
+    int exp;
+    double fraction = std::frexp(x, &exp);
+    return std::ldexp(std::trunc(std::ldexp(fraction, 24)), exp - 24);
+}
+
+/*
+ * For each case, checks a + b, a - b, a * b, and a < b. Expected values are
+ * the exact results truncated toward zero, which is what the circuits compute
+ * for products and for sums of operands with the same sign; cases that
+ * subtract magnitudes must therefore have exact results.
+ */
+void test_float(int low_depth, const std::vector<std::pair<double, double>>& cases) {
+    using Float = programs::Float;
+    constexpr BitWidth width = 32;
+    std::vector<std::uint8_t> input;
+    for (const auto& [a, b] : cases) {
+        tests::append_bits(input, Float::encode(a), width);
+        tests::append_bits(input, Float::encode(b), width);
+    }
+    std::vector<std::uint8_t> output = tests::run_plaintext([&cases]() {
+        for (std::size_t i = 0; i != cases.size(); i++) {
+            Float a, b;
+            a.mark_input(Party::Garbler);
+            b.mark_input(Party::Garbler);
+            Float sum = a + b;
+            sum.mark_output();
+            Float difference = a - b;
+            difference.mark_output();
+            Float product = a * b;
+            product.mark_output();
+            programs::Bit less = a < b;
+            less.mark_output();
+        }
+    }, input, cases.size() * (3 * width + 1), circuit_config(low_depth));
+
+    std::size_t offset = 0;
+    for (const auto& [a, b] : cases) {
+        double input_a = Float::decode(Float::encode(a));
+        double input_b = Float::decode(Float::encode(b));
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), Float::encode(truncate_to_float(input_a + input_b)));
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), Float::encode(truncate_to_float(input_a - input_b)));
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, width), Float::encode(truncate_to_float(input_a * input_b)));
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 1), input_a < input_b ? 1 : 0);
+    }
+}
+
+BOOST_DATA_TEST_CASE(test_int_sub_edges, bdata::xrange(2), low_depth) {
+    test_int_sub<1>(low_depth, { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } });
+    test_int_sub<8>(low_depth, {
+        { 0, 0 }, { 0, 1 }, { 0, 0xFF }, { 0xFF, 0xFF }, { 0xFF, 0 },
+        { 0x80, 1 }, { 0x7F, 0x80 }, { 1, 0xFF }, { 0x10, 0x01 }
+    });
+    test_int_sub<32>(low_depth, { { 0, 1 }, { 0xFFFFFFFF, 0xFFFFFFFF }, { 0x80000000, 1 }, { 3, 0xFFFFFFFF } });
+}
+
+BOOST_DATA_TEST_CASE(test_is_zero_non_zero_edges, bdata::xrange(2), low_depth) {
+    test_zero_tests<1>(low_depth, { 0, 1 });
+    test_zero_tests<2>(low_depth, { 0, 1, 2, 3 });
+    test_zero_tests<8>(low_depth, { 0, 1, 0x80, 0xFF, 0x10 });
+    test_zero_tests<13>(low_depth, { 0, 1, 0x1000, 0x1FFF });
+    test_zero_tests<32>(low_depth, { 0, 1, 0x80000000, 0xFFFFFFFF });
+}
+
+BOOST_AUTO_TEST_CASE(test_in_place_increment_decrement_edges) {
+    test_in_place_increment_decrement<1>({ 0, 1 });
+    test_in_place_increment_decrement<2>({ 0, 1, 2, 3 });
+    test_in_place_increment_decrement<8>({ 0, 1, 0x55, 0x7F, 0x80, 0xFE, 0xFF });
+    test_in_place_increment_decrement<32>({ 0, 1, 0x7FFFFFFF, 0xFFFFFFFF });
+}
+
+BOOST_DATA_TEST_CASE(test_fixed_arithmetic, bdata::xrange(2), low_depth) {
+    test_fixed(low_depth, {
+        { 0.0, 0.0 }, { 1.5, -2.25 }, { -1.5, -0.25 }, { 3.75, 3.75 },
+        { -32768.0, 1.0 }, { 32767.5, -1.0 }, { 0.0001, -0.0001 },
+        { 181.02, 181.02 }, { -100.5, 300.125 }, { -0.5, 0.5 }
+    });
+}
+
+BOOST_DATA_TEST_CASE(test_float_arithmetic, bdata::xrange(2), low_depth) {
+    test_float(low_depth, {
+        { 0.0, 0.0 }, { 1.5, 2.25 }, { -3.0, 5.0 }, { 0.0, 7.5 }, { 0.5, -0.5 },
+        { 1024.0, 0.125 }, { -6.5, -0.75 }, { 2.0, 2.0 }, { -1.0, 0.0 },
+        { 1.1, 1.3 }, { 1.1, 0.0003 }, { -7.7, -3.3e-5 }, { 3.0e10, 2.0e-10 }
+    });
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include "boost/test/unit_test.hpp"
+#include "boost/test/data/test_case.hpp"
+#include "boost/test/data/monomorphic.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "programfile.hpp"
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+#include "plaintext.hpp"
+
+namespace bdata = boost::unit_test::data;
+using namespace mage;
+
+constexpr std::size_t span_array_length = 64;
+
+/*
+ * Adds each element of an array of 128-bit integers to another element of
+ * it. With 64-wire pages, each integer spans two pages, and the array is
+ * several times the size of memory, so multi-page allocations are placed,
+ * evicted, and swapped back in throughout the program.
+ */
+void check_page_spans(const std::vector<std::string>& config, bool expect_spans) {
+    std::vector<std::uint64_t> values(span_array_length);
+    std::vector<std::uint8_t> input;
+    for (std::size_t i = 0; i != span_array_length; i++) {
+        values[i] = (i * UINT64_C(0x9E3779B97F4A7C15)) >> 2;
+        tests::append_bits(input, values[i], 64);
+        tests::append_bits(input, i, 64);
+    }
+
+    std::uint64_t flags = 0;
+    std::vector<std::uint8_t> output = tests::run_plaintext([]() {
+        std::vector<programs::Integer<128>> array(span_array_length);
+        for (auto& elem : array) {
+            elem.mark_input(Party::Garbler);
+        }
+        for (std::size_t i = 0; i != span_array_length; i++) {
+            programs::Integer<128> sum = array[i] + array[(i * 7 + 3) % span_array_length];
+            sum.mark_output();
+        }
+    }, input, span_array_length * 128, config, nullptr, [&flags](const std::string& file_base) {
+        PhysProgramFileReader program(file_base + ".memprog");
+        flags = program.get_header().flags;
+    });
+
+    BOOST_TEST(((flags & ProgramFlagPageSpans) != 0) == expect_spans);
+
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i != span_array_length; i++) {
+        std::size_t j = (i * 7 + 3) % span_array_length;
+        std::uint64_t low = values[i] + values[j];
+        std::uint64_t high = i + j + ((low < values[i]) ? 1 : 0);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 64), low);
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 64), high);
+    }
+}
+
+BOOST_DATA_TEST_CASE(test_page_spans_output, bdata::xrange(3), variant) {
+    std::vector<std::vector<std::string>> configs = {
+        { "page_shift: 6", "num_pages: 16" },
+        { "page_shift: 6", "num_pages: 16", "concurrent_scheduling: 1" },
+        { "page_shift: 6", "num_pages: 16", "prefetch_buffer_size: 1", "prefetch_lookahead: 10" }
+    };
+    check_page_spans(configs[variant], true);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_spans_only_when_needed) {
+    check_page_spans({ "page_shift: 12", "num_pages: 4" }, false);
+}
@@ -152,6 +152,31 @@ BOOST_DATA_TEST_CASE(test_prioqueue_second_min, bdata::make(reverse) + RandomInt
     }
 }
 
+BOOST_DATA_TEST_CASE(test_prioqueue_find_smallest, bdata::make(reverse) + RandomIntsDataset(99)) {
+    std::vector<int> numbers(sample.data);
+    PriorityQueue<int, int> pq;
+    for (auto i = numbers.begin(); i != numbers.end(); i++) {
+        pq.insert(*i, *i);
+    }
+
+    std::vector<std::pair<int, int>> smallest;
+    pq.find_smallest(8, smallest);
+
+    std::vector<int> sorted(numbers);
+    std::sort(sorted.begin(), sorted.end());
+    BOOST_REQUIRE(smallest.size() == std::min<std::size_t>(sorted.size(), 8));
+    for (int i = 0; i != smallest.size(); i++) {
+        BOOST_CHECK(smallest[i].first == smallest[i].second);
+        BOOST_CHECK(sorted[i] == smallest[i].second);
+    }
+
+    /* The priority queue is left unchanged. */
+    BOOST_REQUIRE(pq.size() == numbers.size());
+    for (int i = 0; i != sorted.size(); i++) {
+        BOOST_CHECK(pq.remove_min().second == sorted[i]);
+    }
+}
+
 BOOST_DATA_TEST_CASE(test_prioqueue_decrease_key, bdata::make(reverse) + RandomIntsDataset(99)) {
     std::vector<int> numbers(sample.data);
 
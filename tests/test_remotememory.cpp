@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include "boost/test/unit_test.hpp"
+
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "engine/remotememory.hpp"
+#include "platform/filesystem.hpp"
+#include "platform/network.hpp"
+
+using namespace mage;
+
+struct TestMemoryServer {
+    TestMemoryServer(const char* port, std::uint64_t capacity) : available(capacity) {
+        int server_socket = platform::network_listen(port);
+        this->server = std::thread([this, server_socket]() {
+            int fd;
+            platform::network_accept_on(server_socket, &fd);
+            platform::network_close(server_socket);
+            engine::serve_remote_memory_client(fd, this->available);
+        });
+    }
+
+    /* Waits for the client to disconnect. */
+    void wait() {
+        if (this->server.joinable()) {
+            this->server.join();
+        }
+    }
+
+    ~TestMemoryServer() {
+        this->wait();
+    }
+
+    std::atomic<std::uint64_t> available;
+    std::thread server;
+};
+
+BOOST_AUTO_TEST_CASE(test_remote_memory_round_trip) {
+    constexpr std::uint64_t capacity = 1 << 20;
+    constexpr std::uint32_t page_size = 4096;
+    constexpr std::uint32_t num_pages = 16;
+    TestMemoryServer server("50910", capacity);
+    {
+        engine::RemoteMemory memory("localhost", "50910", page_size * num_pages);
+        BOOST_CHECK_EQUAL(server.available.load(), capacity - page_size * num_pages);
+
+        std::vector<std::uint8_t> written(page_size * num_pages);
+        for (std::size_t i = 0; i != written.size(); i++) {
+            written[i] = static_cast<std::uint8_t>(i * 7 + i / page_size);
+        }
+        for (std::uint32_t i = 0; i != num_pages; i++) {
+            memory.write(&written[i * page_size], i * page_size, page_size);
+        }
+
+        /* Requests complete in order, so these reads observe the writes without waiting. */
+        std::vector<std::uint8_t> read(page_size * num_pages);
+        for (std::uint32_t i = 0; i != num_pages; i++) {
+            std::uint32_t page = (i * 5) % num_pages;
+            memory.read(&read[page * page_size], page * page_size, page_size);
+        }
+
+        /* Overwrite a page, then read it back in pieces. */
+        std::vector<std::uint8_t> overwritten(page_size, 0xA5);
+        memory.write(overwritten.data(), 3 * page_size, page_size);
+        std::vector<std::uint8_t> reread(page_size);
+        memory.read(&reread[0], 3 * page_size, page_size / 2);
+        std::uint64_t last = memory.read(&reread[page_size / 2], 3 * page_size + page_size / 2, page_size / 2);
+        BOOST_CHECK_EQUAL(last, 2 * num_pages + 3);
+
+        memory.wait(last);
+        BOOST_CHECK_EQUAL(memory.get_num_in_flight(), 0);
+        BOOST_CHECK(read == written);
+        BOOST_CHECK(reread == overwritten);
+    }
+    server.wait();
+    BOOST_CHECK_EQUAL(server.available.load(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(test_remote_memory_large_allocation) {
+    /* A size of 4 GiB or more must reach the server intact, not truncated to 32 bits. */
+    TestMemoryServer server("50911", 1 << 20);
+
+    int fd;
+    platform::NetworkError err;
+    platform::network_connect("localhost", "50911", &fd, &err);
+    BOOST_REQUIRE(err == platform::NetworkError::Success);
+
+    engine::RemoteMemoryRequest request;
+    request.offset = (UINT64_C(1) << 32) + 4096;
+    request.length = 0;
+    request.op = engine::RemoteMemoryOp::Allocate;
+    platform::write_to_file(fd, &request, sizeof(request));
+
+    std::uint8_t status = 0;
+    BOOST_REQUIRE_EQUAL(platform::read_from_file(fd, &status, sizeof(status)), sizeof(status));
+    BOOST_CHECK_EQUAL(status, 1);
+    platform::network_close(fd);
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2020 Sam Kumar <samkumar@cs.berkeley.edu>
+ * Copyright (C) 2020 University of California, Berkeley
+ * All rights reserved.
+ *
+ * This file is part of MAGE.
+ *
+ * MAGE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MAGE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MAGE.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include "boost/test/unit_test.hpp"
+#include "boost/test/data/test_case.hpp"
+#include "boost/test/data/monomorphic.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "dsl/groupby.hpp"
+#include "dsl/sort.hpp"
+#include "memprog/pipeline.hpp"
+#include "memprog/replacement.hpp"
+#include "opcode.hpp"
+#include "programfile.hpp"
+#include "programs/registry.hpp"
+#include "programs/util.hpp"
+#include "plaintext.hpp"
+
+namespace bdata = boost::unit_test::data;
+using namespace mage;
+
+constexpr std::size_t sort_length = 4096;
+
+std::vector<std::uint64_t> sort_input() {
+    std::vector<std::uint64_t> values(sort_length);
+    for (std::size_t i = 0; i != sort_length; i++) {
+        values[i] = (i * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+    }
+    return values;
+}
+
+/*
+ * Sorts an array four times the size of memory, so that replacement has to
+ * swap pages throughout the program.
+ */
+void check_sort(const std::vector<std::string>& config, memprog::DefaultPipelineStats* stats = nullptr) {
+    std::vector<std::uint64_t> expected = sort_input();
+    std::vector<std::uint8_t> input;
+    for (std::uint64_t v : expected) {
+        tests::append_bits(input, v, 32);
+    }
+    std::vector<std::string> full_config = { "num_pages: 16" };
+    full_config.insert(full_config.end(), config.begin(), config.end());
+    std::vector<std::uint8_t> output = tests::run_plaintext([]() {
+        std::vector<programs::Integer<32>> array(sort_length);
+        for (auto& elem : array) {
+            elem.mark_input(Party::Garbler);
+        }
+        dsl::sorter(array.data(), sort_length);
+        for (auto& elem : array) {
+            elem.mark_output();
+        }
+    }, input, sort_length * 32, full_config, stats);
+
+    std::sort(expected.begin(), expected.end());
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i != sort_length; i++) {
+        BOOST_CHECK_EQUAL(tests::extract_bits(output, offset, 32), expected[i]);
+    }
+}
+
+constexpr std::size_t group_by_length = 2048;
+constexpr std::uint64_t group_by_num_keys = 64;
+
+/*
+ * Replays the swaps in a physical program, before scheduling, through a
+ * SwapBudgetModel, to predict the stall of any replacement policy.
+ */
+InstructionNumber predict_stall(const std::string& repprog_file, std::uint32_t budget, InstructionNumber lookahead, InstructionNumber latency) {
+    memprog::SwapBudgetModel model(budget, lookahead, latency);
+    PhysProgramFileReader program(repprog_file);
+    InstructionNumber num_instructions = program.get_header().num_instructions;
+    for (InstructionNumber i = 0; i != num_instructions; i++) {
+        PackedPhysInstruction& phys = program.start_instruction();
+        if (phys.header.operation == OpCode::IssueSwapIn) {
+            model.swapin(i);
+        } else if (phys.header.operation == OpCode::IssueSwapOut) {
+            model.swapout(i);
+        }
+        program.finish_instruction(phys.size());
+    }
+    model.finish();
+    return model.get_predicted_stall();
+}
+
+/*
+ * Counts records by key. Unlike sorting, the aggregation reads pages that it
+ * does not write, so some pages are clean when they are evicted.
+ */
+void check_group_by_count(const std::vector<std::string>& config, std::uint32_t budget, InstructionNumber lookahead, memprog::DefaultPipelineStats* stats, InstructionNumber* predicted_stall) {
+    std::vector<std::uint8_t> input;
+    std::map<std::uint64_t, std::uint64_t> expected;
+    for (std::size_t i = 0; i != group_by_length; i++) {
+        std::uint64_t key = ((i * UINT64_C(0x9E3779B97F4A7C15)) >> 32) % group_by_num_keys;
+        tests::append_bits(input, key, 32);
+        tests::append_bits(input, i, 32);
+        expected[key]++;
+    }
+    std::vector<std::string> full_config = { "num_pages: 16", "prefetch_buffer_size: " + std::to_string(budget), "prefetch_lookahead: " + std::to_string(lookahead) };
+    full_config.insert(full_config.end(), config.begin(), config.end());
+    std::vector<std::uint8_t> output = tests::run_plaintext([]() {
+        std::vector<dsl::GroupByEntry<32, 32, memprog::BinnedPlacer, programs::default_program>> entries(group_by_length);
+        for (auto& entry : entries) {
+            entry.key.mark_input(Party::Garbler);
+            entry.value.mark_input(Party::Garbler);
+        }
+        dsl::group_by_aggregate(entries.data(), group_by_length, dsl::Aggregate::Count);
+        for (auto& entry : entries) {
+            entry.key.mark_output();
+            entry.last.mark_output();
+            programs::Integer<32> zero(0);
+            programs::Integer<32>::select(entry.last, entry.value, zero).mark_output();
+        }
+    }, input, group_by_length * 65, full_config, stats, [=](const std::string& file_base) {
+        *predicted_stall = predict_stall(file_base + ".repprog", budget, lookahead, lookahead);
+    });
+
+    std::map<std::uint64_t, std::uint64_t> actual;
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i != group_by_length; i++) {
+        std::uint64_t key = tests::extract_bits(output, offset, 32);
+        std::uint64_t last = tests::extract_bits(output, offset, 1);
+        std::uint64_t count = tests::extract_bits(output, offset, 32);
+        if (last == 1) {
+            actual[key] = count;
+        }
+    }
+    BOOST_TEST(actual == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_swap_budget_model_zero_lookahead) {
+    memprog::SwapBudgetModel model(1, 0, 10);
+    model.swapin(5);
+    model.swapin(6);
+    BOOST_TEST(!model.swapout_would_stall(7));
+    model.swapout(7);
+    model.finish();
+    BOOST_TEST(model.get_num_synchronous_swaps() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_swap_budget_model_budget) {
+    memprog::SwapBudgetModel model(1, 10, 10);
+
+    /* A swap-in issued less than the latency ahead stalls for the rest. */
+    model.swapin(3);
+    BOOST_TEST(model.get_predicted_stall() == 7);
+    model.swapin(20);
+    BOOST_TEST(model.get_predicted_stall() == 7);
+
+    /* A swap-in issued while the only frame is held is synchronous. */
+    model.swapin(21);
+    BOOST_TEST(model.get_num_synchronous_swaps() == 1);
+    BOOST_TEST(model.get_predicted_stall() == 17);
+}
+
+BOOST_AUTO_TEST_CASE(test_swap_budget_model_swapout_would_stall) {
+    memprog::SwapBudgetModel model(2, 10, 10);
+    model.swapout(5);
+    BOOST_TEST(!model.swapout_would_stall(6));
+    model.swapin(8);
+    BOOST_TEST(model.swapout_would_stall(9));
+
+    /* Both frames are released a lookahead later. */
+    BOOST_TEST(!model.swapout_would_stall(18));
+}
+
+BOOST_DATA_TEST_CASE(test_stall_aware_replacement_output, bdata::xrange(3), variant) {
+    std::vector<std::vector<std::string>> configs = {
+        { "stall_aware_replacement: 1", "prefetch_buffer_size: 2", "prefetch_lookahead: 1000" },
+        { "stall_aware_replacement: 1", "prefetch_buffer_size: 8", "prefetch_lookahead: 100" },
+        { "stall_aware_replacement: 1", "prefetch_buffer_size: 2", "prefetch_lookahead: 1000", "concurrent_scheduling: 1" }
+    };
+    check_sort(configs[variant]);
+}
+
+BOOST_AUTO_TEST_CASE(test_stall_aware_replacement_predicts_allocation_failures) {
+    memprog::DefaultPipelineStats stats;
+    check_sort({ "stall_aware_replacement: 1", "prefetch_buffer_size: 2", "prefetch_lookahead: 1000" }, &stats);
+    BOOST_TEST_REQUIRE(stats.num_prefetch_alloc_failures != 0);
+    BOOST_TEST(stats.predicted_synchronous_swaps == stats.num_prefetch_alloc_failures);
+}
+
+/*
+ * Each allocation failure in the scheduler is a swap done synchronously, so
+ * it measures the stall that the model predicts.
+ */
+BOOST_DATA_TEST_CASE(test_stall_aware_replacement_no_worse_than_belady, bdata::xrange(3), variant) {
+    std::vector<std::pair<std::uint32_t, InstructionNumber>> configs = { { 2, 200 }, { 2, 1000 }, { 4, 1000 } };
+    auto [budget, lookahead] = configs[variant];
+
+    memprog::DefaultPipelineStats belady;
+    memprog::DefaultPipelineStats stall_aware;
+    InstructionNumber belady_predicted_stall;
+    InstructionNumber stall_aware_predicted_stall;
+    check_group_by_count({ "stall_aware_replacement: 0" }, budget, lookahead, &belady, &belady_predicted_stall);
+    check_group_by_count({ "stall_aware_replacement: 1" }, budget, lookahead, &stall_aware, &stall_aware_predicted_stall);
+
+    BOOST_TEST_REQUIRE(stall_aware.num_replacement_substitutions != 0);
+    BOOST_TEST(stall_aware_predicted_stall == stall_aware.predicted_swap_stall);
+    BOOST_TEST(stall_aware_predicted_stall <= belady_predicted_stall);
+    BOOST_TEST(stall_aware.num_prefetch_alloc_failures <= belady.num_prefetch_alloc_failures);
+}
+
+BOOST_AUTO_TEST_CASE(test_stall_aware_replacement_matches_belady_without_contention) {
+    memprog::DefaultPipelineStats belady;
+    memprog::DefaultPipelineStats stall_aware;
+    check_sort({ "stall_aware_replacement: 0", "prefetch_buffer_size: 8", "prefetch_lookahead: 100" }, &belady);
+    check_sort({ "stall_aware_replacement: 1", "prefetch_buffer_size: 8", "prefetch_lookahead: 100" }, &stall_aware);
+
+    BOOST_TEST_REQUIRE(belady.num_swapins != 0);
+    BOOST_TEST(stall_aware.num_replacement_substitutions == 0);
+    BOOST_TEST(stall_aware.num_swapins == belady.num_swapins);
+    BOOST_TEST(stall_aware.num_swapouts == belady.num_swapouts);
+    BOOST_TEST(stall_aware.num_synchronous_swapins == belady.num_synchronous_swapins);
+}